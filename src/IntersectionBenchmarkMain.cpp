@@ -0,0 +1,169 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <stdlib.h>
+#include <getopt.h>
+#include <string>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "index/FTSAlgorithms.h"
+#include "util/Timer.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+#define EMPH_ON  "\033[1m"
+#define EMPH_OFF "\033[21m"
+
+// Available options.
+struct option options[] = {
+    {"elements", required_argument, NULL, 'n'},
+    {"repetitions", required_argument, NULL, 'r'},
+    {NULL, 0, NULL, 0}
+};
+
+static const FTSAlgorithms::IntersectionMode MODES[] = {
+    FTSAlgorithms::MERGE, FTSAlgorithms::GALLOP, FTSAlgorithms::SIMD_MERGE,
+    FTSAlgorithms::ADAPTIVE
+};
+static const char* MODE_NAMES[] = {
+    "merge", "gallop", "simd merge", "adaptive"
+};
+
+// Prints the time per run for one mode.
+void report(const string& name, const ad_utility::Timer& timer,
+            size_t nofRepetitions, size_t nofResults) {
+  double usecsPerRun = static_cast<double>(timer.usecs()) / nofRepetitions;
+  cout << "  " << std::left << std::setw(14) << name << std::right
+       << std::setw(12) << std::fixed << std::setprecision(1) << usecsPerRun
+       << " us/run" << std::setw(12) << nofResults << " results" << endl;
+}
+
+// Sorted context ids of a word that occurs in about a fraction of the
+// nofContexts contexts, sometimes twice in the same context.
+void makeList(size_t nofContexts, double fraction, std::mt19937_64& rng,
+              vector<Id>* cids, vector<Score>* scores) {
+  std::geometric_distribution<Id> gap(fraction);
+  std::uniform_int_distribution<int> percent(0, 99);
+  cids->clear();
+  scores->clear();
+  for (Id c = gap(rng); c < nofContexts; c += 1 + gap(rng)) {
+    size_t n = percent(rng) < 5 ? 2 : 1;
+    for (size_t i = 0; i < n; ++i) {
+      cids->push_back(c);
+      scores->push_back(static_cast<Score>(1 + percent(rng) % 10));
+    }
+  }
+}
+
+// Intersects a word list with one ratio times as long in all modes.
+void benchmarkTwoLists(size_t nofElements, size_t ratio,
+                       size_t nofRepetitions, std::mt19937_64& rng) {
+  // The long list covers a quarter of all contexts.
+  size_t nofContexts = 4 * nofElements;
+  vector<Id> cids1;
+  vector<Score> scores1;
+  vector<Id> cids2;
+  vector<Score> scores2;
+  makeList(nofContexts, 0.25 / ratio, rng, &cids1, &scores1);
+  makeList(nofContexts, 0.25, rng, &cids2, &scores2);
+  cout << "Two lists, sizes " << cids1.size() << " and " << cids2.size()
+       << " (ratio " << ratio << "):" << endl;
+  vector<Id> resCids;
+  vector<Score> resScores;
+  for (size_t m = 0; m < 4; ++m) {
+    if (MODES[m] == FTSAlgorithms::SIMD_MERGE &&
+        !FTSAlgorithms::cpuSupportsSimd()) {
+      continue;
+    }
+    FTSAlgorithms::intersectionMode() = MODES[m];
+    ad_utility::Timer timer;
+    timer.start();
+    for (size_t r = 0; r < nofRepetitions; ++r) {
+      FTSAlgorithms::intersectTwoPostingLists(cids1, scores1, cids2, scores2,
+                                              resCids, resScores);
+    }
+    timer.stop();
+    report(MODE_NAMES[m], timer, nofRepetitions, resCids.size());
+  }
+}
+
+// Intersects a frequent, a medium and a rare word, in merge mode and in
+// adaptive mode, where the rare word drives the galloping.
+void benchmarkKWay(size_t nofElements, size_t nofRepetitions,
+                   std::mt19937_64& rng) {
+  size_t nofContexts = 4 * nofElements;
+  vector<vector<Id>> cidVecs(3);
+  vector<vector<Score>> scoreVecs(3);
+  makeList(nofContexts, 0.25, rng, &cidVecs[0], &scoreVecs[0]);
+  makeList(nofContexts, 0.25 / 16, rng, &cidVecs[1], &scoreVecs[1]);
+  makeList(nofContexts, 0.25 / 256, rng, &cidVecs[2], &scoreVecs[2]);
+  cout << "Three lists, sizes " << cidVecs[0].size() << ", "
+       << cidVecs[1].size() << " and " << cidVecs[2].size() << ":" << endl;
+  vector<Id> resCids;
+  vector<Id> resEids;
+  vector<Score> resScores;
+  for (size_t m = 0; m < 4; m += 3) {
+    FTSAlgorithms::intersectionMode() = MODES[m];
+    ad_utility::Timer timer;
+    timer.start();
+    for (size_t r = 0; r < nofRepetitions; ++r) {
+      FTSAlgorithms::intersectKWay(cidVecs, scoreVecs, nullptr, resCids,
+                                   resEids, resScores);
+    }
+    timer.stop();
+    report(MODE_NAMES[m], timer, nofRepetitions, resCids.size());
+  }
+}
+
+// Main function.
+int main(int argc, char **argv) {
+  std::cout << std::endl << EMPH_ON
+      << "IntersectionBenchmarkMain, version " << __DATE__
+      << " " << __TIME__ << EMPH_OFF << std::endl << std::endl;
+
+  size_t nofElements = 4 * 1000 * 1000;
+  size_t nofRepetitions = 10;
+
+  optind = 1;
+  // Process command line arguments.
+  while (true) {
+    int c = getopt_long(argc, argv, "n:r:", options, NULL);
+    if (c == -1) break;
+    switch (c) {
+      case 'n':
+        nofElements = static_cast<size_t>(atol(optarg));
+        break;
+      case 'r':
+        nofRepetitions = static_cast<size_t>(atol(optarg));
+        break;
+      default:
+        cout << endl
+            << "! ERROR in processing options (getopt returned '" << c
+            << "' = 0x" << std::setbase(16) << c << ")"
+            << endl << endl;
+        exit(1);
+    }
+  }
+  if (nofElements == 0 || nofRepetitions == 0) {
+    cout << "Need at least one element and one repetition." << endl;
+    exit(1);
+  }
+  cout << "Elements in the longest list: about " << nofElements
+       << ", repetitions: " << nofRepetitions << ", AVX2 supported: "
+       << (FTSAlgorithms::cpuSupportsSimd() ? "yes" : "no") << endl << endl;
+
+  std::mt19937_64 rng(42);
+  for (size_t ratio : {1, 2, 4, 8, 16, 32, 64, 256, 1024}) {
+    benchmarkTwoLists(nofElements, ratio, nofRepetitions, rng);
+    cout << endl;
+  }
+  benchmarkKWay(nofElements, nofRepetitions, rng);
+  return 0;
+}
@@ -0,0 +1,271 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <stdlib.h>
+#include <getopt.h>
+#include <algorithm>
+#include <string>
+#include <iomanip>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "global/Constants.h"
+#include "index/CompressedPairBlocks.h"
+#include "util/Simple8bCode.h"
+#include "util/Timer.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+using ad_utility::Simple8bCode;
+
+#define EMPH_ON  "\033[1m"
+#define EMPH_OFF "\033[21m"
+
+// Available options.
+struct option options[] = {
+    {"elements", required_argument, NULL, 'n'},
+    {"repetitions", required_argument, NULL, 'r'},
+    {NULL, 0, NULL, 0}
+};
+
+// Prints the time per run and the throughput for one variant.
+void report(const string& name, const ad_utility::Timer& timer,
+            size_t nofElements, size_t nofRepetitions) {
+  double usecsPerRun = static_cast<double>(timer.usecs()) / nofRepetitions;
+  cout << "  " << std::left << std::setw(32) << name << std::right
+       << std::setw(10) << std::fixed << std::setprecision(1) << usecsPerRun
+       << " us/run" << std::setw(10) << std::setprecision(0)
+       << (usecsPerRun > 0 ? nofElements / usecsPerRun : 0)
+       << " M elements/s" << endl;
+}
+
+// Decodes gap-encoded context ids the way the text index did before the
+// decoding was fused, and with the fused decoder in both code paths.
+void benchmarkGaps(const vector<uint64_t>& encoded, size_t nofElements,
+                   size_t nofRepetitions) {
+  vector<uint64_t> decoded(nofElements + 250);
+  uint64_t checksum = 0;
+  cout << "Gap-encoded context ids:" << endl;
+
+  Simple8bCode::simdEnabled() = false;
+  ad_utility::Timer timer;
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    Simple8bCode::decode(encoded.data(), nofElements, decoded.data());
+    uint64_t id = 0;
+    for (size_t i = 0; i < nofElements; ++i) {
+      id += decoded[i];
+      decoded[i] = id;
+    }
+    checksum += decoded[nofElements - 1];
+  }
+  timer.stop();
+  report("scalar decode + gap pass", timer, nofElements, nofRepetitions);
+
+  timer.reset();
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    Simple8bCode::decodeGaps(encoded.data(), nofElements, decoded.data());
+    checksum += decoded[nofElements - 1];
+  }
+  timer.stop();
+  report("scalar fused", timer, nofElements, nofRepetitions);
+
+  if (Simple8bCode::cpuSupportsSimd()) {
+    Simple8bCode::simdEnabled() = true;
+    timer.reset();
+    timer.start();
+    for (size_t r = 0; r < nofRepetitions; ++r) {
+      Simple8bCode::decodeGaps(encoded.data(), nofElements, decoded.data());
+      checksum += decoded[nofElements - 1];
+    }
+    timer.stop();
+    report("avx2 fused", timer, nofElements, nofRepetitions);
+  }
+  cout << "  (checksum " << checksum << ")" << endl;
+}
+
+// Decodes codebook-encoded scores the way the text index did before the
+// decoding was fused, and with the fused decoder in both code paths.
+void benchmarkCodebook(const vector<uint64_t>& encoded,
+                       const vector<uint16_t>& codebook, size_t nofElements,
+                       size_t nofRepetitions) {
+  vector<uint16_t> decoded(nofElements + 250);
+  uint64_t checksum = 0;
+  cout << "Codebook-encoded scores:" << endl;
+
+  Simple8bCode::simdEnabled() = false;
+  ad_utility::Timer timer;
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    Simple8bCode::decode(encoded.data(), nofElements, decoded.data());
+    for (size_t i = 0; i < nofElements; ++i) {
+      decoded[i] = codebook[decoded[i]];
+    }
+    checksum += decoded[nofElements - 1];
+  }
+  timer.stop();
+  report("scalar decode + codebook pass", timer, nofElements,
+         nofRepetitions);
+
+  timer.reset();
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    Simple8bCode::decodeWithCodebook(encoded.data(), nofElements,
+                                     codebook.data(), decoded.data());
+    checksum += decoded[nofElements - 1];
+  }
+  timer.stop();
+  report("scalar fused", timer, nofElements, nofRepetitions);
+
+  if (Simple8bCode::cpuSupportsSimd()) {
+    Simple8bCode::simdEnabled() = true;
+    timer.reset();
+    timer.start();
+    for (size_t r = 0; r < nofRepetitions; ++r) {
+      Simple8bCode::decodeWithCodebook(encoded.data(), nofElements,
+                                       codebook.data(), decoded.data());
+      checksum += decoded[nofElements - 1];
+    }
+    timer.stop();
+    report("avx2 fused", timer, nofElements, nofRepetitions);
+  }
+  cout << "  (checksum " << checksum << ")" << endl;
+}
+
+// Scans a FullIndex the way Index::readRelation does, once stored as raw
+// pairs and once as compressed pair blocks, in blocks of
+// DISTINCT_LHS_PER_BLOCK pairs like the index builder writes them.
+void benchmarkPairBlocks(const vector<array<Id, 2>>& pairs,
+                         size_t nofRepetitions) {
+  vector<uint64_t> encoded;
+  for (size_t i = 0; i < pairs.size(); i += DISTINCT_LHS_PER_BLOCK) {
+    CompressedPairBlocks::encode(
+        pairs.data() + i, std::min(DISTINCT_LHS_PER_BLOCK, pairs.size() - i),
+        &encoded);
+  }
+  size_t rawBytes = pairs.size() * sizeof(array<Id, 2>);
+  size_t encodedBytes = encoded.size() * sizeof(uint64_t);
+  uint64_t checksum = 0;
+  cout << "FullIndex pairs (" << rawBytes / (1024 * 1024) << " MB raw, "
+       << encodedBytes / (1024 * 1024) << " MB compressed):" << endl;
+
+  vector<array<Id, 2>> decoded;
+  ad_utility::Timer timer;
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    decoded.clear();
+    decoded.resize(pairs.size());
+    memcpy(decoded.data(), pairs.data(), rawBytes);
+    checksum += decoded.back()[1];
+  }
+  timer.stop();
+  report("raw pairs", timer, pairs.size(), nofRepetitions);
+
+  timer.reset();
+  timer.start();
+  for (size_t r = 0; r < nofRepetitions; ++r) {
+    decoded.clear();
+    CompressedPairBlocks::decodeAll(encoded.data(), encodedBytes, &decoded);
+    checksum += decoded.back()[1];
+  }
+  timer.stop();
+  report("compressed pair blocks", timer, pairs.size(), nofRepetitions);
+  cout << "  (checksum " << checksum << ")" << endl;
+}
+
+// Main function.
+int main(int argc, char **argv) {
+  std::cout << std::endl << EMPH_ON
+      << "Simple8bBenchmarkMain, version " << __DATE__
+      << " " << __TIME__ << EMPH_OFF << std::endl << std::endl;
+
+  size_t nofElements = 10 * 1000 * 1000;
+  size_t nofRepetitions = 20;
+
+  optind = 1;
+  // Process command line arguments.
+  while (true) {
+    int c = getopt_long(argc, argv, "n:r:", options, NULL);
+    if (c == -1) break;
+    switch (c) {
+      case 'n':
+        nofElements = static_cast<size_t>(atol(optarg));
+        break;
+      case 'r':
+        nofRepetitions = static_cast<size_t>(atol(optarg));
+        break;
+      default:
+        cout << endl
+            << "! ERROR in processing options (getopt returned '" << c
+            << "' = 0x" << std::setbase(16) << c << ")"
+            << endl << endl;
+        exit(1);
+    }
+  }
+  if (nofElements == 0 || nofRepetitions == 0) {
+    cout << "Need at least one element and one repetition." << endl;
+    exit(1);
+  }
+  cout << "Elements: " << nofElements << ", repetitions: " << nofRepetitions
+       << ", AVX2 supported: "
+       << (Simple8bCode::cpuSupportsSimd() ? "yes" : "no") << endl << endl;
+
+  // Context gaps: several postings per context (gap 0), otherwise mostly
+  // small gaps with an occasional large one, as in our context lists.
+  std::mt19937_64 rng(42);
+  std::geometric_distribution<uint64_t> smallGap(0.2);
+  std::uniform_int_distribution<uint64_t> largeGap(0, 1 << 20);
+  std::uniform_int_distribution<int> percent(0, 99);
+  vector<uint64_t> gaps(nofElements);
+  for (size_t i = 0; i < nofElements; ++i) {
+    int p = percent(rng);
+    gaps[i] = p < 30 ? 0 : (p < 98 ? smallGap(rng) : largeGap(rng));
+  }
+  vector<uint64_t> encoded(nofElements);
+  encoded.resize(Simple8bCode::encode(gaps.data(), nofElements,
+                                      encoded.data()) / sizeof(uint64_t));
+  benchmarkGaps(encoded, nofElements, nofRepetitions);
+  cout << endl;
+
+  // Score codes: codebooks are sorted by frequency, so small codes dominate.
+  vector<uint16_t> codebook(64);
+  for (size_t i = 0; i < codebook.size(); ++i) {
+    codebook[i] = static_cast<uint16_t>(codebook.size() - i);
+  }
+  std::geometric_distribution<uint16_t> code(0.5);
+  vector<uint16_t> codes(nofElements);
+  for (size_t i = 0; i < nofElements; ++i) {
+    codes[i] = std::min<uint16_t>(code(rng), codebook.size() - 1);
+  }
+  encoded.resize(nofElements);
+  encoded.resize(Simple8bCode::encode(codes.data(), nofElements,
+                                      encoded.data()) / sizeof(uint64_t));
+  benchmarkCodebook(encoded, codebook, nofElements, nofRepetitions);
+  cout << endl;
+
+  // Pairs of a relation: increasing LHS with a few RHS each, RHS spread
+  // over the whole vocabulary.
+  std::geometric_distribution<size_t> nofRhs(0.5);
+  std::uniform_int_distribution<Id> rhs(0, 100 * 1000 * 1000);
+  vector<array<Id, 2>> pairs;
+  pairs.reserve(nofElements);
+  Id lhs = 0;
+  while (pairs.size() < nofElements) {
+    lhs += 1 + smallGap(rng);
+    size_t n = std::min(nofRhs(rng) + 1, nofElements - pairs.size());
+    size_t first = pairs.size();
+    for (size_t i = 0; i < n; ++i) {
+      pairs.push_back(array<Id, 2>{{lhs, rhs(rng)}});
+    }
+    std::sort(pairs.begin() + first, pairs.end());
+  }
+  benchmarkPairBlocks(pairs, nofRepetitions);
+  return 0;
+}
@@ -5,10 +5,12 @@
 
 #include <utility>
 #include <vector>
+#include "../global/ValueId.h"
 
 using std::pair;
 using std::vector;
 
+// Orders by the given columns, numbers and dates by their values.
 template<typename E>
 class OBComp {
 public:
@@ -17,8 +19,9 @@ public:
 
   bool operator()(const E& a, const E& b) const {
     for (auto& entry : _sortIndices) {
-      if (a[entry.first] < b[entry.first]) { return !entry.second; }
-      if (a[entry.first] > b[entry.first]) { return entry.second; }
+      int c = ValueId::compare(a[entry.first], b[entry.first]);
+      if (c < 0) { return !entry.second; }
+      if (c > 0) { return entry.second; }
     }
     return a[0] < b[0];
   }
@@ -93,6 +93,57 @@ public:
   static void join(const A& a, size_t jc1, const B& b, size_t jc2,
                    vector<vector<E>>* result);
 
+  //! Joins two relations of (lhs, rhs) pairs on their lhs while reading
+  //! them a block at a time from scans like RelationScan, i.e. anything
+  //! with bool next(vector<array<Id, 2>>* block). Only a block of each and
+  //! the rhs of b for the current lhs are held in memory.
+  //! Appends (lhs, rhs of a, rhs of b) to result, sorted by lhs.
+  template<typename ScanA, typename ScanB>
+  static void joinBlocks(ScanA* a, ScanB* b, vector<array<Id, 3>>* result) {
+    vector<array<Id, 2>> blockA;
+    vector<array<Id, 2>> blockB;
+    size_t i = 0;
+    size_t j = 0;
+    bool moreA = a->next(&blockA);
+    bool moreB = b->next(&blockB);
+    vector<Id> matchesB;
+    while (moreA && moreB) {
+      Id lhsA = blockA[i][0];
+      Id lhsB = blockB[j][0];
+      if (lhsA < lhsB) {
+        // Skip whole blocks where possible.
+        if (blockA.back()[0] < lhsB) {
+          i = 0;
+          moreA = a->next(&blockA);
+        } else {
+          advanceInBlocks(a, &blockA, &i, &moreA);
+        }
+      } else if (lhsB < lhsA) {
+        if (blockB.back()[0] < lhsA) {
+          j = 0;
+          moreB = b->next(&blockB);
+        } else {
+          advanceInBlocks(b, &blockB, &j, &moreB);
+        }
+      } else {
+        // The matches may continue in the next blocks.
+        matchesB.clear();
+        while (moreB && blockB[j][0] == lhsA) {
+          matchesB.push_back(blockB[j][1]);
+          advanceInBlocks(b, &blockB, &j, &moreB);
+        }
+        while (moreA && blockA[i][0] == lhsA) {
+          for (size_t k = 0; k < matchesB.size(); ++k) {
+            result->push_back(array<Id, 3>{{lhsA, blockA[i][1],
+                                            matchesB[k]}});
+          }
+          advanceInBlocks(a, &blockA, &i, &moreA);
+        }
+      }
+    }
+    LOG(DEBUG) << "Block join done, size: " << result->size() << "\n";
+  }
+
   template<typename E, typename A>
   static void selfJoin(const A& a, size_t jc,
                    vector<vector<E>>* result);
@@ -149,17 +200,22 @@ public:
     LOG(DEBUG) << "Sort done.\n";
   }
 
+  // Input that is sorted already, e.g. by a scan, is only checked.
   template<typename E, size_t N, typename C>
   static void sort(vector<array<E, N>>& tab, C comp) {
     LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(), comp);
+    if (!std::is_sorted(tab.begin(), tab.end(), comp)) {
+      std::sort(tab.begin(), tab.end(), comp);
+    }
     LOG(DEBUG) << "Sort done.\n";
   }
 
   template<typename E, typename C>
   static void sort(vector<vector<E>>& tab, C comp) {
     LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(), comp);
+    if (!std::is_sorted(tab.begin(), tab.end(), comp)) {
+      std::sort(tab.begin(), tab.end(), comp);
+    }
     LOG(DEBUG) << "Sort done.\n";
   }
 
@@ -275,6 +331,16 @@ public:
 
 private:
 
+  template<typename Scan>
+  static inline void advanceInBlocks(Scan* scan, vector<array<Id, 2>>* block,
+                                     size_t* pos, bool* more) {
+    if (++*pos == block->size()) {
+      *pos = 0;
+      *more = scan->next(block);
+    }
+  }
+
+
   template<typename E, size_t N, size_t I>
   static vector<array<E, N>> doFilterRelationWithSingleId(
       const vector<array<E, N>>& relation,
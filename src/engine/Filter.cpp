@@ -2,10 +2,12 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <cmath>
 #include <sstream>
 #include <unordered_map>
 #include "./QueryExecutionTree.h"
 #include "./Filter.h"
+#include "../global/ValueId.h"
 
 
 using std::string;
@@ -23,7 +25,21 @@ Filter::Filter(QueryExecutionContext* qec, const QueryExecutionTree& subtree,
     _subtree(new QueryExecutionTree(subtree)),
     _type(type),
     _lhsInd(lhsInd),
-    _rhsInd(rhsInd) {
+    _rhsInd(rhsInd),
+    _rhsIsValue(false) {
+}
+
+// _____________________________________________________________________________
+Filter::Filter(QueryExecutionContext* qec, const QueryExecutionTree& subtree,
+               SparqlFilter::FilterType type, size_t varColumn,
+               const string& value) :
+    Operation(qec),
+    _subtree(new QueryExecutionTree(subtree)),
+    _type(type),
+    _lhsInd(varColumn),
+    _rhsInd(0),
+    _rhsIsValue(true),
+    _rhsValue(value) {
 }
 
 // _____________________________________________________________________________
@@ -32,7 +48,9 @@ Filter::Filter(const Filter& other) :
     _subtree(new QueryExecutionTree(*other._subtree)),
     _type(other._type),
     _lhsInd(other._lhsInd),
-    _rhsInd(other._rhsInd) {
+    _rhsInd(other._rhsInd),
+    _rhsIsValue(other._rhsIsValue),
+    _rhsValue(other._rhsValue) {
 }
 
 // _____________________________________________________________________________
@@ -43,6 +61,8 @@ Filter& Filter::operator=(const Filter& other) {
   _type = other._type;
   _lhsInd = other._lhsInd;
   _rhsInd = other._rhsInd;
+  _rhsIsValue = other._rhsIsValue;
+  _rhsValue = other._rhsValue;
   return *this;
 }
 
@@ -55,6 +75,11 @@ Filter::~Filter() {
 string Filter::asString() const {
   std::ostringstream os;
   os << "FILTER " << _subtree->asString() << " with ";
+  if (_rhsIsValue) {
+    os << "col " << _lhsInd << ' ' << SparqlFilter::typeAsString(_type) << ' '
+       << _rhsValue;
+    return os.str();
+  }
   switch (_type) {
     case SparqlFilter::EQ :
       os << "col " << _lhsInd << " == col " << _rhsInd;
@@ -84,6 +109,12 @@ void Filter::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "Filter result computation..." << endl;
   const ResultTable& subRes = _subtree->getResult();
   result->_nofColumns = subRes._nofColumns;
+  if (_rhsIsValue) {
+    computeResultForValue(subRes, result);
+    result->_status = ResultTable::FINISHED;
+    LOG(DEBUG) << "Filter result computation done." << endl;
+    return;
+  }
   size_t l = _lhsInd;
   size_t r = _rhsInd;
   switch (subRes._nofColumns) {
@@ -97,7 +128,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, res);
           break;
         case SparqlFilter::NE:
@@ -105,7 +137,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, res);
           break;
         case SparqlFilter::LT:
@@ -113,7 +146,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, res);
           break;
         case SparqlFilter::LE:
@@ -121,7 +155,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, res);
           break;
         case SparqlFilter::GT:
@@ -129,7 +164,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, res);
           break;
         case SparqlFilter::GE:
@@ -137,7 +173,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, res);
           break;
       }
@@ -153,7 +190,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, res);
           break;
         case SparqlFilter::NE:
@@ -161,7 +199,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, res);
           break;
         case SparqlFilter::LT:
@@ -169,7 +208,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, res);
           break;
         case SparqlFilter::LE:
@@ -177,7 +217,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, res);
           break;
         case SparqlFilter::GT:
@@ -185,7 +226,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, res);
           break;
         case SparqlFilter::GE:
@@ -193,7 +235,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, res);
           break;
       }
@@ -209,7 +252,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, res);
           break;
         case SparqlFilter::NE:
@@ -217,7 +261,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, res);
           break;
         case SparqlFilter::LT:
@@ -225,7 +270,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, res);
           break;
         case SparqlFilter::LE:
@@ -233,7 +279,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, res);
           break;
         case SparqlFilter::GT:
@@ -241,7 +288,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, res);
           break;
         case SparqlFilter::GE:
@@ -249,7 +297,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, res);
           break;
       }
@@ -265,7 +314,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, res);
           break;
         case SparqlFilter::NE:
@@ -273,7 +323,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, res);
           break;
         case SparqlFilter::LT:
@@ -281,7 +332,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, res);
           break;
         case SparqlFilter::LE:
@@ -289,7 +341,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, res);
           break;
         case SparqlFilter::GT:
@@ -297,7 +350,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, res);
           break;
         case SparqlFilter::GE:
@@ -305,7 +359,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, res);
           break;
       }
@@ -321,7 +376,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, res);
           break;
         case SparqlFilter::NE:
@@ -329,7 +385,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, res);
           break;
         case SparqlFilter::LT:
@@ -337,7 +394,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, res);
           break;
         case SparqlFilter::LE:
@@ -345,7 +403,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, res);
           break;
         case SparqlFilter::GT:
@@ -353,7 +412,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, res);
           break;
         case SparqlFilter::GE:
@@ -361,7 +421,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   *static_cast<vector<RT>*>(subRes._fixedSizeData),
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, res);
           break;
       }
@@ -375,7 +436,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] == e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) == 0;
                   }, &result->_varSizeData);
           break;
         case SparqlFilter::NE:
@@ -383,7 +445,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] != e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) != 0;
                   }, &result->_varSizeData);
           break;
         case SparqlFilter::LT:
@@ -391,7 +454,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] < e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) < 0;
                   }, &result->_varSizeData);
           break;
         case SparqlFilter::LE:
@@ -399,7 +463,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] <= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) <= 0;
                   }, &result->_varSizeData);
           break;
         case SparqlFilter::GT:
@@ -407,7 +472,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] > e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) > 0;
                   }, &result->_varSizeData);
           break;
         case SparqlFilter::GE:
@@ -415,7 +481,8 @@ void Filter::computeResult(ResultTable* result) const {
               .filter(
                   subRes._varSizeData,
                   [&l, &r](const RT& e) {
-                    return e[l] >= e[r];
+                    return ValueId::comparable(e[l], e[r]) &&
+                           ValueId::compare(e[l], e[r]) >= 0;
                   }, &result->_varSizeData);
           break;
       }
@@ -425,3 +492,217 @@ void Filter::computeResult(ResultTable* result) const {
   result->_status = ResultTable::FINISHED;
   LOG(DEBUG) << "Filter result computation done." << endl;
 }
+
+// _____________________________________________________________________________
+void Filter::computeResultForValue(const ResultTable& subRes,
+                                   ResultTable* result) const {
+  bool exact = false;
+  Id value = getIndex().getLowerBoundId(_rhsValue, &exact);
+  switch (subRes._nofColumns) {
+    case 1: {
+      auto res = new vector<array<Id, 1>>();
+      result->_fixedSizeData = res;
+      filterByValue(*static_cast<vector<array<Id, 1>>*>(
+          subRes._fixedSizeData), value, exact, res);
+      break;
+    }
+    case 2: {
+      auto res = new vector<array<Id, 2>>();
+      result->_fixedSizeData = res;
+      filterByValue(*static_cast<vector<array<Id, 2>>*>(
+          subRes._fixedSizeData), value, exact, res);
+      break;
+    }
+    case 3: {
+      auto res = new vector<array<Id, 3>>();
+      result->_fixedSizeData = res;
+      filterByValue(*static_cast<vector<array<Id, 3>>*>(
+          subRes._fixedSizeData), value, exact, res);
+      break;
+    }
+    case 4: {
+      auto res = new vector<array<Id, 4>>();
+      result->_fixedSizeData = res;
+      filterByValue(*static_cast<vector<array<Id, 4>>*>(
+          subRes._fixedSizeData), value, exact, res);
+      break;
+    }
+    case 5: {
+      auto res = new vector<array<Id, 5>>();
+      result->_fixedSizeData = res;
+      filterByValue(*static_cast<vector<array<Id, 5>>*>(
+          subRes._fixedSizeData), value, exact, res);
+      break;
+    }
+    default: {
+      filterByValue(subRes._varSizeData, value, exact,
+                    &result->_varSizeData);
+      break;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+template<typename E>
+void Filter::filterByValue(const vector<E>& input, Id value, bool exact,
+                           vector<E>* res) const {
+  size_t l = _lhsInd;
+  SparqlFilter::FilterType type = _type;
+  getEngine().filter(input, [l, value, exact, type](const E& e) {
+    if (!ValueId::comparable(e[l], value)) {
+      return false;
+    }
+    int cmp = ValueId::compare(e[l], value);
+    // A value not in the vocabulary lies just before its lower bound.
+    if (cmp == 0 && !exact) {
+      cmp = 1;
+    }
+    return satisfies(type, cmp);
+  }, res);
+}
+
+// _____________________________________________________________________________
+bool Filter::satisfies(SparqlFilter::FilterType type, int cmp) {
+  switch (type) {
+    case SparqlFilter::EQ:
+      return cmp == 0;
+    case SparqlFilter::NE:
+      return cmp != 0;
+    case SparqlFilter::LT:
+      return cmp < 0;
+    case SparqlFilter::LE:
+      return cmp <= 0;
+    case SparqlFilter::GT:
+      return cmp > 0;
+    case SparqlFilter::GE:
+      return cmp >= 0;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+bool Filter::getIdRange(SparqlFilter::FilterType type, Id value, bool exact,
+                        IdRange* range) {
+  if (type == SparqlFilter::NE || (exact && ValueId::isNumeric(value))) {
+    return false;
+  }
+  // Only Ids comparable with value can satisfy the filter.
+  Id begin = ValueId::getClassBegin(value);
+  Id end = ValueId::getClassEnd(value);
+  // Empty ranges have _first > _last.
+  *range = IdRange(1, 0);
+  switch (type) {
+    case SparqlFilter::LT:
+      if (value > begin) { *range = IdRange(begin, value - 1); }
+      break;
+    case SparqlFilter::LE:
+      if (exact) {
+        *range = IdRange(begin, value);
+      } else if (value > begin) {
+        *range = IdRange(begin, value - 1);
+      }
+      break;
+    case SparqlFilter::GT:
+      if (!exact) {
+        *range = IdRange(value, end);
+      } else if (value < end) {
+        *range = IdRange(value + 1, end);
+      }
+      break;
+    case SparqlFilter::GE:
+      *range = IdRange(value, end);
+      break;
+    case SparqlFilter::EQ:
+      if (exact) { *range = IdRange(value, value); }
+      break;
+    case SparqlFilter::NE:
+      break;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+bool Filter::getIdRanges(SparqlFilter::FilterType type, Id value, bool exact,
+                         vector<IdRange>* ranges) {
+  ranges->clear();
+  if (!exact || !ValueId::isNumeric(value)) {
+    IdRange range;
+    if (!getIdRange(type, value, exact, &range)) {
+      return false;
+    }
+    ranges->push_back(range);
+    return true;
+  }
+  if (type == SparqlFilter::NE) {
+    return false;
+  }
+  // Ascending like the Ids of the types.
+  const ValueId::Type types[] = {ValueId::INTEGER, ValueId::DECIMAL,
+                                 ValueId::DOUBLE};
+  for (ValueId::Type t : types) {
+    IdRange range = getNumericIdRange(type, value, t);
+    if (range._first <= range._last) {
+      ranges->push_back(range);
+    }
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+IdRange Filter::getNumericIdRange(SparqlFilter::FilterType type, Id value,
+                                  ValueId::Type t) {
+  Id begin = ValueId::make(t, 0);
+  Id end = ValueId::make(t, ValueId::PAYLOAD_MASK);
+  // Ids of type t below lower are smaller than value, those above upper
+  // are larger. Those in between may be anything.
+  Id lower = begin;
+  Id upper = end;
+  bool sameType = ValueId::getType(value) == t;
+  if (sameType) {
+    lower = value;
+    upper = value;
+  } else if (t == ValueId::INTEGER) {
+    // The value is a decimal or double and converts exactly. Out of the
+    // range of integers, begin - 1 and end + 1 make the ranges empty.
+    double d = ValueId::toDouble(value);
+    const double bias = std::ldexp(1.0, ValueId::PAYLOAD_BITS - 1);
+    double ceil = std::ceil(d);
+    double floor = std::floor(d);
+    if (ceil < -bias) {
+      lower = begin;
+    } else if (ceil >= bias) {
+      lower = end + 1;
+    } else {
+      ValueId::fromInteger(static_cast<int64_t>(ceil), &lower);
+    }
+    if (floor < -bias) {
+      upper = begin - 1;
+    } else if (floor >= bias) {
+      upper = end;
+    } else {
+      ValueId::fromInteger(static_cast<int64_t>(floor), &upper);
+    }
+  } else {
+    // Rounding to the nearest double and to the nearest Id keeps the order,
+    // a number below (above) value does not get an Id above (below) this.
+    if (!ValueId::fromDouble(ValueId::toDouble(value), t, &lower)) {
+      return IdRange(begin, end);
+    }
+    upper = lower;
+  }
+  switch (type) {
+    case SparqlFilter::LT:
+      return IdRange(begin, sameType ? upper - 1 : upper);
+    case SparqlFilter::LE:
+      return IdRange(begin, upper);
+    case SparqlFilter::GT:
+      return IdRange(sameType ? lower + 1 : lower, end);
+    case SparqlFilter::GE:
+      return IdRange(lower, end);
+    case SparqlFilter::EQ:
+      return IdRange(lower, upper);
+    case SparqlFilter::NE:
+      break;
+  }
+  return IdRange(begin, end);
+}
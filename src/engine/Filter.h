@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include "./Operation.h"
 #include "./QueryExecutionTree.h"
+#include "../global/ValueId.h"
 #include "../parser/ParsedQuery.h"
 
 using std::list;
@@ -25,6 +26,11 @@ class Filter : public Operation {
     Filter(QueryExecutionContext *qec, const QueryExecutionTree& subtree,
            SparqlFilter::FilterType type, size_t var1Column, size_t var2Column);
 
+    // Compares the variable in varColumn with a constant from the query.
+    Filter(QueryExecutionContext *qec, const QueryExecutionTree& subtree,
+           SparqlFilter::FilterType type, size_t varColumn,
+           const string& value);
+
     Filter(const Filter& other);
 
     Filter& operator=(const Filter& other);
@@ -56,11 +62,46 @@ class Filter : public Operation {
       return getSizeEstimate() + _subtree->getCostEstimate();
     }
 
+    virtual double getMultiplicity(size_t col) const {
+      return _subtree->getMultiplicity(col);
+    }
+
+    // The Ids that satisfy "x type value" for a value that is in the
+    // vocabulary (exact) or for the lower bound of a value that is not,
+    // only those comparable with value (cf. ValueId::comparable).
+    // Returns false if they are no single range, i.e. for != and for
+    // numeric values, which compare with values of the other numeric types.
+    static bool getIdRange(SparqlFilter::FilterType type, Id value,
+                           bool exact, IdRange* range);
+
+    // Like getIdRange, but also for numeric values: for those there is one
+    // range per numeric type, ascending, that contains at least the Ids of
+    // that type which satisfy the filter. Other Ids of a range may not, so
+    // the filter still has to be applied. Returns false for !=.
+    static bool getIdRanges(SparqlFilter::FilterType type, Id value,
+                            bool exact, vector<IdRange>* ranges);
+
   private:
     QueryExecutionTree *_subtree;
     SparqlFilter::FilterType _type;
     size_t _lhsInd;
     size_t _rhsInd;
+    bool _rhsIsValue;
+    string _rhsValue;
 
     virtual void computeResult(ResultTable *result) const;
+
+    void computeResultForValue(const ResultTable& subRes,
+                               ResultTable* result) const;
+
+    template<typename E>
+    void filterByValue(const vector<E>& input, Id value, bool exact,
+                       vector<E>* res) const;
+
+    static bool satisfies(SparqlFilter::FilterType type, int cmp);
+
+    // The range of Ids of the numeric type t that getIdRanges gives for a
+    // numeric value.
+    static IdRange getNumericIdRange(SparqlFilter::FilterType type, Id value,
+                                     ValueId::Type t);
 };
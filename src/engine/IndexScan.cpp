@@ -5,6 +5,7 @@
 #include <string>
 #include <sstream>
 #include "./IndexScan.h"
+#include "./Filter.h"
 
 using std::string;
 
@@ -26,6 +27,26 @@ string IndexScan::asString() const {
     case POS_FREE_O:
       os << "SCAN POS with P = \"" << _predicate << "\"";
       break;
+    case SPO_FREE_P:
+      os << "SCAN SPO with S = \"" << _subject << "\"";
+      break;
+    case SOP_FREE_O:
+      os << "SCAN SOP with S = \"" << _subject << "\"";
+      break;
+    case SOP_BOUND_O:
+      os << "SCAN SOP with S = \"" << _subject << "\", O = \"" << _object <<
+          "\"";
+      break;
+    case OSP_FREE_S:
+      os << "SCAN OSP with O = \"" << _object << "\"";
+      break;
+    case OPS_FREE_P:
+      os << "SCAN OPS with O = \"" << _object << "\"";
+      break;
+  }
+  if (_hasLhsFilter) {
+    os << " and col 0 " << SparqlFilter::typeAsString(_lhsFilterType) << ' '
+       << _lhsFilterValue;
   }
   return os.str();
 }
@@ -35,15 +56,89 @@ size_t IndexScan::getResultWidth() const {
   switch (_type) {
     case PSO_BOUND_S:
     case POS_BOUND_O:
+    case SOP_BOUND_O:
       return 1;
     case PSO_FREE_S:
     case POS_FREE_O:
+    case SPO_FREE_P:
+    case SOP_FREE_O:
+    case OSP_FREE_S:
+    case OPS_FREE_P:
       return 2;
     default:
       return 0;
   }
 }
 
+// _____________________________________________________________________________
+void IndexScan::setLhsFilter(SparqlFilter::FilterType type,
+                             const string& value) {
+  AD_CHECK(_type == PSO_FREE_S || _type == POS_FREE_O);
+  _hasLhsFilter = true;
+  _lhsFilterType = type;
+  _lhsFilterValue = value;
+  if (_sizeEstimate > 0) {
+    precomputeSizeEstimate();
+  }
+}
+
+// _____________________________________________________________________________
+vector<IdRange> IndexScan::getLhsRanges() const {
+  bool exact = false;
+  Id value = getIndex().getLowerBoundId(_lhsFilterValue, &exact);
+  vector<IdRange> ranges;
+  if (!Filter::getIdRanges(_lhsFilterType, value, exact, &ranges)) {
+    AD_THROW(ad_semsearch::Exception::CHECK_FAILED,
+             "Filter cannot be part of a scan: " + asString());
+  }
+  return ranges;
+}
+
+// _____________________________________________________________________________
+void IndexScan::scanLhsRanges(Index::Permutation perm,
+                              vector<array<Id, 2>>* result) const {
+  const Index& index = getIndex();
+  vector<IdRange> ranges = getLhsRanges();
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    // The ranges are ascending, so are their pairs one after the other.
+    vector<array<Id, 2>> pairs;
+    vector<array<Id, 2>>* target = i == 0 ? result : &pairs;
+    if (perm == Index::PSO) {
+      index.scanPSO(_predicate, ranges[i], target);
+    } else {
+      index.scanPOS(_predicate, ranges[i], target);
+    }
+    result->insert(result->end(), pairs.begin(), pairs.end());
+  }
+}
+
+// _____________________________________________________________________________
+bool IndexScan::scansWholeRelation() const {
+  return getResultWidth() == 2 && !_hasLhsFilter;
+}
+
+// _____________________________________________________________________________
+RelationScan IndexScan::getRelationScan(size_t pairsPerBlock) const {
+  const Index& index = getIndex();
+  switch (_type) {
+    case PSO_FREE_S:
+      return index.scanBlocks(Index::PSO, _predicate, pairsPerBlock);
+    case POS_FREE_O:
+      return index.scanBlocks(Index::POS, _predicate, pairsPerBlock);
+    case SPO_FREE_P:
+      return index.scanBlocks(Index::SPO, _subject, pairsPerBlock);
+    case SOP_FREE_O:
+      return index.scanBlocks(Index::SOP, _subject, pairsPerBlock);
+    case OSP_FREE_S:
+      return index.scanBlocks(Index::OSP, _object, pairsPerBlock);
+    case OPS_FREE_P:
+      return index.scanBlocks(Index::OPS, _object, pairsPerBlock);
+    default:
+      AD_THROW(ad_semsearch::Exception::CHECK_FAILED,
+               "Not a scan of a whole relation: " + asString());
+  }
+}
+
 // _____________________________________________________________________________
 void IndexScan::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "IndexScan result computation...\n";
@@ -60,6 +155,21 @@ void IndexScan::computeResult(ResultTable* result) const {
     case POS_FREE_O:
       computePOSfreeO(result);
       break;
+    case SPO_FREE_P:
+      computeSPOfreeP(result);
+      break;
+    case SOP_FREE_O:
+      computeSOPfreeO(result);
+      break;
+    case SOP_BOUND_O:
+      computeSOPboundO(result);
+      break;
+    case OSP_FREE_S:
+      computeOSPfreeS(result);
+      break;
+    case OPS_FREE_P:
+      computeOPSfreeP(result);
+      break;
   }
   LOG(DEBUG) << "IndexScan result computation done.\n";
 }
@@ -79,8 +189,13 @@ void IndexScan::computePSOfreeS(ResultTable* result) const {
   result->_nofColumns = 2;
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
-  _executionContext->getIndex().scanPSO(_predicate,
-      static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  if (_hasLhsFilter) {
+    scanLhsRanges(Index::PSO,
+        static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  } else {
+    _executionContext->getIndex().scanPSO(_predicate,
+        static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  }
   result->_status = ResultTable::FINISHED;
 }
 
@@ -99,7 +214,62 @@ void IndexScan::computePOSfreeO(ResultTable* result) const {
   result->_nofColumns = 2;
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
-  _executionContext->getIndex().scanPOS(_predicate,
+  if (_hasLhsFilter) {
+    scanLhsRanges(Index::POS,
+        static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  } else {
+    _executionContext->getIndex().scanPOS(_predicate,
+        static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  }
+  result->_status = ResultTable::FINISHED;
+}
+
+// _____________________________________________________________________________
+void IndexScan::computeSPOfreeP(ResultTable* result) const {
+  result->_nofColumns = 2;
+  result->_sortedBy = 0;
+  result->_fixedSizeData = new vector<array<Id, 2>>();
+  _executionContext->getIndex().scanSPO(_subject,
+      static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  result->_status = ResultTable::FINISHED;
+}
+
+// _____________________________________________________________________________
+void IndexScan::computeSOPfreeO(ResultTable* result) const {
+  result->_nofColumns = 2;
+  result->_sortedBy = 0;
+  result->_fixedSizeData = new vector<array<Id, 2>>();
+  _executionContext->getIndex().scanSOP(_subject,
+      static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  result->_status = ResultTable::FINISHED;
+}
+
+// _____________________________________________________________________________
+void IndexScan::computeSOPboundO(ResultTable* result) const {
+  result->_nofColumns = 1;
+  result->_sortedBy = 0;
+  result->_fixedSizeData = new vector<array<Id, 1>>();
+  _executionContext->getIndex().scanSOP(_subject, _object,
+      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+  result->_status = ResultTable::FINISHED;
+}
+
+// _____________________________________________________________________________
+void IndexScan::computeOSPfreeS(ResultTable* result) const {
+  result->_nofColumns = 2;
+  result->_sortedBy = 0;
+  result->_fixedSizeData = new vector<array<Id, 2>>();
+  _executionContext->getIndex().scanOSP(_object,
+      static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+  result->_status = ResultTable::FINISHED;
+}
+
+// _____________________________________________________________________________
+void IndexScan::computeOPSfreeP(ResultTable* result) const {
+  result->_nofColumns = 2;
+  result->_sortedBy = 0;
+  result->_fixedSizeData = new vector<array<Id, 2>>();
+  _executionContext->getIndex().scanOPS(_object,
       static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
   result->_status = ResultTable::FINISHED;
 }
@@ -111,15 +281,29 @@ size_t IndexScan::computeSizeEstimate() const {
     switch (_type) {
       case POS_FREE_O:
       case PSO_FREE_S:
+        // The same guess as for a Filter on top of the scan.
+        if (_hasLhsFilter) {
+          return getIndex().relationCardinality(_predicate) /
+              (_lhsFilterType == SparqlFilter::EQ ? 100 : 10);
+        }
         return getIndex().relationCardinality(_predicate);
       case PSO_BOUND_S:
-        // TODO: improve estimate
-        return std::max(size_t(1),
-                        getIndex().relationCardinality(_predicate) / 100);
+        // The fixed LHS is more likely one with many pairs than a uniformly
+        // picked one, which the average assumes.
+        return std::max(size_t(1), static_cast<size_t>(
+            getIndex().pairWeightedLhsMultiplicity(Index::PSO, _predicate)));
       case POS_BOUND_O:
-        // TODO: improve estimate
-        return std::max(size_t(1),
-                        getIndex().relationCardinality(_predicate) / 100);
+        return std::max(size_t(1), static_cast<size_t>(
+            getIndex().pairWeightedLhsMultiplicity(Index::POS, _predicate)));
+      case SPO_FREE_P:
+      case SOP_FREE_O:
+        return getIndex().subjectCardinality(_subject);
+      case OSP_FREE_S:
+      case OPS_FREE_P:
+        return getIndex().objectCardinality(_object);
+      case SOP_BOUND_O:
+        return std::max(size_t(1), static_cast<size_t>(
+            getIndex().pairWeightedLhsMultiplicity(Index::SOP, _subject)));
       default:
         AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
         "Unsupported Scan type.");
@@ -128,3 +312,47 @@ size_t IndexScan::computeSizeEstimate() const {
     return 1000;
   }
 }
+
+// _____________________________________________________________________________
+double IndexScan::getMultiplicity(size_t col) const {
+  if (_multiplicities.size() > 0) {
+    return _multiplicities[col];
+  }
+  return computeMultiplicities()[col];
+}
+
+// _____________________________________________________________________________
+vector<double> IndexScan::computeMultiplicities() const {
+  if (!_executionContext) {
+    return vector<double>(getResultWidth(), 1);
+  }
+  const Index& index = getIndex();
+  // Columns are the LHS and the RHS of the scanned relation. For the LHS
+  // the skew is known from the histogram: a row joins with as many rows
+  // as the LHS of a random pair has, not as many as an average LHS.
+  auto lhsAndRhs = [&index](Index::Permutation perm, const string& key) {
+    return vector<double>{index.pairWeightedLhsMultiplicity(perm, key),
+                          index.averageMultiplicity(perm, key, false)};
+  };
+  switch (_type) {
+    case PSO_BOUND_S:
+    case POS_BOUND_O:
+    case SOP_BOUND_O:
+      // All values of the single column belong to the same fixed term.
+      return vector<double>(1, 1);
+    case PSO_FREE_S:
+      return lhsAndRhs(Index::PSO, _predicate);
+    case POS_FREE_O:
+      return lhsAndRhs(Index::POS, _predicate);
+    case SPO_FREE_P:
+      return lhsAndRhs(Index::SPO, _subject);
+    case SOP_FREE_O:
+      return lhsAndRhs(Index::SOP, _subject);
+    case OSP_FREE_S:
+      return lhsAndRhs(Index::OSP, _object);
+    case OPS_FREE_P:
+      return lhsAndRhs(Index::OPS, _object);
+  }
+  AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
+           "Unsupported Scan type.");
+}
@@ -4,9 +4,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "./Operation.h"
+#include "../parser/ParsedQuery.h"
 
 using std::string;
+using std::vector;
 
 class IndexScan : public Operation {
   public:
@@ -14,13 +17,20 @@ class IndexScan : public Operation {
         PSO_BOUND_S = 0,
         POS_BOUND_O = 1,
         PSO_FREE_S = 2,
-        POS_FREE_O = 3
+        POS_FREE_O = 3,
+        // The following require an index with all permutations.
+        SPO_FREE_P = 4,
+        SOP_FREE_O = 5,
+        SOP_BOUND_O = 6,
+        OSP_FREE_S = 7,
+        OPS_FREE_P = 8
     };
 
     virtual string asString() const;
 
     IndexScan(QueryExecutionContext *qec, ScanType type) :
-        Operation(qec), _type(type), _sizeEstimate(0) {
+        Operation(qec), _type(type), _hasLhsFilter(false),
+        _lhsFilterType(SparqlFilter::EQ), _sizeEstimate(0) {
     }
 
     virtual ~IndexScan() { }
@@ -37,6 +47,21 @@ class IndexScan : public Operation {
       _object = object;
     }
 
+    // Only keeps the pairs whose first column x satisfies "x type value".
+    // For PSO_FREE_S and POS_FREE_O scans and filters for which
+    // Filter::getIdRanges gives ranges, only the blocks of the relation
+    // that overlap them are read. For numeric values the ranges also hold
+    // pairs that do not satisfy the filter, which has to stay on top.
+    void setLhsFilter(SparqlFilter::FilterType type, const string& value);
+
+    bool hasLhsFilter() const {
+      return _hasLhsFilter;
+    }
+
+    ScanType getType() const {
+      return _type;
+    }
+
     virtual size_t getResultWidth() const;
 
     virtual size_t resultSortedOn() const { return 0; }
@@ -58,14 +83,29 @@ class IndexScan : public Operation {
 
     void precomputeSizeEstimate() {
       _sizeEstimate = computeSizeEstimate();
+      _multiplicities = computeMultiplicities();
     }
 
+    virtual double getMultiplicity(size_t col) const;
+
+    // True for the scans of a whole relation of a permutation, those
+    // whose pairs can also be read a block at a time.
+    bool scansWholeRelation() const;
+
+    // The pairs of the result, read a block at a time.
+    // Only for scans of a whole relation.
+    RelationScan getRelationScan(size_t pairsPerBlock) const;
+
   private:
     ScanType _type;
     string _subject;
     string _predicate;
     string _object;
+    bool _hasLhsFilter;
+    SparqlFilter::FilterType _lhsFilterType;
+    string _lhsFilterValue;
     size_t _sizeEstimate;
+    vector<double> _multiplicities;
 
     virtual void computeResult(ResultTable *result) const;
 
@@ -77,6 +117,26 @@ class IndexScan : public Operation {
 
     void computePOSfreeO(ResultTable *result) const;
 
+    void computeSPOfreeP(ResultTable *result) const;
+
+    void computeSOPfreeO(ResultTable *result) const;
+
+    void computeSOPboundO(ResultTable *result) const;
+
+    void computeOSPfreeS(ResultTable *result) const;
+
+    void computeOPSfreeP(ResultTable *result) const;
+
+    // The ranges of Ids the first column is restricted to, ascending.
+    vector<IdRange> getLhsRanges() const;
+
+    // Scans the pairs of the relation in PSO or POS order with a first
+    // column in one of the ranges.
+    void scanLhsRanges(Index::Permutation perm,
+                       vector<array<Id, 2>>* result) const;
+
     size_t computeSizeEstimate() const;
+
+    vector<double> computeMultiplicities() const;
 };
 
@@ -2,6 +2,7 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <algorithm>
 #include <sstream>
 #include <unordered_map>
 #include "./QueryExecutionTree.h"
@@ -73,6 +74,10 @@ string Join::asString() const {
 // _____________________________________________________________________________
 void Join::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "Join result computation..." << endl;
+  if (canJoinBlocks()) {
+    computeResultFromBlocks(result);
+    return;
+  }
   size_t leftWidth = _left->getResultWidth();
   size_t rightWidth = _right->getResultWidth();
   const ResultTable& leftRes = _left->getRootOperation()->getResult();
@@ -331,6 +336,44 @@ void Join::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "Join result computation done." << endl;
 }
 
+// _____________________________________________________________________________
+bool Join::canJoinBlocks() const {
+  if (_leftJoinCol != 0 || _rightJoinCol != 0 ||
+      _left->getType() != QueryExecutionTree::SCAN ||
+      _right->getType() != QueryExecutionTree::SCAN) {
+    return false;
+  }
+  const IndexScan* left =
+      static_cast<const IndexScan*>(_left->getRootOperation());
+  const IndexScan* right =
+      static_cast<const IndexScan*>(_right->getRootOperation());
+  // Results that are there already are cheaper to join in memory.
+  return left->scansWholeRelation() && right->scansWholeRelation() &&
+      !_executionContext->hasCachedResult(left->asString()) &&
+      !_executionContext->hasCachedResult(right->asString());
+}
+
+// _____________________________________________________________________________
+void Join::computeResultFromBlocks(ResultTable* result) const {
+  LOG(DEBUG) << "Joining two relation scans a block at a time." << endl;
+  AD_CHECK(result);
+  AD_CHECK(!result->_fixedSizeData);
+  RelationScan left = static_cast<const IndexScan*>(
+      _left->getRootOperation())->getRelationScan(
+      DEFAULT_PAIRS_PER_SCAN_BLOCK);
+  RelationScan right = static_cast<const IndexScan*>(
+      _right->getRootOperation())->getRelationScan(
+      DEFAULT_PAIRS_PER_SCAN_BLOCK);
+  result->_nofColumns = 3;
+  result->_sortedBy = _leftJoinCol;
+  result->_fixedSizeData = new vector<array<Id, 3>>();
+  _executionContext->getEngine().joinBlocks(&left, &right,
+      static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+  result->_status = ResultTable::FINISHED;
+  LOG(DEBUG) << "Read " << left.getNofPairsRead() << " and "
+             << right.getNofPairsRead() << " pairs." << endl;
+}
+
 // _____________________________________________________________________________
 unordered_map<string, size_t> Join::getVariableColumns() const {
   unordered_map<string, size_t> retVal(_left->getVariableColumnMap());
@@ -355,6 +398,37 @@ size_t Join::getResultWidth() const {
   return res;
 }
 
+// _____________________________________________________________________________
+size_t Join::getSizeEstimate() const {
+  // Each distinct value of the join column on the side with fewer distinct
+  // values is assumed to also occur on the other side:
+  // |L| * |R| / max(distinct(L), distinct(R)).
+  // Scans report the multiplicity of an LHS column weighted by pairs, so
+  // a skewed join column makes the estimate grow towards |L| * max(R).
+  double leftSize = _left->getSizeEstimate();
+  double rightSize = _right->getSizeEstimate();
+  double leftMultiplicity = _left->getMultiplicity(_leftJoinCol);
+  double rightMultiplicity = _right->getMultiplicity(_rightJoinCol);
+  return static_cast<size_t>(std::min(leftSize * rightMultiplicity,
+                                      rightSize * leftMultiplicity));
+}
+
+// _____________________________________________________________________________
+double Join::getMultiplicity(size_t col) const {
+  // Each row matches the average multiplicity of the other side.
+  double leftMultiplicity = _left->getMultiplicity(_leftJoinCol);
+  double rightMultiplicity = _right->getMultiplicity(_rightJoinCol);
+  size_t leftWidth = _left->getResultWidth();
+  if (col < leftWidth) {
+    return _left->getMultiplicity(col) * rightMultiplicity;
+  }
+  col -= leftWidth;
+  if (col >= _rightJoinCol) {
+    ++col;
+  }
+  return _right->getMultiplicity(col) * leftMultiplicity;
+}
+
 // _____________________________________________________________________________
 size_t Join::resultSortedOn() const {
   return _leftJoinCol;
@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include "./Operation.h"
 #include "./QueryExecutionTree.h"
+#include "./IndexScan.h"
 
 using std::list;
 using std::unordered_map;
@@ -38,10 +39,9 @@ class Join : public Operation {
       _right->setTextLimit(limit);
     }
 
-    virtual size_t getSizeEstimate() const {
-      // return std::min(_left->getSizeEstimate(), _right->getSizeEstimate()) / 2;
-      return (_left->getSizeEstimate() + _right->getSizeEstimate()) / 4;
-    }
+    virtual size_t getSizeEstimate() const;
+
+    virtual double getMultiplicity(size_t col) const;
 
     virtual size_t getCostEstimate() const {
       return _left->getSizeEstimate() + _left->getCostEstimate() +
@@ -58,4 +58,11 @@ class Join : public Operation {
     bool _keepJoinColumn;
 
     virtual void computeResult(ResultTable *result) const;
+
+    // True if both sides are scans of a whole relation joined on their
+    // first column, that have not been computed yet. Those are joined
+    // while reading them a block at a time instead.
+    bool canJoinBlocks() const;
+
+    void computeResultFromBlocks(ResultTable *result) const;
 };
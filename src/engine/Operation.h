@@ -67,6 +67,13 @@ class Operation {
     virtual size_t getCostEstimate() const = 0;
     virtual size_t getSizeEstimate() const = 0;
 
+    // Average number of rows per distinct value in a column of the result.
+    // Used for join size estimates, 1 if nothing is known.
+    virtual double getMultiplicity(size_t col) const {
+      (void) col;
+      return 1;
+    }
+
   protected:
 
     QueryExecutionContext *getExecutionContext() const {
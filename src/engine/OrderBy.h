@@ -45,6 +45,10 @@ class OrderBy : public Operation {
       return _subtree->getSizeEstimate();
     }
 
+    virtual double getMultiplicity(size_t col) const {
+      return _subtree->getMultiplicity(col);
+    }
+
     virtual size_t getCostEstimate() const {
       return size_t(getSizeEstimate() * logb(getSizeEstimate()))
              + _subtree->getCostEstimate();
@@ -33,6 +33,11 @@ public:
     return &_subtreeCache[queryAsString];
   }
 
+  bool hasCachedResult(const string& queryAsString) {
+    return _subtreeCache.contains(queryAsString) &&
+        _subtreeCache[queryAsString]._status == ResultTable::FINISHED;
+  }
+
   const Engine& getEngine() const {
     return *_engine;
   }
@@ -43,6 +48,8 @@ public:
 
   void clearCache() {
     _subtreeCache.clear();
+    _index->clearBlockCache();
+    _index->clearPostingListCache();
   }
 
 private:
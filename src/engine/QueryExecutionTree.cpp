@@ -286,6 +286,11 @@ size_t QueryExecutionTree::getSizeEstimate() const {
   return _rootOperation->getSizeEstimate();
 }
 
+// _____________________________________________________________________________
+double QueryExecutionTree::getMultiplicity(size_t col) const {
+  return _rootOperation->getMultiplicity(col);
+}
+
 // _____________________________________________________________________________
 bool QueryExecutionTree::varCovered(string var) const {
   return _variableColumnMap.count(var) > 0;
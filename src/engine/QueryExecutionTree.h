@@ -122,6 +122,8 @@ public:
 
     size_t getSizeEstimate() const;
 
+    double getMultiplicity(size_t col) const;
+
     bool varCovered(string var) const;
 
   private:
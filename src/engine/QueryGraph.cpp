@@ -582,7 +582,9 @@ QueryGraph::Node* QueryGraph::collapseAndCreateExecutionTree() {
       QueryExecutionTree::UNDEFINED) {
     // Should only happen for the special case: pure text query.
     AD_CHECK(root->_isContextNode);
-    root->useContextRootOperation(_textLimit);
+    // Without a TEXTLIMIT all contexts are returned.
+    root->useContextRootOperation(_query._textLimit.size() > 0 ? _textLimit
+                                                               : 0);
   }
   return (getNode(lastUpdatedNode));
 }
@@ -10,6 +10,7 @@
 #include "OrderBy.h"
 #include "Distinct.h"
 #include "Filter.h"
+#include "../global/ValueId.h"
 
 // _____________________________________________________________________________
 QueryPlanner::QueryPlanner(QueryExecutionContext *qec) : _qec(qec) { }
@@ -124,7 +125,10 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::getOrderByRow(
   vector<SubtreePlan> added;
   added.reserve(previous.size());
   for (size_t i = 0; i < previous.size(); ++i) {
-    if (pq._orderBy.size() == 1 && !pq._orderBy[0]._desc) {
+    // Sort and sorted scans order by Id, which only is the order of
+    // values if the column holds no numbers of different types.
+    if (pq._orderBy.size() == 1 && !pq._orderBy[0]._desc &&
+        !mayHoldValues(pq, pq._orderBy[0]._key)) {
       size_t col = previous[i]._qet.getVariableColumn(
           pq._orderBy[0]._key);
       if (col == previous[i]._qet.resultSortedOn()) {
@@ -166,6 +170,19 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::getOrderByRow(
   return added;
 }
 
+// _____________________________________________________________________________
+bool QueryPlanner::mayHoldValues(const ParsedQuery& pq, const string& var) {
+  for (auto& t: pq._whereClauseTriples) {
+    if (t._p == IN_CONTEXT_RELATION || t._p == HAS_CONTEXT_RELATION) {
+      continue;
+    }
+    if (t._s == var || t._p == var) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // _____________________________________________________________________________
 void QueryPlanner::getVarTripleMap(
     const ParsedQuery& pq,
@@ -231,6 +248,39 @@ QueryPlanner::TripleGraph QueryPlanner::createTripleGraph(
   return tg;
 }
 
+// _____________________________________________________________________________
+void QueryPlanner::checkAllPermutations(
+    const QueryPlanner::TripleGraph::Node& node) const {
+  // Without an execution context (only in tests) there is nothing to check.
+  if (_qec && !_qec->getIndex().hasAllPermutations()) {
+    AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
+             "Predicate variables need an index with all permutations. "
+             "Triple in question: " + node._triple.asString());
+  }
+}
+
+// _____________________________________________________________________________
+QueryPlanner::SubtreePlan QueryPlanner::makeScanPlan(
+    size_t nodeId, IndexScan::ScanType type, const string& fixed,
+    const string& firstVar, const string& secondVar) const {
+  SubtreePlan plan(_qec);
+  plan._idsOfIncludedNodes.insert(nodeId);
+  QueryExecutionTree tree(_qec);
+  IndexScan scan(_qec, type);
+  if (type == IndexScan::ScanType::SPO_FREE_P ||
+      type == IndexScan::ScanType::SOP_FREE_O) {
+    scan.setSubject(fixed);
+  } else {
+    scan.setObject(fixed);
+  }
+  scan.precomputeSizeEstimate();
+  tree.setOperation(QueryExecutionTree::OperationType::SCAN, &scan);
+  tree.setVariableColumn(firstVar, 0);
+  tree.setVariableColumn(secondVar, 1);
+  plan._qet = tree;
+  return plan;
+}
+
 // _____________________________________________________________________________
 vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScans(
     const QueryPlanner::TripleGraph& tg) const {
@@ -266,9 +316,14 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScans(
         tree.setVariableColumn(node._triple._o, 0);
       } else {
         // Pred variable.
-        AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
-                 "No predicate vars yet, please. Triple in question: "
-                 + node._triple.asString());
+        checkAllPermutations(node);
+        IndexScan scan(_qec, IndexScan::ScanType::SOP_BOUND_O);
+        scan.setSubject(node._triple._s);
+        scan.setObject(node._triple._o);
+        scan.precomputeSizeEstimate();
+        tree.setOperation(QueryExecutionTree::OperationType::SCAN,
+                          &scan);
+        tree.setVariableColumn(node._triple._p, 0);
       }
       plan._qet = tree;
       seeds.push_back(plan);
@@ -278,9 +333,23 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScans(
       // Add plans for both possible scan directions.
       if (isVariable(node._triple._p)) {
         // Pred variable.
-        AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
-                 "No predicate vars yet, please. Triple in question: "
-                 + node._triple.asString());
+        checkAllPermutations(node);
+        if (isVariable(node._triple._o)) {
+          seeds.push_back(makeScanPlan(i, IndexScan::ScanType::SPO_FREE_P,
+                                       node._triple._s,
+                                       node._triple._p, node._triple._o));
+          seeds.push_back(makeScanPlan(i, IndexScan::ScanType::SOP_FREE_O,
+                                       node._triple._s,
+                                       node._triple._o, node._triple._p));
+        } else {
+          seeds.push_back(makeScanPlan(i, IndexScan::ScanType::OSP_FREE_S,
+                                       node._triple._o,
+                                       node._triple._s, node._triple._p));
+          seeds.push_back(makeScanPlan(i, IndexScan::ScanType::OPS_FREE_P,
+                                       node._triple._o,
+                                       node._triple._p, node._triple._s));
+        }
+        continue;
       }
       {
         SubtreePlan plan(_qec);
@@ -507,26 +576,50 @@ void QueryPlanner::applyFiltersIfPossible(
   // It is possible when,
   // 1) the filter has not already been applied
   // 2) all variables in the filter are covered by the query so far
+  // A filter that compares the first column of a scan with a constant
+  // becomes part of the scan, which then only reads the blocks it needs.
+  // For numbers the filter stays on top of that scan.
   for (size_t n = 0; n < row.size(); ++n) {
     const auto& plan = row[n];
     for (size_t i = 0; i < filters.size(); ++i) {
       if (plan._idsOfIncludedFilters.count(i) > 0) {
         continue;
       }
+      bool rhsIsVar = isVariable(filters[i]._rhs);
       if (plan._qet.varCovered(filters[i]._lhs) &&
-          plan._qet.varCovered(filters[i]._rhs)) {
+          (!rhsIsVar || plan._qet.varCovered(filters[i]._rhs))) {
         // Apply this filter.
         SubtreePlan newPlan(_qec);
         newPlan._idsOfIncludedFilters = plan._idsOfIncludedFilters;
         newPlan._idsOfIncludedFilters.insert(i);
         newPlan._idsOfIncludedNodes = plan._idsOfIncludedNodes;
         QueryExecutionTree tree(_qec);
-        Filter filter(_qec, plan._qet, filters[i]._type,
-                      plan._qet.getVariableColumn(filters[i]._lhs),
-                      plan._qet.getVariableColumn(filters[i]._rhs));
         tree.setVariableColumns(plan._qet.getVariableColumnMap());
-        tree.setOperation(QueryExecutionTree::FILTER, &filter);
         tree.setContextVars(plan._qet.getContextVars());
+        size_t lhsCol = plan._qet.getVariableColumn(filters[i]._lhs);
+        if (!rhsIsVar && lhsCol == 0 && canBePartOfScan(plan, filters[i])) {
+          IndexScan scan(*static_cast<const IndexScan*>(
+              plan._qet.getRootOperation()));
+          scan.setLhsFilter(filters[i]._type, filters[i]._rhs);
+          tree.setOperation(QueryExecutionTree::SCAN, &scan);
+          Id id;
+          if (ValueId::fromString(filters[i]._rhs, &id) &&
+              ValueId::isNumeric(id)) {
+            // The scan reads the numbers of all types around the value,
+            // only the filter compares them with it.
+            Filter filter(_qec, tree, filters[i]._type, lhsCol,
+                          filters[i]._rhs);
+            tree.setOperation(QueryExecutionTree::FILTER, &filter);
+          }
+        } else if (!rhsIsVar) {
+          Filter filter(_qec, plan._qet, filters[i]._type, lhsCol,
+                        filters[i]._rhs);
+          tree.setOperation(QueryExecutionTree::FILTER, &filter);
+        } else {
+          Filter filter(_qec, plan._qet, filters[i]._type, lhsCol,
+                        plan._qet.getVariableColumn(filters[i]._rhs));
+          tree.setOperation(QueryExecutionTree::FILTER, &filter);
+        }
         newPlan._qet = tree;
         row[n] = newPlan;
       }
@@ -534,6 +627,20 @@ void QueryPlanner::applyFiltersIfPossible(
   }
 }
 
+// _____________________________________________________________________________
+bool QueryPlanner::canBePartOfScan(const SubtreePlan& plan,
+                                   const SparqlFilter& filter) const {
+  if (plan._qet.getType() != QueryExecutionTree::SCAN) {
+    return false;
+  }
+  auto scan = static_cast<const IndexScan*>(plan._qet.getRootOperation());
+  if (scan->hasLhsFilter() || !(scan->getType() == IndexScan::PSO_FREE_S ||
+                                scan->getType() == IndexScan::POS_FREE_O)) {
+    return false;
+  }
+  return filter._type != SparqlFilter::NE;
+}
+
 // _____________________________________________________________________________
 vector<vector<QueryPlanner::SubtreePlan>> QueryPlanner::fillDpTab(
     const QueryPlanner::TripleGraph& tg,
@@ -606,7 +713,7 @@ void QueryPlanner::TripleGraph::splitAtText(
   }
   vector<SparqlFilter> filtersWithoutContextVars;
   for (auto& f : origFilters) {
-    if (contextVars.count(f._lhs) > 0 || contextVars.count(f._lhs) > 0) {
+    if (contextVars.count(f._lhs) > 0 || contextVars.count(f._rhs) > 0) {
       filtersWithContextVars.push_back(f);
     } else {
       filtersWithoutContextVars.push_back(f);
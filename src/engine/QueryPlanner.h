@@ -6,6 +6,7 @@
 #include <vector>
 #include "../parser/ParsedQuery.h"
 #include "QueryExecutionTree.h"
+#include "IndexScan.h"
 
 using std::vector;
 
@@ -90,6 +91,15 @@ class QueryPlanner {
 
     vector<SubtreePlan> seedWithScans(const TripleGraph& tg) const;
 
+    // Throws if the triple of node needs more than PSO and POS.
+    void checkAllPermutations(const TripleGraph::Node& node) const;
+
+    // Creates a plan for a scan with one fixed element (subject or object,
+    // depending on the type) and two variables in the result columns.
+    SubtreePlan makeScanPlan(size_t nodeId, IndexScan::ScanType type,
+                             const string& fixed, const string& firstVar,
+                             const string& secondVar) const;
+
     vector<SubtreePlan> merge(const vector<SubtreePlan>& a,
                               const vector<SubtreePlan>& b,
                               const TripleGraph& tg) const;
@@ -98,6 +108,10 @@ class QueryPlanner {
         const ParsedQuery& pq,
         const vector<vector<SubtreePlan>>& dpTab) const;
 
+    // False if var is the subject or predicate of a triple, it cannot be
+    // bound to literals and thus not to numbers or dates.
+    static bool mayHoldValues(const ParsedQuery& pq, const string& var);
+
     bool connected(const SubtreePlan& a, const SubtreePlan& b,
                    const TripleGraph& graph) const;
 
@@ -109,6 +123,12 @@ class QueryPlanner {
     void applyFiltersIfPossible(vector<SubtreePlan>& row,
                                 const vector<SparqlFilter>& filters) const;
 
+    // True if the plan is a scan of a relation that can restrict its first
+    // column by the filter with a constant itself, see
+    // IndexScan::setLhsFilter.
+    bool canBePartOfScan(const SubtreePlan& plan,
+                         const SparqlFilter& filter) const;
+
     vector<vector<SubtreePlan>> fillDpTab(const TripleGraph& graph,
                                           const vector<SparqlFilter>& fs) const;
 };
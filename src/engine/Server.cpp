@@ -112,6 +112,8 @@ void Server::process(Socket *client, QueryExecutionContext *qec) const {
       const QueryExecutionTree& qet = qg.getExecutionTree();
       response = composeResponseJson(pq, qet);
       contentType = "application/json";
+      LOG(INFO) << _index.blockCacheStatistics() << '\n';
+      LOG(INFO) << _index.postingListCacheStatistics() << '\n';
     } catch (const ad_semsearch::Exception& e) {
       response = composeResponseJson(query, e);
     } catch (const ParseException& e) {
@@ -40,6 +40,10 @@ class Sort : public Operation {
       return _subtree->getSizeEstimate();
     }
 
+    virtual double getMultiplicity(size_t col) const {
+      return _subtree->getMultiplicity(col);
+    }
+
     virtual size_t getCostEstimate() const {
       size_t size = getSizeEstimate();
       size_t logSize = std::max(size_t(1),
@@ -38,7 +38,9 @@ string TextOperationForContexts::asString() const {
     os << "\n\tand " << _subtrees[i].first.asString() << " [" <<
     _subtrees[i].second << "]";
   }
-  os << " with textLimit = " << _textLimit;
+  if (_textLimit > 0) {
+    os << " with textLimit = " << _textLimit;
+  }
   return os.str();
 }
 
@@ -48,9 +50,16 @@ void TextOperationForContexts::computeResult(ResultTable* result) const {
   if (_subtrees.size() == 0) {
     result->_nofColumns = 2;
     result->_fixedSizeData = new vector<array<Id, 2>>;
-    getExecutionContext()->getIndex().getContextListForWords(
-        _words,
-        reinterpret_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+    if (_textLimit > 0) {
+      // Only reads the parts of the lists that may hold one of the best.
+      getExecutionContext()->getIndex().getTopKContextsForWords(
+          _words, _textLimit,
+          reinterpret_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+    } else {
+      getExecutionContext()->getIndex().getContextListForWords(
+          _words,
+          reinterpret_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+    }
   } else {
     AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
              "Complex text query is a todo for the future.");
@@ -3,6 +3,7 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 #pragma once
 
+#include <algorithm>
 #include <list>
 #include <utility>
 #include <vector>
@@ -41,7 +42,7 @@ class TextOperationForContexts : public Operation {
       if (_executionContext) {
         // TODO: return a better estimate!
       }
-      return 10000;
+      return _textLimit > 0 ? std::min(_textLimit, size_t(10000)) : 10000;
     }
 
     virtual size_t getCostEstimate() const {
@@ -55,6 +56,7 @@ class TextOperationForContexts : public Operation {
   private:
     string _words;
     vector<pair<QueryExecutionTree, size_t>> _subtrees;
+    // The number of contexts with the highest scores to return, 0 for all.
     size_t _textLimit;
 
     virtual void computeResult(ResultTable *result) const;
@@ -6,15 +6,30 @@
 static const int STXXL_MEMORY_TO_USE = 1024 * 1024 * 1024;
 static const int STXXL_DISK_SIZE_INDEX_BUILDER = 300000;
 static const int STXXL_DISK_SIZE_INDEX_TEST = 10;
+static const size_t DEFAULT_VOCABULARY_MEMORY_BUDGET =
+    size_t(4) * 1024 * 1024 * 1024;
+static const size_t VOCABULARY_BLOCK_SIZE = 16;
+static const size_t MAX_INLINE_LITERAL_SIZE = 128;
+static const size_t EXTERNAL_LITERAL_PREFIX_SIZE = 32;
 
 static const size_t NOF_SUBTREES_TO_CACHE = 50;
+static const size_t DEFAULT_BLOCK_CACHE_CAPACITY = 256 * 1024 * 1024;
+static const size_t DEFAULT_POSTING_LIST_CACHE_CAPACITY = 64 * 1024 * 1024;
 static const size_t MAX_NOF_ROWS_IN_RESULT = 1000000;
 static const size_t MIN_WORD_PREFIX_SIZE = 4;
 static const char PREFIX_CHAR = '*';
+static const size_t TEXT_SUB_BLOCK_SIZE = 256;
 
 static const size_t BUFFER_SIZE_RELATION_SIZE = 1000 * 1000 * 1000;
 static const size_t BUFFER_SIZE_DOCSFILE_LINE = 1024 * 1024 * 100;
+static const size_t BUFFER_SIZE_VOCABULARY_WRITER = 1024 * 1024 * 8;
+static const size_t PARSER_CHUNK_SIZE = 1024 * 1024 * 16;
 static const size_t DISTINCT_LHS_PER_BLOCK = 10 * 1000;
+static const size_t MIN_PAIRS_FOR_ASYNC_ENCODE = 100 * 1000;
+static const size_t MAX_PAIRS_PENDING_ENCODE = 1024 * 1024 * 64;
+static const size_t DEFAULT_PAIRS_PER_SCAN_BLOCK = 64 * 1024;
+static const size_t DELTA_COMPACTION_THRESHOLD = 1000 * 1000;
+static const size_t LHS_FILTER_BITS_PER_KEY = 10;
 
 static const size_t IN_CONTEXT_CARDINALITY_ESTIMATE = 1000 * 1000 * 1000;
 
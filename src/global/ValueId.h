@@ -0,0 +1,506 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include "./Id.h"
+
+using std::string;
+
+//! Ids that hold a value instead of referring to the vocabulary.
+//! The upper TYPE_BITS of an Id are its type, vocabulary Ids have type 0.
+//! The payload of each type is encoded such that Ids of the same type
+//! compare like their values, so filters and sorts need no vocabulary.
+//!
+//! INTEGER:  xsd:integer, value + 2^59.
+//! DECIMAL:  xsd:decimal, the upper 60 bits of the double with flipped
+//!           sign (negative: all bits) so that unsigned order is value order.
+//! DOUBLE:   xsd:double, like DECIMAL.
+//! DATE:     xsd:date and xsd:dateTime without or with UTC ("Z") time zone.
+//!           year + 2^19 (20 bits), month (4), day (5), hour (5),
+//!           minute (6), second (6), millisecond (10), hasTime (1), utc (1).
+//!
+//! Values are canonicalized: "007"^^xsd:integer becomes "7"^^xsd:integer.
+//! Literals that cannot be represented stay in the vocabulary, also
+//! decimals that would not print as the same decimal and doubles that would
+//! not parse back to the same double after rounding to 60 bits. Such
+//! literals are vocabulary words like any other: they are ordered as words
+//! and cannot be compared to numbers or dates.
+class ValueId {
+public:
+  enum Type {
+    VOCAB = 0, INTEGER = 1, DECIMAL = 2, DOUBLE = 3, DATE = 4
+  };
+
+  static const int TYPE_BITS = 4;
+  static const int PAYLOAD_BITS = 64 - TYPE_BITS;
+  static const uint64_t PAYLOAD_MASK = (uint64_t(1) << PAYLOAD_BITS) - 1;
+
+  static Type getType(Id id) {
+    return static_cast<Type>(id >> PAYLOAD_BITS);
+  }
+
+  static bool isValue(Id id) {
+    return getType(id) != VOCAB;
+  }
+
+  static bool isNumeric(Id id) {
+    Type t = getType(id);
+    return t == INTEGER || t == DECIMAL || t == DOUBLE;
+  }
+
+  static Id make(Type type, uint64_t payload) {
+    return (static_cast<uint64_t>(type) << PAYLOAD_BITS) |
+           (payload & PAYLOAD_MASK);
+  }
+
+  // ___________________________________________________________________________
+  static bool fromInteger(int64_t value, Id* id) {
+    const int64_t bias = int64_t(1) << (PAYLOAD_BITS - 1);
+    if (value < -bias || value >= bias) {
+      return false;
+    }
+    *id = make(INTEGER, static_cast<uint64_t>(value + bias));
+    return true;
+  }
+
+  static int64_t toInteger(Id id) {
+    const int64_t bias = int64_t(1) << (PAYLOAD_BITS - 1);
+    return static_cast<int64_t>(id & PAYLOAD_MASK) - bias;
+  }
+
+  // ___________________________________________________________________________
+  static bool fromDouble(double value, Type type, Id* id) {
+    if (std::isnan(value) || std::isinf(value)) {
+      return false;
+    }
+    if (value == 0) {
+      // Do not distinguish -0 and 0.
+      value = 0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t sign = uint64_t(1) << 63;
+    bits = (bits & sign) ? ~bits : (bits | sign);
+    // Round to the nearest representable value.
+    uint64_t payload = bits >> TYPE_BITS;
+    if ((bits & ((uint64_t(1) << TYPE_BITS) - 1)) >=
+        (uint64_t(1) << (TYPE_BITS - 1)) && payload < PAYLOAD_MASK) {
+      ++payload;
+    }
+    *id = make(type, payload);
+    return true;
+  }
+
+  // Value of any numeric Id as double.
+  static double toDouble(Id id) {
+    if (getType(id) == INTEGER) {
+      return static_cast<double>(toInteger(id));
+    }
+    uint64_t bits = (id & PAYLOAD_MASK) << TYPE_BITS;
+    const uint64_t sign = uint64_t(1) << 63;
+    bits = (bits & sign) ? (bits & ~sign) : ~bits;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // ___________________________________________________________________________
+  //! Compares two Ids. Ids of the same type (and vocabulary Ids) compare
+  //! as integers, numbers of different types by their exact values.
+  //! Returns a value < 0, 0 or > 0 like strcmp.
+  static int compare(Id a, Id b) {
+    if (getType(a) != getType(b) && isNumeric(a) && isNumeric(b)) {
+      if (getType(a) == INTEGER) {
+        return compareToDouble(toInteger(a), toDouble(b));
+      }
+      if (getType(b) == INTEGER) {
+        return -compareToDouble(toInteger(b), toDouble(a));
+      }
+      double da = toDouble(a);
+      double db = toDouble(b);
+      return da < db ? -1 : (db < da ? 1 : 0);
+    }
+    return a < b ? -1 : (b < a ? 1 : 0);
+  }
+
+  //! Whether a FILTER can compare two Ids. Numbers compare with numbers,
+  //! dates with dates and vocabulary words with words. Anything else is a
+  //! type error in SPARQL, which removes the row.
+  static bool comparable(Id a, Id b) {
+    return getClassBegin(a) == getClassBegin(b);
+  }
+
+  //! The smallest and the largest Id that is comparable with id.
+  static Id getClassBegin(Id id) {
+    return make(isNumeric(id) ? INTEGER : getType(id), 0);
+  }
+
+  static Id getClassEnd(Id id) {
+    return make(isNumeric(id) ? DOUBLE : getType(id), PAYLOAD_MASK);
+  }
+
+  //! Compares an integer and a double exactly. Converting the integer to
+  //! double rounds above 2^53, which makes the order intransitive.
+  static int compareToDouble(int64_t value, double d) {
+    // The integral part of d, exact and within the range of int64_t.
+    double integral = std::trunc(d);
+    const double limit = std::ldexp(1.0, 63);
+    if (integral >= limit) {
+      return -1;
+    }
+    if (integral < -limit) {
+      return 1;
+    }
+    int64_t i = static_cast<int64_t>(integral);
+    if (value != i) {
+      return value < i ? -1 : 1;
+    }
+    double fraction = d - integral;
+    return fraction > 0 ? -1 : (fraction < 0 ? 1 : 0);
+  }
+
+  // ___________________________________________________________________________
+  //! Parses a typed literal like "42"^^<http://www.w3.org/2001/XMLSchema#integer>
+  //! or "42"^^xsd:integer. Returns false if it is none of the supported
+  //! types or cannot be represented.
+  static bool fromString(const string& literal, Id* id) {
+    if (literal.size() < 6 || literal[0] != '"') {
+      return false;
+    }
+    size_t end = literal.rfind("\"^^");
+    if (end == string::npos || end == 0) {
+      return false;
+    }
+    string lexical = literal.substr(1, end - 1);
+    string type = literal.substr(end + 3);
+    if (type.size() > 2 && type[0] == '<' && type[type.size() - 1] == '>') {
+      type = type.substr(1, type.size() - 2);
+      if (type.compare(0, strlen(XSD_PREFIX), XSD_PREFIX) != 0) {
+        return false;
+      }
+      type = type.substr(strlen(XSD_PREFIX));
+    } else if (type.compare(0, 4, "xsd:") == 0) {
+      type = type.substr(4);
+    } else {
+      return false;
+    }
+    if (type == "integer") {
+      return parseInteger(lexical, id);
+    } else if (type == "decimal") {
+      return parseDecimal(lexical, DECIMAL, id);
+    } else if (type == "double") {
+      return parseDecimal(lexical, DOUBLE, id);
+    } else if (type == "date") {
+      return parseDate(lexical, false, id);
+    } else if (type == "dateTime") {
+      return parseDate(lexical, true, id);
+    }
+    return false;
+  }
+
+  // ___________________________________________________________________________
+  //! The typed literal of a number written without datatype as in SPARQL:
+  //! 10 is an xsd:integer, 1.5 an xsd:decimal and 1e3 an xsd:double.
+  //! Returns false if s is no such number.
+  static bool typedLiteralForNumber(const string& s, string* literal) {
+    size_t i = (s.size() > 0 && (s[0] == '+' || s[0] == '-')) ? 1 : 0;
+    size_t digits = 0;
+    bool point = false;
+    for (; i < s.size(); ++i) {
+      if (s[i] >= '0' && s[i] <= '9') {
+        ++digits;
+      } else if (s[i] == '.' && !point) {
+        point = true;
+      } else {
+        break;
+      }
+    }
+    if (digits == 0) {
+      return false;
+    }
+    bool exponent = i < s.size() && (s[i] == 'e' || s[i] == 'E');
+    if (exponent) {
+      ++i;
+      if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+        ++i;
+      }
+      size_t expDigits = 0;
+      for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        ++expDigits;
+      }
+      if (expDigits == 0) {
+        return false;
+      }
+    }
+    if (i != s.size()) {
+      return false;
+    }
+    *literal = typed(s, exponent ? "double" : (point ? "decimal" : "integer"));
+    return true;
+  }
+
+  // ___________________________________________________________________________
+  //! The typed literal of a value Id, with the full datatype IRI.
+  static string toString(Id id) {
+    char buf[64];
+    switch (getType(id)) {
+      case INTEGER:
+        snprintf(buf, sizeof(buf), "%lld",
+                 static_cast<long long>(toInteger(id)));
+        return typed(buf, "integer");
+      case DECIMAL:
+        return typed(shortestDouble(id, "%.*f", 0, 20), "decimal");
+      case DOUBLE:
+        return typed(shortestDouble(id, "%.*g", 1, 17), "double");
+      case DATE:
+        return dateToString(id);
+      default:
+        return "";
+    }
+  }
+
+private:
+  static constexpr const char* XSD_PREFIX =
+      "http://www.w3.org/2001/XMLSchema#";
+
+  static string typed(const string& lexical, const char* type) {
+    return "\"" + lexical + "\"^^<" + XSD_PREFIX + type + ">";
+  }
+
+  // ___________________________________________________________________________
+  static bool parseInteger(const string& s, Id* id) {
+    size_t i = (s.size() > 0 && (s[0] == '+' || s[0] == '-')) ? 1 : 0;
+    if (i == s.size() || s.size() - i > 18) {
+      return false;
+    }
+    for (size_t j = i; j < s.size(); ++j) {
+      if (s[j] < '0' || s[j] > '9') {
+        return false;
+      }
+    }
+    return fromInteger(strtoll(s.c_str(), nullptr, 10), id);
+  }
+
+  // ___________________________________________________________________________
+  static bool parseDecimal(const string& s, Type type, Id* id) {
+    // Digits with an optional sign and point, doubles also with exponent.
+    size_t i = (s.size() > 0 && (s[0] == '+' || s[0] == '-')) ? 1 : 0;
+    size_t digits = 0;
+    bool point = false;
+    for (; i < s.size(); ++i) {
+      if (s[i] >= '0' && s[i] <= '9') {
+        ++digits;
+      } else if (s[i] == '.' && !point) {
+        point = true;
+      } else {
+        break;
+      }
+    }
+    if (digits == 0) {
+      return false;
+    }
+    if (i < s.size() && type == DOUBLE && (s[i] == 'e' || s[i] == 'E')) {
+      ++i;
+      if (i < s.size() && (s[i] == '+' || s[i] == '-')) {
+        ++i;
+      }
+      size_t expDigits = 0;
+      for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        ++expDigits;
+      }
+      if (expDigits == 0) {
+        return false;
+      }
+    }
+    if (i != s.size()) {
+      return false;
+    }
+    double value = strtod(s.c_str(), nullptr);
+    Id result;
+    if (!fromDouble(value, type, &result)) {
+      return false;
+    }
+    // Only values that come back unchanged, others stay in the vocabulary
+    // like integers with too many digits. Decimals have to print as the
+    // same decimal, doubles as the same double.
+    if (type == DECIMAL) {
+      if (shortestDouble(result, "%.*f", 0, 20) != canonicalDecimal(s)) {
+        return false;
+      }
+    } else if (strtod(shortestDouble(result, "%.*g", 1, 17).c_str(),
+                      nullptr) != value) {
+      return false;
+    }
+    *id = result;
+    return true;
+  }
+
+  // The lexical form of a decimal without plus sign, leading zeros before
+  // and trailing zeros after the point, and without point for integers.
+  static string canonicalDecimal(const string& s) {
+    size_t begin = (s[0] == '+' || s[0] == '-') ? 1 : 0;
+    size_t point = s.find('.');
+    if (point == string::npos) {
+      point = s.size();
+    }
+    string integral = s.substr(begin, point - begin);
+    string fraction = point < s.size() ? s.substr(point + 1) : "";
+    integral.erase(0, integral.find_first_not_of('0'));
+    fraction.erase(fraction.find_last_not_of('0') + 1);
+    string result = integral.empty() ? "0" : integral;
+    if (!fraction.empty()) {
+      result += "." + fraction;
+    }
+    return s[0] == '-' && result != "0" ? "-" + result : result;
+  }
+
+  // Shortest output of format with increasing precision that encodes
+  // to the same Id.
+  static string shortestDouble(Id id, const char* format, int minPrecision,
+                               int maxPrecision) {
+    double value = toDouble(id);
+    char buf[512];
+    for (int p = minPrecision; p <= maxPrecision; ++p) {
+      snprintf(buf, sizeof(buf), format, p, value);
+      Id other;
+      if (fromDouble(strtod(buf, nullptr), getType(id), &other) &&
+          other == id) {
+        return buf;
+      }
+    }
+    snprintf(buf, sizeof(buf), "%.17g", value);
+    return buf;
+  }
+
+  // ___________________________________________________________________________
+  // Reads exactly n digits at s[*i].
+  static bool readDigits(const string& s, size_t* i, size_t n, int* value) {
+    if (*i + n > s.size()) {
+      return false;
+    }
+    *value = 0;
+    for (size_t j = 0; j < n; ++j, ++*i) {
+      if (s[*i] < '0' || s[*i] > '9') {
+        return false;
+      }
+      *value = *value * 10 + (s[*i] - '0');
+    }
+    return true;
+  }
+
+  // ___________________________________________________________________________
+  static bool parseDate(const string& s, bool withTime, Id* id) {
+    size_t i = 0;
+    bool negative = s.size() > 0 && s[0] == '-';
+    if (negative) {
+      ++i;
+    }
+    // At least four digits for the year.
+    size_t yearDigits = 0;
+    while (i + yearDigits < s.size() && s[i + yearDigits] >= '0' &&
+           s[i + yearDigits] <= '9') {
+      ++yearDigits;
+    }
+    int year, month, day, hour = 0, minute = 0, second = 0, millis = 0;
+    if (yearDigits < 4 || yearDigits > 6 ||
+        !readDigits(s, &i, yearDigits, &year) ||
+        i >= s.size() || s[i++] != '-' || !readDigits(s, &i, 2, &month) ||
+        i >= s.size() || s[i++] != '-' || !readDigits(s, &i, 2, &day)) {
+      return false;
+    }
+    if (withTime) {
+      if (i >= s.size() || s[i++] != 'T' || !readDigits(s, &i, 2, &hour) ||
+          i >= s.size() || s[i++] != ':' || !readDigits(s, &i, 2, &minute) ||
+          i >= s.size() || s[i++] != ':' || !readDigits(s, &i, 2, &second)) {
+        return false;
+      }
+      if (i < s.size() && s[i] == '.') {
+        ++i;
+        size_t fractionDigits = 0;
+        int digit;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+          if (fractionDigits >= 3) {
+            // No more than milliseconds.
+            return false;
+          }
+          readDigits(s, &i, 1, &digit);
+          millis = millis * 10 + digit;
+          ++fractionDigits;
+        }
+        if (fractionDigits == 0) {
+          return false;
+        }
+        for (; fractionDigits < 3; ++fractionDigits) {
+          millis *= 10;
+        }
+      }
+    }
+    bool utc = i < s.size() && s[i] == 'Z';
+    if (utc) {
+      ++i;
+    }
+    if (i != s.size() || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 59) {
+      return false;
+    }
+    int64_t biasedYear = (negative ? -year : year) + (int64_t(1) << 19);
+    if (biasedYear < 0 || biasedYear >= (int64_t(1) << 20)) {
+      return false;
+    }
+    uint64_t payload = static_cast<uint64_t>(biasedYear);
+    payload = (payload << 4) | static_cast<uint64_t>(month);
+    payload = (payload << 5) | static_cast<uint64_t>(day);
+    payload = (payload << 5) | static_cast<uint64_t>(hour);
+    payload = (payload << 6) | static_cast<uint64_t>(minute);
+    payload = (payload << 6) | static_cast<uint64_t>(second);
+    payload = (payload << 10) | static_cast<uint64_t>(millis);
+    payload = (payload << 1) | (withTime ? 1 : 0);
+    payload = (payload << 1) | (utc ? 1 : 0);
+    *id = make(DATE, payload);
+    return true;
+  }
+
+  // ___________________________________________________________________________
+  static string dateToString(Id id) {
+    uint64_t payload = id & PAYLOAD_MASK;
+    bool utc = payload & 1;
+    payload >>= 1;
+    bool withTime = payload & 1;
+    payload >>= 1;
+    int millis = static_cast<int>(payload & 1023);
+    payload >>= 10;
+    int second = static_cast<int>(payload & 63);
+    payload >>= 6;
+    int minute = static_cast<int>(payload & 63);
+    payload >>= 6;
+    int hour = static_cast<int>(payload & 31);
+    payload >>= 5;
+    int day = static_cast<int>(payload & 31);
+    payload >>= 5;
+    int month = static_cast<int>(payload & 15);
+    payload >>= 4;
+    long long year = static_cast<long long>(payload) - (1LL << 19);
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "%s%04lld-%02d-%02d",
+                       year < 0 ? "-" : "", year < 0 ? -year : year,
+                       month, day);
+    if (withTime) {
+      len += snprintf(buf + len, sizeof(buf) - len, "T%02d:%02d:%02d",
+                      hour, minute, second);
+      if (millis > 0) {
+        len += snprintf(buf + len, sizeof(buf) - len, ".%03d", millis);
+      }
+    }
+    if (utc) {
+      snprintf(buf + len, sizeof(buf) - len, "Z");
+    }
+    return typed(buf, withTime ? "dateTime" : "date");
+  }
+};
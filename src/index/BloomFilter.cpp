@@ -0,0 +1,57 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <algorithm>
+#include <cmath>
+#include "./BloomFilter.h"
+
+// _____________________________________________________________________________
+size_t BloomFilter::build(const vector<Id>& keys, size_t bitsPerKey,
+                          vector<uint64_t>* words) {
+  size_t nofBits = std::max(size_t(64), keys.size() * bitsPerKey);
+  words->assign((nofBits + 63) / 64, 0);
+  // Optimal number of hash functions for the number of bits per key.
+  size_t nofHashes = std::max(size_t(1), static_cast<size_t>(
+      std::round(bitsPerKey * std::log(2.0))));
+  nofBits = words->size() * 64;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    uint64_t h = hash(keys[i]);
+    uint64_t h1 = h & 0xFFFFFFFF;
+    uint64_t h2 = (h >> 32) | 1;
+    for (size_t j = 0; j < nofHashes; ++j) {
+      uint64_t bit = (h1 + j * h2) % nofBits;
+      (*words)[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+  }
+  return nofHashes;
+}
+
+// _____________________________________________________________________________
+bool BloomFilter::mayContain(Id key) const {
+  if (empty()) {
+    return true;
+  }
+  uint64_t nofBits = _nofWords * 64;
+  uint64_t h = hash(key);
+  uint64_t h1 = h & 0xFFFFFFFF;
+  uint64_t h2 = (h >> 32) | 1;
+  for (size_t j = 0; j < _nofHashes; ++j) {
+    uint64_t bit = (h1 + j * h2) % nofBits;
+    if ((_words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+uint64_t BloomFilter::hash(Id key) {
+  // Murmur finalizer, Ids themselves are far from random.
+  key ^= key >> 33;
+  key *= 0xFF51AFD7ED558CCDULL;
+  key ^= key >> 33;
+  key *= 0xC4CEB9FE1A85EC53ULL;
+  key ^= key >> 33;
+  return key;
+}
@@ -0,0 +1,53 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "../global/Id.h"
+
+using std::vector;
+
+//! Bloom filter over Ids, used for the LHS of a relation.
+//! Uses double hashing: the i-th bit of a key is h1 + i * h2.
+//! Does not own its bits, they are part of the (memory-mapped) meta data.
+//! An empty filter (no words) may contain everything.
+class BloomFilter {
+public:
+  BloomFilter() : _words(nullptr), _nofWords(0), _nofHashes(0) { }
+
+  BloomFilter(const uint64_t* words, size_t nofWords, size_t nofHashes) :
+      _words(words), _nofWords(nofWords), _nofHashes(nofHashes) { }
+
+  //! Builds the bits of a filter for keys with bitsPerKey bits per key
+  //! into words. Returns the number of hash functions to use.
+  static size_t build(const vector<Id>& keys, size_t bitsPerKey,
+                      vector<uint64_t>* words);
+
+  bool empty() const {
+    return _nofWords == 0;
+  }
+
+  //! False if the key has definitely not been added.
+  bool mayContain(Id key) const;
+
+  const uint64_t* getWords() const {
+    return _words;
+  }
+
+  size_t getNofWords() const {
+    return _nofWords;
+  }
+
+  size_t getNofHashes() const {
+    return _nofHashes;
+  }
+
+private:
+  const uint64_t* _words;
+  size_t _nofWords;
+  size_t _nofHashes;
+
+  static uint64_t hash(Id key);
+};
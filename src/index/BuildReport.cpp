@@ -0,0 +1,189 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <sys/resource.h>
+#include <fstream>
+#include <sstream>
+#include <stxxl/mng>
+#include "../util/Exception.h"
+#include "../util/File.h"
+#include "../util/Log.h"
+#include "./BuildReport.h"
+
+// _____________________________________________________________________________
+void BuildReport::startPhase(const string& name) {
+  if (_phaseRunning) {
+    endPhase();
+  }
+  LOG(DEBUG) << "Starting build phase " << name << std::endl;
+  _phases.emplace_back();
+  _phases.back()._name = name;
+  _usageAtStart = currentUsage();
+  _timer.start();
+  _phaseRunning = true;
+}
+
+// _____________________________________________________________________________
+void BuildReport::endPhase() {
+  if (!_phaseRunning) {
+    return;
+  }
+  _timer.stop();
+  Usage usage = currentUsage();
+  Phase& phase = _phases.back();
+  phase._wallMs = static_cast<uint64_t>(_timer.msecs());
+  phase._cpuMs = usage._cpuMs - _usageAtStart._cpuMs;
+  phase._bytesRead = usage._bytesRead - _usageAtStart._bytesRead;
+  phase._bytesWritten = usage._bytesWritten - _usageAtStart._bytesWritten;
+  phase._peakRssKb = usage._peakRssKb;
+  stxxl::block_manager* bm = stxxl::block_manager::get_instance();
+  phase._stxxlPeakBytes = bm->get_maximum_allocation();
+  phase._stxxlCurrentBytes = bm->get_current_allocation();
+  _phaseRunning = false;
+  LOG(DEBUG) << "Build phase " << phase._name << " done after "
+             << phase._wallMs << " ms" << std::endl;
+}
+
+// _____________________________________________________________________________
+BuildReport::Usage BuildReport::currentUsage() {
+  Usage usage;
+  struct rusage ru;
+  AD_CHECK_EQ(0, getrusage(RUSAGE_SELF, &ru));
+  usage._cpuMs = static_cast<uint64_t>(
+      (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000 +
+      (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000);
+  // Linux reports ru_maxrss in kilobytes.
+  usage._peakRssKb = static_cast<uint64_t>(ru.ru_maxrss);
+  // Blocks of 512 bytes, only used if /proc/self/io is not available.
+  usage._bytesRead = static_cast<uint64_t>(ru.ru_inblock) * 512;
+  usage._bytesWritten = static_cast<uint64_t>(ru.ru_oublock) * 512;
+  std::ifstream io("/proc/self/io");
+  string key;
+  uint64_t value;
+  while (io >> key >> value) {
+    if (key == "rchar:") {
+      usage._bytesRead = value;
+    } else if (key == "wchar:") {
+      usage._bytesWritten = value;
+    }
+  }
+  return usage;
+}
+
+// _____________________________________________________________________________
+void BuildReport::addPermutation(const string& name, const IndexMetaData& meta,
+                                 uint64_t fileBytes) {
+  PermutationSizes p;
+  p._name = name;
+  p._fileBytes = fileBytes;
+  p._nofRelations = 0;
+  p._nofFunctionalRelations = 0;
+  p._nofElements = 0;
+  p._nofBlocks = 0;
+  p._pairIndexBytes = 0;
+  p._lhsBytes = 0;
+  p._rhsBytes = 0;
+  p._compressed = meta.isFullIndexCompressed();
+  vector<Id> relIds = meta.getRelationIds();
+  for (size_t i = 0; i < relIds.size(); ++i) {
+    const RelationMetaData& rmd = meta.getRmd(relIds[i]);
+    ++p._nofRelations;
+    if (rmd.isFunctional()) {
+      ++p._nofFunctionalRelations;
+    }
+    p._nofElements += rmd._nofElements;
+    p._nofBlocks += rmd._nofBlocks;
+    p._pairIndexBytes += rmd.getNofBytesForFulltextIndex();
+    p._lhsBytes += rmd._startRhs - rmd.getStartOfLhs();
+    p._rhsBytes += rmd._offsetAfter - rmd._startRhs;
+  }
+  // Everything after the last relation: meta data and its start offset.
+  p._metaBytes = fileBytes - static_cast<uint64_t>(meta.getOffsetAfter());
+  _permutations.push_back(p);
+}
+
+// _____________________________________________________________________________
+void BuildReport::setText(const TextMetaData& meta, uint64_t fileBytes) {
+  _hasText = true;
+  _text._fileBytes = fileBytes;
+  _text._nofBlocks = meta.getBlockCount();
+  _text._nofWordPostings = 0;
+  _text._nofEntityPostings = 0;
+  _text._contextListBytes = 0;
+  _text._wordListBytes = 0;
+  _text._scoreListBytes = 0;
+  uint64_t postingBytes = 0;
+  for (size_t i = 0; i < meta.getBlockCount(); ++i) {
+    const TextBlockMetaData& tbmd = meta.getBlockById(i);
+    const ContextListMetaData* lists[] = {&tbmd._cl, &tbmd._entityCl};
+    for (size_t j = 0; j < 2; ++j) {
+      const ContextListMetaData& cl = *lists[j];
+      if (cl._nofElements == 0) {
+        continue;
+      }
+      _text._contextListBytes += cl._startWordlist - cl._startContextlist;
+      _text._wordListBytes += cl._startScorelist - cl._startWordlist;
+      _text._scoreListBytes += cl._lastByte + 1 - cl._startScorelist;
+      postingBytes += cl._lastByte + 1 - cl._startSubBlocks;
+    }
+    _text._nofWordPostings += tbmd._cl._nofElements;
+    _text._nofEntityPostings += tbmd._entityCl._nofElements;
+  }
+  _text._metaBytes = fileBytes > postingBytes ? fileBytes - postingBytes : 0;
+}
+
+// _____________________________________________________________________________
+string BuildReport::asJson() const {
+  std::ostringstream os;
+  os << "{\n  \"phases\": [";
+  for (size_t i = 0; i < _phases.size(); ++i) {
+    const Phase& p = _phases[i];
+    os << (i == 0 ? "\n" : ",\n")
+       << "    {\"name\": \"" << p._name << "\""
+       << ", \"wallMs\": " << p._wallMs
+       << ", \"cpuMs\": " << p._cpuMs
+       << ", \"bytesRead\": " << p._bytesRead
+       << ", \"bytesWritten\": " << p._bytesWritten
+       << ", \"peakRssKb\": " << p._peakRssKb
+       << ", \"stxxlPeakBytes\": " << p._stxxlPeakBytes
+       << ", \"stxxlCurrentBytes\": " << p._stxxlCurrentBytes << "}";
+  }
+  os << "\n  ],\n  \"permutations\": [";
+  for (size_t i = 0; i < _permutations.size(); ++i) {
+    const PermutationSizes& p = _permutations[i];
+    os << (i == 0 ? "\n" : ",\n")
+       << "    {\"name\": \"" << p._name << "\""
+       << ", \"fileBytes\": " << p._fileBytes
+       << ", \"relations\": " << p._nofRelations
+       << ", \"functionalRelations\": " << p._nofFunctionalRelations
+       << ", \"elements\": " << p._nofElements
+       << ", \"blocks\": " << p._nofBlocks
+       << ", \"pairIndexBytes\": " << p._pairIndexBytes
+       << ", \"lhsBytes\": " << p._lhsBytes
+       << ", \"rhsBytes\": " << p._rhsBytes
+       << ", \"metaBytes\": " << p._metaBytes
+       << ", \"compressed\": " << (p._compressed ? "true" : "false") << "}";
+  }
+  os << "\n  ]";
+  if (_hasText) {
+    os << ",\n  \"text\": {\"fileBytes\": " << _text._fileBytes
+       << ", \"blocks\": " << _text._nofBlocks
+       << ", \"wordPostings\": " << _text._nofWordPostings
+       << ", \"entityPostings\": " << _text._nofEntityPostings
+       << ", \"contextListBytes\": " << _text._contextListBytes
+       << ", \"wordListBytes\": " << _text._wordListBytes
+       << ", \"scoreListBytes\": " << _text._scoreListBytes
+       << ", \"metaBytes\": " << _text._metaBytes << "}";
+  }
+  os << "\n}\n";
+  return os.str();
+}
+
+// _____________________________________________________________________________
+void BuildReport::writeJson(const string& fileName) const {
+  ad_utility::File f(fileName.c_str(), "w");
+  string json = asJson();
+  f.write(json.data(), json.size());
+  f.close();
+}
@@ -0,0 +1,109 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../util/Timer.h"
+#include "./IndexMetaData.h"
+#include "./TextMetaData.h"
+
+using std::string;
+using std::vector;
+
+//! Collects timings, resource usage and size breakdowns while an index
+//! is built and writes them as JSON, so that builds on large inputs
+//! can be compared and build machines can be sized.
+//!
+//! A phase is measured from startPhase until the next startPhase or
+//! endPhase. CPU time covers all threads of the process, I/O is what the
+//! process has read / written through system calls (from /proc/self/io).
+class BuildReport {
+public:
+  struct Phase {
+    // All 0 until the phase ends.
+    Phase() : _wallMs(0), _cpuMs(0), _bytesRead(0), _bytesWritten(0),
+              _peakRssKb(0), _stxxlPeakBytes(0), _stxxlCurrentBytes(0) { }
+
+    string _name;
+    uint64_t _wallMs;
+    uint64_t _cpuMs;
+    uint64_t _bytesRead;
+    uint64_t _bytesWritten;
+    // Peak resident set size of the process at the end of the phase.
+    uint64_t _peakRssKb;
+    // Peak / current number of bytes allocated on the STXXL disk.
+    uint64_t _stxxlPeakBytes;
+    uint64_t _stxxlCurrentBytes;
+  };
+
+  struct PermutationSizes {
+    string _name;
+    uint64_t _fileBytes;
+    size_t _nofRelations;
+    size_t _nofFunctionalRelations;
+    size_t _nofElements;
+    size_t _nofBlocks;
+    uint64_t _pairIndexBytes;
+    uint64_t _lhsBytes;
+    uint64_t _rhsBytes;
+    uint64_t _metaBytes;
+    bool _compressed;
+  };
+
+  struct TextSizes {
+    uint64_t _fileBytes;
+    size_t _nofBlocks;
+    size_t _nofWordPostings;
+    size_t _nofEntityPostings;
+    uint64_t _contextListBytes;
+    uint64_t _wordListBytes;
+    uint64_t _scoreListBytes;
+    uint64_t _metaBytes;
+  };
+
+  BuildReport() : _phaseRunning(false), _hasText(false) { }
+
+  // Starts a new phase, ends the current one if there is one.
+  void startPhase(const string& name);
+
+  void endPhase();
+
+  void addPermutation(const string& name, const IndexMetaData& meta,
+                      uint64_t fileBytes);
+
+  void setText(const TextMetaData& meta, uint64_t fileBytes);
+
+  const vector<Phase>& getPhases() const {
+    return _phases;
+  }
+
+  const vector<PermutationSizes>& getPermutations() const {
+    return _permutations;
+  }
+
+  string asJson() const;
+
+  void writeJson(const string& fileName) const;
+
+private:
+  // Resource usage of the process so far.
+  struct Usage {
+    uint64_t _cpuMs;
+    uint64_t _bytesRead;
+    uint64_t _bytesWritten;
+    uint64_t _peakRssKb;
+  };
+
+  static Usage currentUsage();
+
+  vector<Phase> _phases;
+  vector<PermutationSizes> _permutations;
+  TextSizes _text;
+  ad_utility::Timer _timer;
+  Usage _usageAtStart;
+  bool _phaseRunning;
+  bool _hasText;
+};
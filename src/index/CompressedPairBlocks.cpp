@@ -0,0 +1,123 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include "../util/Exception.h"
+#include "../util/Simple8bCode.h"
+#include "./CompressedPairBlocks.h"
+
+const uint64_t CompressedPairBlocks::RAW;
+const uint64_t CompressedPairBlocks::SIMPLE8B;
+const uint64_t CompressedPairBlocks::HEADER_WORDS;
+const uint64_t CompressedPairBlocks::SIMPLE8B_HEADER_WORDS;
+const uint64_t CompressedPairBlocks::MAX_ENCODABLE;
+
+// _____________________________________________________________________________
+size_t CompressedPairBlocks::encode(const array<Id, 2>* pairs,
+                                    size_t nofPairs, vector<uint64_t>* out) {
+  size_t wordsBefore = out->size();
+  out->push_back(nofPairs);
+  Id rhsBase = std::numeric_limits<Id>::max();
+  for (size_t i = 0; i < nofPairs; ++i) {
+    rhsBase = std::min(rhsBase, pairs[i][1]);
+  }
+  vector<Id> lhs(nofPairs);
+  vector<Id> rhs(nofPairs);
+  bool fits = nofPairs > 0;
+  for (size_t i = 0; i < nofPairs; ++i) {
+    lhs[i] = i == 0 ? 0 : pairs[i][0] - pairs[i - 1][0];
+    rhs[i] = pairs[i][1] - rhsBase;
+    if (lhs[i] > MAX_ENCODABLE || rhs[i] > MAX_ENCODABLE) {
+      fits = false;
+      break;
+    }
+  }
+  if (fits) {
+    // Simple8b never needs more than one word per element.
+    vector<uint64_t> lhsCode(nofPairs);
+    vector<uint64_t> rhsCode(nofPairs);
+    size_t lhsWords = ad_utility::Simple8bCode::encode(
+        lhs.data(), nofPairs, lhsCode.data()) / sizeof(uint64_t);
+    size_t rhsWords = ad_utility::Simple8bCode::encode(
+        rhs.data(), nofPairs, rhsCode.data()) / sizeof(uint64_t);
+    if (SIMPLE8B_HEADER_WORDS + lhsWords + rhsWords < 2 * nofPairs) {
+      out->push_back(SIMPLE8B);
+      out->push_back(pairs[0][0]);
+      out->push_back(rhsBase);
+      out->push_back(lhsWords);
+      out->push_back(rhsWords);
+      out->insert(out->end(), lhsCode.begin(), lhsCode.begin() + lhsWords);
+      out->insert(out->end(), rhsCode.begin(), rhsCode.begin() + rhsWords);
+      return (out->size() - wordsBefore) * sizeof(uint64_t);
+    }
+  }
+  out->push_back(RAW);
+  for (size_t i = 0; i < nofPairs; ++i) {
+    out->push_back(pairs[i][0]);
+    out->push_back(pairs[i][1]);
+  }
+  return (out->size() - wordsBefore) * sizeof(uint64_t);
+}
+
+// _____________________________________________________________________________
+size_t CompressedPairBlocks::decode(uint64_t* block,
+                                    vector<array<Id, 2>>* result) {
+  size_t nofPairs = block[0];
+  size_t nofBefore = result->size();
+  if (block[1] == RAW) {
+    result->resize(nofBefore + nofPairs);
+    memcpy(result->data() + nofBefore, block + HEADER_WORDS,
+           nofPairs * sizeof(array<Id, 2>));
+    return HEADER_WORDS + 2 * nofPairs;
+  }
+  AD_CHECK_EQ(block[1], SIMPLE8B);
+  Id lhsBase = block[2];
+  Id rhsBase = block[3];
+  size_t lhsWords = block[4];
+  size_t rhsWords = block[5];
+  uint64_t* lhsCode = block + HEADER_WORDS + SIMPLE8B_HEADER_WORDS;
+  // Simple8b decoding may write up to 239 elements past the end.
+  vector<Id> lhs(nofPairs + 240);
+  vector<Id> rhs(nofPairs + 240);
+  ad_utility::Simple8bCode::decode(lhsCode, nofPairs, lhs.data());
+  ad_utility::Simple8bCode::decode(lhsCode + lhsWords, nofPairs, rhs.data());
+  result->resize(nofBefore + nofPairs);
+  Id currentLhs = lhsBase;
+  for (size_t i = 0; i < nofPairs; ++i) {
+    currentLhs += lhs[i];
+    (*result)[nofBefore + i][0] = currentLhs;
+    (*result)[nofBefore + i][1] = rhsBase + rhs[i];
+  }
+  return HEADER_WORDS + SIMPLE8B_HEADER_WORDS + lhsWords + rhsWords;
+}
+
+// _____________________________________________________________________________
+size_t CompressedPairBlocks::getNofWords(const uint64_t* block,
+                                         size_t nofWords) {
+  if (nofWords < HEADER_WORDS) {
+    return 0;
+  }
+  size_t needed = HEADER_WORDS + 2 * block[0];
+  if (block[1] != RAW) {
+    AD_CHECK_EQ(block[1], SIMPLE8B);
+    if (nofWords < HEADER_WORDS + SIMPLE8B_HEADER_WORDS) {
+      return 0;
+    }
+    needed = HEADER_WORDS + SIMPLE8B_HEADER_WORDS + block[4] + block[5];
+  }
+  return needed <= nofWords ? needed : 0;
+}
+
+// _____________________________________________________________________________
+void CompressedPairBlocks::decodeAll(uint64_t* data, size_t nofBytes,
+                                     vector<array<Id, 2>>* result) {
+  size_t nofWords = nofBytes / sizeof(uint64_t);
+  size_t wordsDone = 0;
+  while (wordsDone < nofWords) {
+    wordsDone += decode(data + wordsDone, result);
+  }
+  AD_CHECK_EQ(wordsDone, nofWords);
+}
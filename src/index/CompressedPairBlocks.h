@@ -0,0 +1,53 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <vector>
+#include "../global/Id.h"
+
+using std::array;
+using std::vector;
+
+//! Block format for compressed FullIndex pair lists.
+//! A block holds the pairs of a contiguous range of a relation, sorted by
+//! LHS. Layout, in 64 bit words:
+//!
+//! nofPairs.format.DATA
+//! DATA := pairs as raw array<Id, 2>                        if format is RAW
+//! DATA := lhsBase.rhsBase.#lhsWords.#rhsWords.LHS.RHS       if SIMPLE8B
+//!
+//! LHS are gaps to the previous LHS (starting at lhsBase), RHS are
+//! offsets to the smallest RHS in the block (rhsBase). Both are Simple8b
+//! encoded. A block falls back to RAW if a value does not fit into
+//! 60 bits or if compression would not save anything.
+class CompressedPairBlocks {
+public:
+  static const uint64_t RAW = 0;
+  static const uint64_t SIMPLE8B = 1;
+
+  //! Encodes nofPairs pairs as one block and appends it to out.
+  //! Returns the number of bytes appended.
+  static size_t encode(const array<Id, 2>* pairs, size_t nofPairs,
+                       vector<uint64_t>* out);
+
+  //! Decodes the block that starts at block and appends its pairs to result.
+  //! Returns the number of 64 bit words the block occupies.
+  static size_t decode(uint64_t* block, vector<array<Id, 2>>* result);
+
+  //! Number of 64 bit words of the block that starts at block, or 0 if
+  //! the block does not lie completely within the nofWords words there.
+  static size_t getNofWords(const uint64_t* block, size_t nofWords);
+
+  //! Decodes all consecutive blocks in nofBytes bytes of data.
+  static void decodeAll(uint64_t* data, size_t nofBytes,
+                        vector<array<Id, 2>>* result);
+
+private:
+  static const uint64_t HEADER_WORDS = 2;
+  static const uint64_t SIMPLE8B_HEADER_WORDS = 4;
+  // Simple8b cannot represent larger values.
+  static const uint64_t MAX_ENCODABLE = 0x0FFFFFFFFFFFFFFF;
+};
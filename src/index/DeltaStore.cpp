@@ -0,0 +1,174 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <algorithm>
+#include <limits>
+#include "./DeltaStore.h"
+
+// _____________________________________________________________________________
+void DeltaStore::insert(Id relId, Id lhs, Id rhs) {
+  update(relId, lhs, rhs, true);
+}
+
+// _____________________________________________________________________________
+void DeltaStore::erase(Id relId, Id lhs, Id rhs) {
+  update(relId, lhs, rhs, false);
+}
+
+// _____________________________________________________________________________
+void DeltaStore::update(Id relId, Id lhs, Id rhs, bool insert) {
+  RelationDelta& rel = _data[relId];
+  array<Id, 2> pair{{lhs, rhs}};
+  std::set<array<Id, 2>>& add = insert ? rel._inserted : rel._deleted;
+  std::set<array<Id, 2>>& remove = insert ? rel._deleted : rel._inserted;
+  // The latest change wins. Keep deletes of inserted triples, too,
+  // in case the triple has also been on disk.
+  _size -= remove.erase(pair);
+  _size += add.insert(pair).second ? 1 : 0;
+}
+
+// _____________________________________________________________________________
+void DeltaStore::clear() {
+  _data.clear();
+  _size = 0;
+}
+
+// _____________________________________________________________________________
+void DeltaStore::merge(const DeltaStore& newer) {
+  // A triple is either inserted or deleted in newer, never both.
+  for (auto it = newer._data.begin(); it != newer._data.end(); ++it) {
+    const RelationDelta& rel = it->second;
+    for (auto p = rel._inserted.begin(); p != rel._inserted.end(); ++p) {
+      insert(it->first, (*p)[0], (*p)[1]);
+    }
+    for (auto p = rel._deleted.begin(); p != rel._deleted.end(); ++p) {
+      erase(it->first, (*p)[0], (*p)[1]);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+vector<Id> DeltaStore::getRelationIds() const {
+  vector<Id> ids;
+  for (auto it = _data.begin(); it != _data.end(); ++it) {
+    ids.push_back(it->first);
+  }
+  return ids;
+}
+
+// _____________________________________________________________________________
+DeltaStore DeltaStore::forRelation(Id relId) const {
+  DeltaStore result;
+  auto it = _data.find(relId);
+  if (it != _data.end()) {
+    result._data[relId] = it->second;
+    result._size = it->second._inserted.size() + it->second._deleted.size();
+  }
+  return result;
+}
+
+// _____________________________________________________________________________
+void DeltaStore::apply(Id relId, vector<array<Id, 2>>* pairs) const {
+  apply(relId, nullptr, nullptr, pairs);
+}
+
+// _____________________________________________________________________________
+void DeltaStore::apply(Id relId, const array<Id, 2>* after,
+                       const array<Id, 2>* upTo,
+                       vector<array<Id, 2>>* pairs) const {
+  auto it = _data.find(relId);
+  if (it == _data.end()) {
+    return;
+  }
+  const RelationDelta& rel = it->second;
+  auto ins = after ? rel._inserted.upper_bound(*after) : rel._inserted.begin();
+  auto insEnd = upTo ? rel._inserted.upper_bound(*upTo) : rel._inserted.end();
+  vector<array<Id, 2>> merged;
+  merged.reserve(pairs->size() + std::distance(ins, insEnd));
+  for (size_t i = 0; i < pairs->size(); ++i) {
+    const array<Id, 2>& pair = (*pairs)[i];
+    while (ins != insEnd && *ins < pair) {
+      merged.push_back(*ins++);
+    }
+    if (ins != insEnd && *ins == pair) {
+      ++ins;
+    }
+    if (rel._deleted.count(pair) == 0) {
+      merged.push_back(pair);
+    }
+  }
+  merged.insert(merged.end(), ins, insEnd);
+  pairs->swap(merged);
+}
+
+// _____________________________________________________________________________
+void DeltaStore::apply(Id relId, const vector<Id>& lhs,
+                       vector<array<Id, 2>>* pairs) const {
+  auto it = _data.find(relId);
+  if (it == _data.end()) {
+    return;
+  }
+  const RelationDelta& rel = it->second;
+  vector<array<Id, 2>> inserted;
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    auto from = rel._inserted.lower_bound(array<Id, 2>{{lhs[i], 0}});
+    auto to = rel._inserted.upper_bound(
+        array<Id, 2>{{lhs[i], std::numeric_limits<Id>::max()}});
+    inserted.insert(inserted.end(), from, to);
+  }
+  vector<array<Id, 2>> merged;
+  merged.reserve(pairs->size() + inserted.size());
+  auto ins = inserted.begin();
+  for (size_t i = 0; i < pairs->size(); ++i) {
+    const array<Id, 2>& pair = (*pairs)[i];
+    while (ins != inserted.end() && *ins < pair) {
+      merged.push_back(*ins++);
+    }
+    if (ins != inserted.end() && *ins == pair) {
+      ++ins;
+    }
+    if (rel._deleted.count(pair) == 0) {
+      merged.push_back(pair);
+    }
+  }
+  merged.insert(merged.end(), ins, inserted.end());
+  pairs->swap(merged);
+}
+
+// _____________________________________________________________________________
+void DeltaStore::apply(Id relId, Id lhs, vector<array<Id, 1>>* rhs) const {
+  auto it = _data.find(relId);
+  if (it == _data.end()) {
+    return;
+  }
+  const RelationDelta& rel = it->second;
+  array<Id, 2> from{{lhs, 0}};
+  array<Id, 2> to{{lhs, std::numeric_limits<Id>::max()}};
+  auto insBegin = rel._inserted.lower_bound(from);
+  auto insEnd = rel._inserted.upper_bound(to);
+  auto delBegin = rel._deleted.lower_bound(from);
+  auto delEnd = rel._deleted.upper_bound(to);
+  if (insBegin == insEnd && delBegin == delEnd) {
+    return;
+  }
+  vector<array<Id, 1>> merged;
+  merged.reserve(rhs->size() + std::distance(insBegin, insEnd));
+  auto ins = insBegin;
+  for (size_t i = 0; i < rhs->size(); ++i) {
+    Id value = (*rhs)[i][0];
+    while (ins != insEnd && (*ins)[1] < value) {
+      merged.push_back(array<Id, 1>{{(*ins++)[1]}});
+    }
+    if (ins != insEnd && (*ins)[1] == value) {
+      ++ins;
+    }
+    if (rel._deleted.count(array<Id, 2>{{lhs, value}}) == 0) {
+      merged.push_back((*rhs)[i]);
+    }
+  }
+  for (; ins != insEnd; ++ins) {
+    merged.push_back(array<Id, 1>{{(*ins)[1]}});
+  }
+  rhs->swap(merged);
+}
@@ -0,0 +1,75 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <array>
+#include <map>
+#include <set>
+#include <vector>
+#include "../global/Id.h"
+
+using std::array;
+using std::vector;
+
+//! Triples that have been inserted into or deleted from one permutation
+//! of an index after it has been built. Triples are stored in the layout
+//! of the permutation: the relation (first sort column) and (lhs, rhs)
+//! pairs, sorted like the pairs on disk.
+//! Scans read the pairs from disk and apply the changes with apply.
+class DeltaStore {
+public:
+  DeltaStore() : _size(0) { }
+
+  void insert(Id relId, Id lhs, Id rhs);
+
+  void erase(Id relId, Id lhs, Id rhs);
+
+  // Number of recorded inserts and deletes.
+  size_t size() const {
+    return _size;
+  }
+
+  bool empty() const {
+    return _size == 0;
+  }
+
+  void clear();
+
+  // Adds the changes of a newer store, they override those in this one.
+  void merge(const DeltaStore& newer);
+
+  // Ids of all relations with changes.
+  vector<Id> getRelationIds() const;
+
+  // Only the changes for one relation.
+  DeltaStore forRelation(Id relId) const;
+
+  // Applies the changes for a relation to its sorted (lhs, rhs) pairs.
+  void apply(Id relId, vector<array<Id, 2>>* pairs) const;
+
+  // Applies the changes for a relation in the range (after, upTo] to the
+  // pairs of that range. Null means the range is open on that side.
+  // Used by scans that go through a relation a block at a time.
+  void apply(Id relId, const array<Id, 2>* after, const array<Id, 2>* upTo,
+             vector<array<Id, 2>>* pairs) const;
+
+  // Applies the changes for a relation and the sorted lhs to the pairs
+  // with one of them.
+  void apply(Id relId, const vector<Id>& lhs,
+             vector<array<Id, 2>>* pairs) const;
+
+  // Applies the changes for a relation and a fixed lhs to its sorted rhs.
+  void apply(Id relId, Id lhs, vector<array<Id, 1>>* rhs) const;
+
+private:
+  struct RelationDelta {
+    std::set<array<Id, 2>> _inserted;
+    std::set<array<Id, 2>> _deleted;
+  };
+
+  std::map<Id, RelationDelta> _data;
+  size_t _size;
+
+  void update(Id relId, Id lhs, Id rhs, bool insert);
+};
@@ -25,9 +25,8 @@ string DocsDB::getTextExcerpt(Id cid) const {
                                return pair.first < key;
                              });
   char *buf = new char[BUFFER_SIZE_DOCSFILE_LINE];
-  _dbFile.seek(it->second, 0);
   string line;
-  _dbFile.readLine(&line, buf, BUFFER_SIZE_DOCSFILE_LINE);
+  _dbFile.readLine(&line, buf, BUFFER_SIZE_DOCSFILE_LINE, it->second);
   delete[] buf;
   // Skip the Id
   return line.substr(line.find('\t'));
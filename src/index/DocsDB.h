@@ -19,6 +19,6 @@ public:
   string getTextExcerpt(Id cid) const;
 
   vector<pair<Id, off_t>> _offsets;
-  mutable ad_utility::File _dbFile;
+  ad_utility::File _dbFile;
 };
 
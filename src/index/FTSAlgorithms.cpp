@@ -2,15 +2,184 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <algorithm>
 #include <utility>
 #include <map>
+#include <queue>
 #include <set>
 #include <unordered_map>
 #include "./FTSAlgorithms.h"
 
+// The AVX2 block skipping is compiled for x86 regardless of the target
+// flags and selected at runtime if the CPU supports it.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AD_FTS_AVX2
+#include <immintrin.h>
+#endif
+
 using std::pair;
 using std::unordered_map;
 
+namespace {
+// The first index at or after from with list[index] >= value, size if
+// there is none. Doubles the step until it overshoots, then searches
+// binary, so skipping d elements costs O(log d) comparisons.
+size_t gallop(const vector<Id>& list, size_t from, Id value) {
+  size_t size = list.size();
+  if (from >= size || list[from] >= value) {
+    return from;
+  }
+  // Invariant: list[lo] < value.
+  size_t lo = from;
+  size_t step = 1;
+  size_t hi = lo + step;
+  while (hi < size && list[hi] < value) {
+    lo = hi;
+    step *= 2;
+    hi = lo + step;
+  }
+  hi = std::min(hi, size);
+  return static_cast<size_t>(
+      std::lower_bound(list.begin() + lo + 1, list.begin() + hi, value) -
+      list.begin());
+}
+
+// Like gallop, but one element at a time.
+size_t advance(const vector<Id>& list, size_t from, Id value) {
+  while (from < list.size() && list[from] < value) {
+    ++from;
+  }
+  return from;
+}
+
+// The end of the run of equal contexts that starts at from.
+size_t runEnd(const vector<Id>& list, size_t from) {
+  size_t end = from + 1;
+  while (end < list.size() && list[end] == list[from]) {
+    ++end;
+  }
+  return end;
+}
+
+#ifdef AD_FTS_AVX2
+// Advances i and j by blocks of four as long as the blocks at i and j have
+// no context in common, always the block with the smaller last context.
+// None of the skipped contexts can occur in the other list: those behind
+// the other block are larger than all of them.
+__attribute__((target("avx2")))
+void skipBlocksAvx2(const vector<Id>& a, const vector<Id>& b, size_t* i,
+                    size_t* j) {
+  size_t x = *i;
+  size_t y = *j;
+  while (x + 4 <= a.size() && y + 4 <= b.size()) {
+    __m256i va = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(a.data() + x));
+    __m256i vb = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(b.data() + y));
+    // Compare with all four rotations of the other block.
+    __m256i eq = _mm256_cmpeq_epi64(va, vb);
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(
+        va, _mm256_permute4x64_epi64(vb, 0x39)));
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(
+        va, _mm256_permute4x64_epi64(vb, 0x4E)));
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(
+        va, _mm256_permute4x64_epi64(vb, 0x93)));
+    if (!_mm256_testz_si256(eq, eq)) {
+      break;
+    }
+    if (a[x + 3] < b[y + 3]) {
+      x += 4;
+    } else {
+      y += 4;
+    }
+  }
+  *i = x;
+  *j = y;
+}
+#endif
+
+// Calls onRun(i0, i1, j0, j1) for each context that occurs in both lists,
+// in ascending order, where [i0, i1) and [j0, j1) are its runs in a and b.
+template<typename OnRun>
+void forEachCommonRun(const vector<Id>& a, const vector<Id>& b,
+                      OnRun onRun) {
+  if (a.empty() || b.empty()) {
+    return;
+  }
+  FTSAlgorithms::IntersectionMode mode = FTSAlgorithms::intersectionMode();
+  size_t shorter = std::min(a.size(), b.size());
+  size_t longer = std::max(a.size(), b.size());
+  if (mode == FTSAlgorithms::GALLOP || (mode == FTSAlgorithms::ADAPTIVE &&
+      longer >= FTSAlgorithms::GALLOP_MIN_RATIO * shorter)) {
+    bool aIsShorter = a.size() <= b.size();
+    const vector<Id>& s = aIsShorter ? a : b;
+    const vector<Id>& l = aIsShorter ? b : a;
+    size_t j = 0;
+    for (size_t i = 0; i < s.size();) {
+      size_t i1 = runEnd(s, i);
+      j = gallop(l, j, s[i]);
+      if (j == l.size()) {
+        return;
+      }
+      if (l[j] == s[i]) {
+        size_t j1 = runEnd(l, j);
+        if (aIsShorter) {
+          onRun(i, i1, j, j1);
+        } else {
+          onRun(j, j1, i, i1);
+        }
+        j = j1;
+      }
+      i = i1;
+    }
+    return;
+  }
+
+#ifdef AD_FTS_AVX2
+  bool simd = mode != FTSAlgorithms::MERGE &&
+      FTSAlgorithms::cpuSupportsSimd();
+#endif
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    // Merge at least up to the end of the current blocks before trying
+    // to skip again.
+    size_t iEnd = i + 4;
+    size_t jEnd = j + 4;
+#ifdef AD_FTS_AVX2
+    if (simd) {
+      skipBlocksAvx2(a, b, &i, &j);
+      iEnd = i + 4;
+      jEnd = j + 4;
+    }
+#endif
+    while (i < std::min(iEnd, a.size()) && j < std::min(jEnd, b.size())) {
+      if (a[i] < b[j]) {
+        ++i;
+      } else if (b[j] < a[i]) {
+        ++j;
+      } else {
+        size_t i1 = runEnd(a, i);
+        size_t j1 = runEnd(b, j);
+        onRun(i, i1, j, j1);
+        i = i1;
+        j = j1;
+      }
+    }
+  }
+}
+}
+
+// _____________________________________________________________________________
+bool FTSAlgorithms::cpuSupportsSimd() {
+#ifdef AD_FTS_AVX2
+  static bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
 // _____________________________________________________________________________
 void FTSAlgorithms::filterByRange(const IdRange& idRange,
                                   const vector<Id>& blockCids,
@@ -70,6 +239,245 @@ void FTSAlgorithms::getTopKByScores(const vector<Id>& cids,
   LOG(DEBUG) << "Done with getTopKByScores.\n";
 }
 
+namespace {
+// Position in one list of getTopKByBlockMaxScores. Sub-blocks are only
+// read when a posting in them is needed, not when they are skipped.
+class SubBlockCursor {
+public:
+  SubBlockCursor(size_t list, const vector<Id>& lastCids,
+                 const vector<Score>& maxScores,
+                 const FTSAlgorithms::SubBlockReader& readSubBlock) :
+      _list(list), _lastCids(lastCids), _maxScores(maxScores),
+      _readSubBlock(readSubBlock), _block(0), _blockRead(lastCids.size()),
+      _pos(0), _nofBlocksRead(0) { }
+
+  bool atEnd() const {
+    return _block == _lastCids.size();
+  }
+
+  Id lastCid() const {
+    return _lastCids[_block];
+  }
+
+  Score maxScore() const {
+    return _maxScores[_block];
+  }
+
+  size_t getNofBlocksRead() const {
+    return _nofBlocksRead;
+  }
+
+  // Moves to the sub-block that would hold cid, without reading it.
+  void skipTo(Id cid) {
+    if (!atEnd() && _lastCids[_block] < cid) {
+      _block = static_cast<size_t>(
+          std::lower_bound(_lastCids.begin() + _block, _lastCids.end(), cid) -
+          _lastCids.begin());
+      _pos = 0;
+    }
+  }
+
+  // The highest score in the sub-blocks that may hold contexts
+  // in [from, to]. False if there are no such sub-blocks.
+  bool getMaxScore(Id from, Id to, Score* score) const {
+    size_t b = static_cast<size_t>(
+        std::lower_bound(_lastCids.begin() + _block, _lastCids.end(), from) -
+        _lastCids.begin());
+    if (b == _lastCids.size()) {
+      return false;
+    }
+    *score = _maxScores[b];
+    for (++b; b < _lastCids.size() && _lastCids[b - 1] < to; ++b) {
+      *score = std::max(*score, _maxScores[b]);
+    }
+    return true;
+  }
+
+  // Moves to the first posting with a context >= cid in the current
+  // sub-block. False if there is none.
+  bool seekInBlock(Id cid) {
+    if (_blockRead != _block) {
+      _readSubBlock(_list, _block, _cids, _scores);
+      AD_CHECK_EQ(_cids.size(), _scores.size());
+      _blockRead = _block;
+      _pos = 0;
+      ++_nofBlocksRead;
+    }
+    _pos = static_cast<size_t>(
+        std::lower_bound(_cids.begin() + _pos, _cids.end(), cid) -
+        _cids.begin());
+    return _pos < _cids.size();
+  }
+
+  // Moves to the first posting with a context >= cid.
+  // False if there is none.
+  bool seek(Id cid) {
+    while (true) {
+      skipTo(cid);
+      if (atEnd()) {
+        return false;
+      }
+      if (seekInBlock(cid)) {
+        return true;
+      }
+      ++_block;
+      _pos = 0;
+    }
+  }
+
+  Id cid() const {
+    return _cids[_pos];
+  }
+
+  // The highest score of the current context, moves past its postings.
+  Score takeScore() {
+    Id cid = _cids[_pos];
+    Score score = 0;
+    for (; _pos < _cids.size() && _cids[_pos] == cid; ++_pos) {
+      score = std::max(score, _scores[_pos]);
+    }
+    return score;
+  }
+
+private:
+  size_t _list;
+  const vector<Id>& _lastCids;
+  const vector<Score>& _maxScores;
+  const FTSAlgorithms::SubBlockReader& _readSubBlock;
+  size_t _block;
+  size_t _blockRead;
+  vector<Id> _cids;
+  vector<Score> _scores;
+  size_t _pos;
+  size_t _nofBlocksRead;
+};
+}
+
+// _____________________________________________________________________________
+void FTSAlgorithms::getTopKByBlockMaxScores(
+    const vector<vector<Id>>& lastCids, const vector<vector<Score>>& maxScores,
+    const FTSAlgorithms::SubBlockReader& readSubBlock, size_t k,
+    WidthTwoList *result) {
+  AD_CHECK_EQ(lastCids.size(), maxScores.size());
+  LOG(DEBUG) << "Block-max top " << k << " of the intersection of "
+             << lastCids.size() << " lists...\n";
+  result->clear();
+  if (k == 0 || lastCids.size() == 0) {
+    return;
+  }
+  // Candidates come from the list with the fewest sub-blocks.
+  vector<SubBlockCursor> cursors;
+  size_t driver = 0;
+  size_t nofBlocks = 0;
+  for (size_t i = 0; i < lastCids.size(); ++i) {
+    AD_CHECK_EQ(lastCids[i].size(), maxScores[i].size());
+    cursors.emplace_back(i, lastCids[i], maxScores[i], readSubBlock);
+    if (lastCids[i].size() < lastCids[driver].size()) {
+      driver = i;
+    }
+    nofBlocks += lastCids[i].size();
+  }
+
+  // The best contexts so far, the worst one on top. Candidates come in
+  // ascending order, so one that only ties the worst never gets in.
+  auto better = [](const pair<size_t, Id>& a, const pair<size_t, Id>& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  };
+  std::priority_queue<pair<size_t, Id>, vector<pair<size_t, Id>>,
+                      decltype(better)> topK(better);
+
+  SubBlockCursor& d = cursors[driver];
+  Id cid = 0;
+  bool done = false;
+  while (!done) {
+    d.skipTo(cid);
+    if (d.atEnd()) {
+      break;
+    }
+    if (topK.size() == k) {
+      // Skip the whole sub-block if the highest scores of it and of the
+      // sub-blocks of the other lists it overlaps cannot beat the worst.
+      size_t bound = d.maxScore();
+      for (size_t i = 0; i < cursors.size() && !done; ++i) {
+        Score score = 0;
+        if (i != driver) {
+          done = !cursors[i].getMaxScore(cid, d.lastCid(), &score);
+          bound += score;
+        }
+      }
+      if (done) {
+        break;
+      }
+      if (bound <= topK.top().first) {
+        cid = d.lastCid() + 1;
+        continue;
+      }
+    }
+    if (!d.seekInBlock(cid)) {
+      cid = d.lastCid() + 1;
+      continue;
+    }
+    cid = d.cid();
+    if (topK.size() == k) {
+      // The same for the sub-blocks that would hold the candidate. The
+      // bound holds up to the first end of one of them.
+      size_t bound = 0;
+      Id boundEnd = d.lastCid();
+      for (size_t i = 0; i < cursors.size() && !done; ++i) {
+        cursors[i].skipTo(cid);
+        done = cursors[i].atEnd();
+        if (!done) {
+          bound += cursors[i].maxScore();
+          boundEnd = std::min(boundEnd, cursors[i].lastCid());
+        }
+      }
+      if (done) {
+        break;
+      }
+      if (bound <= topK.top().first) {
+        cid = boundEnd + 1;
+        continue;
+      }
+    }
+    // All other lists have to contain the candidate.
+    Id next = cid;
+    for (size_t i = 0; i < cursors.size() && next == cid && !done; ++i) {
+      if (i != driver) {
+        done = !cursors[i].seek(cid);
+        next = done ? cid : cursors[i].cid();
+      }
+    }
+    if (done) {
+      break;
+    }
+    if (next != cid) {
+      cid = next;
+      continue;
+    }
+    size_t score = 0;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+      score += cursors[i].takeScore();
+    }
+    topK.push(std::make_pair(score, cid));
+    if (topK.size() > k) {
+      topK.pop();
+    }
+    ++cid;
+  }
+
+  result->resize(topK.size());
+  for (size_t i = result->size(); i > 0; --i) {
+    (*result)[i - 1] = {{topK.top().second, static_cast<Id>(topK.top().first)}};
+    topK.pop();
+  }
+  size_t nofBlocksRead = 0;
+  for (size_t i = 0; i < cursors.size(); ++i) {
+    nofBlocksRead += cursors[i].getNofBlocksRead();
+  }
+  LOG(DEBUG) << "Done with getTopKByBlockMaxScores. Read " << nofBlocksRead
+             << " of " << nofBlocks << " sub-blocks.\n";
+}
+
 // _____________________________________________________________________________
 void FTSAlgorithms::aggScoresAndTakeTopKContexts(const vector<Id>& cids,
                                                  const vector<Id>& eids,
@@ -268,62 +676,24 @@ void FTSAlgorithms::intersect(const vector<Id>& matchingContexts,
              << "so that only matching ones remain\n";
   LOG(DEBUG) << "matchingContexts size: " << matchingContexts.size() << '\n';
   LOG(DEBUG) << "eBlockCids size: " << eBlockCids.size() << '\n';
-  resultCids.reserve(eBlockCids.size() + 2);
-  resultEids.reserve(eBlockCids.size() + 2);
-  resultScores.reserve(eBlockCids.size() + 2);
-  resultCids.resize(eBlockCids.size());
-  resultEids.resize(eBlockCids.size());
-  resultScores.resize(eBlockCids.size());
-  // Cast away constness so we can add sentinels that will be removed
-  // in the end and create and add those sentinels.
-  // Note: this is only efficient if capacity + 2 >= size for the input
-  // context lists. For now, we assume that all lists are read from disk
-  // where they had more than enough size allocated.
-  auto& l1 = const_cast<vector<Id>&>(matchingContexts);
-  auto& l2 = const_cast<vector<Id>&>(eBlockCids);
-  // The two below are needed for the final sentinel match
-  auto& wids = const_cast<vector<Id>&>(eBlockWids);
-  auto& scores = const_cast<vector<Score>&>(eBlockScores);
-
-  Id sent1 = std::numeric_limits<Id>::max();
-  Id sent2 = std::numeric_limits<Id>::max() - 1;
-  Id sentMatch = std::numeric_limits<Id>::max() - 2;
-
-  l1.push_back(sentMatch);
-  l2.push_back(sentMatch);
-  l1.push_back(sent1);
-  l2.push_back(sent2);
-  wids.push_back(0);
-  scores.push_back(0);
-
-  size_t i = 0;
-  size_t j = 0;
-  size_t n = 0;
-
-  while (l1[i] < sent1) {
-    while (l1[i] < l2[j]) { ++i; }
-    while (l2[j] < l1[i]) { ++j; }
-    while (l1[i] == l2[j]) {
-      // Make sure we get all matching elements from the entity list (l2)
-      // that match the current context.
-      // If there are multiple elements for that context in l1,
-      // we can safely skip them unless we want to incorporate the scores
-      // later on.
-      resultCids[n] = l2[j];
-      resultEids[n] = wids[j];
-      resultScores[n++] = scores[j++];
-    }
-    ++i;
-  }
-
-  // Remove sentinels
-  l1.resize(l1.size() - 2);
-  l2.resize(l2.size() - 2);
-  wids.resize(wids.size() - 1);
-  scores.resize(scores.size() - 1);
-  resultCids.resize(n - 1);
-  resultEids.resize(n - 1);
-  resultScores.resize(n - 1);
+  resultCids.clear();
+  resultEids.clear();
+  resultScores.clear();
+  resultCids.reserve(eBlockCids.size());
+  resultEids.reserve(eBlockCids.size());
+  resultScores.reserve(eBlockCids.size());
+  // Keep all entity postings of a matching context. If there are multiple
+  // elements for that context in matchingContexts, we can safely skip them
+  // unless we want to incorporate the scores later on.
+  forEachCommonRun(matchingContexts, eBlockCids,
+                   [&](size_t, size_t, size_t j0, size_t j1) {
+    resultCids.insert(resultCids.end(), eBlockCids.begin() + j0,
+                      eBlockCids.begin() + j1);
+    resultEids.insert(resultEids.end(), eBlockWids.begin() + j0,
+                      eBlockWids.begin() + j1);
+    resultScores.insert(resultScores.end(), eBlockScores.begin() + j0,
+                        eBlockScores.begin() + j1);
+  });
   LOG(DEBUG) << "Intersection done. Size: " << resultCids.size() << "\n";
 }
 
@@ -336,55 +706,20 @@ void FTSAlgorithms::intersectTwoPostingLists(const vector<Id>& cids1,
                                              vector<Score>& resultScores) {
   LOG(DEBUG) << "Intersection of words lists of sizes " << cids1.size() <<
              " and " << cids2.size() << '\n';
-  resultCids.reserve(cids1.size() + 2);
-  resultScores.reserve(cids1.size() + 2);
-  resultCids.resize(cids1.size());
-  resultScores.resize(cids1.size());
-  // Cast away constness so we can add sentinels that will be removed
-  // in the end and create and add those sentinels.
-  // Note: this is only efficient if capacity + 2 >= size for the input
-  // context lists. For now, we assume that all lists are read from disk
-  // where they had more than enough size allocated.
-  auto& l1 = const_cast<vector<Id>&>(cids1);
-  auto& l2 = const_cast<vector<Id>&>(cids2);
-  // The two below are needed for the final sentinel match
-  auto& s1 = const_cast<vector<Score>&>(scores1);
-  auto& s2 = const_cast<vector<Score>&>(scores2);
-
-  Id sent1 = std::numeric_limits<Id>::max();
-  Id sent2 = std::numeric_limits<Id>::max() - 1;
-  Id sentMatch = std::numeric_limits<Id>::max() - 2;
-
-  l1.push_back(sentMatch);
-  l2.push_back(sentMatch);
-  l1.push_back(sent1);
-  l2.push_back(sent2);
-  s1.push_back(0);
-  s2.push_back(0);
-
-  size_t i = 0;
-  size_t j = 0;
-  size_t n = 0;
-
-  while (l1[i] < sent1) {
-    while (l1[i] < l2[j]) { ++i; }
-    while (l2[j] < l1[i]) { ++j; }
-    while (l1[i] == l2[j]) {
-      resultCids[n] = l2[j];
-      resultScores[n++] = s1[i] + s2[j];
-      ++i;
-      ++j;
+  resultCids.clear();
+  resultScores.clear();
+  resultCids.reserve(std::min(cids1.size(), cids2.size()));
+  resultScores.reserve(std::min(cids1.size(), cids2.size()));
+  // Pair the postings of a context in both lists in order, as long as
+  // both have some left.
+  forEachCommonRun(cids1, cids2,
+                   [&](size_t i0, size_t i1, size_t j0, size_t j1) {
+    size_t n = std::min(i1 - i0, j1 - j0);
+    for (size_t k = 0; k < n; ++k) {
+      resultCids.push_back(cids1[i0 + k]);
+      resultScores.push_back(scores1[i0 + k] + scores2[j0 + k]);
     }
-  }
-
-  // Remove sentinels
-  l1.resize(l1.size() - 2);
-  l2.resize(l2.size() - 2);
-  s1.resize(s1.size() - 1);
-  s2.resize(s2.size() - 1);
-  resultCids.resize(n - 1);
-  resultScores.resize(n - 1);
-
+  });
   LOG(DEBUG) << "Intersection done. Size: " << resultCids.size() << "\n";
 }
 
@@ -396,96 +731,73 @@ void FTSAlgorithms::intersectKWay(const vector<vector<Id>>& cidVecs,
                                   vector<Id>& resEids,
                                   vector<Score>& resScores) {
   size_t k = cidVecs.size();
-  LOG(DEBUG) << "K-way intersection of " << k << " lists of sizes:\n";
+  LOG(DEBUG) << "K-way intersection of " << k << " lists.\n";
 
   const bool entityMode = lastListEids != nullptr;
+  resCids.clear();
+  resScores.clear();
+  if (entityMode) {
+    resEids.clear();
+  }
 
-  size_t minSize = std::numeric_limits<size_t>::max();
+  // Visit the lists shortest first. Candidates come from the shortest
+  // list, the others are searched for them. A context that is missing in
+  // one list becomes the next candidate if it is larger.
+  vector<size_t> order(k);
+  for (size_t i = 0; i < k; ++i) {
+    if (cidVecs[i].empty()) { return; }
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&cidVecs](size_t a, size_t b) {
+    return cidVecs[a].size() < cidVecs[b].size();
+  });
+  size_t minSize = cidVecs[order[0]].size();
+  resCids.reserve(entityMode ? lastListEids->size() : minSize);
+  resScores.reserve(entityMode ? lastListEids->size() : minSize);
   if (entityMode) {
-    minSize = lastListEids->size();
-  } else {
-    for (size_t i = 0; i < cidVecs.size(); ++i) {
-      if (cidVecs[i].size() == 0) { return; }
-      if (cidVecs[i].size() < minSize) { minSize = cidVecs[i].size(); }
-    }
-  }
-
-  resCids.reserve(minSize + 2);
-  resCids.resize(minSize);
-  resScores.reserve(minSize + 2);
-  resScores.resize(minSize);
-  if (lastListEids) {
-    resEids.reserve(minSize + 2);
-    resEids.resize(minSize);
-  }
-
-  // For intersection, we don't need a PQ.
-  // The algorithm:
-  // Remember the current context and the length of the streak
-  // (i.e. in how many lists was that context found).
-  // If the streak reaches k, write the context to the result.
-  // Until then, go through lists in a round-robin way and advance until
-  // a) the context is found or
-  // b) a higher context is found without a match before (reset cur and streak).
-  // Stop as soon as one list cannot advance.
-
-  // I think no PQ is needed, because unlike for merge, elements that
-  // do not occur in all lists, don't have to be visited in the right order.
-
-  vector<size_t> nextIndices;
-  nextIndices.resize(cidVecs.size(), 0);
-  Id currentContext = cidVecs[k - 1][0];
-  size_t currentList = k - 1; // Has the fewest different contexts. Start here.
-  size_t streak = 0;
-  size_t n = 0;
-  while (true) {  // break when one list cannot advance
-    size_t thisListSize = cidVecs[currentList].size();
-    while (cidVecs[currentList][nextIndices[currentList]] < currentContext) {
-      nextIndices[currentList] += 1;
-      if (nextIndices[currentList] == thisListSize) { break; }
-    }
-    if (nextIndices[currentList] == thisListSize) { break; }
-    Id atId = cidVecs[currentList][nextIndices[currentList]];
-    if (atId == currentContext) {
-      if (++streak == k) {
-        Score s = 0;
-        for (size_t i = 0; i < k - 1; ++i) {
-          s += scoreVecs[i][(i == currentList ?
-                             nextIndices[i] : nextIndices[i] - 1)];
-        }
-        if (entityMode) {
-          // If entities are involved, there may be multiple postings
-          // for one context. Handle all matching the current context.
-          while (nextIndices[k - 1] - 1 < cidVecs[k - 1].size()
-                 && cidVecs[k - 1][nextIndices[k - 1] - 1] == currentContext) {
-            resCids[n] = currentContext;
-            resEids[n] = (*lastListEids)[nextIndices[k - 1] - 1];
-            resScores[n++] = s + scoreVecs[k - 1][nextIndices[k - 1] - 1];
-            nextIndices[k - 1] += 1;
-          }
-        } else {
-          resCids[n] = currentContext;
-          resScores[n++] = s + scoreVecs[k - 1][(k - 1 == currentList ?
-                                                 nextIndices[k - 1] :
-                                                 nextIndices[k - 1] - 1)];
-        }
-        // Optimization: The last list will feature the fewest different
-        // contexts. After a match, always advance in that list
-        currentList = k - 1;
-        continue;
+    resEids.reserve(lastListEids->size());
+  }
+
+  auto seek = intersectionMode() == MERGE ? advance : gallop;
+  const vector<Id>& driver = cidVecs[order[0]];
+  vector<size_t> nextIndices(k, 0);
+  size_t& d = nextIndices[order[0]];
+  while (d < driver.size()) {
+    Id currentContext = driver[d];
+    size_t o = 1;
+    for (; o < k; ++o) {
+      size_t l = order[o];
+      nextIndices[l] = seek(cidVecs[l], nextIndices[l], currentContext);
+      if (nextIndices[l] == cidVecs[l].size()) { break; }
+      if (cidVecs[l][nextIndices[l]] != currentContext) { break; }
+    }
+    if (o < k) {
+      size_t l = order[o];
+      if (nextIndices[l] == cidVecs[l].size()) { break; }
+      // Continue with the context found instead.
+      d = seek(driver, d, cidVecs[l][nextIndices[l]]);
+      continue;
+    }
+    // Found in all lists. Take the first posting of the context from
+    // each list, but all from the last one if entities are involved.
+    Score s = 0;
+    for (size_t i = 0; i + 1 < k; ++i) {
+      s += scoreVecs[i][nextIndices[i]];
+    }
+    if (entityMode) {
+      const vector<Id>& last = cidVecs[k - 1];
+      for (size_t j = nextIndices[k - 1];
+           j < last.size() && last[j] == currentContext; ++j) {
+        resCids.push_back(currentContext);
+        resEids.push_back((*lastListEids)[j]);
+        resScores.push_back(s + scoreVecs[k - 1][j]);
       }
     } else {
-      streak = 1;
-      currentContext = atId;
+      resCids.push_back(currentContext);
+      resScores.push_back(s + scoreVecs[k - 1][nextIndices[k - 1]]);
     }
-    nextIndices[currentList++] += 1;
-    if (currentList == k) { currentList = 0; }  // wrap around
+    d = runEnd(driver, d);
   }
-
-
-  resCids.resize(n);
-  resScores.resize(n);
-  if (entityMode) { resEids.resize(n); }
   LOG(DEBUG) << "Intersection done. Size: " << resCids.size() << "\n";
 }
 
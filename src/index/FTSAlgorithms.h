@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <array>
+#include <functional>
 #include <unordered_map>
 
 #include "../global/Id.h"
@@ -22,6 +23,28 @@ public:
   typedef vector<array<Id, 2>> WidthTwoList;
   typedef vector<array<Id, 3>> WidthThreeList;
 
+  //! How sorted context lists are intersected.
+  //! MERGE walks all lists linearly. GALLOP searches the contexts of the
+  //! shortest list in the others with exponential and binary search.
+  //! SIMD_MERGE is MERGE that skips blocks of four contexts of both lists
+  //! without a common one at once (with AVX2, else it is MERGE).
+  //! ADAPTIVE, the default, takes GALLOP if the longer of two lists is at
+  //! least GALLOP_MIN_RATIO times as long as the shorter one and SIMD_MERGE
+  //! otherwise. K-way intersections always gallop unless set to MERGE.
+  enum IntersectionMode {
+    MERGE = 0, GALLOP = 1, SIMD_MERGE = 2, ADAPTIVE = 3
+  };
+  static const size_t GALLOP_MIN_RATIO = 64;
+
+  //! Can be changed, e.g. to compare the modes.
+  static IntersectionMode& intersectionMode() {
+    static IntersectionMode mode = ADAPTIVE;
+    return mode;
+  }
+
+  //! Whether the CPU we run on supports the AVX2 block skipping.
+  static bool cpuSupportsSimd();
+
   static void filterByRange(const IdRange& idRange, const vector<Id>& blockCids,
                             const vector<Id>& blockWids,
                             const vector<Score>& blockScores,
@@ -47,6 +70,22 @@ public:
                               const vector<Score>& scores,
                               size_t k, WidthOneList *result);
 
+  //! Reads sub-block b of list i: its contexts in order and their scores.
+  typedef std::function<void(size_t i, size_t b, vector<Id>& cids,
+                             vector<Score>& scores)> SubBlockReader;
+
+  //! The top k of the contexts that occur in all lists, as (context, score)
+  //! rows by descending score, ties by ascending context. The score of a
+  //! context is the sum over the lists of its highest score in each.
+  //! A list is given by the last context and the highest score of each of
+  //! its sub-blocks, a context never spans two sub-blocks.
+  //! Block-max WAND for conjunctions: sub-blocks are only read while their
+  //! highest scores together can still beat the k-th best context so far.
+  static void getTopKByBlockMaxScores(const vector<vector<Id>>& lastCids,
+                                      const vector<vector<Score>>& maxScores,
+                                      const SubBlockReader& readSubBlock,
+                                      size_t k, WidthTwoList *result);
+
   static void aggScoresAndTakeTopKContexts(const vector<Id>& cids,
                                            const vector<Id>& eids,
                                            const vector<Score>& scores,
@@ -71,6 +110,8 @@ public:
   // That list (param: eids) can be given or null.
   // If it is null, resEids is left untouched, otherwise resEids
   // will contain word/entity for the matching contexts.
+  // The lists are visited shortest first: candidates come from the
+  // shortest list and are looked up in the others by galloping.
   static void intersectKWay(const vector<vector<Id>>& cidVecs,
                             const vector<vector<Score>>& scoreVecs,
                             vector<Id> *eids,
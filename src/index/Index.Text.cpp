@@ -7,27 +7,35 @@
 #include <stxxl/algorithm>
 #include "./Index.h"
 #include "../parser/ContextFileParser.h"
-#include "../util/Simple8bCode.h"
+#include "./PostingListCodec.h"
 #include "./FTSAlgorithms.h"
 
 // _____________________________________________________________________________
 void Index::addTextFromContextFile(const string& contextFile) {
   string indexFilename = _onDiskBase + ".text.index";
+  _buildReport.startPhase("text vocabulary");
   size_t nofLines = passContextFileForVocabulary(contextFile);
   _textVocab.writeToFile(_onDiskBase + ".text.vocabulary");
   calculateBlockBoundaries();
+  _buildReport.startPhase("text pass");
   TextVec v(nofLines);
   passContextFileIntoVector(contextFile, v);
   LOG(INFO) << "Sorting text index..." << std::endl;
+  _buildReport.startPhase("text sort");
   stxxl::sort(begin(v), end(v), SortText(), STXXL_MEMORY_TO_USE);
   LOG(INFO) << "Sort done." << std::endl;
+  _buildReport.startPhase("text index");
   createTextIndex(indexFilename, v);
+  _buildReport.endPhase();
   openTextFileHandle();
+  _buildReport.setText(_textMeta,
+                       static_cast<uint64_t>(_textIndexFile.sizeOfFile()));
 }
 
 // _____________________________________________________________________________
 void Index::buildDocsDB(const string& docsFileName) {
   LOG(INFO) << "Building DocsDB...\n";
+  _buildReport.startPhase("docs db");
   ad_utility::File docsFile(docsFileName.c_str(), "r");
   ad_utility::File out(string(_onDiskBase + ".text.docsDB").c_str(), "w");
   off_t currentOffset = 0;
@@ -47,6 +55,7 @@ void Index::buildDocsDB(const string& docsFileName) {
   }
   out.write(&startOfOffsets, sizeof(startOfOffsets));
   out.close();
+  _buildReport.endPhase();
   LOG(INFO) << "DocsDB done.\n";
 }
 
@@ -61,6 +70,8 @@ void Index::addTextFromOnDiskIndex() {
   _textIndexFile.read(buf, static_cast<size_t>(metaTo - metaFrom), metaFrom);
   _textMeta.createFromByteBuffer(buf);
   delete[] buf;
+  _blockCache.clear();
+  _postingListCache.clear();
   LOG(INFO) << "Reading excerpt offsets from file." << endl;
   std::ifstream f(string(_onDiskBase + ".text.docsDB").c_str());
   if (f.good()) {
@@ -107,7 +118,6 @@ void Index::passContextFileIntoVector(const string& contextFile,
     << " and creating stxxl vector.\n";
   ContextFileParser::Line line;
   ContextFileParser p(contextFile);
-  std::unordered_map<string, Id> vocabMap = _vocab.asMap();
   size_t i = 0;
   // write using vector_bufwriter
   TextVec::bufwriter_type writer(vec);
@@ -125,7 +135,7 @@ void Index::passContextFileIntoVector(const string& contextFile,
     }
     if (line._isEntity) {
       Id eid;
-      if (_vocab.getId(line._word, &eid)) {
+      if (getId(line._word, &eid)) {
         entitiesInContext[eid] += line._score;
       } else {
         if (entityNotFoundErrorMsgCount < 20) {
@@ -206,8 +216,10 @@ void Index::createTextIndex(const string& filename, const Index::TextVec& vec) {
     TextBlockMetaData tbmd;
     if (std::get<0>(*reader) != currentBlockId) {
       AD_CHECK(classicPostings.size() > 0);
-      ContextListMetaData classic = writePostings(out, classicPostings, true);
-      ContextListMetaData entity = writePostings(out, entityPostings, false);
+      ContextListMetaData classic = writePostings(out, classicPostings, true,
+                                                  true);
+      ContextListMetaData entity = writePostings(out, entityPostings, false,
+                                                 false);
       _textMeta.addBlock(TextBlockMetaData(
           currentMinWordId,
           currentMaxWordId,
@@ -241,6 +253,15 @@ void Index::createTextIndex(const string& filename, const Index::TextVec& vec) {
       ));
     }
   }
+  // The last block.
+  if (classicPostings.size() > 0) {
+    ContextListMetaData classic = writePostings(out, classicPostings, true,
+                                                true);
+    ContextListMetaData entity = writePostings(out, entityPostings, false,
+                                               false);
+    _textMeta.addBlock(TextBlockMetaData(currentMinWordId, currentMaxWordId,
+                                         classic, entity));
+  }
   LOG(INFO) << "Done creating text index." << std::endl;
   LOG(INFO) << "Writing statistics:\n"
             << _textMeta.statistics() << std::endl;
@@ -256,10 +277,12 @@ void Index::createTextIndex(const string& filename, const Index::TextVec& vec) {
 // _____________________________________________________________________________
 ContextListMetaData Index::writePostings(ad_utility::File& out,
                                          const vector<Posting>& postings,
-                                         bool skipWordlistIfAllTheSame) {
+                                         bool skipWordlistIfAllTheSame,
+                                         bool withSubBlocks) {
   ContextListMetaData meta;
   meta._nofElements = postings.size();
   if (meta._nofElements == 0) {
+    meta._startSubBlocks = _currentoff_t;
     meta._startContextlist = _currentoff_t;
     meta._startWordlist = _currentoff_t;
     meta._startScorelist = _currentoff_t;
@@ -300,32 +323,113 @@ ContextListMetaData Index::writePostings(ad_utility::File& out,
 
   AD_CHECK(meta._nofElements == n);
 
-  // Do the actual writing:
-  size_t bytes = 0;
+  // The word list can be skipped if we're writing classic lists and there
+  // is only one distinct wordId in the block, since this Id is already
+  // stored in the meta data.
+  bool withWordlist = !skipWordlistIfAllTheSame || wordCodebook.size() > 1;
+
+  // Encode everything before writing, the sub-blocks are written first
+  // and point into the code words of the lists.
+  vector<uint64_t> encodedCl;
+  vector<uint64_t> encodedWl;
+  vector<uint64_t> encodedSl;
+  vector<size_t> clEntryElements;
+  vector<size_t> clEntryWords;
+  vector<size_t> wlEntryElements;
+  vector<size_t> wlEntryWords;
+  vector<size_t> slEntryElements;
+  vector<size_t> slEntryWords;
+  meta._contextCodec = encodeList(contextList, n, &encodedCl,
+                                  &clEntryElements, &clEntryWords);
+  if (withWordlist) {
+    meta._wordCodec = encodeList(wordList, n, &encodedWl, &wlEntryElements,
+                                 &wlEntryWords);
+  }
+  meta._scoreCodec = encodeList(scoreList, n, &encodedSl, &slEntryElements,
+                                &slEntryWords);
+
+  // A sub-block ends before the first entry point of the context list that
+  // starts TEXT_SUB_BLOCK_SIZE or more elements after its own start
+  // with a new context.
+  vector<size_t> subBlockStarts;
+  if (withSubBlocks) {
+    subBlockStarts.push_back(0);
+    for (size_t i = 1; i < clEntryElements.size(); ++i) {
+      size_t start = clEntryElements[i];
+      if (start >= subBlockStarts.back() + TEXT_SUB_BLOCK_SIZE &&
+          contextList[start] != 0) {
+        subBlockStarts.push_back(start);
+      }
+    }
+  }
+
+  meta._startSubBlocks = _currentoff_t;
+  meta._startContextlist = meta._startSubBlocks + static_cast<off_t>(
+      subBlockStarts.size() * TextSubBlockMetaData::sizeOnDisk());
+  meta._startWordlist = meta._startContextlist +
+                        static_cast<off_t>(encodedCl.size() * sizeof(uint64_t));
+  off_t wordCodes = meta._startWordlist +
+                    static_cast<off_t>(sizeof(off_t) +
+                                       wordCodebook.size() * sizeof(Id));
+  meta._startScorelist = !withWordlist ? meta._startWordlist :
+                         wordCodes + static_cast<off_t>(
+                             encodedWl.size() * sizeof(uint64_t));
+  off_t scoreCodes = meta._startScorelist +
+                     static_cast<off_t>(sizeof(off_t) +
+                                        scoreCodebook.size() * sizeof(Score));
+  meta._lastByte = scoreCodes +
+                   static_cast<off_t>(encodedSl.size() * sizeof(uint64_t)) - 1;
+
+  // Write sub-blocks:
+  for (size_t i = 0; i < subBlockStarts.size(); ++i) {
+    size_t first = subBlockStarts[i];
+    size_t end = i + 1 < subBlockStarts.size() ? subBlockStarts[i + 1] : n;
+    TextSubBlockMetaData sub;
+    sub._lastContext = std::get<0>(postings[end - 1]);
+    for (size_t j = first; j < end; ++j) {
+      sub._maxScore = std::max(sub._maxScore, std::get<2>(postings[j]));
+    }
+    sub._firstElement = first;
+    size_t entry = static_cast<size_t>(
+        std::lower_bound(clEntryElements.begin(), clEntryElements.end(),
+                         first) - clEntryElements.begin());
+    sub._startContexts = meta._startContextlist + static_cast<off_t>(
+        clEntryWords[entry] * sizeof(uint64_t));
+    if (withWordlist) {
+      entry = static_cast<size_t>(
+          std::upper_bound(wlEntryElements.begin(), wlEntryElements.end(),
+                           first) - wlEntryElements.begin()) - 1;
+      sub._startWords = wordCodes + static_cast<off_t>(
+          wlEntryWords[entry] * sizeof(uint64_t));
+      sub._nofSkippedWords = first - wlEntryElements[entry];
+    }
+    entry = static_cast<size_t>(
+        std::upper_bound(slEntryElements.begin(), slEntryElements.end(),
+                         first) - slEntryElements.begin()) - 1;
+    sub._startScores = scoreCodes + static_cast<off_t>(
+        slEntryWords[entry] * sizeof(uint64_t));
+    sub._nofSkippedScores = first - slEntryElements[entry];
+    out << sub;
+    _currentoff_t += TextSubBlockMetaData::sizeOnDisk();
+  }
 
   // Write context list:
-  meta._startContextlist = _currentoff_t;
-  bytes = writeList(contextList, meta._nofElements, out);
-  _currentoff_t += bytes;
+  _currentoff_t += out.write(encodedCl.data(),
+                             encodedCl.size() * sizeof(uint64_t));
 
   // Write word list:
-  // This can be skipped if we're writing classic lists and there
-  // is only one distinct wordId in the block, since this Id is already
-  // stored in the meta data.
-  meta._startWordlist = _currentoff_t;
-  if (!skipWordlistIfAllTheSame || wordCodebook.size() > 1) {
+  if (withWordlist) {
     _currentoff_t += writeCodebook(wordCodebook, out);
-    bytes = writeList(wordList, meta._nofElements, out);
-    _currentoff_t += bytes;
+    _currentoff_t += out.write(encodedWl.data(),
+                               encodedWl.size() * sizeof(uint64_t));
   }
 
   // Write scores
-  meta._startScorelist = _currentoff_t;
   _currentoff_t += writeCodebook(scoreCodebook, out);
-  bytes = writeList(scoreList, meta._nofElements, out);
-  _currentoff_t += bytes;
+  _currentoff_t += out.write(encodedSl.data(),
+                             encodedSl.size() * sizeof(uint64_t));
 
-  meta._lastByte = _currentoff_t - 1;
+  AD_CHECK_EQ(meta._lastByte + 1, _currentoff_t);
 
   delete[] contextList;
   delete[] wordList;
@@ -345,13 +449,16 @@ void Index::calculateBlockBoundaries() {
   // 4) word.substring(0, MIN_PREFIX_LENGTH) is different from the next.
   // A block boundary is always the last WordId in the block.
   // this way std::lower_bound will point to the correct bracket.
-  for (size_t i = 0; i < _textVocab.size() - 1; ++i) {
-    if (_textVocab[i].size() < MIN_WORD_PREFIX_SIZE ||
-        (_textVocab[i + 1].size() < MIN_WORD_PREFIX_SIZE) ||
-        _textVocab[i].substr(0, MIN_WORD_PREFIX_SIZE) !=
-        _textVocab[i + 1].substr(0, MIN_WORD_PREFIX_SIZE)) {
+  string current = _textVocab.size() > 0 ? _textVocab[0] : "";
+  for (size_t i = 0; i + 1 < _textVocab.size(); ++i) {
+    string next = _textVocab[i + 1];
+    if (current.size() < MIN_WORD_PREFIX_SIZE ||
+        (next.size() < MIN_WORD_PREFIX_SIZE) ||
+        current.substr(0, MIN_WORD_PREFIX_SIZE) !=
+        next.substr(0, MIN_WORD_PREFIX_SIZE)) {
       _blockBoundaries.push_back(i);
     }
+    current.swap(next);
   }
   _blockBoundaries.push_back(_textVocab.size() - 1);
   LOG(INFO) << "Done. Got " << _blockBoundaries.size() <<
@@ -372,19 +479,15 @@ Id Index::getEntityBlockId(Id entityId) const {
 
 // _____________________________________________________________________________
 template<typename Numeric>
-size_t Index::writeList(Numeric *data, size_t nofElements,
-                        ad_utility::File& file) const {
-  if (nofElements > 0) {
-    uint64_t *encoded = new uint64_t[nofElements];
-    size_t size = ad_utility::Simple8bCode::encode(data, nofElements,
-                                                   encoded);
-    size_t ret = file.write(encoded, size);
-    AD_CHECK_EQ(size, ret);
-    delete[] encoded;
-    return size;
-  } else {
-    return 0;
-  }
+PostingListCodec::Codec Index::encodeList(Numeric *data, size_t nofElements,
+                                          vector<uint64_t>* encoded,
+                                          vector<size_t>* entryElements,
+                                          vector<size_t>* entryWords) const {
+  vector<uint64_t> values(data, data + nofElements);
+  encoded->clear();
+  return PostingListCodec::encodeWithBestCodec(
+      _textCodecSelection, _textCodecs, values.data(), nofElements, encoded,
+      entryElements, entryWords);
 }
 
 // _____________________________________________________________________________
@@ -453,10 +556,12 @@ size_t Index::writeCodebook(const vector<T>& codebook,
 void Index::openTextFileHandle() {
   AD_CHECK(_onDiskBase.size() > 0);
   _textIndexFile.open(string(_onDiskBase + ".text.index").c_str(), "r");
+  _blockCache.clear();
+  _postingListCache.clear();
 }
 
 // _____________________________________________________________________________
-const string& Index::wordIdToString(Id id) const {
+string Index::wordIdToString(Id id) const {
   return _textVocab[id];
 }
 
@@ -501,26 +606,210 @@ void Index::getContextListForWords(const string& words,
 }
 
 // _____________________________________________________________________________
-void Index::getWordPostingsForTerm(const string& term, vector<Id>& cids,
-                                   vector<Score>& scores) const {
-  LOG(DEBUG) << "Getting word postings for term: " << term << '\n';
-  IdRange idRange;
+void Index::getTopKContextsForWords(const string& words, size_t k,
+                                    Index::WidthTwoList *result) const {
+  LOG(DEBUG) << "In getTopKContextsForWords...\n";
+  result->clear();
+  auto terms = ad_utility::split(words, ' ');
+  AD_CHECK(terms.size() > 0);
+
+  vector<IdRange> idRanges(terms.size());
+  vector<const TextBlockMetaData*> blocks;
+  vector<shared_ptr<const vector<TextSubBlockMetaData>>> subBlocks;
+  vector<vector<Id>> lastCids(terms.size());
+  vector<vector<Score>> maxScores(terms.size());
+  for (size_t i = 0; i < terms.size(); ++i) {
+    if (!getIdRangeForTerm(terms[i], &idRanges[i])) {
+      return;
+    }
+    blocks.push_back(&_textMeta.getBlockInfoByWordRange(idRanges[i]._first,
+                                                        idRanges[i]._last));
+    subBlocks.push_back(readSubBlockMetaData(blocks.back()->_cl));
+    for (const auto& sub : *subBlocks.back()) {
+      lastCids[i].push_back(sub._lastContext);
+      maxScores[i].push_back(sub._maxScore);
+    }
+  }
+  FTSAlgorithms::getTopKByBlockMaxScores(
+      lastCids, maxScores,
+      [&](size_t i, size_t b, vector<Id>& cids, vector<Score>& scores) {
+        readSubBlock(*blocks[i], *subBlocks[i], b, idRanges[i], cids, scores);
+      },
+      k, result);
+  LOG(DEBUG) << "Done with getTopKContextsForWords. Result size: "
+             << result->size() << "\n";
+}
+
+// _____________________________________________________________________________
+bool Index::getIdRangeForTerm(const string& term, IdRange* idRange) const {
   if (term[term.size() - 1] == PREFIX_CHAR) {
-    if (!_textVocab.getIdRangeForFullTextPrefix(term, &idRange)) {
+    if (!_textVocab.getIdRangeForFullTextPrefix(term, idRange)) {
       LOG(INFO) << "Prefix: " << term << " not in vocabulary\n";
-      return;
+      return false;
     }
   } else {
-    if (!_textVocab.getId(term, &idRange._first)) {
+    if (!_textVocab.getId(term, &idRange->_first)) {
       LOG(INFO) << "Term: " << term << " not in vocabulary\n";
-      return;
+      return false;
     }
-    idRange._last = idRange._first;
+    idRange->_last = idRange->_first;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+shared_ptr<const vector<TextSubBlockMetaData>> Index::readSubBlockMetaData(
+    const ContextListMetaData& cl) const {
+  size_t nofBytes = static_cast<size_t>(cl._startContextlist -
+                                        cl._startSubBlocks);
+  if (nofBytes == 0) {
+    return std::make_shared<vector<TextSubBlockMetaData>>();
+  }
+  ad_utility::BlockCache::Key key = {TEXT_INDEX_CACHE_ID,
+                                     cl._startSubBlocks, nofBytes};
+  shared_ptr<const vector<TextSubBlockMetaData>> cached =
+      _blockCache.get<vector<TextSubBlockMetaData>>(key);
+  if (cached) {
+    return cached;
+  }
+  vector<unsigned char> buffer(nofBytes);
+  AD_CHECK_EQ(nofBytes, _textIndexFile.read(buffer.data(), nofBytes,
+                                            cl._startSubBlocks));
+  auto subBlocks = std::make_shared<vector<TextSubBlockMetaData>>(
+      cl.getNofSubBlocks());
+  for (size_t i = 0; i < subBlocks->size(); ++i) {
+    (*subBlocks)[i].createFromByteBuffer(
+        buffer.data() + i * TextSubBlockMetaData::sizeOnDisk());
+  }
+  _blockCache.insert<vector<TextSubBlockMetaData>>(key, subBlocks, nofBytes);
+  return subBlocks;
+}
+
+// _____________________________________________________________________________
+void Index::readSubBlock(const TextBlockMetaData& tbmd,
+                         const vector<TextSubBlockMetaData>& subBlocks,
+                         size_t b, const IdRange& idRange, vector<Id>& cids,
+                         vector<Score>& scores) const {
+  const ContextListMetaData& cl = tbmd._cl;
+  const TextSubBlockMetaData& sub = subBlocks[b];
+  bool isLast = b + 1 == subBlocks.size();
+  off_t contextsEnd = isLast ? cl._startWordlist :
+                      subBlocks[b + 1]._startContexts;
+  // Not keyed as the file, sub-blocks may cover the same bytes as whole
+  // lists that are cached decoded differently.
+  ad_utility::BlockCache::Key key = {
+      TEXT_SUB_BLOCK_CACHE_ID, sub._startContexts,
+      static_cast<size_t>(contextsEnd - sub._startContexts)};
+  shared_ptr<const TextPostings> block = _blockCache.get<TextPostings>(key);
+  if (!block) {
+    size_t nofElements = (isLast ? cl._nofElements :
+                          subBlocks[b + 1]._firstElement) - sub._firstElement;
+    // The last code word or chunk of the word and score elements may also
+    // hold some of the next sub-block.
+    off_t wordsEnd = isLast ? cl._startScorelist : std::min(
+        subBlocks[b + 1]._startWords + off_t(sizeof(uint64_t) *
+            PostingListCodec::maxWordsPerEntry(cl._wordCodec)),
+        cl._startScorelist);
+    off_t scoresEnd = isLast ? cl._lastByte + 1 : std::min(
+        subBlocks[b + 1]._startScores + off_t(sizeof(uint64_t) *
+            PostingListCodec::maxWordsPerEntry(cl._scoreCodec)),
+        cl._lastByte + 1);
+    // The codebooks end where the code words of the first sub-block begin.
+    off_t startWordCodebook = cl._startWordlist + off_t(sizeof(off_t));
+    off_t startScoreCodebook = cl._startScorelist + off_t(sizeof(off_t));
+    vector<Id> wordCodebook;
+    vector<Score> scoreCodebook(static_cast<size_t>(
+        subBlocks[0]._startScores - startScoreCodebook) / sizeof(Score));
+    vector<uint64_t> encodedCids(static_cast<size_t>(
+        contextsEnd - sub._startContexts) / sizeof(uint64_t));
+    vector<uint64_t> encodedWids;
+    vector<uint64_t> encodedScores(static_cast<size_t>(
+        scoresEnd - sub._startScores) / sizeof(uint64_t));
+
+    // In the order of the file, so that adjacent parts are read at once.
+    vector<ad_utility::File::ReadRequest> requests(1);
+    requests[0]._buffer = encodedCids.data();
+    requests[0]._nofBytes = encodedCids.size() * sizeof(uint64_t);
+    requests[0]._offset = sub._startContexts;
+    if (cl.hasMultipleWords()) {
+      wordCodebook.resize(static_cast<size_t>(
+          subBlocks[0]._startWords - startWordCodebook) / sizeof(Id));
+      encodedWids.resize(static_cast<size_t>(
+          wordsEnd - sub._startWords) / sizeof(uint64_t));
+      requests.push_back({wordCodebook.data(),
+                          wordCodebook.size() * sizeof(Id),
+                          startWordCodebook});
+      requests.push_back({encodedWids.data(),
+                          encodedWids.size() * sizeof(uint64_t),
+                          sub._startWords});
+    }
+    requests.push_back({scoreCodebook.data(),
+                        scoreCodebook.size() * sizeof(Score),
+                        startScoreCodebook});
+    requests.push_back({encodedScores.data(),
+                        encodedScores.size() * sizeof(uint64_t),
+                        sub._startScores});
+    AD_CHECK(_textIndexFile.readBatch(requests));
+
+    auto decoded = std::make_shared<TextPostings>();
+    decoded->_cids.resize(nofElements + 250);
+    PostingListCodec::decodeGaps(
+        cl._contextCodec, encodedCids.data(), nofElements,
+        decoded->_cids.data(),
+        b > 0 ? subBlocks[b - 1]._lastContext : Id(0));
+    decoded->_cids.resize(nofElements);
+    // The first elements of the word and score code words may belong to
+    // the previous sub-block, decode them and drop them afterwards.
+    if (cl.hasMultipleWords()) {
+      decoded->_wids.resize(sub._nofSkippedWords + nofElements + 250);
+      PostingListCodec::decodeWithCodebook(
+          cl._wordCodec, encodedWids.data(), sub._nofSkippedWords + nofElements,
+          wordCodebook.data(), decoded->_wids.data());
+      decoded->_wids.erase(decoded->_wids.begin(),
+                           decoded->_wids.begin() + sub._nofSkippedWords);
+      decoded->_wids.resize(nofElements);
+    }
+    decoded->_scores.resize(sub._nofSkippedScores + nofElements + 250);
+    PostingListCodec::decodeWithCodebook(
+        cl._scoreCodec, encodedScores.data(), sub._nofSkippedScores + nofElements,
+        scoreCodebook.data(), decoded->_scores.data());
+    decoded->_scores.erase(decoded->_scores.begin(),
+                           decoded->_scores.begin() + sub._nofSkippedScores);
+    decoded->_scores.resize(nofElements);
+    _blockCache.insert<TextPostings>(key, decoded, decoded->getSizeInBytes());
+    block = decoded;
+  }
+
+  if (!block->_wids.empty() && (tbmd._firstWordId != idRange._first ||
+                                tbmd._lastWordId != idRange._last)) {
+    FTSAlgorithms::filterByRange(idRange, block->_cids, block->_wids,
+                                 block->_scores, cids, scores);
+  } else {
+    cids = block->_cids;
+    scores = block->_scores;
+  }
+}
+
+// _____________________________________________________________________________
+void Index::getWordPostingsForTerm(const string& term, vector<Id>& cids,
+                                   vector<Score>& scores) const {
+  LOG(DEBUG) << "Getting word postings for term: " << term << '\n';
+  IdRange idRange;
+  if (!getIdRangeForTerm(term, &idRange)) {
+    return;
   }
   const auto& tbmd = _textMeta.getBlockInfoByWordRange(idRange._first,
                                                        idRange._last);
-  if (tbmd._cl.hasMultipleWords() || (tbmd._firstWordId == idRange._first &&
-                                      tbmd._lastWordId == idRange._last)) {
+  ad_utility::BlockCache::Key key = postingListCacheKey(tbmd._cl, idRange);
+  shared_ptr<const TextPostings> cached =
+      _postingListCache.get<TextPostings>(key);
+  if (cached) {
+    cids = cached->_cids;
+    scores = cached->_scores;
+    return;
+  }
+  if (tbmd._cl.hasMultipleWords() && !(tbmd._firstWordId == idRange._first &&
+                                       tbmd._lastWordId == idRange._last)) {
     vector<Id> blockCids;
     vector<Id> blockWids;
     vector<Score> blockScores;
@@ -528,17 +817,17 @@ void Index::getWordPostingsForTerm(const string& term, vector<Id>& cids,
                      tbmd._cl._startContextlist,
                      static_cast<size_t>(tbmd._cl._startWordlist -
                                          tbmd._cl._startContextlist),
-                     blockCids);
+                     tbmd._cl._contextCodec, blockCids);
     readFreqComprList(tbmd._cl._nofElements,
                       tbmd._cl._startWordlist,
                       static_cast<size_t>(tbmd._cl._startScorelist -
                                           tbmd._cl._startWordlist),
-                      blockWids);
+                      tbmd._cl._wordCodec, blockWids);
     readFreqComprList(tbmd._cl._nofElements,
                       tbmd._cl._startScorelist,
                       static_cast<size_t>(tbmd._cl._lastByte + 1 -
                                           tbmd._cl._startScorelist),
-                      blockScores);
+                      tbmd._cl._scoreCodec, blockScores);
     FTSAlgorithms::filterByRange(idRange, blockCids, blockWids, blockScores,
                                  cids, scores);
   } else {
@@ -546,13 +835,18 @@ void Index::getWordPostingsForTerm(const string& term, vector<Id>& cids,
                      tbmd._cl._startContextlist,
                      static_cast<size_t>(tbmd._cl._startWordlist -
                                          tbmd._cl._startContextlist),
-                     cids);
+                     tbmd._cl._contextCodec, cids);
     readFreqComprList(tbmd._cl._nofElements,
                       tbmd._cl._startScorelist,
                       static_cast<size_t>(tbmd._cl._lastByte + 1 -
                                           tbmd._cl._startScorelist),
-                      scores);
+                      tbmd._cl._scoreCodec, scores);
   }
+  auto postings = std::make_shared<TextPostings>();
+  postings->_cids = cids;
+  postings->_scores = scores;
+  _postingListCache.insert<TextPostings>(key, postings,
+                                         postings->getSizeInBytes());
   LOG(DEBUG) << "Word postings for term: " << term
              << ": cids: " << cids.size() << " scores " << scores.size() <<
              '\n';
@@ -649,6 +943,16 @@ void Index::getEntityPostingsForTerm(const string& term, vector<Id>& cids,
   }
   const auto& tbmd = _textMeta.getBlockInfoByWordRange(idRange._first,
                                                        idRange._last);
+  ad_utility::BlockCache::Key key = postingListCacheKey(tbmd._entityCl,
+                                                        idRange);
+  shared_ptr<const TextPostings> cached =
+      _postingListCache.get<TextPostings>(key);
+  if (cached) {
+    cids = cached->_cids;
+    eids = cached->_wids;
+    scores = cached->_scores;
+    return;
+  }
 
   if (!tbmd._cl.hasMultipleWords() || (tbmd._firstWordId == idRange._first &&
                                        tbmd._lastWordId == idRange._last)) {
@@ -659,17 +963,17 @@ void Index::getEntityPostingsForTerm(const string& term, vector<Id>& cids,
                      tbmd._entityCl._startContextlist,
                      static_cast<size_t>(tbmd._entityCl._startWordlist -
                                          tbmd._entityCl._startContextlist),
-                     cids);
+                     tbmd._entityCl._contextCodec, cids);
     readFreqComprList(tbmd._entityCl._nofElements,
                       tbmd._entityCl._startWordlist,
                       static_cast<size_t>(tbmd._entityCl._startScorelist -
                                           tbmd._entityCl._startWordlist),
-                      eids);
+                      tbmd._entityCl._wordCodec, eids);
     readFreqComprList(tbmd._entityCl._nofElements,
                       tbmd._entityCl._startScorelist,
                       static_cast<size_t>(tbmd._entityCl._lastByte + 1 -
                                           tbmd._entityCl._startScorelist),
-                      scores);
+                      tbmd._entityCl._scoreCodec, scores);
   } else {
     // CASE: more than one word in the block.
     // Need to obtain matching postings for regular words and intersect for
@@ -686,44 +990,56 @@ void Index::getEntityPostingsForTerm(const string& term, vector<Id>& cids,
                      tbmd._entityCl._startContextlist,
                      static_cast<size_t>(tbmd._entityCl._startWordlist -
                                          tbmd._entityCl._startContextlist),
-                     eBlockCids);
+                     tbmd._entityCl._contextCodec, eBlockCids);
     readFreqComprList(tbmd._entityCl._nofElements,
                       tbmd._entityCl._startWordlist,
                       static_cast<size_t>(tbmd._entityCl._startScorelist -
                                           tbmd._entityCl._startWordlist),
-                      eBlockWids);
+                      tbmd._entityCl._wordCodec, eBlockWids);
     readFreqComprList(tbmd._entityCl._nofElements,
                       tbmd._entityCl._startScorelist,
                       static_cast<size_t>(tbmd._entityCl._lastByte + 1 -
                                           tbmd._entityCl._startScorelist),
-                      eBlockScores);
+                      tbmd._entityCl._scoreCodec, eBlockScores);
     FTSAlgorithms::intersect(matchingContexts, matchingContextScores,
                              eBlockCids, eBlockWids,
                              eBlockScores, cids, eids, scores);
   }
+  auto postings = std::make_shared<TextPostings>();
+  postings->_cids = cids;
+  postings->_wids = eids;
+  postings->_scores = scores;
+  _postingListCache.insert<TextPostings>(key, postings,
+                                         postings->getSizeInBytes());
 }
 
 
 // _____________________________________________________________________________
 template<typename T>
 void Index::readGapComprList(size_t nofElements, off_t from, size_t nofBytes,
+                             PostingListCodec::Codec codec,
                              vector<T>& result) const {
   LOG(DEBUG) << "Reading gap-encoded list from disk...\n";
   LOG(TRACE) << "NofElements: " << nofElements << ", from: " << from <<
              ", nofBytes: " << nofBytes << '\n';
+  ad_utility::BlockCache::Key key = {TEXT_INDEX_CACHE_ID, from, nofBytes};
+  shared_ptr<const vector<T>> cached = _blockCache.get<vector<T>>(key);
+  if (cached) {
+    result = *cached;
+    LOG(DEBUG) << "Took list from the block cache. Size: " << result.size()
+               << "\n";
+    return;
+  }
   result.resize(nofElements + 250);
   uint64_t *encoded = new uint64_t[nofBytes / 8];
   _textIndexFile.read(encoded, nofBytes, from);
-  LOG(DEBUG) << "Decoding Simple8b code...\n";
-  ad_utility::Simple8bCode::decode(encoded, nofElements, result.data());
-  LOG(DEBUG) << "Reverting gaps to actual IDs...\n";
-  T id = 0;
-  for (size_t i = 0; i < result.size(); ++i) {
-    id += result[i];
-    result[i] = id;
-  }
+  LOG(DEBUG) << "Decoding " << PostingListCodec::name(codec)
+             << " code and reverting gaps...\n";
+  PostingListCodec::decodeGaps(codec, encoded, nofElements, result.data());
   result.resize(nofElements);
   delete[] encoded;
+  _blockCache.insert<vector<T>>(key, std::make_shared<vector<T>>(result),
+                                result.size() * sizeof(T));
   LOG(DEBUG) << "Done reading gap-encoded list. Size: " << result.size() <<
              "\n";
 }
@@ -731,12 +1047,22 @@ void Index::readGapComprList(size_t nofElements, off_t from, size_t nofBytes,
 // _____________________________________________________________________________
 template<typename T>
 void Index::readFreqComprList(size_t nofElements, off_t from, size_t nofBytes,
+                              PostingListCodec::Codec codec,
                               vector<T>& result) const {
   LOG(DEBUG) << "Reading frequency-encoded list from disk...\n";
   LOG(TRACE) << "NofElements: " << nofElements << ", from: " << from <<
              ", nofBytes: " << nofBytes << '\n';
+  ad_utility::BlockCache::Key key = {TEXT_INDEX_CACHE_ID, from, nofBytes};
+  shared_ptr<const vector<T>> cached = _blockCache.get<vector<T>>(key);
+  if (cached) {
+    result = *cached;
+    LOG(DEBUG) << "Took list from the block cache. Size: " << result.size()
+               << "\n";
+    return;
+  }
   size_t nofCodebookBytes;
-  uint64_t *encoded = new uint64_t[nofElements];
+  // Chunked codecs may need more than one word per element.
+  uint64_t *encoded = new uint64_t[nofBytes / sizeof(uint64_t)];
   result.resize(nofElements + 250);
   off_t current = from;
   size_t ret = _textIndexFile.read(&nofCodebookBytes, sizeof(off_t), current);
@@ -744,22 +1070,25 @@ void Index::readFreqComprList(size_t nofElements, off_t from, size_t nofBytes,
   AD_CHECK_EQ(sizeof(off_t), ret);
   current += ret;
   T *codebook = new T[nofCodebookBytes / sizeof(T)];
-  ret = _textIndexFile.read(codebook, nofCodebookBytes);
-  current += ret;
-  AD_CHECK_EQ(ret, size_t(nofCodebookBytes));
-  ret = _textIndexFile.read(encoded,
-                            static_cast<size_t>(nofBytes - (current - from)));
-  current += ret;
-  AD_CHECK_EQ(size_t(current - from), nofBytes);
-  LOG(DEBUG) << "Decoding Simple8b code...\n";
-  ad_utility::Simple8bCode::decode(encoded, nofElements, result.data());
-  LOG(DEBUG) << "Reverting frequency encoded items to actual IDs...\n";
+  // Codebook and list follow each other, read them with one call.
+  vector<ad_utility::File::ReadRequest> requests(2);
+  requests[0]._buffer = codebook;
+  requests[0]._nofBytes = nofCodebookBytes;
+  requests[0]._offset = current;
+  current += nofCodebookBytes;
+  requests[1]._buffer = encoded;
+  requests[1]._nofBytes = static_cast<size_t>(nofBytes - (current - from));
+  requests[1]._offset = current;
+  AD_CHECK(_textIndexFile.readBatch(requests));
+  LOG(DEBUG) << "Decoding " << PostingListCodec::name(codec)
+             << " code and looking up the codebook...\n";
+  PostingListCodec::decodeWithCodebook(codec, encoded, nofElements, codebook,
+                                       result.data());
   result.resize(nofElements);
-  for (size_t i = 0; i < result.size(); ++i) {
-    result[i] = codebook[result[i]];
-  }
   delete[] encoded;
   delete[] codebook;
+  _blockCache.insert<vector<T>>(key, std::make_shared<vector<T>>(result),
+                                result.size() * sizeof(T));
   LOG(DEBUG) << "Done reading frequency-encoded list. Size: " <<
              result.size() << "\n";
 }
@@ -797,8 +1126,9 @@ void Index::dumpAsciiLists() const {
       ids.resize(nofElements + 250);
       uint64_t *encodedD = new uint64_t[nofBytes / 8];
       _textIndexFile.read(encodedD, nofBytes, from);
-      LOG(DEBUG) << "Decoding Simple8b code...\n";
-      ad_utility::Simple8bCode::decode(encodedD, nofElements, ids.data());
+      LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._cl._contextCodec)
+                 << " code...\n";
+      PostingListCodec::decode(tbmd._cl._contextCodec, encodedD, nofElements, ids.data());
       ids.resize(nofElements);
       delete[] encodedD;
       writeAsciiListFile(docIdsFn, ids);
@@ -819,16 +1149,18 @@ void Index::dumpAsciiLists() const {
         AD_CHECK_EQ(sizeof(off_t), ret);
         current += ret;
         Id *codebookW = new Id[nofCodebookBytes / sizeof(Id)];
-        ret = _textIndexFile.read(codebookW, nofCodebookBytes);
+        ret = _textIndexFile.read(codebookW, nofCodebookBytes, current);
         current += ret;
         AD_CHECK_EQ(ret, size_t(nofCodebookBytes));
         ret = _textIndexFile.read(encodedW,
                                   static_cast<size_t>(nofBytes -
-                                                      (current - from)));
+                                                      (current - from)),
+                                  current);
         current += ret;
         AD_CHECK_EQ(size_t(current - from), nofBytes);
-        LOG(DEBUG) << "Decoding Simple8b code...\n";
-        ad_utility::Simple8bCode::decode(encodedW, nofElements, ids.data());
+        LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._cl._wordCodec)
+                   << " code...\n";
+        PostingListCodec::decode(tbmd._cl._wordCodec, encodedW, nofElements, ids.data());
         ids.resize(nofElements);;
         delete[] encodedW;
         delete[] codebookW;
@@ -848,16 +1180,18 @@ void Index::dumpAsciiLists() const {
       AD_CHECK_EQ(sizeof(off_t), ret);
       current += ret;
       Score *codebookS = new Score[nofCodebookBytes / sizeof(Score)];
-      ret = _textIndexFile.read(codebookS, nofCodebookBytes);
+      ret = _textIndexFile.read(codebookS, nofCodebookBytes, current);
       current += ret;
       AD_CHECK_EQ(ret, size_t(nofCodebookBytes));
       ret = _textIndexFile.read(encodedS,
                                 static_cast<size_t>(nofBytes -
-                                                    (current - from)));
+                                                    (current - from)),
+                                current);
       current += ret;
       AD_CHECK_EQ(size_t(current - from), nofBytes);
-      LOG(DEBUG) << "Decoding Simple8b code...\n";
-      ad_utility::Simple8bCode::decode(encodedS, nofElements, ids.data());
+      LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._cl._scoreCodec)
+                 << " code...\n";
+      PostingListCodec::decode(tbmd._cl._scoreCodec, encodedS, nofElements, ids.data());
       ids.resize(nofElements);
       delete[] encodedS;
       delete[] codebookS;
@@ -879,8 +1213,9 @@ void Index::dumpAsciiLists() const {
       ids.resize(nofElements + 250);
       uint64_t *encodedD = new uint64_t[nofBytes / 8];
       _textIndexFile.read(encodedD, nofBytes, from);
-      LOG(DEBUG) << "Decoding Simple8b code...\n";
-      ad_utility::Simple8bCode::decode(encodedD, nofElements, ids.data());
+      LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._entityCl._contextCodec)
+                 << " code...\n";
+      PostingListCodec::decode(tbmd._entityCl._contextCodec, encodedD, nofElements, ids.data());
       ids.resize(nofElements);
       delete[] encodedD;
       writeAsciiListFile(eDocIdsFn, ids);
@@ -901,16 +1236,18 @@ void Index::dumpAsciiLists() const {
         AD_CHECK_EQ(sizeof(off_t), ret);
         current += ret;
         Id *codebookW = new Id[nofCodebookBytes / sizeof(Id)];
-        ret = _textIndexFile.read(codebookW, nofCodebookBytes);
+        ret = _textIndexFile.read(codebookW, nofCodebookBytes, current);
         current += ret;
         AD_CHECK_EQ(ret, size_t(nofCodebookBytes));
         ret = _textIndexFile.read(encodedW,
                                   static_cast<size_t>(nofBytes -
-                                                      (current - from)));
+                                                      (current - from)),
+                                  current);
         current += ret;
         AD_CHECK_EQ(size_t(current - from), nofBytes);
-        LOG(DEBUG) << "Decoding Simple8b code...\n";
-        ad_utility::Simple8bCode::decode(encodedW, nofElements, ids.data());
+        LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._entityCl._wordCodec)
+                   << " code...\n";
+        PostingListCodec::decode(tbmd._entityCl._wordCodec, encodedW, nofElements, ids.data());
         ids.resize(nofElements);;
         delete[] encodedW;
         delete[] codebookW;
@@ -930,16 +1267,18 @@ void Index::dumpAsciiLists() const {
       AD_CHECK_EQ(sizeof(off_t), ret);
       current += ret;
       Score *codebookS = new Score[nofCodebookBytes / sizeof(Score)];
-      ret = _textIndexFile.read(codebookS, nofCodebookBytes);
+      ret = _textIndexFile.read(codebookS, nofCodebookBytes, current);
       current += ret;
       AD_CHECK_EQ(ret, size_t(nofCodebookBytes));
       ret = _textIndexFile.read(encodedS,
                                 static_cast<size_t>(nofBytes -
-                                                    (current - from)));
+                                                    (current - from)),
+                                current);
       current += ret;
       AD_CHECK_EQ(size_t(current - from), nofBytes);
-      LOG(DEBUG) << "Decoding Simple8b code...\n";
-      ad_utility::Simple8bCode::decode(encodedS, nofElements, ids.data());
+      LOG(DEBUG) << "Decoding " << PostingListCodec::name(tbmd._entityCl._scoreCodec)
+                 << " code...\n";
+      PostingListCodec::decode(tbmd._entityCl._scoreCodec, encodedS, nofElements, ids.data());
       ids.resize(nofElements);;
       delete[] encodedS;
       delete[] codebookS;
@@ -3,31 +3,46 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 #include <stxxl/algorithm>
 #include "../parser/TsvParser.h"
 #include "./Index.h"
+#include "./VocabularyMerger.h"
+#include "./CompressedPairBlocks.h"
+#include "../util/Timer.h"
 #include "../parser/NTriplesParser.h"
 
 using std::array;
 
+namespace {
+// Sort columns and file suffixes of the permutations,
+// in the order of Index::Permutation.
+const size_t PERMUTATION_COLUMNS[][3] = {
+    {1, 0, 2}, {1, 2, 0}, {0, 1, 2}, {0, 2, 1}, {2, 0, 1}, {2, 1, 0}
+};
+const char* PERMUTATION_SUFFIXES[] = {
+    ".index.pso", ".index.pos", ".index.spo",
+    ".index.sop", ".index.osp", ".index.ops"
+};
+}
+
 // _____________________________________________________________________________
 void Index::createFromTsvFile(const string& tsvFile, const string& onDiskBase) {
   _onDiskBase = onDiskBase;
   string indexFilename = _onDiskBase + ".index";
-  size_t nofLines = passTsvFileForVocabulary(tsvFile);
-  _vocab.writeToFile(onDiskBase + ".vocabulary");
-  ExtVec v(nofLines);
-  passTsvFileIntoIdVector(tsvFile, v);
-  LOG(INFO) << "Sorting for PSO permutation..." << std::endl;
-  stxxl::sort(begin(v), end(v), SortByPSO(), STXXL_MEMORY_TO_USE);
-  LOG(INFO) << "Sort done." << std::endl;
-  createPermutation(indexFilename + ".pso", v, _psoMeta, 0, 2);
-  LOG(INFO) << "Sorting for POS permutation..." << std::endl;;
-  stxxl::sort(begin(v), end(v), SortByPOS(), STXXL_MEMORY_TO_USE);
-  LOG(INFO) << "Sort done." << std::endl;;
-  createPermutation(indexFilename + ".pos", v, _posMeta, 2, 0);
-  openFileHandles();
+  ExtVec v;
+  passFileIntoIdVector<ParallelTsvParser>(tsvFile, v);
+  createPermutations(indexFilename, v);
+  registerPermutations();
 }
 
 // _____________________________________________________________________________
@@ -35,138 +50,290 @@ void Index::createFromNTriplesFile(const string& ntFile,
                                    const string& onDiskBase) {
   _onDiskBase = onDiskBase;
   string indexFilename = _onDiskBase + ".index";
-  size_t nofLines = passNTriplesFileForVocabulary(ntFile);
-  _vocab.writeToFile(onDiskBase + ".vocabulary");
-  ExtVec v(nofLines);
-  passNTriplesFileIntoIdVector(ntFile, v);
-  LOG(INFO) << "Sorting for PSO permutation..." << std::endl;
-  stxxl::sort(begin(v), end(v), SortByPSO(), STXXL_MEMORY_TO_USE);
-  LOG(INFO) << "Sort done." << std::endl;
-  createPermutation(indexFilename + ".pso", v, _psoMeta, 0, 2);
-  LOG(INFO) << "Sorting for POS permutation..." << std::endl;;
-  stxxl::sort(begin(v), end(v), SortByPOS(), STXXL_MEMORY_TO_USE);
-  LOG(INFO) << "Sort done." << std::endl;;
-  createPermutation(indexFilename + ".pos", v, _posMeta, 2, 0);
-  openFileHandles();
+  ExtVec v;
+  passFileIntoIdVector<ParallelNTriplesParser>(ntFile, v);
+  createPermutations(indexFilename, v);
+  registerPermutations();
 }
 
 // _____________________________________________________________________________
-size_t Index::passTsvFileForVocabulary(const string& tsvFile) {
-  LOG(INFO) << "Making pass over TsvFile " << tsvFile << " for vocabulary."
-            << std::endl;
-  array<string, 3> spo;
-  TsvParser p(tsvFile);
-  std::unordered_set<string> items;
+template<class Parser>
+size_t Index::passFileIntoIdVector(const string& file, ExtVec& data) {
+  LOG(INFO) << "Making a single pass over " << file
+            << " for vocabulary and stxxl vector.\n";
+  _buildReport.startPhase("parse");
+  // The parser threads tokenize, encode values and number the distinct
+  // words of their parser chunk, only those are looked up here.
+  Parser p(file, Parser::defaultNofThreads(), PARSER_CHUNK_SIZE, true);
+  IdChunk parsed;
+  // Words of the current chunk and their chunk-local (provisional) ids.
+  std::unordered_map<string, Id> chunkIds;
+  size_t chunkBytes = 0;
+  vector<string> partialFiles;
+  vector<size_t> chunkEnds;
   size_t i = 0;
-  while (p.getLine(spo)) {
-    items.insert(spo[0]);
-    items.insert(spo[1]);
-    items.insert(spo[2]);
-    ++i;
-    if (i % 10000000 == 0) {
-      LOG(INFO) << "Lines processed: " << i << '\n';
+  // The provisional ids of the words of the parser chunk, unassigned until
+  // looked up since the last spill.
+  const Id unassigned = std::numeric_limits<Id>::max();
+  vector<Id> provisionalIds;
+  // write using vector_bufwriter
+  ExtVec::bufwriter_type writer(data);
+  while (p.getIdChunk(parsed)) {
+    provisionalIds.assign(parsed._words.size(), unassigned);
+    for (size_t t = 0; t < parsed._triples.size(); ++t) {
+      array<Id, 3> ids = parsed._triples[t];
+      for (size_t k = 0; k < 3; ++k) {
+        if (ValueId::isValue(ids[k])) {
+          // Value ids are final already.
+          continue;
+        }
+        Id& provisional = provisionalIds[ids[k]];
+        if (provisional == unassigned) {
+          const string& word = parsed._words[ids[k]];
+          auto it = chunkIds.find(word);
+          if (it == chunkIds.end()) {
+            provisional = chunkIds.size();
+            chunkIds.emplace(word, provisional);
+            chunkBytes += VocabularyMerger::approximateMemoryUsage(word);
+          } else {
+            provisional = it->second;
+          }
+        }
+        ids[k] = provisional;
+      }
+      writer << ids;
+      ++i;
+      if (chunkBytes > _vocabMemoryBudget) {
+        spillPartialVocabulary(chunkIds, partialFiles);
+        chunkEnds.push_back(i);
+        chunkBytes = 0;
+        provisionalIds.assign(parsed._words.size(), unassigned);
+      }
+      if (i % 10000000 == 0) {
+        LOG(INFO) << "Lines processed: " << i << '\n';
+      }
     }
   }
+  writer.finish();
   LOG(INFO) << "Pass done.\n";
-  _vocab.createFromSet(items);
+
+  _buildReport.startPhase("vocabulary");
+  string vocabFile = _onDiskBase + ".vocabulary";
+  if (partialFiles.size() == 0) {
+    // Everything fit into the budget, the sorted chunk is the vocabulary.
+    vector<Id> localToFinal =
+        VocabularyMerger::writeVocabulary(chunkIds, vocabFile);
+    chunkIds.clear();
+    remapProvisionalIds(data, 0, i, localToFinal);
+  } else {
+    if (chunkIds.size() > 0) {
+      spillPartialVocabulary(chunkIds, partialFiles);
+      chunkEnds.push_back(i);
+    }
+    vector<string> idMapFiles;
+    for (size_t c = 0; c < partialFiles.size(); ++c) {
+      idMapFiles.push_back(partialFiles[c] + ".ids");
+    }
+    VocabularyMerger::mergePartialVocabularies(partialFiles, vocabFile,
+                                               idMapFiles);
+    LOG(INFO) << "Remapping provisional ids to vocabulary ids...\n";
+    size_t chunkBegin = 0;
+    for (size_t c = 0; c < partialFiles.size(); ++c) {
+      vector<Id> localToFinal =
+          VocabularyMerger::readIdMap(partialFiles[c] + ".order");
+      vector<Id> rankToFinal = VocabularyMerger::readIdMap(idMapFiles[c]);
+      for (size_t j = 0; j < localToFinal.size(); ++j) {
+        localToFinal[j] = rankToFinal[localToFinal[j]];
+      }
+      remapProvisionalIds(data, chunkBegin, chunkEnds[c], localToFinal);
+      chunkBegin = chunkEnds[c];
+      std::remove(partialFiles[c].c_str());
+      std::remove((partialFiles[c] + ".order").c_str());
+      std::remove(idMapFiles[c].c_str());
+    }
+    LOG(INFO) << "Remapping done.\n";
+  }
+  _vocab.readFromFile(vocabFile);
+  _buildReport.endPhase();
   return i;
 }
 
 // _____________________________________________________________________________
-void Index::passTsvFileIntoIdVector(const string& tsvFile, ExtVec& data) {
-  LOG(INFO) << "Making pass over TsvFile " << tsvFile
-            << " and creating stxxl vector.\n";
-  array<string, 3> spo;
-  TsvParser p(tsvFile);
-  std::unordered_map<string, Id> vocabMap = _vocab.asMap();
-  size_t i = 0;
-  // write using vector_bufwriter
-  ExtVec::bufwriter_type writer(data);
-  while (p.getLine(spo)) {
-    writer << array<Id, 3>{{
-                               vocabMap.find(spo[0])->second,
-                               vocabMap.find(spo[1])->second,
-                               vocabMap.find(spo[2])->second
-                           }};
-    ++i;
-    if (i % 10000000 == 0) {
-      LOG(INFO) << "Lines processed: " << i << '\n';
-    }
-  }
-  writer.finish();
-  LOG(INFO) << "Pass done.\n";
+void Index::spillPartialVocabulary(std::unordered_map<string, Id>& chunkIds,
+                                   vector<string>& partialFiles) const {
+  std::ostringstream os;
+  os << _onDiskBase << ".partial-vocabulary." << partialFiles.size();
+  partialFiles.push_back(os.str());
+  vector<Id> localToRank =
+      VocabularyMerger::writePartialVocabulary(chunkIds, partialFiles.back());
+  chunkIds.clear();
+  ad_utility::File order((partialFiles.back() + ".order").c_str(), "w");
+  order.write(localToRank.data(), localToRank.size() * sizeof(Id));
+  order.close();
 }
 
 // _____________________________________________________________________________
-size_t Index::passNTriplesFileForVocabulary(const string& ntFile) {
-  LOG(INFO) << "Making pass over NTriples " << ntFile << " for vocabulary."
-            << std::endl;
-  array<string, 3> spo;
-  NTriplesParser p(ntFile);
-  std::unordered_set<string> items;
-  size_t i = 0;
-  while (p.getLine(spo)) {
-    items.insert(spo[0]);
-    items.insert(spo[1]);
-    items.insert(spo[2]);
-    ++i;
-    if (i % 10000000 == 0) {
-      LOG(INFO) << "Lines processed: " << i << '\n';
+void Index::remapProvisionalIds(ExtVec& data, size_t from, size_t to,
+                                const vector<Id>& localToFinal) {
+  ExtVec::iterator end = data.begin() + to;
+  for (ExtVec::iterator it = data.begin() + from; it != end; ++it) {
+    array<Id, 3> t = *it;
+    for (size_t k = 0; k < 3; ++k) {
+      if (!ValueId::isValue(t[k])) {
+        t[k] = localToFinal[t[k]];
+      }
     }
+    *it = t;
   }
-  LOG(INFO) << "Pass done.\n";
-  _vocab.createFromSet(items);
-  return i;
 }
 
 // _____________________________________________________________________________
-void Index::passNTriplesFileIntoIdVector(const string& ntFile, ExtVec& data) {
-  LOG(INFO) << "Making pass over NTriples " << ntFile
-            << " and creating stxxl vector.\n";
-  array<string, 3> spo;
-  NTriplesParser p(ntFile);
-  std::unordered_map<string, Id> vocabMap = _vocab.asMap();
-  size_t i = 0;
-  // write using vector_bufwriter
-  ExtVec::bufwriter_type writer(data);
-  while (p.getLine(spo)) {
-    writer << array<Id, 3>{{
-                               vocabMap.find(spo[0])->second,
-                               vocabMap.find(spo[1])->second,
-                               vocabMap.find(spo[2])->second
-                           }};
-    ++i;
-    if (i % 10000000 == 0) {
-      LOG(INFO) << "Lines processed: " << i << '\n';
+template<class Comparator>
+void Index::sortVector(ExtVec& v) {
+  stxxl::sort(begin(v), end(v), Comparator(), STXXL_MEMORY_TO_USE);
+}
+
+// _____________________________________________________________________________
+void Index::createPermutations(const string& indexFilename, ExtVec& v) {
+  // The meta data is written to the files, the index maps it from there.
+  array<IndexMetaData, NOF_PERMUTATIONS> meta;
+  vector<PermutationSpec> perms;
+  perms.push_back(PermutationSpec{"PSO", &meta[PSO], 1, 0, 2,
+                                  &sortVector<SortByPSO>});
+  perms.push_back(PermutationSpec{"POS", &meta[POS], 1, 2, 0,
+                                  &sortVector<SortByPOS>});
+  if (_allPermutations) {
+    perms.push_back(PermutationSpec{"SPO", &meta[SPO], 0, 1, 2,
+                                    &sortVector<SortBySPO>});
+    perms.push_back(PermutationSpec{"SOP", &meta[SOP], 0, 2, 1,
+                                    &sortVector<SortBySOP>});
+    perms.push_back(PermutationSpec{"OSP", &meta[OSP], 2, 0, 1,
+                                    &sortVector<SortByOSP>});
+    perms.push_back(PermutationSpec{"OPS", &meta[OPS], 2, 1, 0,
+                                    &sortVector<SortByOPS>});
+  }
+
+  LOG(INFO) << "Sorting for " << perms[0]._name << " permutation..."
+            << std::endl;
+  _buildReport.startPhase("sort " + perms[0]._name);
+  perms[0]._sort(v);
+  LOG(INFO) << "Sort done." << std::endl;
+  // While a permutation is written from v, a copy of v is sorted for
+  // the next permutation on another thread.
+  ExtVec next;
+  for (size_t i = 0; i < perms.size(); ++i) {
+    // Includes the sort for the next permutation that runs meanwhile.
+    _buildReport.startPhase("permutation " + perms[i]._name);
+    std::thread sorter;
+    std::exception_ptr sortError;
+    if (i + 1 < perms.size()) {
+      next.clear();
+      ExtVec::bufwriter_type writer(next);
+      for (ExtVec::bufreader_type reader(v); !reader.empty(); ++reader) {
+        writer << *reader;
+      }
+      writer.finish();
+      const PermutationSpec& nextPerm = perms[i + 1];
+      sorter = std::thread([&next, &nextPerm, &sortError] {
+        try {
+          LOG(INFO) << "Sorting for " << nextPerm._name << " permutation..."
+                    << std::endl;
+          nextPerm._sort(next);
+          LOG(INFO) << "Sort for " << nextPerm._name << " done." << std::endl;
+        } catch (...) {
+          sortError = std::current_exception();
+        }
+      });
+    }
+    perms[i]._meta->setFullIndexCompressed(_compressFullIndex);
+    perms[i]._meta->setLhsFilters(_buildLhsFilters);
+    string suffix = perms[i]._name;
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+    try {
+      createPermutation(indexFilename + "." + suffix, v, *perms[i]._meta,
+                        perms[i]._c0, perms[i]._c1, perms[i]._c2);
+    } catch (...) {
+      if (sorter.joinable()) {
+        sorter.join();
+      }
+      throw;
+    }
+    if (sorter.joinable()) {
+      sorter.join();
+      if (sortError) {
+        std::rethrow_exception(sortError);
+      }
+      v.swap(next);
+    }
+  }
+  next.clear();
+  _buildReport.endPhase();
+  for (size_t i = 0; i < perms.size(); ++i) {
+    string suffix = perms[i]._name;
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+    string fileName = indexFilename + "." + suffix;
+    if (ad_utility::File::exists(fileName)) {
+      ad_utility::File f(fileName.c_str(), "r");
+      _buildReport.addPermutation(perms[i]._name, *perms[i]._meta,
+                                  static_cast<uint64_t>(f.sizeOfFile()));
     }
   }
-  writer.finish();
-  LOG(INFO) << "Pass done.\n";
 }
 
 // _____________________________________________________________________________
 void Index::createPermutation(const string& fileName, Index::ExtVec const& vec,
-                              IndexMetaData& metaData, size_t c1, size_t c2) {
+                              IndexMetaData& metaData, size_t c0, size_t c1,
+                              size_t c2) {
+  // An empty permutation still gets a file with meta data, e.g. when a
+  // compaction folds in the deletion of all triples.
   if (vec.size() == 0) {
-    LOG(WARN) << "Attempt to write an empty index!" << std::endl;
-    return;
+    LOG(WARN) << "Writing an empty index permutation." << std::endl;
   }
   ad_utility::File out(fileName.c_str(), "w");
   LOG(INFO) << "Creating an on-disk index permutation of " << vec.size()
             << " elements / facts." << std::endl;
+  bool compress = metaData.isFullIndexCompressed();
+  bool lhsFilters = metaData.hasLhsFilters();
+  // Relations are encoded by worker threads and written in order.
+  // Small relations are encoded lazily by this thread when it writes them.
+  size_t maxPending = 2 * std::max(std::thread::hardware_concurrency(), 1u);
+  std::deque<std::future<EncodedRelation>> pending;
+  size_t nofPendingPairs = 0;
+  off_t lastOffset = 0;
+  auto writeFront = [&]() {
+    EncodedRelation rel = pending.front().get();
+    pending.pop_front();
+    nofPendingPairs -= rel._rmd._nofElements;
+    rebaseRelation(&rel, lastOffset);
+    out.write(rel._bytes.data(), rel._bytes.size());
+    metaData.add(rel.getRmd());
+    lastOffset = metaData.getOffsetAfter();
+  };
+  auto addRel = [&](Id relId, vector<array<Id, 2>>& data, bool functional) {
+    while (!pending.empty() &&
+           (pending.size() >= maxPending ||
+            nofPendingPairs + data.size() > MAX_PAIRS_PENDING_ENCODE)) {
+      writeFront();
+    }
+    nofPendingPairs += data.size();
+    std::launch policy = data.size() >= MIN_PAIRS_FOR_ASYNC_ENCODE ?
+                         std::launch::async : std::launch::deferred;
+    pending.push_back(std::async(policy, &Index::encodeRel, relId,
+                                 std::move(data), functional, compress,
+                                 lhsFilters));
+    data.clear();
+  };
+
   // Iterate over the vector and identify relation boundaries
   size_t from = 0;
-  Id currentRel = vec[0][1];
-  off_t lastOffset = 0;
+  Id currentRel = vec.size() > 0 ? vec[0][c0] : 0;
   vector<array<Id, 2>> buffer;
   bool functional = true;
   Id lastLhs = std::numeric_limits<Id>::max();
   for (ExtVec::bufreader_type reader(vec); !reader.empty(); ++reader) {
-    if ((*reader)[1] != currentRel) {
-      metaData.add(writeRel(out, lastOffset, currentRel, buffer, functional));
-      buffer.clear();
-      lastOffset = metaData.getOffsetAfter();
-      currentRel = (*reader)[1];
+    if ((*reader)[c0] != currentRel) {
+      addRel(currentRel, buffer, functional);
+      currentRel = (*reader)[c0];
       functional = true;
     } else {
       if ((*reader)[c1] == lastLhs) {
@@ -177,7 +344,10 @@ void Index::createPermutation(const string& fileName, Index::ExtVec const& vec,
     lastLhs = (*reader)[c1];
   }
   if (from < vec.size()) {
-    metaData.add(writeRel(out, lastOffset, currentRel, buffer, functional));
+    addRel(currentRel, buffer, functional);
+  }
+  while (!pending.empty()) {
+    writeFront();
   }
 
   LOG(INFO) << "Done creating index permutation." << std::endl;
@@ -185,65 +355,136 @@ void Index::createPermutation(const string& fileName, Index::ExtVec const& vec,
             << metaData.statistics() << std::endl;
 
   LOG(INFO) << "Writing Meta data to index file...\n";
-  out << metaData;
+  // The meta data is mapped and read in place, it has to be aligned.
   off_t startOfMeta = metaData.getOffsetAfter();
+  const char padding[sizeof(uint64_t)] = {};
+  size_t nofPaddingBytes = (sizeof(uint64_t) - startOfMeta % sizeof(uint64_t))
+                           % sizeof(uint64_t);
+  out.write(padding, nofPaddingBytes);
+  startOfMeta += nofPaddingBytes;
+  out << metaData;
   out.write(&startOfMeta, sizeof(startOfMeta));
   out.close();
   LOG(INFO) << "Permutation done.\n";
 }
 
+namespace {
+// Appends nofBytes bytes from data to bytes.
+void appendBytes(vector<char>* bytes, const void* data, size_t nofBytes) {
+  const char* begin = static_cast<const char*>(data);
+  bytes->insert(bytes->end(), begin, begin + nofBytes);
+}
+}
+
 // _____________________________________________________________________________
-RelationMetaData Index::writeRel(ad_utility::File& out, off_t currentOffset,
-                                 Id relId, const vector<array<Id, 2>>& data,
-                                 bool functional) {
-  LOG(TRACE) << "Writing a relation ...\n";
+Index::EncodedRelation Index::encodeRel(Id relId,
+                                        const vector<array<Id, 2>>& data,
+                                        bool functional, bool compress,
+                                        bool lhsFilter) {
+  LOG(TRACE) << "Encoding a relation ...\n";
   AD_CHECK_GT(data.size(), 0);
-  RelationMetaData rmd;
+  EncodedRelation rel;
+  RelationMetaData& rmd = rel._rmd;
   rmd._relId = relId;
-  rmd._startFullIndex = currentOffset;
+  rmd._startFullIndex = 0;
   rmd._nofElements = data.size();
 
-  // Write the full pair index.
-  out.write(data.data(), data.size() * 2 * sizeof(Id));
+  // Encode the full pair index. Remember where each group of
+  // DISTINCT_LHS_PER_BLOCK pairs starts, functional relations use
+  // those positions as their blocks.
+  vector<off_t> fullIndexBlocks;
+  if (compress) {
+    vector<uint64_t> encoded;
+    for (size_t i = 0; i < data.size(); i += DISTINCT_LHS_PER_BLOCK) {
+      fullIndexBlocks.push_back(encoded.size() * sizeof(uint64_t));
+      CompressedPairBlocks::encode(
+          data.data() + i, std::min(DISTINCT_LHS_PER_BLOCK, data.size() - i),
+          &encoded);
+    }
+    appendBytes(&rel._bytes, encoded.data(),
+                encoded.size() * sizeof(uint64_t));
+  } else {
+    for (size_t i = 0; i < data.size(); i += DISTINCT_LHS_PER_BLOCK) {
+      fullIndexBlocks.push_back(i * 2 * sizeof(Id));
+    }
+    appendBytes(&rel._bytes, data.data(), data.size() * 2 * sizeof(Id));
+  }
+  off_t afterFullIndex = rel._bytes.size();
 
   if (functional) {
-    rmd = writeFunctionalRelation(data, rmd);
+    writeFunctionalRelation(data, fullIndexBlocks, afterFullIndex, rmd,
+                            &rel._blocks);
   } else {
-    rmd = writeNonFunctionalRelation(out, data, rmd);
+    writeNonFunctionalRelation(&rel._bytes, data, afterFullIndex, rmd,
+                               &rel._blocks);
   };
-  rmd._nofBlocks = rmd._blocks.size();
-  LOG(TRACE) << "Done writing relation.\n";
-  return rmd;
+  rmd._nofBlocks = rel._blocks.size();
+  rmd._stats = RelationStatistics(data);
+  if (lhsFilter) {
+    vector<Id> lhs;
+    lhs.reserve(rmd._stats._nofDistinctLhs);
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (i == 0 || data[i][0] != data[i - 1][0]) {
+        lhs.push_back(data[i][0]);
+      }
+    }
+    rel._lhsFilterHashes = BloomFilter::build(lhs, LHS_FILTER_BITS_PER_KEY,
+                                              &rel._lhsFilterWords);
+  }
+  LOG(TRACE) << "Done encoding relation.\n";
+  return rel;
+}
+
+// _____________________________________________________________________________
+void Index::rebaseRelation(EncodedRelation* rel, off_t offset) {
+  rel->getRmd();
+  RelationMetaData& rmd = rel->_rmd;
+  if (!rmd.isFunctional()) {
+    // The LHS list holds absolute offsets into the RHS list.
+    off_t startOfLhs = rmd.getStartOfLhs();
+    pair<Id, off_t>* lhs = reinterpret_cast<pair<Id, off_t>*>(
+        rel->_bytes.data() + startOfLhs);
+    size_t nofLhs = static_cast<size_t>(rmd._startRhs - startOfLhs) /
+                    (sizeof(Id) + sizeof(off_t));
+    for (size_t i = 0; i < nofLhs; ++i) {
+      lhs[i].second += offset;
+    }
+  }
+  rmd._startFullIndex += offset;
+  rmd._startRhs += offset;
+  rmd._offsetAfter += offset;
+  for (size_t i = 0; i < rel->_blocks.size(); ++i) {
+    rel->_blocks[i]._startOffset += offset;
+  }
 }
 
 // _____________________________________________________________________________
 RelationMetaData& Index::writeFunctionalRelation(
-    const vector<array<Id, 2>>& data, RelationMetaData& rmd) {
+    const vector<array<Id, 2>>& data, const vector<off_t>& fullIndexBlocks,
+    off_t afterFullIndex, RelationMetaData& rmd,
+    vector<BlockMetaData>* blocks) {
   LOG(TRACE) << "Writing part for functional relation ...\n";
   // Do not write extra LHS and RHS lists.
-  rmd._startRhs = rmd._startFullIndex + data.size() * 2 * sizeof(Id);
+  rmd._startRhs = afterFullIndex;
   rmd._offsetAfter = rmd._startRhs;
   // Create the block data for the RelationMetaData.
   // Blocks are offsets into the full pair index for functional relations.
-  size_t nofDistinctLhs = 0;
-  Id lastLhs = std::numeric_limits<Id>::max();
-  for (size_t i = 0; i < data.size(); ++i) {
-    if (data[i][0] != lastLhs) {
-      if (nofDistinctLhs % DISTINCT_LHS_PER_BLOCK == 0) {
-        rmd._blocks.emplace_back(
-            BlockMetaData(data[i][0],
-                          rmd._startFullIndex + i * 2 * sizeof(Id)));
-      }
-      ++nofDistinctLhs;
-    }
+  // Each LHS occurs exactly once, so every group of pairs in the full
+  // index holds DISTINCT_LHS_PER_BLOCK distinct LHS.
+  for (size_t i = 0; i < fullIndexBlocks.size(); ++i) {
+    size_t last = std::min((i + 1) * DISTINCT_LHS_PER_BLOCK, data.size()) - 1;
+    blocks->emplace_back(BlockMetaData(data[i * DISTINCT_LHS_PER_BLOCK][0],
+                                       data[last][0], fullIndexBlocks[i]));
   }
   return rmd;
 }
 
 // _____________________________________________________________________________
-RelationMetaData& Index::writeNonFunctionalRelation(ad_utility::File& out,
+RelationMetaData& Index::writeNonFunctionalRelation(vector<char>* out,
                                                     const vector<array<Id, 2>>& data,
-                                                    RelationMetaData& rmd) {
+                                                    off_t startOfLhs,
+                                                    RelationMetaData& rmd,
+                                                    vector<BlockMetaData>* blocks) {
   LOG(TRACE) << "Writing part for non-functional relation ...\n";
   // Make a pass over the data and extract a RHS list for each LHS.
   // Prepare both in buffers.
@@ -263,16 +504,16 @@ RelationMetaData& Index::writeNonFunctionalRelation(ad_utility::File& out,
   }
 
   // Go over the Lhs data once more and adjust the offsets.
-  off_t startRhs = rmd.getStartOfLhs()
+  off_t startRhs = startOfLhs
                    + nofDistinctLhs * (sizeof(Id) + sizeof(off_t));
 
   for (size_t i = 0; i < nofDistinctLhs; ++i) {
     bufLhs[i].second += startRhs;
   }
 
-  // Write to file.
-  out.write(bufLhs, nofDistinctLhs * (sizeof(Id) + sizeof(off_t)));
-  out.write(bufRhs, data.size() * sizeof(Id));
+  // Write to the buffer.
+  appendBytes(out, bufLhs, nofDistinctLhs * (sizeof(Id) + sizeof(off_t)));
+  appendBytes(out, bufRhs, data.size() * sizeof(Id));
 
 
   // Update meta data.
@@ -283,8 +524,9 @@ RelationMetaData& Index::writeNonFunctionalRelation(ad_utility::File& out,
   // Block are offsets into the LHS list for non-functional relations.
   for (size_t i = 0; i < nofDistinctLhs; ++i) {
     if (i % DISTINCT_LHS_PER_BLOCK == 0) {
-      rmd._blocks.emplace_back(BlockMetaData(bufLhs[i].first,
-                                             rmd.getStartOfLhs() +
+      size_t last = std::min(i + DISTINCT_LHS_PER_BLOCK, nofDistinctLhs) - 1;
+      blocks->emplace_back(BlockMetaData(bufLhs[i].first, bufLhs[last].first,
+                                             startOfLhs +
                                              i * (sizeof(Id) + sizeof(off_t))));
     }
   }
@@ -298,55 +540,95 @@ RelationMetaData& Index::writeNonFunctionalRelation(ad_utility::File& out,
 void Index::createFromOnDiskIndex(const string& onDiskBase) {
   _onDiskBase = onDiskBase;
   _vocab.readFromFile(onDiskBase + ".vocabulary");
-  _psoFile.open(string(_onDiskBase + ".index.pso").c_str(), "r");
-  _posFile.open(string(_onDiskBase + ".index.pos").c_str(), "r");
-  AD_CHECK(_psoFile.isOpen() && _posFile.isOpen());
-  off_t metaFrom;
-  off_t metaTo = _psoFile.getLastOffset(&metaFrom);
-  unsigned char *buf = new unsigned char[metaTo - metaFrom];
-  _psoFile.read(buf, static_cast<size_t>(metaTo - metaFrom), metaFrom);
-  _psoMeta.createFromByteBuffer(buf);
-  delete[] buf;
-  LOG(INFO) << "Registered PSO permutation: " << _psoMeta.statistics()
-            << std::endl;
+  _allPermutations = ad_utility::File::exists(_onDiskBase + ".index.spo");
+  registerPermutations();
+}
 
-  metaTo = _posFile.getLastOffset(&metaFrom);
-  buf = new unsigned char[metaTo - metaFrom];
-  _posFile.read(buf, static_cast<size_t>(metaTo - metaFrom), metaFrom);
-  _posMeta.createFromByteBuffer(buf);
-  delete[] buf;
-  LOG(INFO) << "Registered POS permutation: " << _posMeta.statistics()
+// _____________________________________________________________________________
+void Index::registerPermutations() {
+  AD_CHECK(_onDiskBase.size() > 0);
+  shared_ptr<PermutationFiles> permutations =
+      std::make_shared<PermutationFiles>();
+  // Only called on load and by the compaction thread, never concurrently.
+  permutations->_generation = ++_permutationGeneration;
+  size_t nofPermutations = _allPermutations ? NOF_PERMUTATIONS : 2;
+  for (size_t i = 0; i < nofPermutations; ++i) {
+    string fileName = _onDiskBase + PERMUTATION_SUFFIXES[i];
+    permutations->_files[i].open(fileName.c_str(), "r");
+    AD_CHECK(permutations->_files[i].isOpen());
+    // The meta data is mapped, not read, statistics are only computed
+    // when they are logged.
+    readMetaData(fileName, permutations->_meta[i]);
+  }
+  LOG(INFO) << "Registered PSO permutation with "
+            << permutations->_meta[PSO].getNofRelations() << " relations."
+            << std::endl;
+  LOG(DEBUG) << "PSO permutation: " << permutations->_meta[PSO].statistics()
+             << std::endl;
+  LOG(INFO) << "Registered POS permutation with "
+            << permutations->_meta[POS].getNofRelations() << " relations."
             << std::endl;
+  LOG(DEBUG) << "POS permutation: " << permutations->_meta[POS].statistics()
+             << std::endl;
+  if (_allPermutations) {
+    LOG(INFO) << "Registered SPO, SOP, OSP and OPS permutations."
+              << std::endl;
+  }
+  shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  snapshot->_permutations = permutations;
+  {
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    _snapshot = snapshot;
+  }
+  // Blocks of the replaced files are never read again. Scans of an older
+  // snapshot may still add some after this, under the ids of their
+  // generation, until they are evicted.
+  _blockCache.clear();
 }
 
 // _____________________________________________________________________________
-bool Index::ready() const {
-  return _psoFile.isOpen() && _posFile.isOpen();
+void Index::readMetaData(const string& fileName, IndexMetaData& meta) {
+  meta.readFromFile(fileName);
 }
 
 // _____________________________________________________________________________
-void Index::openFileHandles() {
-  AD_CHECK(_onDiskBase.size() > 0);
-  _psoFile.open(string(_onDiskBase + ".index.pso").c_str(), "r");
-  _posFile.open(string(_onDiskBase + ".index.pos").c_str(), "r");
-  AD_CHECK(_psoFile.isOpen());
-  AD_CHECK(_posFile.isOpen());
+string Index::blockCacheStatistics() const {
+  return cacheStatistics("Block cache", _blockCache);
+}
+
+// _____________________________________________________________________________
+string Index::postingListCacheStatistics() const {
+  return cacheStatistics("Posting list cache", _postingListCache);
+}
+
+// _____________________________________________________________________________
+string Index::cacheStatistics(const string& name,
+                              const ad_utility::BlockCache& cache) {
+  std::ostringstream os;
+  size_t hits = cache.getNofHits();
+  size_t misses = cache.getNofMisses();
+  os << name << ": " << hits << " hits, " << misses << " misses";
+  if (hits + misses > 0) {
+    os << " (" << 100.0 * hits / (hits + misses) << "% hits)";
+  }
+  os << ", " << cache.getSizeInBytes() << " bytes cached";
+  return os.str();
+}
+
+// _____________________________________________________________________________
+bool Index::ready() const {
+  shared_ptr<const Snapshot> snapshot = getSnapshot();
+  return snapshot && snapshot->file(PSO).isOpen() &&
+         snapshot->file(POS).isOpen();
 }
 
 // _____________________________________________________________________________
 void Index::scanPSO(const string& predicate, WidthTwoList *result) const {
   LOG(DEBUG) << "Performing PSO scan for full relation: " << predicate << "\n";
   Id relId;
-  if (_vocab.getId(predicate, &relId)) {
+  if (getId(predicate, &relId)) {
     LOG(TRACE) << "Sucessfully got relation ID.\n";
-    if (_psoMeta.relationExists(relId)) {
-      LOG(TRACE) << "Relation exists.\n";
-      const RelationMetaData& rmd = _psoMeta.getRmd(relId);
-      result->reserve(rmd._nofElements + 2);
-      result->resize(rmd._nofElements);
-      _psoFile.read(result->data(), rmd._nofElements * 2 * sizeof(Id),
-                    rmd._startFullIndex);
-    }
+    scanRelation(PSO, relId, result);
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
@@ -358,22 +640,8 @@ void Index::scanPSO(const string& predicate, const string& subject,
              << "with fixed subject: " << subject << "...\n";
   Id relId;
   Id subjId;
-  if (_vocab.getId(predicate, &relId) && _vocab.getId(subject, &subjId)) {
-    if (_psoMeta.relationExists(relId)) {
-      const RelationMetaData& rmd = _psoMeta.getRmd(relId);
-      pair<off_t, size_t> blockOff = rmd.getBlockStartAndNofBytesForLhs(subjId);
-      // Functional relations have blocks point into the pair index,
-      // non-functional relations have them point into lhs lists
-      if (rmd.isFunctional()) {
-        scanFunctionalRelation(blockOff, subjId, _psoFile, result);
-      } else {
-        pair<off_t, size_t> block2 = rmd.getFollowBlockForLhs(subjId);
-        scanNonFunctionalRelation(blockOff, block2, subjId, _psoFile,
-                                  rmd._offsetAfter, result);
-      }
-    } else {
-      LOG(DEBUG) << "So such relation.\n";
-    }
+  if (getId(predicate, &relId) && getId(subject, &subjId)) {
+    scanRelation(PSO, relId, subjId, result);
   } else {
     LOG(DEBUG) << "So such subject.\n";
   }
@@ -384,16 +652,57 @@ void Index::scanPSO(const string& predicate, const string& subject,
 void Index::scanPOS(const string& predicate, WidthTwoList *result) const {
   LOG(DEBUG) << "Performing POS scan for full relation: " << predicate << "\n";
   Id relId;
-  if (_vocab.getId(predicate, &relId)) {
+  if (getId(predicate, &relId)) {
     LOG(TRACE) << "Sucessfully got relation ID.\n";
-    if (_posMeta.relationExists(relId)) {
-      LOG(TRACE) << "Relation exists.\n";
-      const RelationMetaData& rmd = _posMeta.getRmd(relId);
-      result->reserve(rmd._nofElements + 2);
-      result->resize(rmd._nofElements);
-      _posFile.read(result->data(), rmd._nofElements * 2 * sizeof(Id),
-                    rmd._startFullIndex);
-    }
+    scanRelation(POS, relId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanPSO(const string& predicate, const IdRange& subjectRange,
+                    WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing PSO scan of relation " << predicate
+             << " for subjects in " << subjectRange << "\n";
+  Id relId;
+  if (getId(predicate, &relId)) {
+    scanRelation(PSO, relId, subjectRange, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanPOS(const string& predicate, const IdRange& objectRange,
+                    WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing POS scan of relation " << predicate
+             << " for objects in " << objectRange << "\n";
+  Id relId;
+  if (getId(predicate, &relId)) {
+    scanRelation(POS, relId, objectRange, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanPSOBatch(const string& predicate, const vector<Id>& subjects,
+                         WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing PSO scan of relation " << predicate
+             << " for " << subjects.size() << " subjects\n";
+  Id relId;
+  if (getId(predicate, &relId)) {
+    scanRelation(PSO, relId, subjects, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanPOSBatch(const string& predicate, const vector<Id>& objects,
+                         WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing POS scan of relation " << predicate
+             << " for " << objects.size() << " objects\n";
+  Id relId;
+  if (getId(predicate, &relId)) {
+    scanRelation(POS, relId, objects, result);
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
@@ -405,22 +714,8 @@ void Index::scanPOS(const string& predicate, const string& object,
              << "with fixed object: " << object << "...\n";
   Id relId;
   Id objId;
-  if (_vocab.getId(predicate, &relId) && _vocab.getId(object, &objId)) {
-    if (_posMeta.relationExists(relId)) {
-      const RelationMetaData& rmd = _posMeta.getRmd(relId);
-      pair<off_t, size_t> blockOff = rmd.getBlockStartAndNofBytesForLhs(objId);
-      // Functional relations have blocks point into the pair index,
-      // non-functional relations have them point into lhs lists
-      if (rmd.isFunctional()) {
-        scanFunctionalRelation(blockOff, objId, _posFile, result);
-      } else {
-        pair<off_t, size_t> block2 = rmd.getFollowBlockForLhs(objId);
-        scanNonFunctionalRelation(blockOff, block2, objId, _posFile,
-                                  rmd._offsetAfter, result);
-      }
-    } else {
-      LOG(DEBUG) << "No such relation.\n";
-    }
+  if (getId(predicate, &relId) && getId(object, &objId)) {
+    scanRelation(POS, relId, objId, result);
   } else {
     LOG(DEBUG) << "No such object.\n";
   }
@@ -428,24 +723,521 @@ void Index::scanPOS(const string& predicate, const string& object,
 }
 
 // _____________________________________________________________________________
-const string& Index::idToString(Id id) const {
+void Index::scanSPO(const string& subject, WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing SPO scan for subject: " << subject << "\n";
+  AD_CHECK(_allPermutations);
+  Id subjId;
+  if (getId(subject, &subjId)) {
+    scanRelation(SPO, subjId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanSOP(const string& subject, WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing SOP scan for subject: " << subject << "\n";
+  AD_CHECK(_allPermutations);
+  Id subjId;
+  if (getId(subject, &subjId)) {
+    scanRelation(SOP, subjId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanSOP(const string& subject, const string& object,
+                    WidthOneList *result) const {
+  LOG(DEBUG) << "Performing SOP scan for subject: " << subject
+             << " and object: " << object << "\n";
+  AD_CHECK(_allPermutations);
+  Id subjId;
+  Id objId;
+  if (getId(subject, &subjId) && getId(object, &objId)) {
+    scanRelation(SOP, subjId, objId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanOSP(const string& object, WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing OSP scan for object: " << object << "\n";
+  AD_CHECK(_allPermutations);
+  Id objId;
+  if (getId(object, &objId)) {
+    scanRelation(OSP, objId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+void Index::scanOPS(const string& object, WidthTwoList *result) const {
+  LOG(DEBUG) << "Performing OPS scan for object: " << object << "\n";
+  AD_CHECK(_allPermutations);
+  Id objId;
+  if (getId(object, &objId)) {
+    scanRelation(OPS, objId, result);
+  }
+  LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
+}
+
+// _____________________________________________________________________________
+RelationScan Index::scanBlocks(Permutation perm, const string& key,
+                               size_t pairsPerBlock) const {
+  LOG(DEBUG) << "Starting block scan of permutation " << perm
+             << " for: " << key << "\n";
+  AD_CHECK(perm == PSO || perm == POS || _allPermutations);
+  Id relId;
+  if (!getId(key, &relId)) {
+    return RelationScan();
+  }
+  DeltaStore deltas;
+  shared_ptr<const Snapshot> snapshot = getSnapshot(perm, relId, &deltas);
+  DeltaStore allDeltas = snapshot->_compactingDeltas[perm].forRelation(relId);
+  allDeltas.merge(deltas);
+  const IndexMetaData& meta = snapshot->meta(perm);
+  if (!meta.relationExists(relId)) {
+    return RelationScan(shared_ptr<const ad_utility::File>(), 0, 0, false,
+                        relId, allDeltas, pairsPerBlock);
+  }
+  const RelationMetaData& rmd = meta.getRmd(relId);
+  off_t from = rmd._startFullIndex;
+  off_t to = from + rmd.getNofBytesForFulltextIndex();
+  // Shares ownership of the snapshot, its file stays open even if a
+  // compaction replaces it.
+  shared_ptr<const ad_utility::File> file(snapshot, &snapshot->file(perm));
+  return RelationScan(file, from, to, meta.isFullIndexCompressed(), relId,
+                      allDeltas, pairsPerBlock);
+}
+
+// _____________________________________________________________________________
+void Index::scanRelation(Permutation perm, Id relId,
+                         WidthTwoList *result) const {
+  DeltaStore deltas;
+  shared_ptr<const Snapshot> snapshot = getSnapshot(perm, relId, &deltas);
+  readRelation(snapshot->meta(perm), snapshot->file(perm), relId, result);
+  snapshot->_compactingDeltas[perm].apply(relId, result);
+  deltas.apply(relId, result);
+}
+
+// _____________________________________________________________________________
+void Index::scanRelation(Permutation perm, Id relId, Id lhsId,
+                         WidthOneList *result) const {
+  DeltaStore deltas;
+  shared_ptr<const Snapshot> snapshot = getSnapshot(perm, relId, &deltas);
+  readRelation(snapshot->meta(perm), snapshot->file(perm),
+               snapshot->cacheId(perm), relId, lhsId, result);
+  snapshot->_compactingDeltas[perm].apply(relId, lhsId, result);
+  deltas.apply(relId, lhsId, result);
+}
+
+// _____________________________________________________________________________
+void Index::scanRelation(Permutation perm, Id relId, const IdRange& lhsRange,
+                         WidthTwoList *result) const {
+  if (lhsRange._first > lhsRange._last) {
+    return;
+  }
+  DeltaStore deltas;
+  shared_ptr<const Snapshot> snapshot = getSnapshot(perm, relId, &deltas);
+  readRelation(snapshot->meta(perm), snapshot->file(perm), relId, lhsRange,
+               result);
+  // Only the changes in the range, i.e. after the pairs with a smaller LHS.
+  array<Id, 2> after{{lhsRange._first - 1, std::numeric_limits<Id>::max()}};
+  array<Id, 2> upTo{{lhsRange._last, std::numeric_limits<Id>::max()}};
+  const array<Id, 2>* from = lhsRange._first > 0 ? &after : nullptr;
+  snapshot->_compactingDeltas[perm].apply(relId, from, &upTo, result);
+  deltas.apply(relId, from, &upTo, result);
+}
+
+// _____________________________________________________________________________
+void Index::scanRelation(Permutation perm, Id relId, const vector<Id>& lhsIds,
+                         WidthTwoList *result) const {
+  AD_CHECK(std::is_sorted(lhsIds.begin(), lhsIds.end()));
+  vector<Id> keys(lhsIds);
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  DeltaStore deltas;
+  shared_ptr<const Snapshot> snapshot = getSnapshot(perm, relId, &deltas);
+  readRelation(snapshot->meta(perm), snapshot->file(perm),
+               snapshot->cacheId(perm), relId, keys, result);
+  snapshot->_compactingDeltas[perm].apply(relId, keys, result);
+  deltas.apply(relId, keys, result);
+}
+
+// _____________________________________________________________________________
+shared_ptr<const Index::Snapshot> Index::getSnapshot() const {
+  std::lock_guard<std::mutex> lock(_updateMutex);
+  return _snapshot;
+}
+
+// _____________________________________________________________________________
+shared_ptr<const Index::Snapshot> Index::getSnapshot(Permutation perm,
+                                                     Id relId,
+                                                     DeltaStore* deltas) const {
+  std::lock_guard<std::mutex> lock(_updateMutex);
+  *deltas = _deltas[perm].forRelation(relId);
+  return _snapshot;
+}
+
+// _____________________________________________________________________________
+void Index::readRelation(const IndexMetaData& meta,
+                         const ad_utility::File& file, Id relId,
+                         WidthTwoList *result) const {
+  if (meta.relationExists(relId)) {
+    LOG(TRACE) << "Relation exists.\n";
+    const RelationMetaData& rmd = meta.getRmd(relId);
+    result->reserve(rmd._nofElements + 2);
+    if (meta.isFullIndexCompressed()) {
+      ad_utility::Timer timer;
+      timer.start();
+      size_t nofBytes = rmd.getNofBytesForFulltextIndex();
+      vector<uint64_t> encoded(nofBytes / sizeof(uint64_t));
+      file.read(encoded.data(), nofBytes, rmd._startFullIndex);
+      CompressedPairBlocks::decodeAll(encoded.data(), nofBytes, result);
+      timer.stop();
+      LOG(DEBUG) << "Read and decoded " << rmd._nofElements << " pairs from "
+                 << nofBytes << " bytes in " << timer.msecs() << " ms.\n";
+    } else {
+      result->resize(rmd._nofElements);
+      file.read(result->data(), rmd._nofElements * 2 * sizeof(Id),
+                rmd._startFullIndex);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void Index::readRelation(const IndexMetaData& meta,
+                         const ad_utility::File& file, uint64_t fileId,
+                         Id relId, Id lhsId, WidthOneList *result) const {
+  if (meta.relationExists(relId)) {
+    const RelationMetaData& rmd = meta.getRmd(relId);
+    if (!rmd.mayContainLhs(lhsId)) {
+      LOG(DEBUG) << "LHS not in relation.\n";
+      return;
+    }
+    pair<off_t, size_t> blockOff = rmd.getBlockStartAndNofBytesForLhs(lhsId);
+    // Functional relations have blocks point into the pair index,
+    // non-functional relations have them point into lhs lists
+    if (rmd.isFunctional()) {
+      scanFunctionalRelation(blockOff, lhsId, file, fileId,
+                             meta.isFullIndexCompressed(), result);
+    } else {
+      pair<off_t, size_t> block2 = rmd.getFollowBlockForLhs(lhsId);
+      scanNonFunctionalRelation(blockOff, block2, lhsId, file, fileId,
+                                rmd._offsetAfter, result);
+    }
+  } else {
+    LOG(DEBUG) << "No such relation.\n";
+  }
+}
+
+// _____________________________________________________________________________
+void Index::readRelation(const IndexMetaData& meta,
+                         const ad_utility::File& file, Id relId,
+                         const IdRange& lhsRange,
+                         WidthTwoList *result) const {
+  if (!meta.relationExists(relId)) {
+    LOG(DEBUG) << "No such relation.\n";
+    return;
+  }
+  RelationMetaData rmd = meta.getRmd(relId);
+  pair<size_t, size_t> blocks = rmd.getBlocksForLhsRange(lhsRange._first,
+                                                         lhsRange._last);
+  LOG(DEBUG) << "Reading " << blocks.second - blocks.first << " of "
+             << rmd._nofBlocks << " blocks.\n";
+  if (blocks.first == blocks.second) {
+    return;
+  }
+  off_t from = rmd._blocks[blocks.first]._startOffset;
+  off_t to = rmd.getBlockEnd(blocks.second - 1);
+  size_t nofBytes = static_cast<size_t>(to - from);
+  auto inRange = [&lhsRange](Id lhs) {
+    return lhsRange._first <= lhs && lhs <= lhsRange._last;
+  };
+  if (rmd.isFunctional()) {
+    // The blocks are groups of pairs in the FullIndex.
+    WidthTwoList pairs;
+    if (meta.isFullIndexCompressed()) {
+      vector<uint64_t> encoded(nofBytes / sizeof(uint64_t));
+      file.read(encoded.data(), nofBytes, from);
+      CompressedPairBlocks::decodeAll(encoded.data(), nofBytes, &pairs);
+    } else {
+      pairs.resize(nofBytes / sizeof(array<Id, 2>));
+      file.read(pairs.data(), nofBytes, from);
+    }
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      if (inRange(pairs[i][0])) {
+        result->push_back(pairs[i]);
+      }
+    }
+    return;
+  }
+  // The blocks are parts of the LHS list. Read one more entry if there is
+  // one, its offset is where the RHS of the last LHS in the blocks end.
+  size_t nofEntries = nofBytes / (sizeof(Id) + sizeof(off_t));
+  bool hasFollower = to < rmd._startRhs;
+  vector<pair<Id, off_t>> lhs(nofEntries + (hasFollower ? 1 : 0));
+  file.read(lhs.data(), lhs.size() * (sizeof(Id) + sizeof(off_t)), from);
+  size_t first = 0;
+  while (first < nofEntries && !inRange(lhs[first].first)) {
+    ++first;
+  }
+  size_t end = first;
+  while (end < nofEntries && inRange(lhs[end].first)) {
+    ++end;
+  }
+  if (first == end) {
+    return;
+  }
+  off_t rhsEnd = end < lhs.size() ? lhs[end].second : rmd._offsetAfter;
+  vector<Id> rhs(static_cast<size_t>(rhsEnd - lhs[first].second) /
+                 sizeof(Id));
+  file.read(rhs.data(), rhs.size() * sizeof(Id), lhs[first].second);
+  result->reserve(result->size() + rhs.size());
+  for (size_t i = first; i < end; ++i) {
+    off_t rhsTo = i + 1 < lhs.size() ? lhs[i + 1].second : rmd._offsetAfter;
+    size_t begin = static_cast<size_t>(lhs[i].second - lhs[first].second) /
+                   sizeof(Id);
+    size_t stop = static_cast<size_t>(rhsTo - lhs[first].second) / sizeof(Id);
+    for (size_t j = begin; j < stop; ++j) {
+      result->push_back(array<Id, 2>{{lhs[i].first, rhs[j]}});
+    }
+  }
+}
+
+// _____________________________________________________________________________
+template<class Block, class Decode>
+vector<shared_ptr<const Block>> Index::readBlocks(
+    const ad_utility::File& file, uint64_t fileId,
+    const vector<pair<off_t, size_t>>& spans, Decode decode) const {
+  vector<shared_ptr<const Block>> blocks(spans.size());
+  vector<vector<uint64_t>> words(spans.size());
+  vector<ad_utility::File::ReadRequest> requests;
+  for (size_t i = 0; i < spans.size(); ++i) {
+    ad_utility::BlockCache::Key key = {fileId, spans[i].first,
+                                       spans[i].second};
+    blocks[i] = _blockCache.get<Block>(key);
+    if (!blocks[i]) {
+      words[i].resize(spans[i].second / sizeof(uint64_t));
+      ad_utility::File::ReadRequest request;
+      request._buffer = words[i].data();
+      request._nofBytes = spans[i].second;
+      request._offset = spans[i].first;
+      requests.push_back(request);
+    }
+  }
+  // Adjacent blocks are read with a single read.
+  AD_CHECK(file.readBatch(requests));
+  for (size_t i = 0; i < spans.size(); ++i) {
+    if (!blocks[i]) {
+      shared_ptr<Block> block = std::make_shared<Block>();
+      decode(words[i], block.get());
+      ad_utility::BlockCache::Key key = {fileId, spans[i].first,
+                                         spans[i].second};
+      _blockCache.insert<Block>(key, block, block->size() *
+                                sizeof(typename Block::value_type));
+      blocks[i] = block;
+    }
+  }
+  return blocks;
+}
+
+// _____________________________________________________________________________
+void Index::readRelation(const IndexMetaData& meta,
+                         const ad_utility::File& file, uint64_t fileId,
+                         Id relId, const vector<Id>& lhsIds,
+                         WidthTwoList *result) const {
+  if (!meta.relationExists(relId)) {
+    LOG(DEBUG) << "No such relation.\n";
+    return;
+  }
+  RelationMetaData rmd = meta.getRmd(relId);
+  // The blocks that may contain keys and the keys for each.
+  vector<size_t> blocks;
+  vector<pair<off_t, size_t>> spans;
+  vector<vector<Id>> keys;
+  const BlockMetaData* begin = rmd._blocks;
+  const BlockMetaData* end = rmd._blocks + rmd._nofBlocks;
+  for (size_t i = 0; i < lhsIds.size(); ++i) {
+    Id lhs = lhsIds[i];
+    auto it = std::upper_bound(begin, end, lhs,
+                               [](Id key, const BlockMetaData& block) {
+                                 return key < block._firstLhs;
+                               });
+    if (it == begin || !rmd.mayContainLhs(lhs) || lhs > (--it)->_lastLhs) {
+      continue;
+    }
+    size_t block = static_cast<size_t>(it - begin);
+    if (blocks.empty() || blocks.back() != block) {
+      blocks.push_back(block);
+      spans.push_back(pair<off_t, size_t>(it->_startOffset,
+          static_cast<size_t>(rmd.getBlockEnd(block) - it->_startOffset)));
+      keys.emplace_back();
+    }
+    keys.back().push_back(lhs);
+  }
+  LOG(DEBUG) << "Reading " << blocks.size() << " of " << rmd._nofBlocks
+             << " blocks for " << lhsIds.size() << " keys.\n";
+
+  if (rmd.isFunctional()) {
+    // The blocks are groups of pairs in the FullIndex.
+    bool compressed = meta.isFullIndexCompressed();
+    auto pairs = readBlocks<WidthTwoList>(file, fileId, spans,
+        [compressed](vector<uint64_t>& words, WidthTwoList* block) {
+          if (compressed) {
+            CompressedPairBlocks::decodeAll(words.data(),
+                                            words.size() * sizeof(uint64_t),
+                                            block);
+          } else {
+            block->resize(words.size() * sizeof(uint64_t) /
+                          sizeof(array<Id, 2>));
+            memcpy(block->data(), words.data(),
+                   words.size() * sizeof(uint64_t));
+          }
+        });
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      auto it = pairs[b]->begin();
+      for (Id lhs: keys[b]) {
+        it = std::lower_bound(it, pairs[b]->end(), lhs,
+                              [](const array<Id, 2>& elem, Id key) {
+                                return elem[0] < key;
+                              });
+        if (it != pairs[b]->end() && (*it)[0] == lhs) {
+          result->push_back(*it);
+        }
+      }
+    }
+    return;
+  }
+
+  // The blocks are parts of the LHS list.
+  typedef vector<pair<Id, off_t>> LhsBlock;
+  auto lhsBlocks = readBlocks<LhsBlock>(file, fileId, spans,
+      [](vector<uint64_t>& words, LhsBlock* block) {
+        // Each entry is an Id and an offset, one word each.
+        block->resize(words.size() / 2);
+        for (size_t i = 0; i < block->size(); ++i) {
+          (*block)[i].first = words[2 * i];
+          (*block)[i].second = static_cast<off_t>(words[2 * i + 1]);
+        }
+      });
+  // The entries of the keys found. The RHS of the last LHS of a block end
+  // where those of the first one of the next block start, read that
+  // entry unless the next block has been read anyway.
+  vector<pair<Id, off_t>> found;
+  vector<off_t> rhsEnds;
+  vector<pair<Id, off_t>> followers(blocks.size());
+  vector<ad_utility::File::ReadRequest> requests;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    const LhsBlock& lhsBlock = *lhsBlocks[b];
+    auto it = lhsBlock.begin();
+    for (Id lhs: keys[b]) {
+      it = std::lower_bound(it, lhsBlock.end(), lhs,
+                            [](const pair<Id, off_t>& elem, Id key) {
+                              return elem.first < key;
+                            });
+      if (it == lhsBlock.end() || it->first != lhs) {
+        continue;
+      }
+      found.push_back(*it);
+      if (it + 1 != lhsBlock.end()) {
+        rhsEnds.push_back((it + 1)->second);
+      } else if (blocks[b] + 1 == rmd._nofBlocks) {
+        rhsEnds.push_back(rmd._offsetAfter);
+      } else if (b + 1 < blocks.size() && blocks[b + 1] == blocks[b] + 1) {
+        rhsEnds.push_back(lhsBlocks[b + 1]->front().second);
+      } else {
+        // Refers to the follower, filled in after the read.
+        rhsEnds.push_back(-1 - static_cast<off_t>(b));
+        ad_utility::File::ReadRequest request;
+        request._buffer = &followers[b];
+        request._nofBytes = sizeof(followers[b]);
+        request._offset = rmd._blocks[blocks[b] + 1]._startOffset;
+        requests.push_back(request);
+      }
+    }
+  }
+  AD_CHECK(file.readBatch(requests));
+  size_t nofRhs = 0;
+  for (size_t i = 0; i < found.size(); ++i) {
+    if (rhsEnds[i] < 0) {
+      rhsEnds[i] = followers[static_cast<size_t>(-1 - rhsEnds[i])].second;
+    }
+    nofRhs += static_cast<size_t>(rhsEnds[i] - found[i].second) / sizeof(Id);
+  }
+  // The RHS of adjacent keys are adjacent on disk and read together.
+  vector<Id> rhs(nofRhs);
+  requests.clear();
+  size_t pos = 0;
+  for (size_t i = 0; i < found.size(); ++i) {
+    ad_utility::File::ReadRequest request;
+    request._buffer = rhs.data() + pos;
+    request._nofBytes = static_cast<size_t>(rhsEnds[i] - found[i].second);
+    request._offset = found[i].second;
+    requests.push_back(request);
+    pos += request._nofBytes / sizeof(Id);
+  }
+  AD_CHECK(file.readBatch(requests));
+  result->reserve(result->size() + nofRhs);
+  pos = 0;
+  for (size_t i = 0; i < found.size(); ++i) {
+    size_t n = static_cast<size_t>(rhsEnds[i] - found[i].second) / sizeof(Id);
+    for (size_t j = 0; j < n; ++j) {
+      result->push_back(array<Id, 2>{{found[i].first, rhs[pos + j]}});
+    }
+    pos += n;
+  }
+}
+
+// _____________________________________________________________________________
+string Index::idToString(Id id) const {
+  if (ValueId::isValue(id)) {
+    return ValueId::toString(id);
+  }
   assert(id < _vocab.size());
   return _vocab[id];
 }
 
+// _____________________________________________________________________________
+bool Index::getId(const string& word, Id* id) const {
+  return ValueId::fromString(word, id) || _vocab.getId(word, id);
+}
+
+// _____________________________________________________________________________
+Id Index::getLowerBoundId(const string& term, bool* exact) const {
+  Id id;
+  *exact = getId(term, &id);
+  return *exact ? id : _vocab.getLowerBoundId(term);
+}
+
 // _____________________________________________________________________________
 void Index::scanFunctionalRelation(const pair<off_t, size_t>& blockOff,
-                                   Id lhsId, ad_utility::File& indexFile,
+                                   Id lhsId,
+                                   const ad_utility::File& indexFile,
+                                   uint64_t fileId, bool compressed,
                                    WidthOneList *result) const {
   LOG(TRACE) << "Scanning functional relation ...\n";
-  WidthTwoList block;
-  block.resize(blockOff.second / (2 * sizeof(Id)));
-  indexFile.read(block.data(), blockOff.second, blockOff.first);
-  auto it = std::lower_bound(block.begin(), block.end(), lhsId,
+  ad_utility::BlockCache::Key key = {fileId, blockOff.first,
+                                     blockOff.second};
+  shared_ptr<const WidthTwoList> block = _blockCache.get<WidthTwoList>(key);
+  if (!block) {
+    shared_ptr<WidthTwoList> decoded = std::make_shared<WidthTwoList>();
+    if (compressed) {
+      vector<uint64_t> encoded(blockOff.second / sizeof(uint64_t));
+      indexFile.read(encoded.data(), blockOff.second, blockOff.first);
+      CompressedPairBlocks::decodeAll(encoded.data(), blockOff.second,
+                                      decoded.get());
+    } else {
+      decoded->resize(blockOff.second / (2 * sizeof(Id)));
+      indexFile.read(decoded->data(), blockOff.second, blockOff.first);
+    }
+    _blockCache.insert<WidthTwoList>(key, decoded,
+                                     decoded->size() * sizeof(array<Id, 2>));
+    block = decoded;
+  }
+  auto it = std::lower_bound(block->begin(), block->end(), lhsId,
                              [](const array<Id, 2>& elem, Id key) {
                                  return elem[0] < key;
                              });
-  if ((*it)[0] == lhsId) {
+  if (it != block->end() && (*it)[0] == lhsId) {
     result->push_back(array<Id, 1>{(*it)[1]});
   }
   LOG(TRACE) << "Read " << result->size() << " RHS.\n";
@@ -454,20 +1246,29 @@ void Index::scanFunctionalRelation(const pair<off_t, size_t>& blockOff,
 // _____________________________________________________________________________
 void Index::scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
                                       const pair<off_t, size_t>& followBlock,
-                                      Id lhsId, ad_utility::File& indexFile,
-                                      off_t upperBound,
+                                      Id lhsId,
+                                      const ad_utility::File& indexFile,
+                                      uint64_t fileId, off_t upperBound,
                                       Index::WidthOneList *result) const {
   LOG(TRACE) << "Scanning non-functional relation ...\n";
-  vector<pair<Id, off_t>> block;
-  block.resize(blockOff.second / (sizeof(Id) + sizeof(off_t)));
-  indexFile.read(block.data(), blockOff.second, blockOff.first);
-  auto it = std::lower_bound(block.begin(), block.end(), lhsId,
+  typedef vector<pair<Id, off_t>> LhsBlock;
+  ad_utility::BlockCache::Key key = {fileId, blockOff.first,
+                                     blockOff.second};
+  shared_ptr<const LhsBlock> block = _blockCache.get<LhsBlock>(key);
+  if (!block) {
+    shared_ptr<LhsBlock> read = std::make_shared<LhsBlock>(
+        blockOff.second / (sizeof(Id) + sizeof(off_t)));
+    indexFile.read(read->data(), blockOff.second, blockOff.first);
+    _blockCache.insert<LhsBlock>(key, read, blockOff.second);
+    block = read;
+  }
+  auto it = std::lower_bound(block->begin(), block->end(), lhsId,
                              [](const pair<Id, off_t>& elem, Id key) {
                                  return elem.first < key;
                              });
-  if (it->first == lhsId) {
+  if (it != block->end() && it->first == lhsId) {
     size_t nofBytes = 0;
-    if ((it + 1) != block.end()) {
+    if ((it + 1) != block->end()) {
       LOG(TRACE) << "Obtained upper bound from same block!\n";
       nofBytes = static_cast<size_t>((it + 1)->second - it->second);
     } else {
@@ -478,7 +1279,7 @@ void Index::scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
       } else {
         LOG(TRACE) << "Special case: extra scan of follow block!\n";
         pair<Id, off_t> follower;
-        _psoFile.read(&follower, sizeof(follower), followBlock.first);
+        indexFile.read(&follower, sizeof(follower), followBlock.first);
         nofBytes = static_cast<size_t>(follower.second - it->second);
       }
     }
@@ -496,14 +1297,273 @@ size_t Index::relationCardinality(const string& relationName) const {
     return IN_CONTEXT_CARDINALITY_ESTIMATE;
   }
   Id relId;
-  if (_vocab.getId(relationName, &relId)) {
-    if (this->_psoMeta.relationExists(relId)) {
-      return this->_psoMeta.getRmd(relId)._nofElements;
+  if (getId(relationName, &relId)) {
+    shared_ptr<const Snapshot> snapshot = getSnapshot();
+    if (snapshot->meta(PSO).relationExists(relId)) {
+      return snapshot->meta(PSO).getRmd(relId)._nofElements;
+    }
+  }
+  return 0;
+}
+
+// _____________________________________________________________________________
+size_t Index::subjectCardinality(const string& subject) const {
+  Id subjId;
+  if (_allPermutations && getId(subject, &subjId)) {
+    shared_ptr<const Snapshot> snapshot = getSnapshot();
+    if (snapshot->meta(SPO).relationExists(subjId)) {
+      return snapshot->meta(SPO).getRmd(subjId)._nofElements;
     }
   }
   return 0;
 }
 
+// _____________________________________________________________________________
+size_t Index::objectCardinality(const string& object) const {
+  Id objId;
+  if (_allPermutations && getId(object, &objId)) {
+    shared_ptr<const Snapshot> snapshot = getSnapshot();
+    if (snapshot->meta(OSP).relationExists(objId)) {
+      return snapshot->meta(OSP).getRmd(objId)._nofElements;
+    }
+  }
+  return 0;
+}
+
+// _____________________________________________________________________________
+double Index::averageMultiplicity(Permutation perm, const string& key,
+                                  bool lhs) const {
+  shared_ptr<const Snapshot> snapshot = getSnapshot();
+  Id relId;
+  if ((perm == PSO || perm == POS || _allPermutations) &&
+      getId(key, &relId) && snapshot->meta(perm).relationExists(relId)) {
+    const RelationMetaData& rmd = snapshot->meta(perm).getRmd(relId);
+    return lhs ? rmd.getAverageLhsMultiplicity() :
+                 rmd.getAverageRhsMultiplicity();
+  }
+  return 1;
+}
+
+// _____________________________________________________________________________
+double Index::pairWeightedLhsMultiplicity(Permutation perm,
+                                          const string& key) const {
+  shared_ptr<const Snapshot> snapshot = getSnapshot();
+  Id relId;
+  if ((perm == PSO || perm == POS || _allPermutations) &&
+      getId(key, &relId) && snapshot->meta(perm).relationExists(relId)) {
+    return snapshot->meta(perm).getRmd(relId).getPairWeightedLhsMultiplicity();
+  }
+  return 1;
+}
+
+// _____________________________________________________________________________
+bool Index::hasTriple(const string& subject, const string& predicate,
+                      const string& object) const {
+  Id relId;
+  Id subjId;
+  Id objId = 0;
+  if (!getId(predicate, &relId) || !getId(subject, &subjId) ||
+      (object.size() > 0 && !getId(object, &objId))) {
+    return false;
+  }
+  WidthOneList objects;
+  scanRelation(PSO, relId, subjId, &objects);
+  if (object.size() == 0) {
+    return objects.size() > 0;
+  }
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (objects[i][0] == objId) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const size_t Index::NOF_PERMUTATIONS;
+
+// _____________________________________________________________________________
+Index::~Index() {
+  if (_compactionThread.joinable()) {
+    _compactionThread.join();
+  }
+}
+
+// _____________________________________________________________________________
+bool Index::insertTriple(const string& subject, const string& predicate,
+                         const string& object) {
+  return updateTriple(subject, predicate, object, true);
+}
+
+// _____________________________________________________________________________
+bool Index::deleteTriple(const string& subject, const string& predicate,
+                         const string& object) {
+  return updateTriple(subject, predicate, object, false);
+}
+
+// _____________________________________________________________________________
+bool Index::updateTriple(const string& subject, const string& predicate,
+                         const string& object, bool insert) {
+  array<Id, 3> spo;
+  if (!getId(subject, &spo[0]) || !getId(predicate, &spo[1]) ||
+      !getId(object, &spo[2])) {
+    LOG(WARN) << "Cannot update triple with a term that is not in the "
+              << "vocabulary: " << subject << " " << predicate << " "
+              << object << std::endl;
+    return false;
+  }
+  size_t nofChanges;
+  {
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    size_t nofPermutations = _allPermutations ? NOF_PERMUTATIONS : 2;
+    for (size_t i = 0; i < nofPermutations; ++i) {
+      const size_t* c = PERMUTATION_COLUMNS[i];
+      if (insert) {
+        _deltas[i].insert(spo[c[0]], spo[c[1]], spo[c[2]]);
+      } else {
+        _deltas[i].erase(spo[c[0]], spo[c[1]], spo[c[2]]);
+      }
+    }
+    nofChanges = _deltas[PSO].size();
+  }
+  if (nofChanges >= DELTA_COMPACTION_THRESHOLD) {
+    startCompaction();
+  }
+  return true;
+}
+
+// _____________________________________________________________________________
+void Index::startCompaction() {
+  std::lock_guard<std::mutex> lock(_updateMutex);
+  AD_CHECK(_onDiskBase.size() > 0 && _snapshot);
+  if (_compactionRunning || (_deltas[PSO].empty() &&
+                             _snapshot->_compactingDeltas[PSO].empty())) {
+    return;
+  }
+  if (_compactionThread.joinable()) {
+    _compactionThread.join();
+  }
+  // After a failed compaction the old changes are still there,
+  // the newer ones are added on top.
+  shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>(*_snapshot);
+  for (size_t i = 0; i < NOF_PERMUTATIONS; ++i) {
+    snapshot->_compactingDeltas[i].merge(_deltas[i]);
+    _deltas[i].clear();
+  }
+  _snapshot = snapshot;
+  _compactionError = std::exception_ptr();
+  _compactionRunning = true;
+  _compactionThread = std::thread(&Index::compact, this);
+}
+
+// _____________________________________________________________________________
+void Index::waitForCompaction() {
+  std::thread compactionThread;
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(_updateMutex);
+    _compactionDone.wait(lock, [this] { return !_compactionRunning; });
+    compactionThread.swap(_compactionThread);
+    error = _compactionError;
+  }
+  // The compaction is done, the thread only has to return.
+  if (compactionThread.joinable()) {
+    compactionThread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// _____________________________________________________________________________
+void Index::compact() {
+  try {
+    // Only this thread replaces the snapshot while the compaction runs.
+    shared_ptr<const Snapshot> snapshot = getSnapshot();
+    const DeltaStore& deltas = snapshot->_compactingDeltas[PSO];
+    const IndexMetaData& meta = snapshot->meta(PSO);
+    LOG(INFO) << "Compacting " << deltas.size()
+              << " changes into the index..." << std::endl;
+    ExtVec v;
+    {
+      std::set<Id> relIds;
+      vector<Id> ids = meta.getRelationIds();
+      relIds.insert(ids.begin(), ids.end());
+      ids = deltas.getRelationIds();
+      relIds.insert(ids.begin(), ids.end());
+      ExtVec::bufwriter_type writer(v);
+      for (auto it = relIds.begin(); it != relIds.end(); ++it) {
+        WidthTwoList pairs;
+        readRelation(meta, snapshot->file(PSO), *it, &pairs);
+        deltas.apply(*it, &pairs);
+        for (size_t i = 0; i < pairs.size(); ++i) {
+          writer << array<Id, 3>{{pairs[i][0], *it, pairs[i][1]}};
+        }
+      }
+      writer.finish();
+    }
+    string tmpBase = _onDiskBase + ".compacting";
+    Index builder;
+    builder.setBuildAllPermutations(_allPermutations);
+    builder.setCompressFullIndex(meta.isFullIndexCompressed());
+    builder.setBuildLhsFilters(meta.hasLhsFilters());
+    builder.createPermutations(tmpBase + ".index", v);
+
+    // Open files keep their contents, scans of the old snapshot are not
+    // affected by the renames.
+    replacePermutationFiles(tmpBase);
+    registerPermutations();
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    _compactionRunning = false;
+    _compactionDone.notify_all();
+    LOG(INFO) << "Compaction done." << std::endl;
+  } catch (...) {
+    LOG(ERROR) << "Compaction failed, changes are kept in memory."
+               << std::endl;
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    _compactionError = std::current_exception();
+    _compactionRunning = false;
+    _compactionDone.notify_all();
+  }
+}
+
+// _____________________________________________________________________________
+void Index::replacePermutationFiles(const string& newBase) const {
+  string oldBase = _onDiskBase + ".replaced";
+  size_t nofPermutations = _allPermutations ? NOF_PERMUTATIONS : 2;
+  size_t nofMovedAside = 0;
+  string error;
+  for (size_t i = 0; i < nofPermutations; ++i) {
+    string current = _onDiskBase + PERMUTATION_SUFFIXES[i];
+    string old = oldBase + PERMUTATION_SUFFIXES[i];
+    string next = newBase + PERMUTATION_SUFFIXES[i];
+    if (std::rename(current.c_str(), old.c_str()) != 0) {
+      error = "Could not move " + current + " to " + old;
+      break;
+    }
+    ++nofMovedAside;
+    if (std::rename(next.c_str(), current.c_str()) != 0) {
+      error = "Could not replace " + current + " by " + next;
+      break;
+    }
+  }
+  if (error.size() > 0) {
+    // Puts the old files back, also over new ones already in place.
+    for (size_t i = 0; i < nofMovedAside; ++i) {
+      string current = _onDiskBase + PERMUTATION_SUFFIXES[i];
+      string old = oldBase + PERMUTATION_SUFFIXES[i];
+      if (std::rename(old.c_str(), current.c_str()) != 0) {
+        LOG(ERROR) << "Could not restore " << current << " from " << old
+                   << std::endl;
+      }
+    }
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT, error);
+  }
+  for (size_t i = 0; i < nofPermutations; ++i) {
+    string old = oldBase + PERMUTATION_SUFFIXES[i];
+    std::remove(old.c_str());
+  }
+}
+
 // _____________________________________________________________________________
 void Index::writeAsciiListFile(string filename, const vector<Id>& ids) const {
   std::ofstream f(filename.c_str());
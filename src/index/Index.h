@@ -5,24 +5,42 @@
 
 #include <string>
 #include <array>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <vector>
+#include <unordered_map>
 #include <stxxl/vector>
 #include "./Vocabulary.h"
 #include "./IndexMetaData.h"
+#include "./BuildReport.h"
+#include "./DeltaStore.h"
+#include "./RelationScan.h"
 #include "./StxxlSortFunctors.h"
+#include "../util/BlockCache.h"
 #include "../util/File.h"
 #include "./TextMetaData.h"
+#include "./PostingListCodec.h"
 #include "./DocsDB.h"
+#include "../global/ValueId.h"
 
 
 using std::string;
 using std::array;
 using std::vector;
 using std::tuple;
+using std::unordered_map;
+using std::shared_ptr;
 
 class Index {
 public:
+  enum Permutation {
+    PSO = 0, POS = 1, SPO = 2, SOP = 3, OSP = 4, OPS = 5
+  };
+  static const size_t NOF_PERMUTATIONS = 6;
+
   typedef stxxl::VECTOR_GENERATOR<array<Id, 3>>::result ExtVec;
   // Block Id, Context Id, Word Id, Score, entity
   typedef stxxl::VECTOR_GENERATOR<tuple<Id, Id, Id, Score, bool>>::result TextVec;
@@ -36,6 +54,8 @@ public:
 
   Index() = default;
 
+  ~Index();
+
   // Creates an index from a TSV file.
   // Will write vocabulary and on-disk index data.
   // Also ends up with fully functional in-memory metadata.
@@ -46,6 +66,45 @@ public:
   // Also ends up with fully functional in-memory metadata.
   void createFromNTriplesFile(const string& ntFile, const string& onDiskBase);
 
+  // Sets the approximate number of bytes the vocabulary construction
+  // may hold in memory. Larger inputs are split into chunks whose partial
+  // vocabularies are written to disk and merged afterwards.
+  void setVocabularyMemoryBudget(size_t bytes) {
+    _vocabMemoryBudget = bytes;
+  }
+
+  // Also build the SPO, SOP, OSP and OPS permutations when creating
+  // an index. Without them, only PSO and POS are available.
+  void setBuildAllPermutations(bool all) {
+    _allPermutations = all;
+  }
+
+  bool hasAllPermutations() const {
+    return _allPermutations;
+  }
+
+  // Store the pair lists of the FullIndex in compressed blocks
+  // (see CompressedPairBlocks) when creating an index.
+  void setCompressFullIndex(bool compress) {
+    _compressFullIndex = compress;
+  }
+
+  // Store a Bloom filter over the LHS of each relation when creating an
+  // index, so that scans for an absent LHS do not read from disk.
+  void setBuildLhsFilters(bool lhsFilters) {
+    _buildLhsFilters = lhsFilters;
+  }
+
+  // How the codec of each context, word and score list of the text index
+  // is chosen when creating it: the smallest or a fast one among the
+  // allowed codecs (see PostingListCodec).
+  void setTextCodecSelection(
+      PostingListCodec::Selection selection,
+      unsigned allowedCodecs = PostingListCodec::ALL_CODECS) {
+    _textCodecSelection = selection;
+    _textCodecs = allowedCodecs;
+  }
+
   // Creates an index object from an on disk index
   // that has previously been constructed.
   // Read necessary meta data into memory and opens file handles.
@@ -64,6 +123,37 @@ public:
   // Checks if the index is ready for use, i.e. it is properly intitialized.
   bool ready() const;
 
+  // Number of bytes the cache for blocks and lists read from the
+  // permutations and the text index may hold, 0 disables it.
+  void setBlockCacheCapacity(size_t bytes) {
+    _blockCache.setCapacity(bytes);
+  }
+
+  void clearBlockCache() const {
+    _blockCache.clear();
+  }
+
+  // Hits, misses and size of the block cache.
+  string blockCacheStatistics() const;
+
+  // Number of bytes the cache for the postings of single terms may hold,
+  // 0 disables it.
+  void setPostingListCacheCapacity(size_t bytes) {
+    _postingListCache.setCapacity(bytes);
+  }
+
+  void clearPostingListCache() const {
+    _postingListCache.clear();
+  }
+
+  // Hits, misses and size of the posting list cache.
+  string postingListCacheStatistics() const;
+
+  // Timings, resource usage and sizes of the parts built by this object.
+  const BuildReport& getBuildReport() const {
+    return _buildReport;
+  }
+
   // --------------------------------------------------------------------------
   //  -- RETRIEVAL ---
   // --------------------------------------------------------------------------
@@ -77,7 +167,7 @@ public:
   // --------------------------------------------------------------------------
   size_t relationCardinality(const string& relationName) const;
 
-  const string& idToString(Id id) const;
+  string idToString(Id id) const;
 
   void scanPSO(const string& predicate, WidthTwoList *result) const;
 
@@ -89,14 +179,123 @@ public:
   void scanPOS(const string& predicate, const string& object, WidthOneList *
   result) const;
 
+  // (subject, object) pairs with a subject in the range / (object, subject)
+  // pairs with an object in the range. Only reads the blocks of the
+  // relation that overlap the range.
+  void scanPSO(const string& predicate, const IdRange& subjectRange,
+               WidthTwoList *result) const;
+
+  void scanPOS(const string& predicate, const IdRange& objectRange,
+               WidthTwoList *result) const;
+
+  // (subject, object) pairs for several subjects / (object, subject) pairs
+  // for several objects at once, sorted by the keys, which have to be
+  // sorted. Each block of the relation with keys is read once, adjacent
+  // blocks with a single read.
+  void scanPSOBatch(const string& predicate, const vector<Id>& subjects,
+                    WidthTwoList *result) const;
+
+  void scanPOSBatch(const string& predicate, const vector<Id>& objects,
+                    WidthTwoList *result) const;
+
+  // The Id of an RDF term in the vocabulary or as a value. If there is
+  // none, the Id the term would be inserted before in the vocabulary,
+  // exact is false then.
+  Id getLowerBoundId(const string& term, bool* exact) const;
+
+  // The following scans require all permutations.
+  // Number of triples with the given subject / object.
+  size_t subjectCardinality(const string& subject) const;
+
+  size_t objectCardinality(const string& object) const;
+
+  // Average number of pairs per distinct LHS (or RHS) of the relation
+  // with the given key in a permutation, e.g. the number of objects per
+  // subject of a predicate for PSO and lhs = true.
+  // 1 if there is no such relation.
+  double averageMultiplicity(Permutation perm, const string& key,
+                             bool lhs) const;
+
+  // Number of pairs of the LHS of a random pair of that relation, see
+  // RelationMetaData::getPairWeightedLhsMultiplicity. Larger than the
+  // average for skewed relations. 1 if there is no such relation.
+  double pairWeightedLhsMultiplicity(Permutation perm,
+                                     const string& key) const;
+
+  // True if there is a triple with the given subject and predicate and,
+  // unless it is empty, object. Most absent subjects are rejected by the
+  // LHS filters without reading from disk.
+  bool hasTriple(const string& subject, const string& predicate,
+                 const string& object = "") const;
+
+  // (predicate, object) pairs for a subject.
+  void scanSPO(const string& subject, WidthTwoList *result) const;
+
+  // (object, predicate) pairs for a subject.
+  void scanSOP(const string& subject, WidthTwoList *result) const;
+
+  // Predicates connecting a subject and an object.
+  void scanSOP(const string& subject, const string& object,
+               WidthOneList *result) const;
+
+  // (subject, predicate) pairs for an object.
+  void scanOSP(const string& object, WidthTwoList *result) const;
+
+  // (predicate, subject) pairs for an object.
+  void scanOPS(const string& object, WidthTwoList *result) const;
+
+  // The pairs of the relation with the given key in a permutation, e.g.
+  // the (subject, object) pairs of a predicate for PSO, as a RelationScan
+  // that reads them a block at a time. Same order and contents as the
+  // scans above, but only one block has to be in memory.
+  RelationScan scanBlocks(Permutation perm, const string& key,
+                          size_t pairsPerBlock =
+                              DEFAULT_PAIRS_PER_SCAN_BLOCK) const;
+
+
+  // --------------------------------------------------------------------------
+  // UPDATES
+  // --------------------------------------------------------------------------
+  // Inserts / deletes a triple. The change is kept in memory and visible
+  // to all scans right away. Once enough changes have been collected, a
+  // compaction is started.
+  // Only triples over known terms can be changed: all terms have to be in
+  // the vocabulary or be literals with a value id (numbers, dates).
+  // Returns false and ignores the triple otherwise. New entities cannot be
+  // added, ids are ranks in the sorted vocabulary and neither the changes
+  // nor a compaction touch the vocabulary.
+  bool insertTriple(const string& subject, const string& predicate,
+                    const string& object);
+
+  bool deleteTriple(const string& subject, const string& predicate,
+                    const string& object);
+
+  // Folds all changes so far into new permutation files on a background
+  // thread. Scans keep working on the old files and the changes in memory
+  // until the new files replace them. Does nothing if a compaction is
+  // already running. After a failed compaction, the files on disk are the
+  // old ones and the next compaction retries with all changes.
+  void startCompaction();
+
+  // Waits until a running compaction is done, from any thread.
+  // Rethrows the error if the compaction failed.
+  void waitForCompaction();
 
   // --------------------------------------------------------------------------
   // TEXT RETRIEVAL
   // --------------------------------------------------------------------------
-  const string& wordIdToString(Id id) const;
+  string wordIdToString(Id id) const;
 
   void getContextListForWords(const string& words, WidthTwoList *result) const;
 
+  //! The k contexts with the highest scores that contain all words, as
+  //! (context, score) rows by descending score. Unlike for
+  //! getContextListForWords, the score of a context is the sum over the
+  //! words of its highest score for each. Only reads the sub-blocks of
+  //! the lists that may still hold one of the top k.
+  void getTopKContextsForWords(const string& words, size_t k,
+                               WidthTwoList *result) const;
+
   void getECListForWords(const string& words, size_t limit,
                          WidthThreeList *result) const;
 
@@ -141,63 +340,254 @@ private:
   string _onDiskBase;
   Vocabulary _vocab;
   Vocabulary _textVocab;
-  IndexMetaData _psoMeta;
-  IndexMetaData _posMeta;
   TextMetaData _textMeta;
   DocsDB _docsDB;
+  BuildReport _buildReport;
   vector<Id> _blockBoundaries;
   off_t _currentoff_t;
-  mutable ad_utility::File _psoFile;
-  mutable ad_utility::File _posFile;
-  mutable ad_utility::File _textIndexFile;
-
-  size_t passTsvFileForVocabulary(const string& tsvFile);
-
-  void passTsvFileIntoIdVector(const string& tsvFile, ExtVec& data);
-
-  size_t passNTriplesFileForVocabulary(const string& tsvFile);
-
-  void passNTriplesFileIntoIdVector(const string& tsvFile, ExtVec& data);
+  size_t _vocabMemoryBudget = DEFAULT_VOCABULARY_MEMORY_BUDGET;
+  bool _allPermutations = false;
+  bool _compressFullIndex = false;
+  bool _buildLhsFilters = false;
+  PostingListCodec::Selection _textCodecSelection = PostingListCodec::SMALLEST;
+  unsigned _textCodecs = PostingListCodec::ALL_CODECS;
+  ad_utility::File _textIndexFile;
+  // Decoded blocks of the files above, shared by concurrent scans.
+  mutable ad_utility::BlockCache _blockCache{DEFAULT_BLOCK_CACHE_CAPACITY};
+  // Postings of single words and prefixes as getWordPostingsForTerm and
+  // getEntityPostingsForTerm return them, filtered and intersected.
+  // Separate from _blockCache so that scans do not evict hot terms.
+  mutable ad_utility::BlockCache _postingListCache{
+      DEFAULT_POSTING_LIST_CACHE_CAPACITY};
+
+  // The permutation files with their meta data.
+  struct PermutationFiles {
+    array<IndexMetaData, NOF_PERMUTATIONS> _meta;
+    array<ad_utility::File, NOF_PERMUTATIONS> _files;
+    // Counts the registered permutation files, distinguishes their blocks
+    // in the block cache from those of the files they replaced.
+    uint64_t _generation;
+  };
+
+  // What scans read besides the changes since the last compaction:
+  // the permutation files and the changes a running compaction folds
+  // into new files. Never modified once published, a compaction
+  // publishes a new snapshot. Scans hold on to the one they started
+  // with, which keeps its files open and its meta data mapped.
+  struct Snapshot {
+    shared_ptr<const PermutationFiles> _permutations;
+    array<DeltaStore, NOF_PERMUTATIONS> _compactingDeltas;
+
+    const IndexMetaData& meta(Permutation perm) const {
+      return _permutations->_meta[perm];
+    }
+
+    const ad_utility::File& file(Permutation perm) const {
+      return _permutations->_files[perm];
+    }
+
+    // Id of a permutation file in the block cache.
+    uint64_t cacheId(Permutation perm) const {
+      return _permutations->_generation * NOF_PERMUTATIONS + perm;
+    }
+  };
+
+  // Ids of the text index file and of its decoded sub-blocks in the block
+  // cache. Generations start at 1, permutation files never get these ids.
+  static const uint64_t TEXT_INDEX_CACHE_ID = 0;
+  static const uint64_t TEXT_SUB_BLOCK_CACHE_ID = 1;
+  uint64_t _permutationGeneration = 0;
+
+  shared_ptr<const Snapshot> _snapshot;
+  // Changes since the last compaction, one store per permutation.
+  // Scans apply the compacting changes of their snapshot first and the
+  // ones here on top.
+  array<DeltaStore, NOF_PERMUTATIONS> _deltas;
+  // Guards _snapshot, _deltas and the compaction state below. Only held
+  // to copy or replace them, never while reading from disk.
+  mutable std::mutex _updateMutex;
+  std::thread _compactionThread;
+  bool _compactionRunning = false;
+  std::exception_ptr _compactionError;
+  std::condition_variable _compactionDone;
+
+  // Parses the input once. Assigns chunk-local ids to the words of each
+  // chunk of at most _vocabMemoryBudget bytes and writes the triples with
+  // these provisional ids to data. The chunks are spilled as partial
+  // vocabularies, merged into the vocabulary file and the provisional ids
+  // in data are rewritten to final vocabulary ids in a streaming pass.
+  // Returns the number of triples.
+  template<class Parser>
+  size_t passFileIntoIdVector(const string& file, ExtVec& data);
+
+  void spillPartialVocabulary(std::unordered_map<string, Id>& chunkIds,
+                              vector<string>& partialFiles) const;
+
+  static void remapProvisionalIds(ExtVec& data, size_t from, size_t to,
+                                  const vector<Id>& localToFinal);
+
+  // Id of an RDF term: a value Id for numeric and date literals,
+  // the vocabulary Id otherwise. Returns false if there is none.
+  bool getId(const string& word, Id* id) const;
 
   size_t passContextFileForVocabulary(const string& contextFile);
 
   void passContextFileIntoVector(const string& contextFile, TextVec& vec);
 
+  // How to sort the triples for a permutation and which columns to use.
+  struct PermutationSpec {
+    string _name;
+    IndexMetaData* _meta;
+    size_t _c0;
+    size_t _c1;
+    size_t _c2;
+    void (*_sort)(ExtVec&);
+  };
+
+  template<class Comparator>
+  static void sortVector(ExtVec& v);
+
+  // Sorts the vector for each permutation that is to be built
+  // and writes the permutation files. The sort for the next permutation
+  // runs on a copy of the vector while the current one is written.
+  void createPermutations(const string& indexFilename, ExtVec& v);
+
+  // Writes a permutation from a vector sorted by columns c0, c1, c2.
+  // Column c0 identifies the "relation", c1 and c2 form its pairs.
   static void createPermutation(const string& fileName,
                                 const ExtVec& vec,
                                 IndexMetaData& meta,
-                                size_t c1, size_t c2);
+                                size_t c0, size_t c1, size_t c2);
+
+  static void readMetaData(const string& fileName, IndexMetaData& meta);
 
   void createTextIndex(const string& filename, const TextVec& vec);
 
   ContextListMetaData writePostings(ad_utility::File& out,
                                     const vector<Posting>& postings,
-                                    bool skipWordlistIfAllTheSame);
-
-  static RelationMetaData writeRel(ad_utility::File& out, off_t currentOffset,
-                                   Id relId, const vector<array<Id, 2>>& data,
-                                   bool functional);
+                                    bool skipWordlistIfAllTheSame,
+                                    bool withSubBlocks);
+
+  // A relation encoded in memory. Offsets in the meta data and inside
+  // the bytes are relative to the start of the relation.
+  // The meta data does not own its blocks and its LHS filter, use
+  // getRmd to point it to the ones here.
+  struct EncodedRelation {
+    RelationMetaData _rmd;
+    vector<char> _bytes;
+    vector<BlockMetaData> _blocks;
+    vector<uint64_t> _lhsFilterWords;
+    size_t _lhsFilterHashes = 0;
+
+    const RelationMetaData& getRmd() {
+      _rmd._blocks = _blocks.data();
+      _rmd._nofBlocks = _blocks.size();
+      _rmd._lhsFilter = BloomFilter(_lhsFilterWords.data(),
+                                    _lhsFilterWords.size(), _lhsFilterHashes);
+      return _rmd;
+    }
+  };
+
+  static EncodedRelation encodeRel(Id relId,
+                                   const vector<array<Id, 2>>& data,
+                                   bool functional, bool compress,
+                                   bool lhsFilter);
+
+  // Moves an encoded relation to the given offset in the file.
+  static void rebaseRelation(EncodedRelation* rel, off_t offset);
 
   static RelationMetaData& writeFunctionalRelation(
-      const vector<array<Id, 2>>& data, RelationMetaData& rmd);
+      const vector<array<Id, 2>>& data, const vector<off_t>& fullIndexBlocks,
+      off_t afterFullIndex, RelationMetaData& rmd,
+      vector<BlockMetaData>* blocks);
 
   static RelationMetaData& writeNonFunctionalRelation(
-      ad_utility::File& out,
+      vector<char>* out,
       const vector<array<Id, 2>>& data,
-      RelationMetaData& rmd);
-
-  void openFileHandles();
+      off_t startOfLhs,
+      RelationMetaData& rmd,
+      vector<BlockMetaData>* blocks);
 
   void openTextFileHandle();
 
+  // Scans a permutation and applies the changes in memory.
+  void scanRelation(Permutation perm, Id relId, WidthTwoList *result) const;
+
+  void scanRelation(Permutation perm, Id relId, Id lhsId,
+                    WidthOneList *result) const;
+
+  void scanRelation(Permutation perm, Id relId, const IdRange& lhsRange,
+                    WidthTwoList *result) const;
+
+  void scanRelation(Permutation perm, Id relId, const vector<Id>& lhsIds,
+                    WidthTwoList *result) const;
+
+  // Reads from a permutation file only.
+  void readRelation(const IndexMetaData& meta,
+                    const ad_utility::File& file,
+                    Id relId, WidthTwoList *result) const;
+
+  // Blocks read by these two are cached under the file id given.
+  void readRelation(const IndexMetaData& meta,
+                    const ad_utility::File& file, uint64_t fileId,
+                    Id relId, Id lhsId, WidthOneList *result) const;
+
+  void readRelation(const IndexMetaData& meta,
+                    const ad_utility::File& file,
+                    Id relId, const IdRange& lhsRange,
+                    WidthTwoList *result) const;
+
+  void readRelation(const IndexMetaData& meta,
+                    const ad_utility::File& file, uint64_t fileId,
+                    Id relId, const vector<Id>& lhsIds,
+                    WidthTwoList *result) const;
+
+  // The current snapshot.
+  shared_ptr<const Snapshot> getSnapshot() const;
+
+  // The current snapshot and the changes to one relation of a
+  // permutation since the last compaction, consistent with each other.
+  shared_ptr<const Snapshot> getSnapshot(Permutation perm, Id relId,
+                                         DeltaStore* deltas) const;
+
+  // Meta data of the current snapshot. Only for callers that do not run
+  // concurrently with a compaction.
+  const IndexMetaData& getMeta(Permutation perm) const {
+    return _snapshot->meta(perm);
+  }
+
+  // Opens the permutation files, maps their meta data and publishes
+  // them as a new snapshot without compacting changes.
+  void registerPermutations();
+
+  bool updateTriple(const string& subject, const string& predicate,
+                    const string& object, bool insert);
+
+  // Runs on the compaction thread.
+  void compact();
+
+  // Replaces the permutation files by the ones with base name newBase.
+  // The old files are moved aside and only removed once all new files are
+  // in place. If a rename fails, the old files are moved back and an
+  // exception is thrown, so the files are either all old or all new.
+  void replacePermutationFiles(const string& newBase) const;
+
+  // The blocks at the (offset, nofBytes) spans of a file, from the block
+  // cache or read with one batch of reads and decoded from the words read.
+  template<class Block, class Decode>
+  vector<shared_ptr<const Block>> readBlocks(
+      const ad_utility::File& file, uint64_t fileId,
+      const vector<pair<off_t, size_t>>& spans, Decode decode) const;
+
   void scanFunctionalRelation(const pair<off_t, size_t>& blockOff,
-                              Id lhsId, ad_utility::File& indexFile,
+                              Id lhsId, const ad_utility::File& indexFile,
+                              uint64_t fileId, bool compressed,
                               WidthOneList *result) const;
 
   void scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
                                  const pair<off_t, size_t>& followBlock,
-                                 Id lhsId, ad_utility::File& indexFile,
-                                 off_t upperBound,
+                                 Id lhsId, const ad_utility::File& indexFile,
+                                 uint64_t fileId, off_t upperBound,
                                  WidthOneList *result) const;
 
   void addContextToVector(TextVec::bufwriter_type& writer, Id context,
@@ -206,12 +596,53 @@ private:
 
   template<typename T>
   void readGapComprList(size_t nofElements, off_t from, size_t nofBytes,
+                        PostingListCodec::Codec codec,
                         vector<T>& result) const;
 
   template<typename T>
   void readFreqComprList(size_t nofElements, off_t from, size_t nofBytes,
+                         PostingListCodec::Codec codec,
                          vector<T>& result) const;
 
+  // The word ids of a word or a prefix. False if there are none.
+  bool getIdRangeForTerm(const string& term, IdRange* idRange) const;
+
+  // Decoded postings of a sub-block of a classic list or of a term,
+  // words only if there are any.
+  struct TextPostings {
+    vector<Id> _cids;
+    vector<Id> _wids;
+    vector<Score> _scores;
+
+    size_t getSizeInBytes() const {
+      return (_cids.size() + _wids.size()) * sizeof(Id) +
+          _scores.size() * sizeof(Score);
+    }
+  };
+
+  static string cacheStatistics(const string& name,
+                                const ad_utility::BlockCache& cache);
+
+  // Key of the postings for idRange in the posting list cache. The address
+  // of the context list identifies the block and whether these are word or
+  // entity postings, so the cache has to be cleared with the meta data.
+  static ad_utility::BlockCache::Key postingListCacheKey(
+      const ContextListMetaData& cl, const IdRange& idRange) {
+    return {reinterpret_cast<uintptr_t>(&cl),
+            static_cast<off_t>(idRange._first),
+            static_cast<size_t>(idRange._last)};
+  }
+
+  shared_ptr<const vector<TextSubBlockMetaData>> readSubBlockMetaData(
+      const ContextListMetaData& cl) const;
+
+  // Contexts and scores of sub-block b of the classic list of a block,
+  // only for the words in idRange.
+  void readSubBlock(const TextBlockMetaData& tbmd,
+                    const vector<TextSubBlockMetaData>& subBlocks, size_t b,
+                    const IdRange& idRange, vector<Id>& cids,
+                    vector<Score>& scores) const;
+
 
   size_t getIndexOfBestSuitedElTerm(const vector<string>& terms) const;
 
@@ -222,12 +653,16 @@ private:
 
   Id getEntityBlockId(Id entityId) const;
 
-  //! Writes a list of elements (have to be able to be cast to unit64_t)
-  //! to file.
-  //! Returns the number of bytes written.
+  //! Encodes a list of elements (have to be able to be cast to unit64_t)
+  //! with the codec _textCodecSelection picks for it among _textCodecs and
+  //! returns that codec.
+  //! entryElements and entryWords receive the first element and the
+  //! first code word of each point the list can be decoded from.
   template<class Numeric>
-  size_t writeList(Numeric *data, size_t nofElements,
-                   ad_utility::File& file) const;
+  PostingListCodec::Codec encodeList(Numeric *data, size_t nofElements,
+                                     vector<uint64_t>* encoded,
+                                     vector<size_t>* entryElements,
+                                     vector<size_t>* entryWords) const;
 
   typedef unordered_map<Id, Id> IdCodeMap;
   typedef unordered_map<Score, Score> ScoreCodeMap;
@@ -248,5 +683,19 @@ private:
 
   friend class IndexTest_createFromOnDiskIndexTest_Test;
 
+  friend class IndexTest_createWithPartialVocabulariesTest_Test;
+
+  friend class IndexTest_compressedFullIndexTest_Test;
+
+  friend class IndexTest_updateTest_Test;
+
+  friend class IndexTest_rangeScanTest_Test;
+
+  friend class IndexTest_topKContextsTest_Test;
+
+  friend class IndexTest_textCodecsTest_Test;
+
+  friend class IndexTest_postingListCacheTest_Test;
+
     void writeAsciiListFile(string filename, const vector<Id>& ids) const;
 };
\ No newline at end of file
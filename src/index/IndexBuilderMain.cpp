@@ -32,6 +32,12 @@ struct option options[] = {
     {"index-basename",    required_argument, NULL, 'b'},
     {"words-by-contexts", required_argument, NULL, 'w'},
     {"docs-by-contexts",  required_argument, NULL, 'd'},
+    {"vocabulary-memory-mb", required_argument, NULL, 'm'},
+    {"all-permutations",  no_argument,       NULL, 'a'},
+    {"compress-pairs",    no_argument,       NULL, 'c'},
+    {"lhs-filters",       no_argument,       NULL, 'f'},
+    {"build-report",      required_argument, NULL, 'r'},
+    {"text-codecs",       required_argument, NULL, 'x'},
     {NULL, 0,                                NULL, 0}
 };
 
@@ -74,10 +80,17 @@ int main(int argc, char** argv) {
   string baseName;
   string wordsfile;
   string docsfile;
+  size_t vocabMemoryBudget = DEFAULT_VOCABULARY_MEMORY_BUDGET;
+  bool allPermutations = false;
+  bool compressPairs = false;
+  bool lhsFilters = false;
+  string reportFile;
+  PostingListCodec::Selection textCodecSelection = PostingListCodec::SMALLEST;
+  unsigned textCodecs = PostingListCodec::ALL_CODECS;
   optind = 1;
   // Process command line arguments.
   while (true) {
-    int c = getopt_long(argc, argv, "t:n:b:w:d:", options, NULL);
+    int c = getopt_long(argc, argv, "t:n:b:w:d:m:acfr:x:", options, NULL);
     if (c == -1) { break; }
     switch (c) {
       case 't':
@@ -95,6 +108,36 @@ int main(int argc, char** argv) {
       case 'd':
         docsfile = optarg;
         break;
+      case 'm':
+        vocabMemoryBudget = size_t(atol(optarg)) * 1024 * 1024;
+        break;
+      case 'a':
+        allPermutations = true;
+        break;
+      case 'c':
+        compressPairs = true;
+        break;
+      case 'f':
+        lhsFilters = true;
+        break;
+      case 'r':
+        reportFile = optarg;
+        break;
+      case 'x': {
+        PostingListCodec::Codec codec;
+        if (string(optarg) == "smallest") {
+          textCodecSelection = PostingListCodec::SMALLEST;
+        } else if (string(optarg) == "fastest") {
+          textCodecSelection = PostingListCodec::FASTEST;
+        } else if (PostingListCodec::fromName(optarg, &codec)) {
+          textCodecs = PostingListCodec::only(codec);
+        } else {
+          cout << "--text-codecs (-x) has to be smallest, fastest, Simple8b, "
+              "BitPacking, PFor or StreamVByte" << endl;
+          exit(1);
+        }
+        break;
+      }
       default:
         cout << endl
         << "! ERROR in processing options (getopt returned '" << c
@@ -126,6 +169,11 @@ int main(int argc, char** argv) {
 
   try {
     Index index;
+    index.setVocabularyMemoryBudget(vocabMemoryBudget);
+    index.setBuildAllPermutations(allPermutations);
+    index.setCompressFullIndex(compressPairs);
+    index.setBuildLhsFilters(lhsFilters);
+    index.setTextCodecSelection(textCodecSelection, textCodecs);
     if (ntFile.size() > 0) {
       index.createFromNTriplesFile(ntFile, baseName);
     } else if (tsvFile.size() > 0) {
@@ -141,6 +189,11 @@ int main(int argc, char** argv) {
     if (docsfile.size() > 0) {
       index.buildDocsDB(docsfile);
     }
+
+    if (reportFile.size() > 0) {
+      LOG(INFO) << "Writing build report to " << reportFile << std::endl;
+      index.getBuildReport().writeJson(reportFile);
+    }
   } catch (ad_semsearch::Exception& e) {
     LOG(ERROR) << e.getFullErrorMessage() << std::endl;
   }
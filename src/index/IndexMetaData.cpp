@@ -2,18 +2,128 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
 #include "./IndexMetaData.h"
+#include "../util/Exception.h"
 #include "../util/ReadableNumberFact.h"
 
+const size_t RelationStatistics::HISTOGRAM_SIZE;
+const size_t IndexMetaData::HEADER_WORDS;
+
+namespace {
+// Bits of the format word in the header.
+const size_t FORMAT_COMPRESSED = 1;
+const size_t FORMAT_LHS_FILTERS = 2;
+// Blocks know their last LHS. Set for all permutations written since.
+const size_t FORMAT_BLOCK_LAST_LHS = 4;
+// Relation records have 64 bit histogram buckets. Required, the records
+// of older permutations have a different size.
+const size_t FORMAT_WIDE_HISTOGRAM = 8;
+}
+
+// _____________________________________________________________________________
+IndexMetaData::IndexMetaData() : _offsetAfter(0),
+                                 _fullIndexCompressed(false),
+                                 _lhsFilters(false),
+                                 _relations(nullptr),
+                                 _blocks(nullptr),
+                                 _filterWords(nullptr),
+                                 _nofRelations(0),
+                                 _nofBlocks(0),
+                                 _nofFilterWords(0),
+                                 _mapping(nullptr),
+                                 _mappingBytes(0) {
+}
+
+// _____________________________________________________________________________
+IndexMetaData::~IndexMetaData() {
+  clear();
+}
+
+// _____________________________________________________________________________
+IndexMetaData::IndexMetaData(IndexMetaData&& other) : IndexMetaData() {
+  *this = std::move(other);
+}
+
+// _____________________________________________________________________________
+IndexMetaData& IndexMetaData::operator=(IndexMetaData&& other) {
+  if (this == &other) {
+    return *this;
+  }
+  clear();
+  _offsetAfter = other._offsetAfter;
+  _fullIndexCompressed = other._fullIndexCompressed;
+  _lhsFilters = other._lhsFilters;
+  _relations = other._relations;
+  _blocks = other._blocks;
+  _filterWords = other._filterWords;
+  _nofRelations = other._nofRelations;
+  _nofBlocks = other._nofBlocks;
+  _nofFilterWords = other._nofFilterWords;
+  // Moving a vector keeps its elements in place, so the pointers stay valid.
+  _relationData = std::move(other._relationData);
+  _blockData = std::move(other._blockData);
+  _filterData = std::move(other._filterData);
+  _mapping = other._mapping;
+  _mappingBytes = other._mappingBytes;
+  other._mapping = nullptr;
+  other._mappingBytes = 0;
+  other.clear();
+  return *this;
+}
+
+// _____________________________________________________________________________
+void IndexMetaData::clear() {
+  if (_mapping) {
+    munmap(_mapping, _mappingBytes);
+    _mapping = nullptr;
+    _mappingBytes = 0;
+  }
+  _relationData.clear();
+  _blockData.clear();
+  _filterData.clear();
+  _offsetAfter = 0;
+  pointToData();
+}
+
 // _____________________________________________________________________________
-IndexMetaData::IndexMetaData() : _offsetAfter(0) {
+void IndexMetaData::pointToData() {
+  _relations = _relationData.data();
+  _blocks = _blockData.data();
+  _filterWords = _filterData.data();
+  _nofRelations = _relationData.size();
+  _nofBlocks = _blockData.size();
+  _nofFilterWords = _filterData.size();
 }
 
 // _____________________________________________________________________________
 void IndexMetaData::add(const RelationMetaData& rmd) {
-  _data[rmd._relId] = rmd;
+  // Relations are added in the order of their ids when an index is built.
+  AD_CHECK(!_mapping);
+  AD_CHECK(_relationData.empty() || _relationData.back()._relId < rmd._relId);
+  RelationRecord record;
+  record._relId = rmd._relId;
+  record._startFullIndex = rmd._startFullIndex;
+  record._startRhs = rmd._startRhs;
+  record._offsetAfter = rmd._offsetAfter;
+  record._nofElements = rmd._nofElements;
+  record._nofBlocks = rmd._nofBlocks;
+  record._firstBlock = _blockData.size();
+  record._firstFilterWord = _filterData.size();
+  record._nofFilterWords = rmd._lhsFilter.getNofWords();
+  record._nofFilterHashes = rmd._lhsFilter.getNofHashes();
+  record._stats = rmd._stats;
+  _relationData.push_back(record);
+  _blockData.insert(_blockData.end(), rmd._blocks,
+                    rmd._blocks + rmd._nofBlocks);
+  _filterData.insert(_filterData.end(), rmd._lhsFilter.getWords(),
+                     rmd._lhsFilter.getWords() + record._nofFilterWords);
+  pointToData();
   if (rmd._offsetAfter > _offsetAfter) { _offsetAfter = rmd._offsetAfter; }
 }
 
@@ -24,37 +134,128 @@ off_t IndexMetaData::getOffsetAfter() const {
 }
 
 // _____________________________________________________________________________
-void IndexMetaData::createFromByteBuffer(unsigned char* buf) {
-  size_t nofRelations = *reinterpret_cast<size_t*>(buf);
-  size_t nofBytesDone = sizeof(size_t);
+void IndexMetaData::readFromFile(const string& fileName) {
+  clear();
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not open permutation " + fileName);
+  }
+  struct stat st;
+  AD_CHECK_EQ(0, fstat(fd, &st));
+  off_t startOfMeta;
+  AD_CHECK_GE(st.st_size, static_cast<off_t>(sizeof(startOfMeta)));
+  off_t endOfMeta = st.st_size - sizeof(startOfMeta);
+  AD_CHECK_EQ(static_cast<ssize_t>(sizeof(startOfMeta)),
+              pread(fd, &startOfMeta, sizeof(startOfMeta), endOfMeta));
+  AD_CHECK_GE(endOfMeta - startOfMeta,
+              static_cast<off_t>(HEADER_WORDS * sizeof(size_t)));
+  size_t header[HEADER_WORDS];
+  AD_CHECK_EQ(static_cast<ssize_t>(sizeof(header)),
+              pread(fd, header, sizeof(header), startOfMeta));
+  size_t nofRelations = header[0];
+  size_t nofBlocks = header[1];
+  size_t nofFilterWords = header[2];
+  _offsetAfter = static_cast<off_t>(header[3]);
+  _fullIndexCompressed = (header[4] & FORMAT_COMPRESSED) != 0;
+  _lhsFilters = (header[4] & FORMAT_LHS_FILTERS) != 0;
+  if ((header[4] & FORMAT_BLOCK_LAST_LHS) == 0 ||
+      (header[4] & FORMAT_WIDE_HISTOGRAM) == 0) {
+    close(fd);
+    clear();
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Meta data of " + fileName + " is in an old format, "
+             "please rebuild the index.");
+  }
+  off_t startOfRelations = startOfMeta + sizeof(header);
+  size_t nofBytes = nofRelations * sizeof(RelationRecord) +
+                    nofBlocks * sizeof(BlockMetaData) +
+                    nofFilterWords * sizeof(uint64_t);
+  AD_CHECK_EQ(static_cast<size_t>(endOfMeta - startOfRelations), nofBytes);
+  // The records are used in place, the writer aligns them.
+  AD_CHECK_EQ(0, startOfMeta % static_cast<off_t>(sizeof(uint64_t)));
+  // Mappings have to start at a page boundary.
+  off_t pageSize = sysconf(_SC_PAGESIZE);
+  off_t mappingStart = startOfMeta - startOfMeta % pageSize;
+  size_t nofMappedBytes = static_cast<size_t>(endOfMeta - mappingStart);
+  void* mapping = mmap(nullptr, nofMappedBytes, PROT_READ, MAP_SHARED, fd,
+                       mappingStart);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not map the meta data of " + fileName);
+  }
+  _mapping = static_cast<char*>(mapping);
+  _mappingBytes = nofMappedBytes;
+  _nofRelations = nofRelations;
+  _nofBlocks = nofBlocks;
+  _nofFilterWords = nofFilterWords;
+  _relations = reinterpret_cast<const RelationRecord*>(
+      _mapping + (startOfRelations - mappingStart));
+  _blocks = reinterpret_cast<const BlockMetaData*>(
+      _relations + _nofRelations);
+  _filterWords = reinterpret_cast<const uint64_t*>(_blocks + _nofBlocks);
+}
 
-  for (size_t i = 0; i < nofRelations; ++i) {
-    RelationMetaData rmd;
-    rmd.createFromByteBuffer(buf + nofBytesDone);
-    nofBytesDone += rmd.bytesRequired();
-    add(rmd);
+// _____________________________________________________________________________
+const IndexMetaData::RelationRecord* IndexMetaData::findRelation(
+    Id relId) const {
+  const RelationRecord* end = _relations + _nofRelations;
+  const RelationRecord* it = std::lower_bound(
+      _relations, end, relId, [](const RelationRecord& a, Id relId) {
+        return a._relId < relId;
+      });
+  if (it == end || it->_relId != relId) {
+    return nullptr;
   }
+  return it;
 }
 
 // _____________________________________________________________________________
-const RelationMetaData& IndexMetaData::getRmd(Id relId) const {
-  auto it = _data.find(relId);
-  AD_CHECK(it != _data.end());
-  return it->second;
+RelationMetaData IndexMetaData::getRmd(Id relId) const {
+  const RelationRecord* record = findRelation(relId);
+  AD_CHECK(record);
+  RelationMetaData rmd(record->_relId, record->_startFullIndex,
+                       record->_startRhs, record->_offsetAfter,
+                       record->_nofElements, record->_nofBlocks,
+                       _blocks + record->_firstBlock);
+  rmd._stats = record->_stats;
+  rmd._lhsFilter = BloomFilter(_filterWords + record->_firstFilterWord,
+                               record->_nofFilterWords,
+                               record->_nofFilterHashes);
+  return rmd;
 }
 
 // _____________________________________________________________________________
 bool IndexMetaData::relationExists(Id relId) const {
-  return _data.count(relId) > 0;
+  return findRelation(relId) != nullptr;
 }
 
 // _____________________________________________________________________________
-ad_utility::File& operator<<(ad_utility::File& f, const IndexMetaData& imd) {
-  size_t nofElements = imd._data.size();
-  f.write(&nofElements, sizeof(nofElements));
-  for (auto it = imd._data.begin(); it != imd._data.end(); ++it) {
-    f << it->second;
+vector<Id> IndexMetaData::getRelationIds() const {
+  vector<Id> ids;
+  ids.reserve(_nofRelations);
+  for (size_t i = 0; i < _nofRelations; ++i) {
+    ids.push_back(_relations[i]._relId);
   }
+  return ids;
+}
+
+// _____________________________________________________________________________
+ad_utility::File& operator<<(ad_utility::File& f, const IndexMetaData& imd) {
+  size_t header[IndexMetaData::HEADER_WORDS];
+  header[0] = imd._nofRelations;
+  header[1] = imd._nofBlocks;
+  header[2] = imd._nofFilterWords;
+  header[3] = static_cast<size_t>(imd._offsetAfter);
+  header[4] = (imd._fullIndexCompressed ? FORMAT_COMPRESSED : 0) |
+              (imd._lhsFilters ? FORMAT_LHS_FILTERS : 0) |
+              FORMAT_BLOCK_LAST_LHS | FORMAT_WIDE_HISTOGRAM;
+  f.write(header, sizeof(header));
+  f.write(imd._relations,
+          imd._nofRelations * sizeof(IndexMetaData::RelationRecord));
+  f.write(imd._blocks, imd._nofBlocks * sizeof(BlockMetaData));
+  f.write(imd._filterWords, imd._nofFilterWords * sizeof(uint64_t));
   return f;
 }
 
@@ -70,30 +271,68 @@ string IndexMetaData::statistics() const {
   os << "----------------------------------\n";
   os << "Index Statistics:\n";
   os << "----------------------------------\n\n";
-  os << "# Relations: " << _data.size() << '\n';
+  os << "# Relations: " << _nofRelations << '\n';
   size_t totalElements = 0;
   size_t totalBytes = 0;
-  size_t totalBlocks = 0;
+  size_t totalPairIndexBytes = 0;
   size_t totalLhsBytes = 0;
   size_t totalRhsBytes = 0;
-  for (unordered_map<Id, RelationMetaData>::const_iterator it = _data.begin();
-       it != _data.end(); ++it) {
-    totalElements += it->second._nofElements;
-    totalBytes += it->second._offsetAfter - it->second._startFullIndex;
-    totalBlocks += it->second._nofBlocks;
-    totalLhsBytes += it->second._startRhs -
-        (it->second._startFullIndex + 2 * sizeof(Id) * it->second._nofElements);
-    totalRhsBytes += it->second._offsetAfter - it->second._startRhs;
-  }
-  size_t totalPairIndexBytes = totalElements * 2 * sizeof(Id);
+  size_t totalDistinctLhs = 0;
+  size_t maxLhsMultiplicity = 0;
+  array<size_t, RelationStatistics::HISTOGRAM_SIZE> lhsHistogram;
+  lhsHistogram.fill(0);
+  for (size_t i = 0; i < _nofRelations; ++i) {
+    RelationMetaData rmd = getRmd(_relations[i]._relId);
+    totalElements += rmd._nofElements;
+    totalBytes += rmd._offsetAfter - rmd._startFullIndex;
+    totalPairIndexBytes += rmd.getNofBytesForFulltextIndex();
+    totalLhsBytes += rmd._startRhs - rmd.getStartOfLhs();
+    totalRhsBytes += rmd._offsetAfter - rmd._startRhs;
+    const RelationStatistics& stats = rmd._stats;
+    totalDistinctLhs += stats._nofDistinctLhs;
+    maxLhsMultiplicity = std::max(maxLhsMultiplicity,
+                                  stats._maxLhsMultiplicity);
+    for (size_t j = 0; j < lhsHistogram.size(); ++j) {
+      lhsHistogram[j] += stats._lhsHistogram[j];
+    }
+  }
+  size_t rawPairIndexBytes = totalElements * 2 * sizeof(Id);
   os << "# Elements:  " << totalElements << '\n';
-  os << "# Blocks:    " << totalBlocks << "\n\n";
+  os << "# Blocks:    " << _nofBlocks << '\n';
+  os << "# Distinct LHS:       " << totalDistinctLhs << '\n';
+  os << "Max LHS multiplicity: " << maxLhsMultiplicity << '\n';
+  os << "LHS multiplicities:  ";
+  for (size_t i = 0; i < lhsHistogram.size(); ++i) {
+    size_t from = size_t(1) << i;
+    os << ' ' << from;
+    if (i + 1 == lhsHistogram.size()) {
+      os << '+';
+    } else if (from > 1) {
+      os << '-' << 2 * from - 1;
+    }
+    os << ": " << lhsHistogram[i];
+  }
+  os << "\n\n";
   os << "Theoretical size of Id triples: "
       << totalElements * 3 * sizeof(Id) << " bytes \n";
   os << "Size of pair index:             "
       << totalPairIndexBytes << " bytes \n";
+  if (_fullIndexCompressed && totalPairIndexBytes > 0) {
+    os << "Pair index compression ratio:   "
+        << static_cast<double>(rawPairIndexBytes) / totalPairIndexBytes
+        << " (" << rawPairIndexBytes << " bytes uncompressed)\n";
+  }
   os << "Size of LHS lists:              " << totalLhsBytes << " bytes \n";
   os << "Size of RHS lists:              " << totalRhsBytes << " bytes \n";
+  if (_lhsFilters) {
+    os << "Size of LHS filters:            "
+       << _nofFilterWords * sizeof(uint64_t) << " bytes \n";
+  }
+  os << "Size of meta data:              "
+     << HEADER_WORDS * sizeof(size_t) +
+        _nofRelations * sizeof(RelationRecord) +
+        _nofBlocks * sizeof(BlockMetaData) +
+        _nofFilterWords * sizeof(uint64_t) << " bytes \n";
   os << "Total Size:                     " << totalBytes << " bytes \n";
   os << "-------------------------------------------------------------------\n";
   return os.str();
@@ -103,13 +342,13 @@ string IndexMetaData::statistics() const {
 // _____________________________________________________________________________
 RelationMetaData::RelationMetaData() :
     _relId(0), _startFullIndex(0), _startRhs(0), _offsetAfter(0),
-    _nofElements(0), _nofBlocks(0), _blocks() {
+    _nofElements(0), _nofBlocks(0), _blocks(nullptr) {
 }
 
 // _____________________________________________________________________________
 RelationMetaData::RelationMetaData(Id relId, off_t startFullIndex,
     off_t startRhs, off_t offsetAfter, size_t nofElements, size_t nofBlocks,
-    const vector<BlockMetaData>& blocks) :
+    const BlockMetaData* blocks) :
     _relId(relId),
     _startFullIndex(startFullIndex),
     _startRhs(startRhs),
@@ -119,9 +358,25 @@ RelationMetaData::RelationMetaData(Id relId, off_t startFullIndex,
     _blocks(blocks) {
 }
 
+// _____________________________________________________________________________
+RelationMetaData::RelationMetaData(Id relId, off_t startFullIndex,
+    off_t startRhs, off_t offsetAfter, size_t nofElements, size_t nofBlocks,
+    const vector<BlockMetaData>& blocks) :
+    RelationMetaData(relId, startFullIndex, startRhs, offsetAfter,
+                     nofElements, nofBlocks, blocks.data()) {
+  AD_CHECK_EQ(nofBlocks, blocks.size());
+}
+
 // _____________________________________________________________________________
 size_t RelationMetaData::getNofBytesForFulltextIndex() const {
-  return _nofElements * 2 * sizeof(Id);
+  // Functional relations end right after the FullIndex, for all others
+  // the first block points to the start of the LHS list behind it.
+  // This holds for raw and compressed pair lists alike.
+  if (isFunctional()) {
+    return static_cast<size_t>(_startRhs - _startFullIndex);
+  }
+  AD_CHECK_GT(_nofBlocks, 0);
+  return static_cast<size_t>(_blocks[0]._startOffset - _startFullIndex);
 }
 
 // _____________________________________________________________________________
@@ -133,19 +388,20 @@ bool RelationMetaData::isFunctional() const {
 pair<off_t, size_t> RelationMetaData::getBlockStartAndNofBytesForLhs(
     Id lhs) const {
 
-  auto it = std::lower_bound(_blocks.begin(), _blocks.end(), lhs,
+  const BlockMetaData* end = _blocks + _nofBlocks;
+  const BlockMetaData* it = std::lower_bound(_blocks, end, lhs,
       [](const BlockMetaData& a, Id lhs) {
         return a._firstLhs < lhs;
       });
 
   // Go back one block unless perfect lhs match.
-  if (it == _blocks.end() || it->_firstLhs > lhs) {
-    AD_CHECK(it != _blocks.begin());
+  if (it == end || it->_firstLhs > lhs) {
+    AD_CHECK(it != _blocks);
     it--;
   }
 
   off_t after;
-  if ((it + 1) != _blocks.end()) {
+  if ((it + 1) != end) {
     after = (it + 1)->_startOffset;
   }  else {
     if (isFunctional()) {
@@ -164,24 +420,25 @@ pair<off_t, size_t> RelationMetaData::getBlockStartAndNofBytesForLhs(
 pair<off_t, size_t> RelationMetaData::getFollowBlockForLhs(
     Id lhs) const {
 
-  auto it = std::lower_bound(_blocks.begin(), _blocks.end(), lhs,
+  const BlockMetaData* end = _blocks + _nofBlocks;
+  const BlockMetaData* it = std::lower_bound(_blocks, end, lhs,
       [](const BlockMetaData& a, Id lhs) {
         return a._firstLhs < lhs;
       });
 
   // Go back one block unless perfect lhs match.
-  if (it == _blocks.end() || it->_firstLhs > lhs) {
-    AD_CHECK(it != _blocks.begin());
+  if (it == end || it->_firstLhs > lhs) {
+    AD_CHECK(it != _blocks);
     it--;
   }
 
   // Advance one block again is possible
-  if ((it + 1) != _blocks.end()) {
+  if ((it + 1) != end) {
     ++it;
   }
 
   off_t after;
-  if ((it + 1) != _blocks.end()) {
+  if ((it + 1) != end) {
     after = (it + 1)->_startOffset;
   }  else {
     if (isFunctional()) {
@@ -197,37 +454,126 @@ pair<off_t, size_t> RelationMetaData::getFollowBlockForLhs(
 }
 
 // _____________________________________________________________________________
-RelationMetaData& RelationMetaData::createFromByteBuffer(
-    unsigned char* buffer) {
+pair<size_t, size_t> RelationMetaData::getBlocksForLhsRange(
+    Id firstLhs, Id lastLhs) const {
+  if (firstLhs > lastLhs) {
+    return pair<size_t, size_t>(0, 0);
+  }
+  const BlockMetaData* end = _blocks + _nofBlocks;
+  const BlockMetaData* from = std::lower_bound(_blocks, end, firstLhs,
+      [](const BlockMetaData& a, Id lhs) {
+        return a._lastLhs < lhs;
+      });
+  const BlockMetaData* to = std::upper_bound(from, end, lastLhs,
+      [](Id lhs, const BlockMetaData& a) {
+        return lhs < a._firstLhs;
+      });
+  return pair<size_t, size_t>(from - _blocks, to - _blocks);
+}
+
+// _____________________________________________________________________________
+off_t RelationMetaData::getBlockEnd(size_t block) const {
+  AD_CHECK_LT(block, _nofBlocks);
+  // The last block ends with the FullIndex of functional relations and
+  // with the LHS list otherwise, both where the RHS lists would start.
+  return block + 1 < _nofBlocks ? _blocks[block + 1]._startOffset : _startRhs;
+}
 
-  _relId = *reinterpret_cast<Id*>(buffer);
-  _startFullIndex = *reinterpret_cast<off_t*>(buffer + sizeof(Id));
-  _startRhs = *reinterpret_cast<off_t*>(buffer + sizeof(Id) + sizeof(off_t));
-  _offsetAfter = *reinterpret_cast<off_t*>(
-      buffer + sizeof(Id) + 2 * sizeof(off_t));
-  _nofElements = *reinterpret_cast<size_t*>(
-      buffer + sizeof(Id) + 3 * sizeof(off_t));
-  _nofBlocks = *reinterpret_cast<size_t*>(
-      buffer + sizeof(Id) + 3 * sizeof(off_t) + sizeof(size_t));
-  _blocks.resize(_nofBlocks);
-  memcpy(_blocks.data(),
-      buffer + sizeof(Id) + 3 * sizeof(off_t) + 2 * sizeof(size_t),
-      _nofBlocks * sizeof(BlockMetaData));
-  return *this;
+// _____________________________________________________________________________
+bool RelationMetaData::mayContainLhs(Id lhs) const {
+  if (_nofBlocks > 0 && lhs < _blocks[0]._firstLhs) {
+    return false;
+  }
+  return _lhsFilter.mayContain(lhs);
 }
 
 // _____________________________________________________________________________
-size_t RelationMetaData::bytesRequired() const {
-  return sizeof(_relId)
-      + sizeof(_startFullIndex)
-      + sizeof(_startRhs)
-      + sizeof(_offsetAfter)
-      + sizeof(_nofElements)
-      + sizeof(_nofBlocks)
-      + _nofBlocks * sizeof(BlockMetaData);
+double RelationMetaData::getAverageLhsMultiplicity() const {
+  if (_stats._nofDistinctLhs == 0) {
+    return 1;
+  }
+  return static_cast<double>(_nofElements) / _stats._nofDistinctLhs;
+}
+
+// _____________________________________________________________________________
+double RelationMetaData::getAverageRhsMultiplicity() const {
+  if (_stats._nofDistinctRhs == 0) {
+    return 1;
+  }
+  return static_cast<double>(_nofElements) / _stats._nofDistinctRhs;
+}
+
+// _____________________________________________________________________________
+double RelationMetaData::getPairWeightedLhsMultiplicity() const {
+  // Sum of m^2 over all LHS divided by the sum of m, with the middle of its
+  // bucket for each m. The open last bucket is represented by the maximum.
+  double squares = 0;
+  double pairs = 0;
+  const size_t n = RelationStatistics::HISTOGRAM_SIZE;
+  for (size_t i = 0; i < n; ++i) {
+    double m = i == 0 ? 1 : 1.5 * (size_t(1) << i);
+    if (i + 1 == n) {
+      m = std::max(m, static_cast<double>(_stats._maxLhsMultiplicity));
+    }
+    m = std::min(m, static_cast<double>(_stats._maxLhsMultiplicity));
+    squares += _stats._lhsHistogram[i] * m * m;
+    pairs += _stats._lhsHistogram[i] * m;
+  }
+  double average = getAverageLhsMultiplicity();
+  if (pairs == 0) {
+    return average;
+  }
+  return std::min(std::max(squares / pairs, average),
+                  std::max(average,
+                      static_cast<double>(_stats._maxLhsMultiplicity)));
+}
+
+// _____________________________________________________________________________
+RelationStatistics::RelationStatistics(const vector<array<Id, 2>>& pairs) :
+    _nofDistinctLhs(0), _nofDistinctRhs(0), _maxLhsMultiplicity(0),
+    _maxRhsMultiplicity(0), _lhsHistogram() {
+  auto addLhs = [this](size_t multiplicity) {
+    ++_nofDistinctLhs;
+    _maxLhsMultiplicity = std::max(_maxLhsMultiplicity, multiplicity);
+    size_t bucket = 0;
+    while (multiplicity >>= 1) {
+      ++bucket;
+    }
+    ++_lhsHistogram[std::min(bucket, HISTOGRAM_SIZE - 1)];
+  };
+  size_t multiplicity = 0;
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    if (i > 0 && pairs[i][0] != pairs[i - 1][0]) {
+      addLhs(multiplicity);
+      multiplicity = 0;
+    }
+    ++multiplicity;
+  }
+  if (multiplicity > 0) {
+    addLhs(multiplicity);
+  }
+  // The RHS are only sorted per LHS.
+  vector<Id> rhs(pairs.size());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    rhs[i] = pairs[i][1];
+  }
+  std::sort(rhs.begin(), rhs.end());
+  multiplicity = 0;
+  for (size_t i = 0; i < rhs.size(); ++i) {
+    if (i > 0 && rhs[i] != rhs[i - 1]) {
+      ++_nofDistinctRhs;
+      _maxRhsMultiplicity = std::max(_maxRhsMultiplicity, multiplicity);
+      multiplicity = 0;
+    }
+    ++multiplicity;
+  }
+  if (multiplicity > 0) {
+    ++_nofDistinctRhs;
+    _maxRhsMultiplicity = std::max(_maxRhsMultiplicity, multiplicity);
+  }
 }
 
 // _____________________________________________________________________________
 off_t RelationMetaData::getStartOfLhs() const {
-  return _startFullIndex + _nofElements * 2 * sizeof(Id);
+  return _startFullIndex + getNofBytesForFulltextIndex();
 }
@@ -4,18 +4,19 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <vector>
 #include <utility>
-#include <unordered_map>
 
 #include "../global/Id.h"
 #include "../util/File.h"
+#include "./BloomFilter.h"
 
 
 using std::array;
+using std::string;
 using std::vector;
 using std::pair;
-using std::unordered_map;
 
 // Copy & Paste from IndexLayout.txt:
 //
@@ -33,6 +34,9 @@ using std::unordered_map;
 // * # elements
 // * # blocks
 // * vector of BlockMetaData (pairs)
+// * statistics: # distinct LHS / RHS, max multiplicity of an LHS / RHS,
+//   histogram of LHS multiplicities
+// * Bloom filter over the LHS (empty if the index has none)
 //
 //
 //
@@ -46,24 +50,69 @@ using std::unordered_map;
 // b) Block Meta Data
 // --
 // - minLHS
+// - maxLHS
 // - offset: start of RHS Data
+//
+// --
+// c) On disk
+// --
+// The meta data of a permutation is a flat structure that is memory-mapped
+// and queried in place, in 64 bit words:
+//
+// nofRelations.nofBlocks.nofFilterWords.offsetAfter.format
+// RELATIONS (RelationRecord[], sorted by rel Id)
+// BLOCKS (BlockMetaData[] of all relations)
+// FILTERS (the words of all LHS filters)
 
 class BlockMetaData {
 public:
-  BlockMetaData() :_firstLhs(0), _startOffset(0) { }
-  BlockMetaData(Id lhs, off_t start) :_firstLhs(lhs), _startOffset(start) { }
+  BlockMetaData() :_firstLhs(0), _lastLhs(0), _startOffset(0) { }
+  BlockMetaData(Id firstLhs, Id lastLhs, off_t start) :
+      _firstLhs(firstLhs), _lastLhs(lastLhs), _startOffset(start) { }
   Id _firstLhs;
+  Id _lastLhs;
   off_t _startOffset;
 };
 
+// Statistics about a relation for size estimates, computed at build time.
+// The multiplicity of an LHS is the number of pairs it occurs in.
+// Bucket i of the histogram counts the LHS with a multiplicity
+// in [2^i, 2^(i+1)), the last bucket also all larger ones.
+// The buckets are 64 bit since a relation can have more than 2^32 LHS.
+class RelationStatistics {
+public:
+  static const size_t HISTOGRAM_SIZE = 8;
+
+  RelationStatistics() : _nofDistinctLhs(0), _nofDistinctRhs(0),
+                         _maxLhsMultiplicity(0), _maxRhsMultiplicity(0),
+                         _lhsHistogram() { }
+
+  // Computes the statistics for pairs sorted by LHS.
+  explicit RelationStatistics(const vector<array<Id, 2>>& pairs);
+
+  size_t _nofDistinctLhs;
+  size_t _nofDistinctRhs;
+  size_t _maxLhsMultiplicity;
+  size_t _maxRhsMultiplicity;
+  array<uint64_t, HISTOGRAM_SIZE> _lhsHistogram;
+};
+
+// Meta data of a single relation. Does not own its blocks and its LHS
+// filter, they belong to the IndexMetaData (or, while a relation is built,
+// to the code that builds it).
 class RelationMetaData {
 public:
   RelationMetaData();
 
+  RelationMetaData(Id relId, off_t startFullIndex, off_t startRhs,
+      off_t offsetAfter, size_t nofElements, size_t nofBlocks,
+      const BlockMetaData* blocks);
+
   RelationMetaData(Id relId, off_t startFullIndex, off_t startRhs,
       off_t offsetAfter, size_t nofElements, size_t nofBlocks,
       const vector<BlockMetaData>& blocks);
 
+  // Number of bytes the FullIndex occupies on disk.
   size_t getNofBytesForFulltextIndex() const;
 
   off_t getStartOfLhs() const;
@@ -88,12 +137,29 @@ public:
   // it means it is the last block and the offsetAfter can be used.
   pair<off_t, size_t> getFollowBlockForLhs(Id lhs) const;
 
-  // Restores meta data from raw memory.
-  // Needed when registering an index on startup.
-  RelationMetaData& createFromByteBuffer(unsigned char* buffer);
+  // The blocks [first, second) that may hold an LHS in [firstLhs, lastLhs].
+  // Blocks that end before or start after the range are skipped, an empty
+  // range of blocks means that no LHS of the relation is in the range.
+  pair<size_t, size_t> getBlocksForLhsRange(Id firstLhs, Id lastLhs) const;
+
+  // The offset at which a block ends.
+  off_t getBlockEnd(size_t block) const;
+
+  // False if the relation definitely has no pair with this LHS.
+  // Answered from memory, by the LHS range and the LHS filter.
+  bool mayContainLhs(Id lhs) const;
 
-  // The size this object will require when serialized to file.
-  size_t bytesRequired() const;
+  // Average number of pairs per distinct LHS / RHS.
+  double getAverageLhsMultiplicity() const;
+
+  double getAverageRhsMultiplicity() const;
+
+  // Expected number of pairs of the LHS of a random pair, estimated from
+  // the LHS histogram. The size of a scan for an LHS that is taken from the
+  // data rather than picked uniformly. Equals the average if all LHS have
+  // the same multiplicity, approaches the maximum if few LHS have most of
+  // the pairs and never exceeds it.
+  double getPairWeightedLhsMultiplicity() const;
 
   Id _relId;
   off_t _startFullIndex;
@@ -101,38 +167,110 @@ public:
   off_t _offsetAfter;
   size_t _nofElements;
   size_t _nofBlocks;
-  vector<BlockMetaData> _blocks;
+  const BlockMetaData* _blocks;
+  RelationStatistics _stats;
+  BloomFilter _lhsFilter;
 };
 
-inline ad_utility::File& operator<<(ad_utility::File& f,
-    const RelationMetaData& rmd) {
-  f.write(&rmd._relId, sizeof(rmd._relId));
-  f.write(&rmd._startFullIndex, sizeof(rmd._startFullIndex));
-  f.write(&rmd._startRhs, sizeof(rmd._startRhs));
-  f.write(&rmd._offsetAfter, sizeof(rmd._offsetAfter));
-  f.write(&rmd._nofElements, sizeof(rmd._nofElements));
-  f.write(&rmd._nofBlocks, sizeof(rmd._nofBlocks));
-  f.write(rmd._blocks.data(), rmd._nofBlocks * sizeof(BlockMetaData));
-  return f;
-}
-
 class IndexMetaData {
 public:
   IndexMetaData();
 
+  ~IndexMetaData();
+
+  IndexMetaData(const IndexMetaData&) = delete;
+
+  IndexMetaData& operator=(const IndexMetaData&) = delete;
+
+  IndexMetaData(IndexMetaData&& other);
+
+  IndexMetaData& operator=(IndexMetaData&& other);
+
+  // Adds a relation, copies its blocks and its LHS filter.
+  // Relations have to be added in the order of their ids.
   void add(const RelationMetaData& rmd);
   off_t getOffsetAfter() const;
-  const RelationMetaData& getRmd(Id relId) const;
 
-  void createFromByteBuffer(unsigned char* buf);
+  // The returned meta data points into this object.
+  RelationMetaData getRmd(Id relId) const;
+
+  // Maps the meta data at the end of a permutation file, which ends
+  // with the offset at which the meta data starts.
+  void readFromFile(const string& fileName);
 
   bool relationExists(Id relId) const;
 
+  size_t getNofRelations() const {
+    return _nofRelations;
+  }
+
+  vector<Id> getRelationIds() const;
+
+  // True if the FullIndex of each relation is stored as a sequence of
+  // blocks as written by CompressedPairBlocks instead of raw pairs.
+  bool isFullIndexCompressed() const {
+    return _fullIndexCompressed;
+  }
+
+  void setFullIndexCompressed(bool compressed) {
+    _fullIndexCompressed = compressed;
+  }
+
+  // True if relations have a Bloom filter over their LHS.
+  bool hasLhsFilters() const {
+    return _lhsFilters;
+  }
+
+  void setLhsFilters(bool lhsFilters) {
+    _lhsFilters = lhsFilters;
+  }
+
   string statistics() const;
 
 private:
-  unordered_map<Id, RelationMetaData> _data;
+  // A relation as stored on disk.
+  struct RelationRecord {
+    Id _relId;
+    off_t _startFullIndex;
+    off_t _startRhs;
+    off_t _offsetAfter;
+    size_t _nofElements;
+    size_t _nofBlocks;
+    size_t _firstBlock;
+    size_t _firstFilterWord;
+    size_t _nofFilterWords;
+    size_t _nofFilterHashes;
+    RelationStatistics _stats;
+  };
+
+  static const size_t HEADER_WORDS = 5;
+
   off_t _offsetAfter;
+  bool _fullIndexCompressed;
+  bool _lhsFilters;
+
+  // Point into the vectors below while an index is built,
+  // into the mapped file otherwise.
+  const RelationRecord* _relations;
+  const BlockMetaData* _blocks;
+  const uint64_t* _filterWords;
+  size_t _nofRelations;
+  size_t _nofBlocks;
+  size_t _nofFilterWords;
+
+  vector<RelationRecord> _relationData;
+  vector<BlockMetaData> _blockData;
+  vector<uint64_t> _filterData;
+
+  char* _mapping;
+  size_t _mappingBytes;
+
+  void clear();
+
+  // Sets the pointers to the vectors after they have changed.
+  void pointToData();
+
+  const RelationRecord* findRelation(Id relId) const;
 
   friend ad_utility::File& operator<<(ad_utility::File& f,
       const IndexMetaData& rmd);
@@ -0,0 +1,241 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "../util/Exception.h"
+#include "../util/File.h"
+#include "../util/Log.h"
+#include "./PerfectHash.h"
+
+using std::pair;
+
+const uint64_t PerfectHash::FINGERPRINT_BITS;
+const uint64_t PerfectHash::ID_MASK;
+const uint64_t PerfectHash::KEYS_PER_BUCKET;
+const uint64_t PerfectHash::HEADER_WORDS;
+
+// _____________________________________________________________________________
+PerfectHash::PerfectHash() : _mapping(nullptr), _mappingBytes(0),
+                             _nofKeys(0), _nofSlots(0), _nofBuckets(0),
+                             _pilots(nullptr), _remap(nullptr),
+                             _table(nullptr) {
+}
+
+// _____________________________________________________________________________
+PerfectHash::~PerfectHash() {
+  clear();
+}
+
+// _____________________________________________________________________________
+void PerfectHash::clear() {
+  if (_mapping) {
+    munmap(_mapping, _mappingBytes);
+    _mapping = nullptr;
+    _mappingBytes = 0;
+  }
+}
+
+// _____________________________________________________________________________
+uint64_t PerfectHash::mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// _____________________________________________________________________________
+uint64_t PerfectHash::hash(const string& word) {
+  // MurmurHash64A. Fixed seed, hashes are written to disk.
+  const uint64_t m = 0xC6A4A7935BD1E995ULL;
+  const int r = 47;
+  uint64_t h = 0x5BD1E9955BD1E995ULL ^ (word.size() * m);
+  const unsigned char* data =
+      reinterpret_cast<const unsigned char*>(word.data());
+  size_t nofWords = word.size() / 8;
+  for (size_t i = 0; i < nofWords; ++i) {
+    uint64_t k;
+    memcpy(&k, data + i * 8, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  const unsigned char* tail = data + nofWords * 8;
+  size_t nofTailBytes = word.size() & 7;
+  if (nofTailBytes > 0) {
+    for (size_t i = 0; i < nofTailBytes; ++i) {
+      h ^= uint64_t(tail[i]) << (8 * i);
+    }
+    h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+// _____________________________________________________________________________
+bool PerfectHash::build(vector<pair<uint64_t, Id>>* keys,
+                        const string& fileName) {
+  uint64_t nofKeys = keys->size();
+  uint64_t nofSlots = nofKeys + nofKeys / 50 + 1;
+  uint64_t nofBuckets = nofKeys / KEYS_PER_BUCKET + 1;
+  LOG(INFO) << "Building perfect hash function for " << nofKeys
+            << " keys...\n";
+  std::sort(keys->begin(), keys->end(),
+            [nofBuckets](const pair<uint64_t, Id>& a,
+                         const pair<uint64_t, Id>& b) {
+              uint64_t ba = bucket(a.first, nofBuckets);
+              uint64_t bb = bucket(b.first, nofBuckets);
+              return ba < bb || (ba == bb && a.first < b.first);
+            });
+  // Buckets as (size, first key), largest first.
+  vector<pair<uint64_t, uint64_t>> buckets;
+  for (size_t i = 0; i < keys->size(); ++i) {
+    if ((*keys)[i].second > ID_MASK) {
+      LOG(WARN) << "Id too large for the perfect hash function.\n";
+      return false;
+    }
+    if (i > 0 && (*keys)[i].first == (*keys)[i - 1].first) {
+      LOG(WARN) << "Hash collision, no perfect hash function.\n";
+      return false;
+    }
+    if (i == 0 || bucket((*keys)[i].first, nofBuckets) !=
+                  bucket((*keys)[i - 1].first, nofBuckets)) {
+      buckets.push_back(pair<uint64_t, uint64_t>(0, i));
+    }
+    ++buckets.back().first;
+  }
+  std::stable_sort(buckets.begin(), buckets.end(),
+                   [](const pair<uint64_t, uint64_t>& a,
+                      const pair<uint64_t, uint64_t>& b) {
+                     return a.first > b.first;
+                   });
+
+  vector<uint32_t> pilots(nofBuckets + (nofBuckets & 1), 0);
+  vector<bool> taken(nofSlots, false);
+  vector<uint64_t> positions;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    const pair<uint64_t, Id>* bucketKeys = keys->data() + buckets[i].second;
+    uint64_t size = buckets[i].first;
+    uint32_t pilot = 0;
+    while (true) {
+      positions.clear();
+      bool fits = true;
+      for (size_t j = 0; j < size && fits; ++j) {
+        uint64_t p = position(bucketKeys[j].first, pilot, nofSlots);
+        fits = !taken[p] &&
+               std::find(positions.begin(), positions.end(), p) ==
+               positions.end();
+        positions.push_back(p);
+      }
+      if (fits) {
+        break;
+      }
+      if (pilot == std::numeric_limits<uint32_t>::max()) {
+        LOG(WARN) << "No pilot found, no perfect hash function.\n";
+        return false;
+      }
+      ++pilot;
+    }
+    for (size_t j = 0; j < positions.size(); ++j) {
+      taken[positions[j]] = true;
+    }
+    pilots[bucket(bucketKeys[0].first, nofBuckets)] = pilot;
+  }
+
+  // Move keys from positions >= nofKeys to the free slots below.
+  vector<uint64_t> remap(nofSlots - nofKeys, 0);
+  uint64_t nextFree = 0;
+  for (uint64_t p = nofKeys; p < nofSlots; ++p) {
+    if (taken[p]) {
+      while (taken[nextFree]) {
+        ++nextFree;
+      }
+      remap[p - nofKeys] = nextFree++;
+    }
+  }
+  vector<uint64_t> table(nofKeys, 0);
+  for (size_t i = 0; i < keys->size(); ++i) {
+    uint64_t h = (*keys)[i].first;
+    uint64_t p = position(h, pilots[bucket(h, nofBuckets)], nofSlots);
+    if (p >= nofKeys) {
+      p = remap[p - nofKeys];
+    }
+    table[p] = (fingerprint(h) << (64 - FINGERPRINT_BITS)) |
+               (*keys)[i].second;
+  }
+
+  ad_utility::File out(fileName.c_str(), "w");
+  out.write(&nofKeys, sizeof(nofKeys));
+  out.write(&nofSlots, sizeof(nofSlots));
+  out.write(&nofBuckets, sizeof(nofBuckets));
+  out.write(pilots.data(), pilots.size() * sizeof(uint32_t));
+  out.write(remap.data(), remap.size() * sizeof(uint64_t));
+  out.write(table.data(), table.size() * sizeof(uint64_t));
+  out.close();
+  LOG(INFO) << "Done, perfect hash function needs "
+            << (pilots.size() * sizeof(uint32_t) +
+                (remap.size() + table.size()) * sizeof(uint64_t))
+            << " bytes.\n";
+  return true;
+}
+
+// _____________________________________________________________________________
+bool PerfectHash::readFromFile(const string& fileName) {
+  clear();
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  AD_CHECK_EQ(0, fstat(fd, &st));
+  size_t nofBytes = static_cast<size_t>(st.st_size);
+  AD_CHECK_GE(nofBytes, HEADER_WORDS * sizeof(uint64_t));
+  void* mapping = mmap(nullptr, nofBytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not map perfect hash function " + fileName);
+  }
+  _mapping = static_cast<char*>(mapping);
+  _mappingBytes = nofBytes;
+  const uint64_t* header = reinterpret_cast<const uint64_t*>(_mapping);
+  _nofKeys = header[0];
+  _nofSlots = header[1];
+  _nofBuckets = header[2];
+  _pilots = reinterpret_cast<const uint32_t*>(header + HEADER_WORDS);
+  _remap = header + HEADER_WORDS + (_nofBuckets + 1) / 2;
+  _table = _remap + (_nofSlots - _nofKeys);
+  AD_CHECK_EQ(nofBytes, static_cast<size_t>(
+      reinterpret_cast<const char*>(_table + _nofKeys) - _mapping));
+  return true;
+}
+
+// _____________________________________________________________________________
+bool PerfectHash::lookup(const string& word, Id* id) const {
+  if (_nofKeys == 0) {
+    return false;
+  }
+  uint64_t h = hash(word);
+  uint64_t p = position(h, _pilots[bucket(h, _nofBuckets)], _nofSlots);
+  if (p >= _nofKeys) {
+    p = _remap[p - _nofKeys];
+  }
+  uint64_t entry = _table[p];
+  if ((entry >> (64 - FINGERPRINT_BITS)) != fingerprint(h)) {
+    return false;
+  }
+  *id = entry & ID_MASK;
+  return true;
+}
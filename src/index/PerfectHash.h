@@ -0,0 +1,87 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../global/Id.h"
+
+using std::string;
+using std::vector;
+
+//! Minimal perfect hash function from the words of a vocabulary to their
+//! ids, built with hash and displace: keys are distributed to buckets,
+//! the largest buckets first get a pilot that moves all their keys to
+//! free slots. Positions beyond the number of keys are remapped to the
+//! slots that stayed free. Each slot stores the id and a fingerprint
+//! of its key, so most words that are not in the vocabulary are rejected
+//! without touching the vocabulary. File layout, in 64 bit words:
+//!
+//! nofKeys.nofSlots.nofBuckets.PILOTS(uint32_t[]).REMAP.TABLE
+//!
+//! REMAP has nofSlots - nofKeys entries, TABLE one per key:
+//! the fingerprint in the upper FINGERPRINT_BITS, the id below.
+class PerfectHash {
+public:
+  PerfectHash();
+
+  ~PerfectHash();
+
+  PerfectHash(const PerfectHash&) = delete;
+
+  PerfectHash& operator=(const PerfectHash&) = delete;
+
+  static uint64_t hash(const string& word);
+
+  //! Builds the function for keys given as (hash, id) pairs and writes
+  //! it to a file. The pairs are reordered. Returns false and writes
+  //! nothing if two keys have the same hash or if an id is too large.
+  static bool build(vector<std::pair<uint64_t, Id>>* keys,
+                    const string& fileName);
+
+  //! Maps a file written by build. Returns false if there is none.
+  bool readFromFile(const string& fileName);
+
+  void clear();
+
+  bool empty() const {
+    return _mapping == nullptr;
+  }
+
+  //! Returns true if the word may have been one of the keys and sets
+  //! its id. False positives are possible, callers have to verify.
+  bool lookup(const string& word, Id* id) const;
+
+private:
+  static const uint64_t FINGERPRINT_BITS = 24;
+  static const uint64_t ID_MASK = (uint64_t(1) << (64 - FINGERPRINT_BITS)) - 1;
+  // Average number of keys per bucket.
+  static const uint64_t KEYS_PER_BUCKET = 4;
+  static const uint64_t HEADER_WORDS = 3;
+
+  char* _mapping;
+  size_t _mappingBytes;
+  uint64_t _nofKeys;
+  uint64_t _nofSlots;
+  uint64_t _nofBuckets;
+  const uint32_t* _pilots;
+  const uint64_t* _remap;
+  const uint64_t* _table;
+
+  static uint64_t mix(uint64_t x);
+
+  static uint64_t fingerprint(uint64_t h) {
+    return mix(h ^ 0x9E3779B97F4A7C15ULL) >> (64 - FINGERPRINT_BITS);
+  }
+
+  static uint64_t bucket(uint64_t h, uint64_t nofBuckets) {
+    return (h >> 32) % nofBuckets;
+  }
+
+  static uint64_t position(uint64_t h, uint32_t pilot, uint64_t nofSlots) {
+    return (h ^ mix(pilot + 1)) % nofSlots;
+  }
+};
@@ -0,0 +1,355 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <string.h>
+#include <limits>
+#include "../util/Exception.h"
+#include "./PostingListCodec.h"
+
+const size_t PostingListCodec::NOF_CODECS;
+const unsigned PostingListCodec::ALL_CODECS;
+constexpr double PostingListCodec::FASTEST_MAX_SIZE_FACTOR;
+const size_t PostingListCodec::CHUNK_SIZE;
+const size_t PostingListCodec::DECODE_OVERHEAD;
+
+namespace {
+// Simple8b cannot represent larger values.
+const uint64_t SIMPLE8B_MAX_ENCODABLE = 0x0FFFFFFFFFFFFFFF;
+
+// Codecs in the order of their decoding speed, fastest first, as measured
+// on context gaps. Simple8b profits from its AVX2 decoder.
+const PostingListCodec::Codec CODECS_BY_SPEED[] = {
+    PostingListCodec::SIMPLE8B, PostingListCodec::BIT_PACKING,
+    PostingListCodec::PFOR, PostingListCodec::STREAM_VBYTE
+};
+
+size_t bitsNeeded(uint64_t value) {
+  return value == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(value));
+}
+
+uint64_t lowBits(uint64_t value, size_t width) {
+  return width >= 64 ? value : value & ((uint64_t(1) << width) - 1);
+}
+
+uint64_t chunkHeader(size_t count, size_t width, size_t nofExceptions,
+                     size_t exceptionWidth, size_t nofDataBytes) {
+  return uint64_t(count) | uint64_t(width) << 8 |
+         uint64_t(nofExceptions) << 16 | uint64_t(exceptionWidth) << 24 |
+         uint64_t(nofDataBytes) << 32;
+}
+
+// Appends values of up to 64 bits to a list of words, without gaps.
+class BitWriter {
+public:
+  explicit BitWriter(vector<uint64_t>* out) : _out(out), _bit(0) { }
+
+  void write(uint64_t value, size_t width) {
+    if (width == 0) {
+      return;
+    }
+    if (_bit == 0) {
+      _out->push_back(0);
+    }
+    _out->back() |= value << _bit;
+    if (_bit + width > 64) {
+      _out->push_back(value >> (64 - _bit));
+    }
+    _bit = (_bit + width) % 64;
+  }
+
+private:
+  vector<uint64_t>* _out;
+  size_t _bit;
+};
+
+// Reads count values of the given width that a BitWriter wrote and
+// returns the number of words they occupy. Faster than a BitReader because
+// the loop keeps its state in registers.
+size_t unpack(const uint64_t* in, size_t count, size_t width,
+              uint64_t* values) {
+  if (width == 0) {
+    std::fill(values, values + count, 0);
+    return 0;
+  }
+  uint64_t mask = width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+  size_t bit = 0;
+  for (size_t i = 0; i < count; ++i, bit += width) {
+    size_t word = bit / 64;
+    size_t offset = bit % 64;
+    uint64_t value = in[word] >> offset;
+    if (offset + width > 64) {
+      value |= in[word + 1] << (64 - offset);
+    }
+    values[i] = value & mask;
+  }
+  return (bit + 63) / 64;
+}
+
+// Reads what a BitWriter wrote.
+class BitReader {
+public:
+  explicit BitReader(const uint64_t* in) : _in(in), _word(0), _bit(0) { }
+
+  uint64_t read(size_t width) {
+    if (width == 0) {
+      return 0;
+    }
+    uint64_t value = _in[_word] >> _bit;
+    if (_bit + width > 64) {
+      value |= _in[_word + 1] << (64 - _bit);
+    }
+    _bit += width;
+    if (_bit >= 64) {
+      _bit -= 64;
+      ++_word;
+    }
+    return lowBits(value, width);
+  }
+
+  size_t nofWords() const {
+    return _word + (_bit > 0 ? 1 : 0);
+  }
+
+private:
+  const uint64_t* _in;
+  size_t _word;
+  size_t _bit;
+};
+}
+
+// _____________________________________________________________________________
+string PostingListCodec::name(Codec codec) {
+  switch (codec) {
+    case SIMPLE8B:
+      return "Simple8b";
+    case BIT_PACKING:
+      return "BitPacking";
+    case PFOR:
+      return "PFor";
+    case STREAM_VBYTE:
+      return "StreamVByte";
+  }
+  return "unknown";
+}
+
+// _____________________________________________________________________________
+void PostingListCodec::encode(Codec codec, const uint64_t* values,
+                              size_t nofElements, vector<uint64_t>* encoded,
+                              vector<size_t>* entryElements,
+                              vector<size_t>* entryWords) {
+  size_t wordsBefore = encoded->size();
+  entryElements->clear();
+  entryWords->clear();
+  if (codec == SIMPLE8B) {
+    // Each code word holds at least one element.
+    encoded->resize(wordsBefore + nofElements);
+    size_t nofWords = ad_utility::Simple8bCode::encode(
+        values, nofElements, encoded->data() + wordsBefore) / sizeof(uint64_t);
+    encoded->resize(wordsBefore + nofWords);
+    size_t nofElementsBefore = 0;
+    for (size_t i = 0; i < nofWords; ++i) {
+      entryElements->push_back(nofElementsBefore);
+      entryWords->push_back(i);
+      nofElementsBefore += ad_utility::SIMPLE8B_SELECTORS[
+          (*encoded)[wordsBefore + i] &
+          ad_utility::SIMPLE8B_SELECTOR_MASK]._groupSize;
+    }
+    return;
+  }
+  for (size_t i = 0; i < nofElements; i += CHUNK_SIZE) {
+    entryElements->push_back(i);
+    entryWords->push_back(encoded->size() - wordsBefore);
+    encodeChunk(codec, values + i, std::min(CHUNK_SIZE, nofElements - i),
+                encoded);
+  }
+}
+
+// _____________________________________________________________________________
+PostingListCodec::Codec PostingListCodec::encodeWithBestCodec(
+    Selection selection, unsigned allowedCodecs, const uint64_t* values,
+    size_t nofElements, vector<uint64_t>* encoded,
+    vector<size_t>* entryElements, vector<size_t>* entryWords) {
+  uint64_t maxValue = 0;
+  for (size_t i = 0; i < nofElements; ++i) {
+    maxValue = std::max(maxValue, values[i]);
+  }
+  if (maxValue > SIMPLE8B_MAX_ENCODABLE) {
+    allowedCodecs &= ~only(SIMPLE8B);
+  }
+  if ((allowedCodecs & ALL_CODECS) == 0) {
+    allowedCodecs = only(BIT_PACKING);
+  }
+  vector<vector<uint64_t>> candidates(NOF_CODECS);
+  size_t smallest = std::numeric_limits<size_t>::max();
+  for (size_t c = 0; c < NOF_CODECS; ++c) {
+    if (allowedCodecs & only(Codec(c))) {
+      vector<size_t> elements;
+      vector<size_t> words;
+      encode(Codec(c), values, nofElements, &candidates[c], &elements,
+             &words);
+      smallest = std::min(smallest, candidates[c].size());
+    }
+  }
+  Codec best = BIT_PACKING;
+  for (Codec c : CODECS_BY_SPEED) {
+    if (!(allowedCodecs & only(c))) {
+      continue;
+    }
+    size_t size = candidates[c].size();
+    if (selection == FASTEST ?
+        size <= FASTEST_MAX_SIZE_FACTOR * smallest : size == smallest) {
+      best = c;
+      break;
+    }
+  }
+  encode(best, values, nofElements, encoded, entryElements, entryWords);
+  return best;
+}
+
+// _____________________________________________________________________________
+bool PostingListCodec::fromName(const string& name, Codec* codec) {
+  for (size_t c = 0; c < NOF_CODECS; ++c) {
+    if (PostingListCodec::name(Codec(c)) == name) {
+      *codec = Codec(c);
+      return true;
+    }
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+void PostingListCodec::encodeChunk(Codec codec, const uint64_t* values,
+                                   size_t nofValues,
+                                   vector<uint64_t>* encoded) {
+  AD_CHECK_GT(nofValues, 0);
+  AD_CHECK_LE(nofValues, CHUNK_SIZE);
+  size_t maxWidth = 0;
+  for (size_t i = 0; i < nofValues; ++i) {
+    maxWidth = std::max(maxWidth, bitsNeeded(values[i]));
+  }
+  if (codec == BIT_PACKING) {
+    encoded->push_back(chunkHeader(nofValues, maxWidth, 0, 0, 0));
+    BitWriter writer(encoded);
+    for (size_t i = 0; i < nofValues; ++i) {
+      writer.write(values[i], maxWidth);
+    }
+  } else if (codec == PFOR) {
+    // Try all widths, the ones above maxWidth cannot be better.
+    // Prefer the widest among equally small ones, it has fewer exceptions.
+    size_t nofLarger[65] = {0};
+    for (size_t i = 0; i < nofValues; ++i) {
+      ++nofLarger[bitsNeeded(values[i])];
+    }
+    size_t width = maxWidth;
+    size_t bestBits = nofValues * maxWidth;
+    size_t nofExceptions = 0;
+    for (size_t w = maxWidth; w-- > 0;) {
+      nofExceptions += nofLarger[w + 1];
+      size_t bits = nofValues * w + nofExceptions * (8 + maxWidth - w);
+      if (bits < bestBits) {
+        bestBits = bits;
+        width = w;
+      }
+    }
+    nofExceptions = 0;
+    for (size_t i = 0; i < nofValues; ++i) {
+      nofExceptions += bitsNeeded(values[i]) > width ? 1 : 0;
+    }
+    size_t exceptionWidth = maxWidth - width;
+    encoded->push_back(chunkHeader(nofValues, width, nofExceptions,
+                                   exceptionWidth, 0));
+    BitWriter writer(encoded);
+    for (size_t i = 0; i < nofValues; ++i) {
+      writer.write(lowBits(values[i], width), width);
+    }
+    // The exceptions start at a new word.
+    BitWriter exceptionWriter(encoded);
+    for (size_t i = 0; i < nofValues; ++i) {
+      if (bitsNeeded(values[i]) > width) {
+        exceptionWriter.write(i, 8);
+      }
+    }
+    for (size_t i = 0; i < nofValues; ++i) {
+      if (bitsNeeded(values[i]) > width) {
+        exceptionWriter.write(values[i] >> width, exceptionWidth);
+      }
+    }
+  } else {
+    AD_CHECK_EQ(STREAM_VBYTE, codec);
+    size_t nofControlBytes = (nofValues + 3) / 4;
+    vector<unsigned char> bytes(nofControlBytes, 0);
+    for (size_t i = 0; i < nofValues; ++i) {
+      size_t width = bitsNeeded(values[i]);
+      size_t code = width <= 8 ? 0 : width <= 16 ? 1 : width <= 32 ? 2 : 3;
+      bytes[i / 4] |= static_cast<unsigned char>(code << (2 * (i % 4)));
+      size_t nofBytes = size_t(1) << code;
+      for (size_t b = 0; b < nofBytes; ++b) {
+        bytes.push_back(static_cast<unsigned char>(values[i] >> (8 * b)));
+      }
+    }
+    encoded->push_back(chunkHeader(nofValues, 0, 0, 0,
+                                   bytes.size() - nofControlBytes));
+    size_t wordsBefore = encoded->size();
+    encoded->resize(wordsBefore + (bytes.size() + 7) / 8, 0);
+    memcpy(encoded->data() + wordsBefore, bytes.data(), bytes.size());
+  }
+}
+
+// _____________________________________________________________________________
+size_t PostingListCodec::decodeChunk(Codec codec, const uint64_t* chunk,
+                                     uint64_t* values, size_t* nofValues) {
+  uint64_t header = chunk[0];
+  size_t count = header & 0xFF;
+  size_t width = (header >> 8) & 0xFF;
+  *nofValues = count;
+  if (codec == STREAM_VBYTE) {
+    size_t nofControlBytes = (count + 3) / 4;
+    size_t nofDataBytes = header >> 32;
+    const unsigned char* control =
+        reinterpret_cast<const unsigned char*>(chunk + 1);
+    const unsigned char* data = control + nofControlBytes;
+    // Fixed size copies compile to single loads.
+    for (size_t i = 0; i < count; ++i) {
+      switch ((control[i / 4] >> (2 * (i % 4))) & 3) {
+        case 0:
+          values[i] = *data;
+          data += 1;
+          break;
+        case 1: {
+          uint16_t value;
+          memcpy(&value, data, sizeof(value));
+          values[i] = value;
+          data += sizeof(value);
+          break;
+        }
+        case 2: {
+          uint32_t value;
+          memcpy(&value, data, sizeof(value));
+          values[i] = value;
+          data += sizeof(value);
+          break;
+        }
+        default:
+          memcpy(&values[i], data, sizeof(uint64_t));
+          data += sizeof(uint64_t);
+      }
+    }
+    return 1 + (nofControlBytes + nofDataBytes + 7) / 8;
+  }
+  size_t nofWords = unpack(chunk + 1, count, width, values);
+  if (codec == PFOR) {
+    BitReader reader(chunk + 1 + nofWords);
+    size_t nofExceptions = (header >> 16) & 0xFF;
+    size_t exceptionWidth = (header >> 24) & 0xFF;
+    size_t positions[CHUNK_SIZE];
+    for (size_t i = 0; i < nofExceptions; ++i) {
+      positions[i] = reader.read(8);
+    }
+    for (size_t i = 0; i < nofExceptions; ++i) {
+      values[positions[i]] |= reader.read(exceptionWidth) << width;
+    }
+    nofWords += reader.nofWords();
+  }
+  return 1 + nofWords;
+}
@@ -0,0 +1,161 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../util/Simple8bCode.h"
+
+using std::string;
+using std::vector;
+
+//! Codecs for the context, word and score lists of the text index.
+//! Every codec writes whole 64 bit words and a list can be decoded starting
+//! at any of its entry points:
+//!
+//! SIMPLE8B      one Simple8b code word per entry point (see Simple8bCode.h).
+//! BIT_PACKING   chunks of up to CHUNK_SIZE values, all with the width of
+//!               the largest one.
+//! PFOR          chunks like BIT_PACKING, but with the width that minimizes
+//!               the chunk size. The high bits of larger values are stored
+//!               as exceptions behind the low bits, with their positions.
+//! STREAM_VBYTE  chunks of 2 bit length codes (1, 2, 4 or 8 bytes) for all
+//!               values, followed by the bytes of the values.
+//!
+//! Chunks start with a header word:
+//! count(8 bits).width(8).#exceptions(8).exceptionWidth(8).#dataBytes(32)
+//! with the fields a codec does not need left 0.
+class PostingListCodec {
+public:
+  enum Codec : uint8_t {
+    SIMPLE8B = 0, BIT_PACKING = 1, PFOR = 2, STREAM_VBYTE = 3
+  };
+  static const size_t NOF_CODECS = 4;
+
+  //! How the writer picks the codec of a list.
+  //! SMALLEST takes the codec with the fewest bytes, FASTEST the one that
+  //! decodes fastest among those at most FASTEST_MAX_SIZE_FACTOR times as
+  //! large as the smallest.
+  enum Selection {
+    SMALLEST = 0, FASTEST = 1
+  };
+  static constexpr double FASTEST_MAX_SIZE_FACTOR = 1.25;
+
+  //! Sets of codecs the writer may choose from, one bit per codec.
+  static const unsigned ALL_CODECS = (1u << NOF_CODECS) - 1;
+  static unsigned only(Codec codec) {
+    return 1u << codec;
+  }
+
+  //! Maximum number of values in a chunk.
+  static const size_t CHUNK_SIZE = 128;
+
+  //! Decoding may write this many values behind the requested ones.
+  //! Buffers have to be allocated with this overhead.
+  static const size_t DECODE_OVERHEAD = 239;
+
+  //! Encodes nofElements values with the given codec and appends the
+  //! code words to encoded. entryElements and entryWords get the index of
+  //! the first value and of the first word (relative to the start of
+  //! this list) for each point the list can be decoded from.
+  static void encode(Codec codec, const uint64_t* values, size_t nofElements,
+                     vector<uint64_t>* encoded,
+                     vector<size_t>* entryElements,
+                     vector<size_t>* entryWords);
+
+  //! Encodes the values with the codec chosen by selection among the
+  //! allowed ones and returns that codec. Outputs as for encode.
+  //! Simple8b is skipped for values above 60 bits, if it was the only
+  //! allowed codec BIT_PACKING is taken instead.
+  static Codec encodeWithBestCodec(Selection selection,
+                                   unsigned allowedCodecs,
+                                   const uint64_t* values, size_t nofElements,
+                                   vector<uint64_t>* encoded,
+                                   vector<size_t>* entryElements,
+                                   vector<size_t>* entryWords);
+
+  //! The codec with the given name, false if there is none.
+  static bool fromName(const string& name, Codec* codec);
+
+  //! Maximum number of words from an entry point to the end of the values
+  //! that belong to it.
+  static size_t maxWordsPerEntry(Codec codec) {
+    return codec == SIMPLE8B ? 1 : 1 + (CHUNK_SIZE / 4 + CHUNK_SIZE * 8) / 8;
+  }
+
+  static string name(Codec codec);
+
+  //! Decodes nofElements values starting at an entry point.
+  template<typename Numeric>
+  static void decode(Codec codec, const uint64_t* encoded, size_t nofElements,
+                     Numeric* decoded) {
+    if (codec == SIMPLE8B) {
+      ad_utility::Simple8bCode::decode(encoded, nofElements, decoded);
+      return;
+    }
+    decodeChunks(codec, encoded, nofElements, decoded,
+                 [](uint64_t value) { return static_cast<Numeric>(value); });
+  }
+
+  //! Decodes gaps and turns them into values, starting at base.
+  template<typename Numeric>
+  static void decodeGaps(Codec codec, const uint64_t* encoded,
+                         size_t nofElements, Numeric* decoded,
+                         Numeric base = 0) {
+    if (codec == SIMPLE8B) {
+      ad_utility::Simple8bCode::decodeGaps(encoded, nofElements, decoded,
+                                           base);
+      return;
+    }
+    Numeric current = base;
+    decodeChunks(codec, encoded, nofElements, decoded,
+                 [&current](uint64_t gap) {
+                   current += static_cast<Numeric>(gap);
+                   return current;
+                 });
+  }
+
+  //! Decodes codes and replaces each by its codebook entry.
+  template<typename Numeric>
+  static void decodeWithCodebook(Codec codec, const uint64_t* encoded,
+                                 size_t nofElements, const Numeric* codebook,
+                                 Numeric* decoded) {
+    if (codec == SIMPLE8B) {
+      ad_utility::Simple8bCode::decodeWithCodebook(encoded, nofElements,
+                                                   codebook, decoded);
+      return;
+    }
+    decodeChunks(codec, encoded, nofElements, decoded,
+                 [codebook](uint64_t code) { return codebook[code]; });
+  }
+
+private:
+  // Decodes the chunk at chunk into values and returns the number of
+  // words it occupies. Sets nofValues to the number of values in it.
+  static size_t decodeChunk(Codec codec, const uint64_t* chunk,
+                            uint64_t* values, size_t* nofValues);
+
+  // Decodes chunk after chunk and passes each value through transform
+  // while the chunk is still in the cache.
+  template<typename Numeric, typename Transform>
+  static void decodeChunks(Codec codec, const uint64_t* encoded,
+                           size_t nofElements, Numeric* decoded,
+                           Transform transform) {
+    uint64_t values[CHUNK_SIZE];
+    size_t nofElementsDone = 0;
+    while (nofElementsDone < nofElements) {
+      size_t nofValues;
+      encoded += decodeChunk(codec, encoded, values, &nofValues);
+      for (size_t i = 0; i < nofValues; ++i) {
+        decoded[nofElementsDone + i] = transform(values[i]);
+      }
+      nofElementsDone += nofValues;
+    }
+  }
+
+  static void encodeChunk(Codec codec, const uint64_t* values,
+                          size_t nofValues, vector<uint64_t>* encoded);
+};
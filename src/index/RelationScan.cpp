@@ -0,0 +1,93 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <algorithm>
+#include "../util/Exception.h"
+#include "./CompressedPairBlocks.h"
+#include "./RelationScan.h"
+
+// _____________________________________________________________________________
+RelationScan::RelationScan() :
+    _offset(0), _end(0), _compressed(false), _relId(0), _pairsPerBlock(1),
+    _nofPairsRead(0), _done(true), _hasLast(false), _last{{0, 0}},
+    _bufferPos(0) {
+}
+
+// _____________________________________________________________________________
+RelationScan::RelationScan(const shared_ptr<const ad_utility::File>& file,
+                           off_t from, off_t to, bool compressed, Id relId,
+                           const DeltaStore& deltas, size_t pairsPerBlock) :
+    _file(file), _offset(from), _end(to), _compressed(compressed),
+    _relId(relId), _deltas(deltas), _pairsPerBlock(pairsPerBlock),
+    _nofPairsRead(0), _done(false), _hasLast(false), _last{{0, 0}},
+    _bufferPos(0) {
+  AD_CHECK_GT(_pairsPerBlock, 0);
+  AD_CHECK_LE(_offset, _end);
+  AD_CHECK(_file || _offset == _end);
+}
+
+// _____________________________________________________________________________
+bool RelationScan::next(vector<array<Id, 2>>* block) {
+  block->clear();
+  // All pairs of a block may have been deleted, go on with the next one.
+  while (block->empty() && !_done) {
+    if (_compressed) {
+      readCompressedPairs(block);
+    } else {
+      readPairs(block);
+    }
+    _nofPairsRead += block->size();
+    _done = _offset == _end && _bufferPos == _buffer.size();
+    // The changes after the last pair from disk belong to the last block.
+    array<Id, 2> last = block->empty() ? _last : block->back();
+    _deltas.apply(_relId, _hasLast ? &_last : nullptr,
+                  _done ? nullptr : &last, block);
+    _hasLast = _hasLast || !_done;
+    _last = last;
+  }
+  return !block->empty();
+}
+
+// _____________________________________________________________________________
+void RelationScan::readPairs(vector<array<Id, 2>>* block) {
+  size_t nofPairs = std::min(_pairsPerBlock,
+      static_cast<size_t>(_end - _offset) / sizeof(array<Id, 2>));
+  size_t nofBytes = nofPairs * sizeof(array<Id, 2>);
+  block->resize(nofPairs);
+  if (nofPairs > 0) {
+    AD_CHECK_EQ(nofBytes, _file->read(block->data(), nofBytes, _offset));
+  }
+  _offset += nofBytes;
+}
+
+// _____________________________________________________________________________
+void RelationScan::readCompressedPairs(vector<array<Id, 2>>* block) {
+  while (true) {
+    // Decode what is complete.
+    while (block->size() < _pairsPerBlock) {
+      size_t nofWords = CompressedPairBlocks::getNofWords(
+          _buffer.data() + _bufferPos, _buffer.size() - _bufferPos);
+      if (nofWords == 0) {
+        break;
+      }
+      CompressedPairBlocks::decode(_buffer.data() + _bufferPos, block);
+      _bufferPos += nofWords;
+    }
+    if (block->size() >= _pairsPerBlock || _offset == _end) {
+      AD_CHECK(_offset < _end || _bufferPos == _buffer.size());
+      return;
+    }
+    // Read about as many words as the pairs of a block would need raw,
+    // but always enough to finish the compressed block begun.
+    _buffer.erase(_buffer.begin(), _buffer.begin() + _bufferPos);
+    _bufferPos = 0;
+    size_t nofBytes = std::min(2 * _pairsPerBlock * sizeof(uint64_t),
+                               static_cast<size_t>(_end - _offset));
+    size_t before = _buffer.size();
+    _buffer.resize(before + nofBytes / sizeof(uint64_t));
+    AD_CHECK_EQ(nofBytes,
+                _file->read(_buffer.data() + before, nofBytes, _offset));
+    _offset += nofBytes;
+  }
+}
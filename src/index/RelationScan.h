@@ -0,0 +1,67 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <sys/types.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "../global/Id.h"
+#include "../util/File.h"
+#include "./DeltaStore.h"
+
+using std::array;
+using std::shared_ptr;
+using std::vector;
+
+//! Goes through the (lhs, rhs) pairs of one relation of a permutation
+//! a block at a time, so that the relation never has to be in memory
+//! as a whole. Blocks come in the order of the pairs on disk.
+//! Each block holds up to pairsPerBlock pairs from disk, for compressed
+//! FullIndex data at least one whole compressed block, with the changes
+//! in memory for its range of pairs applied.
+//!
+//! A scan keeps the file it was started on open and has a copy of the
+//! changes at that time, it is not affected by later updates or a
+//! compaction.
+class RelationScan {
+public:
+  // A scan without pairs.
+  RelationScan();
+
+  // Scans the FullIndex of a relation in [from, to) of file.
+  RelationScan(const shared_ptr<const ad_utility::File>& file, off_t from,
+               off_t to, bool compressed, Id relId, const DeltaStore& deltas,
+               size_t pairsPerBlock);
+
+  // Replaces the contents of block by the next block.
+  // Returns false if there are no more pairs, blocks are never empty.
+  bool next(vector<array<Id, 2>>* block);
+
+  // Number of pairs read from disk so far.
+  size_t getNofPairsRead() const {
+    return _nofPairsRead;
+  }
+
+private:
+  shared_ptr<const ad_utility::File> _file;
+  off_t _offset;
+  off_t _end;
+  bool _compressed;
+  Id _relId;
+  DeltaStore _deltas;
+  size_t _pairsPerBlock;
+  size_t _nofPairsRead;
+  bool _done;
+  // The last pair from disk handed out, the changes up to it are applied.
+  bool _hasLast;
+  array<Id, 2> _last;
+  // Compressed words that have been read but not decoded, from _bufferPos.
+  vector<uint64_t> _buffer;
+  size_t _bufferPos;
+
+  void readPairs(vector<array<Id, 2>>* block);
+
+  void readCompressedPairs(vector<array<Id, 2>>* block);
+};
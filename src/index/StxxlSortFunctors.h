@@ -4,6 +4,7 @@
 #pragma once
 
 #include <array>
+#include <limits>
 #include <tuple>
 #include "../global/Id.h"
 
@@ -58,6 +59,37 @@ struct SortByPOS {
   }
 };
 
+// Lexicographic order on the columns I0, I1, I2.
+template<size_t I0, size_t I1, size_t I2>
+struct SortByColumns {
+  // comparison function
+  bool operator()(const array<Id, 3>& a, const array<Id, 3>& b) const {
+    if (a[I0] == b[I0]) {
+      if (a[I1] == b[I1]) {
+        return a[I2] < b[I2];
+      }
+      return a[I1] < b[I1];
+    }
+    return a[I0] < b[I0];
+  }
+
+  // min sentinel = value which is strictly smaller that any input element
+  static array<Id, 3> min_value() {
+    return array<Id, 3>{{0, 0, 0}};
+  }
+
+  // max sentinel = value which is strictly larger that any input element
+  static array<Id, 3> max_value() {
+    Id max = std::numeric_limits<Id>::max();
+    return array<Id, 3>{{max, max, max}};
+  }
+};
+
+typedef SortByColumns<0, 1, 2> SortBySPO;
+typedef SortByColumns<0, 2, 1> SortBySOP;
+typedef SortByColumns<2, 0, 1> SortByOSP;
+typedef SortByColumns<2, 1, 0> SortByOPS;
+
 struct SortText {
   // comparison function
   bool operator()(const tuple<Id, Id, Id, Score, bool>& a,
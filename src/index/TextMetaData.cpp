@@ -94,10 +94,14 @@ TextBlockMetaData& TextBlockMetaData::createFromByteBuffer(
 ad_utility::File& operator<<(ad_utility::File& f,
                              const ContextListMetaData& md) {
   f.write(&md._nofElements, sizeof(md._nofElements));
+  f.write(&md._startSubBlocks, sizeof(md._startSubBlocks));
   f.write(&md._startContextlist, sizeof(md._startContextlist));
   f.write(&md._startWordlist, sizeof(md._startWordlist));
   f.write(&md._startScorelist, sizeof(md._startScorelist));
   f.write(&md._lastByte, sizeof(md._lastByte));
+  f.write(&md._contextCodec, sizeof(md._contextCodec));
+  f.write(&md._wordCodec, sizeof(md._wordCodec));
+  f.write(&md._scoreCodec, sizeof(md._scoreCodec));
   return f;
 }
 
@@ -107,6 +111,8 @@ ContextListMetaData& ContextListMetaData::createFromByteBuffer(
   off_t offset = 0;
   _nofElements = *reinterpret_cast<size_t*>(buffer + offset);
   offset += sizeof(_nofElements);
+  _startSubBlocks = *reinterpret_cast<off_t*>(buffer + offset);
+  offset += sizeof(_startSubBlocks);
   _startContextlist = *reinterpret_cast<off_t*>(buffer + offset);
   offset += sizeof(_startContextlist);
   _startWordlist = *reinterpret_cast<off_t*>(buffer + offset);
@@ -114,6 +120,48 @@ ContextListMetaData& ContextListMetaData::createFromByteBuffer(
   _startScorelist = *reinterpret_cast<off_t*>(buffer + offset);
   offset += sizeof(_startScorelist);
   _lastByte = *reinterpret_cast<off_t*>(buffer + offset);
+  offset += sizeof(_lastByte);
+  _contextCodec = *reinterpret_cast<PostingListCodec::Codec*>(buffer + offset);
+  offset += sizeof(_contextCodec);
+  _wordCodec = *reinterpret_cast<PostingListCodec::Codec*>(buffer + offset);
+  offset += sizeof(_wordCodec);
+  _scoreCodec = *reinterpret_cast<PostingListCodec::Codec*>(buffer + offset);
+  return *this;
+}
+
+// _____________________________________________________________________________
+ad_utility::File& operator<<(ad_utility::File& f,
+                             const TextSubBlockMetaData& md) {
+  f.write(&md._lastContext, sizeof(md._lastContext));
+  f.write(&md._maxScore, sizeof(md._maxScore));
+  f.write(&md._firstElement, sizeof(md._firstElement));
+  f.write(&md._startContexts, sizeof(md._startContexts));
+  f.write(&md._startWords, sizeof(md._startWords));
+  f.write(&md._startScores, sizeof(md._startScores));
+  f.write(&md._nofSkippedWords, sizeof(md._nofSkippedWords));
+  f.write(&md._nofSkippedScores, sizeof(md._nofSkippedScores));
+  return f;
+}
+
+// _____________________________________________________________________________
+TextSubBlockMetaData& TextSubBlockMetaData::createFromByteBuffer(
+    unsigned char* buffer) {
+  off_t offset = 0;
+  _lastContext = *reinterpret_cast<Id*>(buffer + offset);
+  offset += sizeof(_lastContext);
+  _maxScore = *reinterpret_cast<Score*>(buffer + offset);
+  offset += sizeof(_maxScore);
+  _firstElement = *reinterpret_cast<size_t*>(buffer + offset);
+  offset += sizeof(_firstElement);
+  _startContexts = *reinterpret_cast<off_t*>(buffer + offset);
+  offset += sizeof(_startContexts);
+  _startWords = *reinterpret_cast<off_t*>(buffer + offset);
+  offset += sizeof(_startWords);
+  _startScores = *reinterpret_cast<off_t*>(buffer + offset);
+  offset += sizeof(_startScores);
+  _nofSkippedWords = *reinterpret_cast<size_t*>(buffer + offset);
+  offset += sizeof(_nofSkippedWords);
+  _nofSkippedScores = *reinterpret_cast<size_t*>(buffer + offset);
   return *this;
 }
 
@@ -137,15 +185,29 @@ string TextMetaData::statistics() const {
   size_t totalBytesCls = 0;
   size_t totalBytesWls = 0;
   size_t totalBytesSls = 0;
+  size_t totalBytesSubBlocks = 0;
+  vector<size_t> nofListsPerCodec(PostingListCodec::NOF_CODECS, 0);
   for (size_t i = 0; i < _blocks.size(); ++i) {
     const ContextListMetaData& wcl = _blocks[i]._cl;
     const ContextListMetaData& ecl = _blocks[i]._entityCl;
 
+    for (const ContextListMetaData* cl : {&wcl, &ecl}) {
+      if (cl->_nofElements > 0) {
+        ++nofListsPerCodec[cl->_contextCodec];
+        ++nofListsPerCodec[cl->_scoreCodec];
+        if (cl->hasMultipleWords()) {
+          ++nofListsPerCodec[cl->_wordCodec];
+        }
+      }
+    }
+
     totalElementsClassicLists += wcl._nofElements;
     totalElementsEntityLists += ecl._nofElements;
 
-    totalBytesClassicLists += 1 + wcl._lastByte - wcl._startContextlist;
-    totalBytesEntityLists += 1 + ecl._lastByte - ecl._startContextlist;
+    totalBytesClassicLists += 1 + wcl._lastByte - wcl._startSubBlocks;
+    totalBytesEntityLists += 1 + ecl._lastByte - ecl._startSubBlocks;
+
+    totalBytesSubBlocks += wcl._startContextlist - wcl._startSubBlocks;
 
     totalBytesCls += wcl._startWordlist - wcl._startContextlist;
     totalBytesCls += ecl._startWordlist - ecl._startContextlist;
@@ -171,6 +233,13 @@ string TextMetaData::statistics() const {
   os << "    Bytes in context / doc lists: " << totalBytesCls << '\n';
   os << "    Bytes in word lists:          " << totalBytesWls << '\n';
   os << "    Bytes in score lists:         " << totalBytesSls << '\n';
+  os << "    Bytes in sub-block lists:     " << totalBytesSubBlocks << '\n';
+  os << "-------------------------------------------------------------------\n";
+  os << "Lists per codec:\n";
+  for (size_t c = 0; c < PostingListCodec::NOF_CODECS; ++c) {
+    os << "    " << PostingListCodec::name(PostingListCodec::Codec(c)) << ": "
+       << nofListsPerCodec[c] << '\n';
+  }
   os << "-------------------------------------------------------------------\n";
   os << "\n";
   os << "-------------------------------------------------------------------\n";
@@ -8,36 +8,95 @@
 #include "../global/Id.h"
 #include "../util/Exception.h"
 #include "../util/File.h"
+#include "./PostingListCodec.h"
 
 using std::vector;
 
+//! About TEXT_SUB_BLOCK_SIZE consecutive postings of a classic list that
+//! can be decoded without the rest of the list. A sub-block starts at an
+//! entry point of the context list (see PostingListCodec), its first gap
+//! is to the last context of the sub-block before. Its word and score
+//! elements begin inside the code words or chunks at _startWords and
+//! _startScores, after the given number of elements that belong to the
+//! sub-block before.
+//! A context never spans two sub-blocks.
+class TextSubBlockMetaData {
+public:
+  TextSubBlockMetaData() : _lastContext(0), _maxScore(0), _firstElement(0),
+                           _startContexts(0), _startWords(0), _startScores(0),
+                           _nofSkippedWords(0), _nofSkippedScores(0) { }
+
+  Id _lastContext;
+  Score _maxScore;
+  size_t _firstElement;
+  off_t _startContexts;
+  off_t _startWords;
+  off_t _startScores;
+  size_t _nofSkippedWords;
+  size_t _nofSkippedScores;
+
+  // Restores meta data from raw memory.
+  TextSubBlockMetaData& createFromByteBuffer(unsigned char* buffer);
+
+  static constexpr size_t sizeOnDisk() {
+    return sizeof(Id) + sizeof(Score) + 3 * sizeof(size_t) + 3 * sizeof(off_t);
+  }
+
+  friend ad_utility::File& operator<<(ad_utility::File& f,
+                                      const TextSubBlockMetaData& md);
+};
+
+ad_utility::File& operator<<(ad_utility::File& f,
+                             const TextSubBlockMetaData& md);
+
+//! A list of postings on disk. Classic lists are preceded by their
+//! sub-blocks in [_startSubBlocks, _startContextlist), entity lists have none.
+//! The context, word and score lists each have their own codec.
 class ContextListMetaData {
 public:
-  ContextListMetaData() : _nofElements(), _startContextlist(0),
-                          _startWordlist(0), _startScorelist(0), _lastByte(0) {
+  ContextListMetaData() : _nofElements(), _startSubBlocks(0),
+                          _startContextlist(0), _startWordlist(0),
+                          _startScorelist(0), _lastByte(0),
+                          _contextCodec(PostingListCodec::SIMPLE8B),
+                          _wordCodec(PostingListCodec::SIMPLE8B),
+                          _scoreCodec(PostingListCodec::SIMPLE8B) {
   }
 
-  ContextListMetaData(size_t nofElements, off_t startCl,
+  ContextListMetaData(size_t nofElements, off_t startSubBlocks, off_t startCl,
                       off_t startWl, off_t startSl, off_t lastByte) :
-      _nofElements(nofElements), _startContextlist(startCl),
-      _startWordlist(startWl), _startScorelist(startSl), _lastByte(lastByte) { }
+      _nofElements(nofElements), _startSubBlocks(startSubBlocks),
+      _startContextlist(startCl), _startWordlist(startWl),
+      _startScorelist(startSl), _lastByte(lastByte),
+      _contextCodec(PostingListCodec::SIMPLE8B),
+      _wordCodec(PostingListCodec::SIMPLE8B),
+      _scoreCodec(PostingListCodec::SIMPLE8B) { }
 
   size_t _nofElements;
+  off_t _startSubBlocks;
   off_t _startContextlist;
   off_t _startWordlist;
   off_t _startScorelist;
   off_t _lastByte;
+  PostingListCodec::Codec _contextCodec;
+  PostingListCodec::Codec _wordCodec;
+  PostingListCodec::Codec _scoreCodec;
 
   bool hasMultipleWords() const {
     return _startScorelist > _startWordlist;
   }
 
+  size_t getNofSubBlocks() const {
+    return static_cast<size_t>(_startContextlist - _startSubBlocks) /
+        TextSubBlockMetaData::sizeOnDisk();
+  }
+
   // Restores meta data from raw memory.
   // Needed when registering an index on startup.
   ContextListMetaData& createFromByteBuffer(unsigned char* buffer);
 
   static constexpr size_t sizeOnDisk() {
-    return sizeof(size_t) + 4 * sizeof(off_t);
+    return sizeof(size_t) + 5 * sizeof(off_t) +
+        3 * sizeof(PostingListCodec::Codec);
   }
 
   friend ad_utility::File& operator<<(ad_utility::File& f,
@@ -2,66 +2,468 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold <buchholb>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
 #include <iostream>
-#include <fstream>
 
-#include "../util/File.h"
 #include "./Vocabulary.h"
 
 using std::string;
 
+namespace {
 // _____________________________________________________________________________
-Vocabulary::Vocabulary() {
+void appendVarint(size_t value, vector<char>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// _____________________________________________________________________________
+size_t readVarint(const char** data) {
+  size_t value = 0;
+  size_t shift = 0;
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(*data);
+  while (*p & 0x80) {
+    value |= static_cast<size_t>(*p & 0x7F) << shift;
+    shift += 7;
+    ++p;
+  }
+  value |= static_cast<size_t>(*p) << shift;
+  *data = reinterpret_cast<const char*>(p + 1);
+  return value;
+}
+}
+
+// _____________________________________________________________________________
+void FrontCodingEncoder::add(const string& word) {
+  VocabularyEntry entry;
+  entry._text = word;
+  append(entry);
+}
+
+// _____________________________________________________________________________
+void FrontCodingEncoder::addExternal(const string& word, uint64_t offset) {
+  VocabularyEntry entry;
+  entry._text = word.substr(0, EXTERNAL_LITERAL_PREFIX_SIZE);
+  entry._external = true;
+  entry._offset = offset;
+  entry._size = word.size();
+  append(entry);
+}
+
+// _____________________________________________________________________________
+void FrontCodingEncoder::append(const VocabularyEntry& entry) {
+  const string& text = entry._text;
+  size_t flag = entry._external ? 1 : 0;
+  if (_nofWords % VOCABULARY_BLOCK_SIZE == 0) {
+    _blockStarts.push_back(_base + _bytes.size());
+    appendVarint(text.size() * 2 + flag, &_bytes);
+    _bytes.insert(_bytes.end(), text.begin(), text.end());
+  } else {
+    size_t shared = 0;
+    size_t maxShared = std::min(text.size(), _last.size());
+    while (shared < maxShared && text[shared] == _last[shared]) {
+      ++shared;
+    }
+    appendVarint(shared, &_bytes);
+    appendVarint((text.size() - shared) * 2 + flag, &_bytes);
+    _bytes.insert(_bytes.end(), text.begin() + shared, text.end());
+  }
+  if (entry._external) {
+    appendVarint(entry._offset, &_bytes);
+    appendVarint(entry._size, &_bytes);
+  }
+  _last = text;
+  ++_nofWords;
+}
+
+// _____________________________________________________________________________
+Vocabulary::Vocabulary() : _mapping(nullptr), _mappingBytes(0),
+                           _mappedBlockStarts(nullptr), _externalFd(-1),
+                           _nofWords(0),
+                           _nofBlocks(0) {
 }
 // _____________________________________________________________________________
 Vocabulary::~Vocabulary() {
+  unmap();
 }
 
+// _____________________________________________________________________________
+void Vocabulary::unmap() {
+  if (_mapping) {
+    munmap(_mapping, _mappingBytes);
+    _mapping = nullptr;
+    _mappingBytes = 0;
+    _mappedBlockStarts = nullptr;
+  }
+  if (_externalFd >= 0) {
+    close(_externalFd);
+    _externalFd = -1;
+  }
+  _hash.clear();
+}
 
 // _____________________________________________________________________________
 void Vocabulary::readFromFile(const string& fileName) {
-  LOG(INFO) << "Reading vocabulary from file " << fileName << "\n";
-  _words.clear();
-  std::fstream in(fileName.c_str(), std::ios_base::in);
-  string line;
-  while (std::getline(in, line)) {
-    _words.push_back(line);
+  LOG(INFO) << "Mapping vocabulary from file " << fileName << "\n";
+  unmap();
+  _encoder = FrontCodingEncoder();
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not open vocabulary file " + fileName);
   }
-  in.close();
-  LOG(INFO) << "Done reading vocabulary from file.\n";
+  struct stat st;
+  AD_CHECK_EQ(0, fstat(fd, &st));
+  size_t nofBytes = static_cast<size_t>(st.st_size);
+  if (nofBytes < sizeof(uint64_t) + sizeof(off_t)) {
+    close(fd);
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Not a vocabulary file: " + fileName);
+  }
+  void* mapping = mmap(nullptr, nofBytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not map vocabulary file " + fileName);
+  }
+  _mapping = static_cast<char*>(mapping);
+  _mappingBytes = nofBytes;
+  off_t startOfOffsets;
+  memcpy(&startOfOffsets, _mapping + nofBytes - sizeof(off_t), sizeof(off_t));
+  uint64_t nofWords;
+  memcpy(&nofWords, _mapping + nofBytes - sizeof(off_t) - sizeof(uint64_t),
+         sizeof(uint64_t));
+  _nofWords = static_cast<size_t>(nofWords);
+  _nofBlocks = (nofBytes - sizeof(off_t) - sizeof(uint64_t) -
+                static_cast<size_t>(startOfOffsets)) / sizeof(uint64_t);
+  AD_CHECK_EQ(_nofBlocks, (_nofWords + VOCABULARY_BLOCK_SIZE - 1) /
+                          VOCABULARY_BLOCK_SIZE);
+  _mappedBlockStarts = _mapping + startOfOffsets;
+  string externalFile = fileName + ".external";
+  if (ad_utility::File::exists(externalFile)) {
+    _externalFd = open(externalFile.c_str(), O_RDONLY);
+    if (_externalFd < 0) {
+      AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+               "Could not open external vocabulary " + externalFile);
+    }
+  }
+  if (_hash.readFromFile(fileName + ".mphf")) {
+    LOG(INFO) << "Using perfect hash function for lookups.\n";
+  }
+  LOG(INFO) << "Done mapping vocabulary with " << _nofWords << " words.\n";
 }
 
 // _____________________________________________________________________________
 void Vocabulary::writeToFile(const string& fileName) const {
   LOG(INFO) << "Writing vocabulary to file " << fileName << "\n";
-  std::ofstream out(fileName.c_str(), std::ios_base::out);
-  for (size_t i = 0; i + 1 < _words.size(); ++i) {
-    out << _words[i] << '\n';
-  }
-  if (_words.size() > 0) {
-    out << _words[_words.size() - 1];
+  ad_utility::File out(fileName.c_str(), "w");
+  std::remove((fileName + ".external").c_str());
+  std::remove((fileName + ".mphf").c_str());
+  if (_mapping) {
+    out.write(_mapping, _mappingBytes);
+    if (_externalFd >= 0) {
+      ad_utility::File external((fileName + ".external").c_str(), "w");
+      struct stat st;
+      AD_CHECK_EQ(0, fstat(_externalFd, &st));
+      vector<char> buf(static_cast<size_t>(st.st_size));
+      AD_CHECK_EQ(static_cast<ssize_t>(buf.size()),
+                  pread(_externalFd, buf.data(), buf.size(), 0));
+      external.write(buf.data(), buf.size());
+    }
+  } else {
+    out.write(_encoder._bytes.data(), _encoder._bytes.size());
+    off_t startOfOffsets = static_cast<off_t>(_encoder._bytes.size());
+    out.write(_encoder._blockStarts.data(),
+              _encoder._blockStarts.size() * sizeof(uint64_t));
+    uint64_t nofWords = _nofWords;
+    out.write(&nofWords, sizeof(nofWords));
+    out.write(&startOfOffsets, sizeof(startOfOffsets));
   }
   out.close();
   LOG(INFO) << "Done writing vocabulary to file.\n";
 }
 
+// _____________________________________________________________________________
+Vocabulary::Writer::Writer(const string& fileName)
+    : _fileName(fileName), _out(fileName.c_str(), "w"), _externalBytes(0),
+      _finished(false) {
+  // The external file is only created for the first long literal.
+  std::remove((fileName + ".external").c_str());
+  std::remove((fileName + ".mphf").c_str());
+}
+
+// _____________________________________________________________________________
+Vocabulary::Writer::~Writer() {
+  if (!_finished) {
+    finish();
+  }
+}
+
+// _____________________________________________________________________________
+void Vocabulary::Writer::push_back(const string& word) {
+  _hashes.push_back(std::make_pair(PerfectHash::hash(word),
+                                   Id(_encoder.nofWords())));
+  if (shouldBeExternalized(word)) {
+    if (!_external.isOpen()) {
+      _external.open((_fileName + ".external").c_str(), "w");
+    }
+    _external.write(word.data(), word.size());
+    _encoder.addExternal(word, _externalBytes);
+    _externalBytes += word.size();
+  } else {
+    _encoder.add(word);
+  }
+  if (_encoder._bytes.size() > BUFFER_SIZE_VOCABULARY_WRITER) {
+    _out.write(_encoder._bytes.data(), _encoder._bytes.size());
+    _encoder.flush();
+  }
+}
+
+// _____________________________________________________________________________
+void Vocabulary::Writer::finish() {
+  _out.write(_encoder._bytes.data(), _encoder._bytes.size());
+  _encoder.flush();
+  off_t startOfOffsets = _out.tell();
+  _out.write(_encoder._blockStarts.data(),
+             _encoder._blockStarts.size() * sizeof(uint64_t));
+  uint64_t nofWords = _encoder.nofWords();
+  _out.write(&nofWords, sizeof(nofWords));
+  _out.write(&startOfOffsets, sizeof(startOfOffsets));
+  _out.close();
+  if (_external.isOpen()) {
+    _external.close();
+  }
+  PerfectHash::build(&_hashes, _fileName + ".mphf");
+  vector<std::pair<uint64_t, Id>>().swap(_hashes);
+  _finished = true;
+}
+
+// _____________________________________________________________________________
+void Vocabulary::push_back(const string& word) {
+  if (_mapping) {
+    // Continue with an in-memory copy of the mapped words.
+    FrontCodingEncoder encoder;
+    for (size_t i = 0; i < _nofBlocks; ++i) {
+      decodeBlock(i, VOCABULARY_BLOCK_SIZE - 1,
+                  [this, &encoder](const VocabularyEntry& e, size_t) {
+                    encoder.add(resolve(e));
+                    return false;
+                  });
+    }
+    unmap();
+    _encoder = encoder;
+  }
+  _encoder.add(word);
+  _nofWords = _encoder.nofWords();
+  _nofBlocks = _encoder._blockStarts.size();
+}
+
+// _____________________________________________________________________________
+const char* Vocabulary::blockData(size_t block) const {
+  if (_mapping) {
+    // The offsets follow the blocks without padding and may be unaligned.
+    uint64_t blockStart;
+    memcpy(&blockStart, _mappedBlockStarts + block * sizeof(uint64_t),
+           sizeof(blockStart));
+    return _mapping + blockStart;
+  }
+  return _encoder._bytes.data() + _encoder._blockStarts[block];
+}
+
+// _____________________________________________________________________________
+VocabularyEntry Vocabulary::firstWordOfBlock(size_t block) const {
+  VocabularyEntry entry;
+  decodeBlock(block, 0, [&entry](const VocabularyEntry& e, size_t) {
+    entry = e;
+    return true;
+  });
+  return entry;
+}
+
+// _____________________________________________________________________________
+template<class F>
+size_t Vocabulary::decodeBlock(size_t block, size_t last, F f) const {
+  const char* data = blockData(block);
+  size_t nofWords = std::min(VOCABULARY_BLOCK_SIZE,
+                             _nofWords - block * VOCABULARY_BLOCK_SIZE);
+  last = std::min(last, nofWords - 1);
+  VocabularyEntry entry;
+  for (size_t i = 0; i <= last; ++i) {
+    size_t shared = i == 0 ? 0 : readVarint(&data);
+    size_t suffix = readVarint(&data);
+    entry._external = (suffix & 1) != 0;
+    suffix >>= 1;
+    entry._text.resize(shared);
+    entry._text.append(data, suffix);
+    data += suffix;
+    if (entry._external) {
+      entry._offset = readVarint(&data);
+      entry._size = readVarint(&data);
+    }
+    if (f(entry, i)) {
+      return i;
+    }
+  }
+  return last + 1;
+}
+
+// _____________________________________________________________________________
+string Vocabulary::operator[](Id id) const {
+  AD_CHECK_LT(id, _nofWords);
+  string result;
+  size_t block = static_cast<size_t>(id) / VOCABULARY_BLOCK_SIZE;
+  decodeBlock(block, static_cast<size_t>(id) % VOCABULARY_BLOCK_SIZE,
+              [this, &result](const VocabularyEntry& e, size_t) {
+                result = resolve(e);
+                return false;
+              });
+  return result;
+}
+
+// _____________________________________________________________________________
+template<class Pred>
+Id Vocabulary::findFirst(Pred pred) const {
+  // First block whose first word satisfies pred.
+  size_t lo = 0;
+  size_t hi = _nofBlocks;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (pred(firstWordOfBlock(mid))) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  if (lo == 0) {
+    return 0;
+  }
+  // The result is in the previous block or is the start of block lo.
+  size_t block = lo - 1;
+  size_t inBlock = decodeBlock(block, VOCABULARY_BLOCK_SIZE - 1,
+                               [&pred](const VocabularyEntry& e, size_t) {
+                                 return pred(e);
+                               });
+  return static_cast<Id>(block * VOCABULARY_BLOCK_SIZE + inBlock);
+}
+
+// _____________________________________________________________________________
+string Vocabulary::resolve(const VocabularyEntry& entry) const {
+  if (!entry._external) {
+    return entry._text;
+  }
+  AD_CHECK_GE(_externalFd, 0);
+  string word(entry._size, '\0');
+  ssize_t nofBytes = pread(_externalFd, &word[0], word.size(),
+                           static_cast<off_t>(entry._offset));
+  AD_CHECK_EQ(static_cast<ssize_t>(word.size()), nofBytes);
+  return word;
+}
+
+// _____________________________________________________________________________
+int Vocabulary::compare(const VocabularyEntry& entry,
+                        const string& word) const {
+  // If word does not start with the prefix, the prefix decides:
+  // either they differ within the prefix or word is shorter and smaller.
+  if (entry._external && ad_utility::startsWith(word, entry._text)) {
+    return resolve(entry).compare(word);
+  }
+  return entry._text.compare(word);
+}
+
+// _____________________________________________________________________________
+Id Vocabulary::lower_bound(const string& word) const {
+  return findFirst([this, &word](const VocabularyEntry& e) {
+    return compare(e, word) >= 0;
+  });
+}
+
+// _____________________________________________________________________________
+Id Vocabulary::upper_bound(const string& word, PrefixComparator comp) const {
+  Id retVal = findFirst([this, &word, &comp](const VocabularyEntry& e) {
+    if (e._external && e._text.size() < word.size()) {
+      return comp(word, resolve(e));
+    }
+    return comp(word, e._text);
+  });
+  AD_CHECK_LE(retVal, size());
+  return retVal;
+}
+
+// _____________________________________________________________________________
+bool Vocabulary::getId(const string& word, Id* id) const {
+  if (!_hash.empty()) {
+    // The fingerprint rejects most other words, verify the rest.
+    return _hash.lookup(word, id) && *id < _nofWords && compare(*id, word) == 0;
+  }
+  *id = lower_bound(word);
+  return *id < _nofWords && compare(*id, word) == 0;
+}
+
+// _____________________________________________________________________________
+int Vocabulary::compare(Id id, const string& word) const {
+  int result = 0;
+  size_t block = static_cast<size_t>(id) / VOCABULARY_BLOCK_SIZE;
+  decodeBlock(block, static_cast<size_t>(id) % VOCABULARY_BLOCK_SIZE,
+              [this, &word, &result](const VocabularyEntry& e, size_t) {
+                result = compare(e, word);
+                return false;
+              });
+  return result;
+}
+
+// _____________________________________________________________________________
+bool Vocabulary::getIdRangeForFullTextPrefix(const string& word,
+                                             IdRange* range) const {
+  AD_CHECK_EQ(word[word.size() - 1], PREFIX_CHAR);
+  string prefix = word.substr(0, word.size() - 1);
+  range->_first = lower_bound(prefix);
+  range->_last = upper_bound(prefix, PrefixComparator(prefix.size())) - 1;
+  bool success = range->_first < _nofWords
+      && ad_utility::startsWith((*this)[range->_first], prefix)
+      && range->_last < _nofWords
+      && ad_utility::startsWith((*this)[range->_last], prefix)
+      && range->_first <= range->_last;
+  if (success) {
+    AD_CHECK_LT(range->_first, _nofWords);
+    AD_CHECK_LT(range->_last, _nofWords);
+  }
+  return success;
+}
+
 // _____________________________________________________________________________
 void Vocabulary::createFromSet(const std::unordered_set<string>& set) {
   LOG(INFO) << "Creating vocabulary from set ...\n";
-  _words.clear();
-  _words.reserve(set.size());
-  _words.insert(begin(_words), begin(set), end(set));
+  unmap();
+  _encoder = FrontCodingEncoder();
+  vector<string> words(begin(set), end(set));
   LOG(INFO) << "... sorting ...\n";
-  std::sort(begin(_words), end(_words));
+  std::sort(begin(words), end(words));
+  for (size_t i = 0; i < words.size(); ++i) {
+    _encoder.add(words[i]);
+  }
+  _nofWords = _encoder.nofWords();
+  _nofBlocks = _encoder._blockStarts.size();
   LOG(INFO) << "Done creating vocabulary.\n";
 }
 
 // _____________________________________________________________________________
 std::unordered_map<string, Id> Vocabulary::asMap() {
   std::unordered_map<string, Id> map;
-  map.reserve(_words.size());
-  for (size_t i = 0; i < _words.size(); ++i) {
-    map[_words[i]] = i;
+  map.reserve(_nofWords);
+  for (size_t i = 0; i < _nofBlocks; ++i) {
+    size_t first = i * VOCABULARY_BLOCK_SIZE;
+    decodeBlock(i, VOCABULARY_BLOCK_SIZE - 1,
+                [this, &map, first](const VocabularyEntry& e, size_t j) {
+                  map[resolve(e)] = first + j;
+                  return false;
+                });
   }
   return map;
 }
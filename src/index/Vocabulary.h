@@ -4,18 +4,22 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <cassert>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <vector>
 #include <algorithm>
 
 
 #include "../util/Exception.h"
+#include "../util/File.h"
 #include "../util/StringUtils.h"
 #include "../util/Log.h"
 #include "../global/Id.h"
 #include "../global/Constants.h"
+#include "./PerfectHash.h"
 
 
 using std::string;
@@ -55,104 +59,201 @@ private:
   const size_t _prefixLength;
 };
 
-//! A vocabulary. Wraps a vector of strings
-//! and provides additional methods for retrieval.
+//! A word as stored in the vocabulary. Of externalized literals, only a
+//! prefix is stored inline. The full word is in a separate file.
+struct VocabularyEntry {
+  VocabularyEntry() : _external(false), _offset(0), _size(0) { }
+
+  string _text;
+  bool _external;
+  // Position and size of the full word in the external file.
+  uint64_t _offset;
+  uint64_t _size;
+};
+
+//! Appends words to a vocabulary in front-coded form.
+//! Words are grouped into blocks of VOCABULARY_BLOCK_SIZE. The first word
+//! of a block is stored in full, each other word as the length of the
+//! prefix it shares with its predecessor and the remaining suffix.
+//! All lengths are stored as varints. The lowest bit of the (suffix)
+//! length marks externalized words, they are followed by the offset
+//! and size of the full word.
+class FrontCodingEncoder {
+public:
+  FrontCodingEncoder() : _nofWords(0), _base(0) { }
+
+  void add(const string& word);
+
+  // Adds a word of which only a prefix is kept inline.
+  void addExternal(const string& word, uint64_t offset);
+
+  size_t nofWords() const {
+    return _nofWords;
+  }
+
+  // Forgets the encoded bytes, e.g. after they have been written to a file.
+  void flush() {
+    _base += _bytes.size();
+    _bytes.clear();
+  }
+
+  // Encoded bytes that have not been taken with flush.
+  vector<char> _bytes;
+  // Offsets of all block starts, relative to the first byte ever added.
+  vector<uint64_t> _blockStarts;
+
+private:
+  string _last;
+  size_t _nofWords;
+  uint64_t _base;
+
+  void append(const VocabularyEntry& entry);
+};
+
+//! A vocabulary of sorted words with dense ids.
+//! Words are stored front-coded (see FrontCodingEncoder). On disk, the
+//! blocks are followed by the block start offsets, the number of words and
+//! the start of the offsets:
+//!
+//! BLOCKS.blockStarts(uint64_t[]).nofWords(uint64_t).startOfOffsets(off_t)
+//!
+//! readFromFile memory-maps such a file. Lookups binary search the first
+//! words of the blocks and decode a single block.
+//!
+//! Literals longer than MAX_INLINE_LITERAL_SIZE are externalized when
+//! written with a Writer: the full words go to <file>.external and only
+//! their first EXTERNAL_LITERAL_PREFIX_SIZE bytes stay in the blocks.
+//! Ids are assigned by the order of the full words, as for all other
+//! words. The external file is only read if a lookup cannot be decided
+//! by the prefix or if the full word is requested with operator[].
+//!
+//! A Writer also builds a minimal perfect hash function from words to ids
+//! (<file>.mphf). If it exists, getId uses it instead of a binary search.
 class Vocabulary {
 public:
   Vocabulary();
 
   virtual ~Vocabulary();
 
-  //! Read the vocabulary from file.
+  Vocabulary(const Vocabulary&) = delete;
+
+  Vocabulary& operator=(const Vocabulary&) = delete;
+
+  //! Map the vocabulary from file.
   void readFromFile(const string& fileName);
 
   //! Write the vocabulary to a file.
   void writeToFile(const string& fileName) const;
 
-
-  //! Append a word to the vocabulary. Wraps the std::vector method.
-  void push_back(const string& word) {
-    _words.push_back(word);
+  //! Writes a vocabulary file word by word without keeping the words
+  //! in memory. Words have to be added in sorted order.
+  class Writer {
+  public:
+    explicit Writer(const string& fileName);
+
+    ~Writer();
+
+    void push_back(const string& word);
+
+    // Writes the block offsets. Called by the destructor if necessary.
+    void finish();
+
+  private:
+    string _fileName;
+    ad_utility::File _out;
+    ad_utility::File _external;
+    uint64_t _externalBytes;
+    FrontCodingEncoder _encoder;
+    // Hashes of all words with their ids, for the perfect hash function.
+    vector<std::pair<uint64_t, Id>> _hashes;
+    bool _finished;
+  };
+
+  //! True for words that a Writer stores in the external file.
+  static bool shouldBeExternalized(const string& word) {
+    return word.size() > MAX_INLINE_LITERAL_SIZE && word[0] == '"';
   }
 
-  //! Get the word with the given id (as const, not as lvalue).
-  const string& operator[](Id id) const {
-    return _words[static_cast<size_t>(id)];
-  }
+  //! Append a word to the vocabulary. Words have to be added in sorted order.
+  void push_back(const string& word);
+
+  //! Get the word with the given id.
+  //! Reads externalized words from disk.
+  string operator[](Id id) const;
 
   //! Get the number of words in the vocabulary.
   size_t size() const {
-    return _words.size();
-  }
-
-  //! Reserve space for the given number of words.
-  void reserve(unsigned int n) {
-    _words.reserve(n);
+    return _nofWords;
   }
 
-
   //! Get an Id from the vocabulary for some "normal" word.
   //! Return value signals if something was found at all.
-  bool getId(const string& word, Id* id) const {
-    *id = lower_bound(word);
-    return *id < _words.size() && _words[*id] == word;
+  //! If not, id is unspecified.
+  bool getId(const string& word, Id* id) const;
+
+  //! Get the Id of the first word that is not smaller than the given one,
+  //! the size of the vocabulary if there is none.
+  Id getLowerBoundId(const string& word) const {
+    return lower_bound(word);
   }
 
   //! Get an Id range that matches a prefix.
   //! Return value signals if something was found at all.
-  bool getIdRangeForFullTextPrefix(const string& word, IdRange* range) const {
-    AD_CHECK_EQ(word[word.size() - 1], PREFIX_CHAR);
-    range->_first = lower_bound(word.substr(0, word.size() - 1));
-    range->_last = upper_bound(word.substr(0, word.size() - 1), range->_first,
-        PrefixComparator(word.size() - 1)) - 1;
-    bool success = range->_first < _words.size()
-        && ad_utility::startsWith(_words[range->_first],
-        word.substr(0, word.size() - 1)) && range->_last < _words.size()
-        && ad_utility::startsWith(_words[range->_last],
-        word.substr(0, word.size() - 1))
-        && range->_first <= range->_last;
-    if (success) {
-      AD_CHECK_LT(range->_first, _words.size());
-      AD_CHECK_LT(range->_last, _words.size());
-    }
-    return success;
-  }
-
+  bool getIdRangeForFullTextPrefix(const string& word, IdRange* range) const;
 
   void createFromSet(const std::unordered_set<string>& set);
 
   std::unordered_map<string, Id> asMap();
 
 private:
+  // Either the words added with push_back ...
+  FrontCodingEncoder _encoder;
+  // ... or a mapped vocabulary file.
+  char* _mapping;
+  size_t _mappingBytes;
+  // The block start offsets in the mapping, read with memcpy.
+  const char* _mappedBlockStarts;
+  // File descriptor of the external words or -1.
+  int _externalFd;
+  PerfectHash _hash;
+  size_t _nofWords;
+  size_t _nofBlocks;
+
+  void unmap();
+
+  const char* blockData(size_t block) const;
+
+  // Compares the word with the given id to a word.
+  int compare(Id id, const string& word) const;
+
+  // Returns the first word of a block.
+  VocabularyEntry firstWordOfBlock(size_t block) const;
+
+  // Decodes the words of a block up to and including index last
+  // within the block and calls f(entry, index) for each. Stops early if
+  // f returns true. Returns the index at which it stopped or the number
+  // of decoded words.
+  template<class F>
+  size_t decodeBlock(size_t block, size_t last, F f) const;
+
+  // Returns the first id for which pred(entry) is true.
+  // pred has to be false for a prefix of the vocabulary and true for
+  // the rest. Decodes a single block.
+  template<class Pred>
+  Id findFirst(Pred pred) const;
+
+  // The full word of an entry, read from the external file if necessary.
+  string resolve(const VocabularyEntry& entry) const;
+
+  // Compares the full word of an entry to a word like string::compare.
+  // Only reads the external file if the word starts with the inline prefix.
+  int compare(const VocabularyEntry& entry, const string& word) const;
 
   // Wraps std::lower_bound and returns an index instead of an iterator
-  Id lower_bound(const string& word) const {
-    return static_cast<Id>(std::lower_bound(_words.begin(), _words.end(), word)
-        - _words.begin());
-  }
-
-  // Wraps std::lower_bound and returns an index instead of an iterator
-  Id lower_bound(const string& word, size_t first) const {
-    return static_cast<Id>(std::lower_bound(_words.begin() + first,
-        _words.end(), word) - _words.begin());
-  }
+  Id lower_bound(const string& word) const;
 
   // Wraps std::upper_bound and returns an index instead of an iterator
   // Only compares words that have at most word.size() or to prefixes of
   // that length otherwise.
-  Id upper_bound(const string& word, size_t first,
-      PrefixComparator comp) const {
-    AD_CHECK_LE(first, _words.size());
-    vector<string>::const_iterator it = std::upper_bound(
-        _words.begin() + first, _words.end(), word, comp);
-    Id retVal = (it == _words.end()) ?
-        size() : static_cast<Id>(it - _words.begin());
-    AD_CHECK_LE(retVal, size());
-    return retVal;
-  }
-
-  vector<string> _words;
+  Id upper_bound(const string& word, PrefixComparator comp) const;
 };
-
-
-
@@ -0,0 +1,150 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <utility>
+#include "../util/Exception.h"
+#include "../util/File.h"
+#include "../util/Log.h"
+#include "./Vocabulary.h"
+#include "./VocabularyMerger.h"
+
+using std::pair;
+
+namespace {
+// Orders pointers to words by the words they point to.
+struct DerefLess {
+  bool operator()(const pair<const string*, Id>& a,
+                  const pair<const string*, Id>& b) const {
+    return *a.first < *b.first;
+  }
+};
+}
+
+// _____________________________________________________________________________
+vector<pair<const string*, Id>> VocabularyMerger::sortChunk(
+    const std::unordered_map<string, Id>& words) {
+  vector<pair<const string*, Id>> sorted;
+  sorted.reserve(words.size());
+  for (auto it = words.begin(); it != words.end(); ++it) {
+    sorted.push_back(pair<const string*, Id>(&it->first, it->second));
+  }
+  std::sort(sorted.begin(), sorted.end(), DerefLess());
+  return sorted;
+}
+
+// _____________________________________________________________________________
+vector<Id> VocabularyMerger::writeVocabulary(
+    const std::unordered_map<string, Id>& words, const string& fileName) {
+  LOG(INFO) << "Writing vocabulary of " << words.size()
+            << " words to " << fileName << "\n";
+  vector<pair<const string*, Id>> sorted = sortChunk(words);
+  Vocabulary::Writer out(fileName);
+  vector<Id> localToRank(sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    out.push_back(*sorted[i].first);
+    localToRank[sorted[i].second] = i;
+  }
+  out.finish();
+  return localToRank;
+}
+
+// _____________________________________________________________________________
+vector<Id> VocabularyMerger::writePartialVocabulary(
+    const std::unordered_map<string, Id>& words, const string& fileName) {
+  LOG(INFO) << "Writing partial vocabulary of " << words.size()
+            << " words to " << fileName << "\n";
+  vector<pair<const string*, Id>> sorted = sortChunk(words);
+  std::ofstream out(fileName.c_str(), std::ios_base::out);
+  if (!out.is_open()) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not open partial vocabulary file " + fileName);
+  }
+  vector<Id> localToRank(sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (i > 0) {
+      out << '\n';
+    }
+    out << *sorted[i].first;
+    localToRank[sorted[i].second] = i;
+  }
+  out.close();
+  return localToRank;
+}
+
+// _____________________________________________________________________________
+size_t VocabularyMerger::mergePartialVocabularies(
+    const vector<string>& partialFiles, const string& outFile,
+    const vector<string>& idMapFiles) {
+  LOG(INFO) << "Merging " << partialFiles.size()
+            << " partial vocabularies into " << outFile << "\n";
+  AD_CHECK(idMapFiles.empty() || idMapFiles.size() == partialFiles.size());
+  vector<std::ifstream*> in;
+  vector<ad_utility::File*> idMaps;
+  in.reserve(partialFiles.size());
+  // Min-heap over the current head word of each partial vocabulary.
+  typedef pair<string, size_t> HeapEntry;
+  std::priority_queue<HeapEntry, vector<HeapEntry>,
+      std::greater<HeapEntry>> heap;
+  string line;
+  for (size_t i = 0; i < partialFiles.size(); ++i) {
+    in.push_back(new std::ifstream(partialFiles[i].c_str(),
+                                   std::ios_base::in));
+    if (!in.back()->is_open()) {
+      for (size_t j = 0; j < in.size(); ++j) { delete in[j]; }
+      for (size_t j = 0; j < idMaps.size(); ++j) { delete idMaps[j]; }
+      AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+               "Could not open partial vocabulary file " + partialFiles[i]);
+    }
+    if (!idMapFiles.empty()) {
+      idMaps.push_back(new ad_utility::File(idMapFiles[i].c_str(), "w"));
+    }
+    if (std::getline(*in[i], line)) {
+      heap.push(HeapEntry(line, i));
+    }
+  }
+
+  Vocabulary::Writer out(outFile);
+  size_t nofWords = 0;
+  string last;
+  while (!heap.empty()) {
+    HeapEntry top = heap.top();
+    heap.pop();
+    if (nofWords == 0 || top.first != last) {
+      out.push_back(top.first);
+      last.swap(top.first);
+      ++nofWords;
+    }
+    if (!idMaps.empty()) {
+      Id finalId = nofWords - 1;
+      idMaps[top.second]->write(&finalId, sizeof(finalId));
+    }
+    if (std::getline(*in[top.second], line)) {
+      heap.push(HeapEntry(line, top.second));
+    }
+  }
+  out.finish();
+  for (size_t i = 0; i < in.size(); ++i) {
+    in[i]->close();
+    delete in[i];
+  }
+  for (size_t i = 0; i < idMaps.size(); ++i) {
+    delete idMaps[i];
+  }
+  LOG(INFO) << "Done merging, vocabulary has " << nofWords << " words.\n";
+  return nofWords;
+}
+
+// _____________________________________________________________________________
+vector<Id> VocabularyMerger::readIdMap(const string& fileName) {
+  ad_utility::File f(fileName.c_str(), "r");
+  off_t nofBytes = f.sizeOfFile();
+  vector<Id> ids(static_cast<size_t>(nofBytes) / sizeof(Id));
+  if (ids.size() > 0) {
+    f.readFromBeginning(ids.data(), ids.size() * sizeof(Id));
+  }
+  return ids;
+}
@@ -0,0 +1,59 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include "../global/Id.h"
+
+using std::string;
+using std::vector;
+
+//! Builds a vocabulary that does not fit into memory as a whole.
+//! Distinct words are collected per chunk of the input, each chunk is
+//! sorted and spilled to disk as a partial vocabulary and the partial
+//! vocabularies are k-way merged into the final vocabulary file.
+//! Partial vocabularies hold one word per line, the merged vocabulary
+//! is written in the format of Vocabulary::writeToFile.
+class VocabularyMerger {
+public:
+  //! Sorts the words of a chunk and writes them to a partial vocabulary file.
+  //! The map assigns each word its chunk-local id (0 .. words.size() - 1).
+  //! Returns the rank of each word in sorted order, indexed by local id.
+  static vector<Id> writePartialVocabulary(
+      const std::unordered_map<string, Id>& words, const string& fileName);
+
+  //! Like writePartialVocabulary but writes a final vocabulary file.
+  //! Used if all words fit into a single chunk.
+  static vector<Id> writeVocabulary(
+      const std::unordered_map<string, Id>& words, const string& fileName);
+
+  //! Merges sorted partial vocabularies into one sorted vocabulary file
+  //! without duplicates. Returns the number of words written.
+  //! If idMapFiles is not empty, it has to contain one file name per
+  //! partial vocabulary. For each word of a partial vocabulary, in the
+  //! order of that file, its final id is written to the corresponding file.
+  static size_t mergePartialVocabularies(const vector<string>& partialFiles,
+                                         const string& outFile,
+                                         const vector<string>& idMapFiles);
+
+  //! Reads a file of ids as written by mergePartialVocabularies.
+  static vector<Id> readIdMap(const string& fileName);
+
+  //! Approximate number of bytes a word occupies inside the
+  //! hash map that collects a chunk.
+  static size_t approximateMemoryUsage(const string& word) {
+    return word.size() + BYTES_PER_MAP_ENTRY;
+  }
+
+private:
+  // Sorts the words of a chunk. Pairs of word and local id.
+  static vector<std::pair<const string*, Id>> sortChunk(
+      const std::unordered_map<string, Id>& words);
+
+  // Node, bucket pointer, hash, id and the string object itself.
+  static const size_t BYTES_PER_MAP_ENTRY = 72;
+};
@@ -3,6 +3,7 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include "../util/Exception.h"
 #include "./NTriplesParser.h"
@@ -22,58 +23,76 @@ NTriplesParser::~NTriplesParser() {
 // _____________________________________________________________________________
 bool NTriplesParser::getLine(array<string, 3>& res) {
   string line;
-  if (std::getline(_in, line)) {
-    size_t i = 0;
-    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {++i;}
-    assert(i < line.size());
-    size_t j = i + 1;
-    while (j < line.size() && line[j] != '\t' && line[j] != ' ') {++j;}
-    assert(j < line.size());
-    if (!(line[i] == '<' && line[j - 1] == '>')) {
-      AD_THROW(ad_semsearch::Exception::BAD_INPUT, "Illegal URI in : " + line);
-    }
-    res[0] = line.substr(i, j - i);
-    i = j;
-    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {++i;}
-    assert(i < line.size());
-    j = i + 1;
-    while (j < line.size() && line[j] != '\t' && line[j] != ' ') {++j;}
-    if (!(line[i] == '<' && line[j - 1] == '>')) {
-      AD_THROW(ad_semsearch::Exception::BAD_INPUT, "Illegal URI in : " + line);
-    }
-    res[1] = line.substr(i, j - i);
-    i = j;
-    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {++i;}
-    assert(i < line.size());
-    if (line[i] == '<') {
-      // URI
-      j = line.find('>', i + 1);
-      if (j == string::npos) {
-        AD_THROW(ad_semsearch::Exception::BAD_INPUT,
-            "Illegal URI in : " + line);
-      }
-      ++j;
-    } else {
-      // Literal
-      j = line.find('\"', i + 1);
-      while (j != string::npos && line[j - 1] == '\\') {
-        j = line.find('\"', j + 1);
-      }
-      if (j == string::npos) {
-        AD_THROW(ad_semsearch::Exception::BAD_INPUT,
-            "Illegal literal in : " + line);
+  while (std::getline(_in, line)) {
+    TripleRef t;
+    if (tokenize(line.data(), line.size(), t)) {
+      for (size_t i = 0; i < 3; ++i) {
+        res[i].assign(t[i]._begin, t[i]._size);
       }
+      return true;
+    }
+  }
+  return false;
+}
 
-      ++j;
-      while (j < line.size() && line[j] != ' ' && line[j] != '\t') {++j;}
+// _____________________________________________________________________________
+bool NTriplesParser::tokenize(const char* line, size_t length,
+                              TripleRef& res) {
+  size_t i = 0;
+  while (i < length && (line[i] == ' ' || line[i] == '\t')) {++i;}
+  if (i == length) {
+    // Empty line.
+    return false;
+  }
+  size_t j = i + 1;
+  while (j < length && line[j] != '\t' && line[j] != ' ') {++j;}
+  if (!(j < length && line[i] == '<' && line[j - 1] == '>')) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Illegal URI in : " + string(line, length));
+  }
+  res[0]._begin = line + i;
+  res[0]._size = j - i;
+  i = j;
+  while (i < length && (line[i] == ' ' || line[i] == '\t')) {++i;}
+  j = i + 1;
+  while (j < length && line[j] != '\t' && line[j] != ' ') {++j;}
+  if (!(j < length && line[i] == '<' && line[j - 1] == '>')) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Illegal URI in : " + string(line, length));
+  }
+  res[1]._begin = line + i;
+  res[1]._size = j - i;
+  i = j;
+  while (i < length && (line[i] == ' ' || line[i] == '\t')) {++i;}
+  if (i == length) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Missing object in : " + string(line, length));
+  }
+  if (line[i] == '<') {
+    // URI
+    const char* close = static_cast<const char*>(
+        memchr(line + i + 1, '>', length - i - 1));
+    if (!close) {
+      AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+               "Illegal URI in : " + string(line, length));
     }
-    assert(j < line.size());
-    res[2] = line.substr(i, j - i);
-    if (!(line[j] == ' ' || line[j] == '\t')) {
+    j = close - line + 1;
+  } else {
+    // Literal
+    j = i + 1;
+    while (j < length && (line[j] != '\"' || line[j - 1] == '\\')) {++j;}
+    if (j == length) {
       AD_THROW(ad_semsearch::Exception::BAD_INPUT,
-          "Object not followed by space in : " + line);
+               "Illegal literal in : " + string(line, length));
     }
-    return true;
+    ++j;
+    while (j < length && line[j] != ' ' && line[j] != '\t') {++j;}
   }
-  return false;
+  if (!(j < length && (line[j] == ' ' || line[j] == '\t'))) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Object not followed by space in : " + string(line, length));
+  }
+  res[2]._begin = line + i;
+  res[2]._size = j - i;
+  return true;
 }
@@ -0,0 +1,258 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../global/Constants.h"
+#include "../global/Id.h"
+#include "../global/ValueId.h"
+#include "../util/BoundedQueue.h"
+#include "../util/Exception.h"
+
+using std::string;
+using std::array;
+using std::vector;
+
+//! A field of a line, points into the buffer the line was read into.
+struct FieldRef {
+  const char* _begin;
+  size_t _size;
+};
+
+typedef array<FieldRef, 3> TripleRef;
+
+//! The triples of a chunk with their fields replaced by ids. Fields that
+//! ValueId::fromString encodes get their value id, all others the index
+//! of the field in _words, the distinct words of the chunk.
+struct IdChunk {
+  vector<string> _words;
+  vector<array<Id, 3>> _triples;
+};
+
+//! Parses a file of triples, one per line, with several threads.
+//! The input is read in blocks that are cut at line boundaries. Worker
+//! threads split each chunk into triples of FieldRefs using
+//! Tokenizer::tokenize(const char* line, size_t length, TripleRef& res)
+//! and hand them to the consumer through a bounded queue.
+//! getLine returns the triples in the order of the input file.
+//! With assignIds, the workers also assign the chunk-local ids of
+//! IdChunk and getIdChunk returns the chunks in the order of the file,
+//! so that the consumer only looks up each distinct word of a chunk.
+template<class Tokenizer>
+class ParallelParser {
+public:
+  explicit ParallelParser(const string& file,
+                          size_t nofThreads = defaultNofThreads(),
+                          size_t chunkSize = PARSER_CHUNK_SIZE,
+                          bool assignIds = false) :
+      _in(file.c_str(), std::ios_base::in | std::ios_base::binary),
+      _chunkSize(chunkSize),
+      _assignIds(assignIds),
+      _inputDone(!_in.good()),
+      _nextSeq(0),
+      _activeWorkers(nofThreads),
+      _results(2 * nofThreads),
+      _pos(0) {
+    AD_CHECK_GT(nofThreads, 0);
+    for (size_t i = 0; i < nofThreads; ++i) {
+      _workers.push_back(std::thread(&ParallelParser::work, this));
+    }
+  }
+
+  ~ParallelParser() {
+    _results.abort();
+    {
+      std::lock_guard<std::mutex> lock(_inputMutex);
+      _inputDone = true;
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+      _workers[i].join();
+    }
+    _in.close();
+  }
+
+  // Don't allow copy & assignment
+  explicit ParallelParser(const ParallelParser& other) = delete;
+  ParallelParser& operator=(const ParallelParser& other) = delete;
+
+  // Get the next line from the file.
+  // Returns true if something was stored.
+  bool getLine(array<string, 3>& res) {
+    AD_CHECK(!_assignIds);
+    while (!_current || _pos >= _current->_triples.size()) {
+      if (!nextChunk()) {
+        return false;
+      }
+      _pos = 0;
+    }
+    const TripleRef& t = _current->_triples[_pos++];
+    for (size_t i = 0; i < 3; ++i) {
+      res[i].assign(t[i]._begin, t[i]._size);
+    }
+    return true;
+  }
+
+  // Get the triples of the next chunk, only if the parser assigns ids.
+  // Returns true if something was stored, chunks may be empty.
+  bool getIdChunk(IdChunk& res) {
+    AD_CHECK(_assignIds);
+    if (!nextChunk()) {
+      return false;
+    }
+    std::swap(res, _current->_ids);
+    return true;
+  }
+
+  static size_t defaultNofThreads() {
+    size_t n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+  }
+
+private:
+  struct Chunk {
+    string _data;
+    vector<TripleRef> _triples;
+    IdChunk _ids;
+    std::exception_ptr _error;
+  };
+
+  std::ifstream _in;
+  size_t _chunkSize;
+  bool _assignIds;
+  bool _inputDone;
+  size_t _nextSeq;
+  // The incomplete last line of the previous block.
+  string _carry;
+  std::mutex _inputMutex;
+
+  size_t _activeWorkers;
+  vector<std::thread> _workers;
+  ad_utility::BoundedQueue<std::unique_ptr<Chunk>> _results;
+
+  std::unique_ptr<Chunk> _current;
+  size_t _pos;
+
+  // Makes the next chunk in file order the current one.
+  bool nextChunk() {
+    if (!_results.pop(_current)) {
+      return false;
+    }
+    if (_current->_error) {
+      std::rethrow_exception(_current->_error);
+    }
+    return true;
+  }
+
+  // Reads the next block of whole lines into data.
+  // Returns false if the input is exhausted.
+  bool readChunk(string& data, size_t* seq) {
+    std::lock_guard<std::mutex> lock(_inputMutex);
+    if (_inputDone) {
+      return false;
+    }
+    data.swap(_carry);
+    _carry.clear();
+    size_t searchFrom = 0;
+    while (true) {
+      size_t old = data.size();
+      data.resize(old + _chunkSize);
+      _in.read(&data[old], _chunkSize);
+      data.resize(old + static_cast<size_t>(_in.gcount()));
+      if (!_in.good()) {
+        _inputDone = true;
+        break;
+      }
+      size_t lastNewline = data.rfind('\n');
+      if (lastNewline != string::npos && lastNewline >= searchFrom) {
+        _carry.assign(data, lastNewline + 1, string::npos);
+        data.resize(lastNewline + 1);
+        break;
+      }
+      // A single line longer than the chunk size, keep reading.
+      searchFrom = data.size();
+    }
+    *seq = _nextSeq++;
+    return true;
+  }
+
+  void tokenizeChunk(Chunk& chunk) {
+    const char* p = chunk._data.data();
+    const char* end = p + chunk._data.size();
+    while (p < end) {
+      const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (!eol) {
+        eol = end;
+      }
+      TripleRef t;
+      if (eol > p && Tokenizer::tokenize(p, eol - p, t)) {
+        chunk._triples.push_back(t);
+      }
+      p = eol + 1;
+    }
+  }
+
+  // Replaces the triples of a tokenized chunk by ids, cf. IdChunk.
+  static void assignChunkIds(Chunk& chunk) {
+    IdChunk& ids = chunk._ids;
+    std::unordered_map<string, Id> wordIds;
+    ids._triples.resize(chunk._triples.size());
+    string word;
+    for (size_t i = 0; i < chunk._triples.size(); ++i) {
+      for (size_t k = 0; k < 3; ++k) {
+        word.assign(chunk._triples[i][k]._begin, chunk._triples[i][k]._size);
+        Id& id = ids._triples[i][k];
+        if (ValueId::fromString(word, &id)) {
+          continue;
+        }
+        auto it = wordIds.find(word);
+        if (it == wordIds.end()) {
+          id = ids._words.size();
+          wordIds.emplace(word, id);
+          ids._words.push_back(word);
+        } else {
+          id = it->second;
+        }
+      }
+    }
+    // Only the ids are handed on.
+    vector<TripleRef>().swap(chunk._triples);
+    string().swap(chunk._data);
+  }
+
+  void work() {
+    while (true) {
+      std::unique_ptr<Chunk> chunk(new Chunk());
+      size_t seq;
+      if (!readChunk(chunk->_data, &seq)) {
+        break;
+      }
+      try {
+        tokenizeChunk(*chunk);
+        if (_assignIds) {
+          assignChunkIds(*chunk);
+        }
+      } catch (...) {
+        chunk->_triples.clear();
+        chunk->_ids = IdChunk();
+        chunk->_error = std::current_exception();
+      }
+      if (!_results.push(seq, std::move(chunk))) {
+        break;
+      }
+    }
+    std::lock_guard<std::mutex> lock(_inputMutex);
+    if (--_activeWorkers == 0) {
+      _results.close();
+    }
+  }
+};
@@ -74,6 +74,19 @@ string SparqlTriple::asString() const {
   return os.str();
 }
 
+// _____________________________________________________________________________
+const char* SparqlFilter::typeAsString(FilterType type) {
+  switch (type) {
+    case EQ: return "==";
+    case NE: return "!=";
+    case LT: return "<";
+    case LE: return "<=";
+    case GT: return ">";
+    case GE: return ">=";
+  }
+  return "?";
+}
+
 // _____________________________________________________________________________
 void ParsedQuery::expandPrefixes() {
   std::unordered_map<string, string> prefixMap;
@@ -86,6 +99,9 @@ void ParsedQuery::expandPrefixes() {
     expandPrefix(trip._p, prefixMap);
     expandPrefix(trip._o, prefixMap);
   }
+  for (auto& filter: _filters) {
+    expandPrefix(filter._rhs, prefixMap);
+  }
 }
 
 // _____________________________________________________________________________
@@ -69,7 +69,10 @@ public:
 
   FilterType _type;
   string _lhs;
+  // A variable or a constant.
   string _rhs;
+
+  static const char* typeAsString(FilterType type);
 };
 
 // A parsed SPARQL query. To be extended.
@@ -8,6 +8,7 @@
 #include "./ParseException.h"
 #include "../util/Exception.h"
 #include "../global/Constants.h"
+#include "../global/ValueId.h"
 
 // _____________________________________________________________________________
 ParsedQuery SparqlParser::parse(const string& query) {
@@ -274,14 +275,19 @@ void SparqlParser::addFilter(const string& str, ParsedQuery& query) {
     AD_THROW(ad_semsearch::Exception::BAD_QUERY,
              "Unknown syntax for filter: " + filter);
   }
-  if (tokens[0].size() == 0 || tokens[0][0] != '?' || tokens[2].size() == 0 ||
-      tokens[2][0] != '?') {
+  // The rhs may also be a constant, the lhs has to be a variable.
+  if (tokens[0].size() == 0 || tokens[0][0] != '?' || tokens[2].size() == 0) {
     AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
              "Filter not supported yet: " + filter);
   }
   SparqlFilter f;
   f._lhs = tokens[0];
   f._rhs = tokens[2];
+  // Numbers are values, like the typed literals they stand for.
+  string literal;
+  if (ValueId::typedLiteralForNumber(f._rhs, &literal)) {
+    f._rhs = literal;
+  }
 
   if (tokens[1] == "=" || tokens[1] == "==") {
     f._type = SparqlFilter::EQ;
@@ -291,7 +297,7 @@ void SparqlParser::addFilter(const string& str, ParsedQuery& query) {
     f._type = SparqlFilter::LT;
   } else if (tokens[1] == "<=") {
     f._type = SparqlFilter::LE;
-  } else if (tokens[1] == "<") {
+  } else if (tokens[1] == ">") {
     f._type = SparqlFilter::GT;
   } else if (tokens[1] == ">=") {
     f._type = SparqlFilter::GE;
@@ -3,8 +3,10 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include "./TsvParser.h"
+#include "../util/Exception.h"
 #include "../util/Log.h"
 
 // _____________________________________________________________________________
@@ -19,17 +21,40 @@ TsvParser::~TsvParser() {
 // _____________________________________________________________________________
 bool TsvParser::getLine(array<string, 3>& res) {
   string line;
-  if (std::getline(_in, line)) {
-    size_t i = line.find('\t');
-    assert(i != string::npos);
-    size_t j = line.find('\t', i + 1);
-    assert(j != string::npos);
-    size_t k = line.find('\t', j + 1);
-    assert(k != string::npos);
-    res[0] = line.substr(0, i);
-    res[1] = line.substr(i + 1, j - (i + 1));
-    res[2] = line.substr(j + 1, k - (j + 1));
-    return true;
+  while (std::getline(_in, line)) {
+    TripleRef t;
+    if (tokenize(line.data(), line.size(), t)) {
+      for (size_t i = 0; i < 3; ++i) {
+        res[i].assign(t[i]._begin, t[i]._size);
+      }
+      return true;
+    }
   }
   return false;
 }
+
+// _____________________________________________________________________________
+bool TsvParser::tokenize(const char* line, size_t length, TripleRef& res) {
+  if (length == 0) {
+    return false;
+  }
+  const char* end = line + length;
+  const char* i = static_cast<const char*>(memchr(line, '\t', length));
+  const char* j = i ? static_cast<const char*>(memchr(i + 1, '\t', end - i - 1))
+                    : nullptr;
+  if (!j) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Less than three columns in : " + string(line, length));
+  }
+  const char* k = static_cast<const char*>(memchr(j + 1, '\t', end - j - 1));
+  if (!k) {
+    k = end;
+  }
+  res[0]._begin = line;
+  res[0]._size = i - line;
+  res[1]._begin = i + 1;
+  res[1]._size = j - (i + 1);
+  res[2]._begin = j + 1;
+  res[2]._size = k - (j + 1);
+  return true;
+}
@@ -6,6 +6,7 @@
 #include <array>
 #include <string>
 #include <fstream>
+#include "./ParallelParser.h"
 
 using std::string;
 using std::array;
@@ -22,7 +23,15 @@ public:
   // Returns true if something was stored.
   bool getLine(array<string, 3>&);
 
+  // Splits a single line into its three fields without copying them.
+  // Returns false if the line does not contain a triple,
+  // throws on malformed input.
+  static bool tokenize(const char* line, size_t length, TripleRef& res);
+
 
 private:
   std::ifstream _in;
-};
\ No newline at end of file
+};
+
+//! Parses TSV files on several threads, cf. ParallelParser.
+typedef ParallelParser<TsvParser> ParallelTsvParser;
\ No newline at end of file
@@ -0,0 +1,164 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using std::list;
+using std::shared_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace ad_utility {
+//! Cache for blocks read from files, keyed by (file id, offset, length).
+//! Holds the blocks decoded, in whatever form the reader wants them.
+//! A range of a file must always be decoded to the same type T.
+//! The capacity is in bytes, as given by the callers on insert, and split
+//! evenly among shards with their own lock and LRU list, so concurrent
+//! readers rarely wait for each other. Blocks are shared, a block that is
+//! evicted stays valid for those that still use it.
+class BlockCache {
+  public:
+    struct Key {
+      //! Identifies the file. A file that replaces another one while its
+      //! blocks may still be inserted needs a new id, an address is not
+      //! enough since it can be reused.
+      uint64_t _fileId;
+      off_t _offset;
+      size_t _nofBytes;
+
+      bool operator==(const Key& other) const {
+        return _fileId == other._fileId && _offset == other._offset &&
+            _nofBytes == other._nofBytes;
+      }
+    };
+
+    explicit BlockCache(size_t capacityInBytes, size_t nofShards = 16) :
+        _shards(nofShards), _nofHits(0), _nofMisses(0) {
+      setCapacity(capacityInBytes);
+    }
+
+    //! The cached block or null. Counts a hit or a miss.
+    template<class T>
+    shared_ptr<const T> get(const Key& key) {
+      Shard& shard = getShard(key);
+      std::lock_guard<std::mutex> lock(shard._mutex);
+      auto it = shard._map.find(key);
+      if (it == shard._map.end()) {
+        ++_nofMisses;
+        return shared_ptr<const T>();
+      }
+      ++_nofHits;
+      shard._entries.splice(shard._entries.begin(), shard._entries,
+          it->second);
+      return std::static_pointer_cast<const T>(it->second->_block);
+    }
+
+    //! Adds a block of the given size. Blocks larger than a shard
+    //! are not cached.
+    template<class T>
+    void insert(const Key& key, const shared_ptr<const T>& block,
+        size_t nofBytes) {
+      Shard& shard = getShard(key);
+      std::lock_guard<std::mutex> lock(shard._mutex);
+      if (nofBytes > shard._capacity || shard._map.count(key) > 0) {
+        return;
+      }
+      Entry entry;
+      entry._key = key;
+      entry._block = block;
+      entry._nofBytes = nofBytes;
+      shard._entries.push_front(entry);
+      shard._map[key] = shard._entries.begin();
+      shard._nofBytes += nofBytes;
+      evict(&shard);
+    }
+
+    //! Set the capacity, 0 disables the cache.
+    void setCapacity(size_t capacityInBytes) {
+      for (size_t i = 0; i < _shards.size(); ++i) {
+        std::lock_guard<std::mutex> lock(_shards[i]._mutex);
+        _shards[i]._capacity = capacityInBytes / _shards.size();
+        evict(&_shards[i]);
+      }
+    }
+
+    void clear() {
+      for (size_t i = 0; i < _shards.size(); ++i) {
+        std::lock_guard<std::mutex> lock(_shards[i]._mutex);
+        _shards[i]._entries.clear();
+        _shards[i]._map.clear();
+        _shards[i]._nofBytes = 0;
+      }
+    }
+
+    size_t getNofHits() const {
+      return _nofHits;
+    }
+
+    size_t getNofMisses() const {
+      return _nofMisses;
+    }
+
+    //! Total size of the cached blocks.
+    size_t getSizeInBytes() const {
+      size_t nofBytes = 0;
+      for (size_t i = 0; i < _shards.size(); ++i) {
+        std::lock_guard<std::mutex> lock(_shards[i]._mutex);
+        nofBytes += _shards[i]._nofBytes;
+      }
+      return nofBytes;
+    }
+
+  private:
+    struct Entry {
+      Key _key;
+      shared_ptr<const void> _block;
+      size_t _nofBytes;
+    };
+
+    struct KeyHash {
+      size_t operator()(const Key& key) const {
+        size_t h = std::hash<uint64_t>()(key._fileId);
+        h = h * 31 + std::hash<off_t>()(key._offset);
+        return h * 31 + std::hash<size_t>()(key._nofBytes);
+      }
+    };
+
+    struct Shard {
+      Shard() : _capacity(0), _nofBytes(0) { }
+      mutable std::mutex _mutex;
+      list<Entry> _entries;
+      unordered_map<Key, list<Entry>::iterator, KeyHash> _map;
+      size_t _capacity;
+      size_t _nofBytes;
+    };
+
+    vector<Shard> _shards;
+    std::atomic<size_t> _nofHits;
+    std::atomic<size_t> _nofMisses;
+
+    Shard& getShard(const Key& key) {
+      return _shards[KeyHash()(key) % _shards.size()];
+    }
+
+    // Removes the least recently used blocks until the shard fits.
+    static void evict(Shard* shard) {
+      while (shard->_nofBytes > shard->_capacity) {
+        shard->_nofBytes -= shard->_entries.back()._nofBytes;
+        shard->_map.erase(shard->_entries.back()._key);
+        shard->_entries.pop_back();
+      }
+    }
+};
+}
@@ -0,0 +1,83 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace ad_utility {
+//! Hands elements from several producer threads to a single consumer.
+//! Every element carries a sequence number and the consumer gets them in
+//! exactly that order. At most capacity elements are buffered; a producer
+//! that is too far ahead of the consumer blocks in push.
+template<class T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) :
+      _capacity(capacity), _next(0), _closed(false), _aborted(false) {
+  }
+
+  // Adds the element with the given sequence number.
+  // Returns false if the queue has been aborted, the element is dropped then.
+  bool push(size_t seq, T&& value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [this, seq] {
+      return _aborted || seq < _next + _capacity;
+    });
+    if (_aborted) {
+      return false;
+    }
+    _elements.insert(std::make_pair(seq, std::move(value)));
+    _notEmpty.notify_all();
+    return true;
+  }
+
+  // Gets the next element in sequence.
+  // Returns false once the queue is closed and the next element will never
+  // arrive, or if the queue has been aborted.
+  bool pop(T& value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] {
+      return _aborted || _closed || _elements.count(_next) > 0;
+    });
+    auto it = _elements.find(_next);
+    if (_aborted || it == _elements.end()) {
+      return false;
+    }
+    value = std::move(it->second);
+    _elements.erase(it);
+    ++_next;
+    _notFull.notify_all();
+    return true;
+  }
+
+  // Signals that no more elements will be pushed.
+  // Elements already in the queue can still be popped.
+  void close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _notEmpty.notify_all();
+  }
+
+  // Wakes up everybody and makes all further operations fail.
+  void abort() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _aborted = true;
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+  }
+
+private:
+  size_t _capacity;
+  size_t _next;
+  bool _closed;
+  bool _aborted;
+  std::map<size_t, T> _elements;
+  std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+};
+}
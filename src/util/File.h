@@ -7,6 +7,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <string.h>
 #include <string>
@@ -74,6 +76,11 @@ class File {
       return true;
     }
 
+    //! Checks if a file with the given name exists.
+    static bool exists(const string& path) {
+      return access(path.c_str(), F_OK) == 0;
+    }
+
     //! checks if the file is open.
     bool isOpen() const {
       return (_file != NULL);
@@ -174,14 +181,92 @@ class File {
       return (fseeko(_file, seekOffset, seekOrigin) == 0);
     }
 
-    //! Move file pointer to desired position
-    //! (offset from file beginning) and start reading from there
+    //! Read from the desired position (offset from file beginning).
+    //! Uses pread and does not move the file pointer, so several threads
+    //! may read from the same file at the same time. Does not see data
+    //! that is still in the write buffer.
     //! returns number of bytes read
     size_t read(void* targetBuffer, size_t nofBytesToRead,
-        off_t seekOffsetFromStart) {
+        off_t seekOffsetFromStart) const {
       assert(_file);
-      if (!seek(seekOffsetFromStart, SEEK_SET)) return 0;
-      return read(targetBuffer, nofBytesToRead);
+      char* target = static_cast<char*>(targetBuffer);
+      size_t nofBytesRead = 0;
+      while (nofBytesRead < nofBytesToRead) {
+        ssize_t ret = pread(fileno(_file), target + nofBytesRead,
+            nofBytesToRead - nofBytesRead,
+            seekOffsetFromStart + static_cast<off_t>(nofBytesRead));
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) break;
+        nofBytesRead += static_cast<size_t>(ret);
+      }
+      return nofBytesRead;
+    }
+
+    //! A single read for readBatch.
+    struct ReadRequest {
+      void* _buffer;
+      size_t _nofBytes;
+      off_t _offset;
+    };
+
+    //! Performs several positional reads. Consecutive requests that
+    //! continue where the previous one ended are read with a single
+    //! preadv. Thread-safe like read with an offset.
+    //! Returns true iff all requests have been read completely.
+    bool readBatch(const vector<ReadRequest>& requests) const {
+      assert(_file);
+      vector<struct iovec> iov;
+      size_t i = 0;
+      while (i < requests.size()) {
+        iov.clear();
+        off_t from = requests[i]._offset;
+        off_t to = from;
+        size_t j = i;
+        while (j < requests.size() && requests[j]._offset == to &&
+            iov.size() < IOV_MAX) {
+          struct iovec v;
+          v.iov_base = requests[j]._buffer;
+          v.iov_len = requests[j]._nofBytes;
+          iov.push_back(v);
+          to += static_cast<off_t>(requests[j]._nofBytes);
+          ++j;
+        }
+        ssize_t ret;
+        do {
+          ret = preadv(fileno(_file), iov.data(), static_cast<int>(iov.size()),
+              from);
+        } while (ret < 0 && errno == EINTR);
+        if (ret != to - from) {
+          // Short read, retry request by request.
+          for (size_t k = i; k < j; ++k) {
+            if (read(requests[k]._buffer, requests[k]._nofBytes,
+                requests[k]._offset) != requests[k]._nofBytes) {
+              return false;
+            }
+          }
+        }
+        i = j;
+      }
+      return true;
+    }
+
+    //! Reads the line that starts at the given offset, like readLine
+    //! but with pread, see read with an offset.
+    //! Returns false if there is no data at the offset.
+    bool readLine(string* line, char* buf, size_t bufferSize,
+        off_t offset) const {
+      assert(bufferSize > 0);
+      size_t nofBytes = read(buf, bufferSize, offset);
+      if (nofBytes == 0) {
+        return false;
+      }
+      char* end = static_cast<char*>(memchr(buf, '\n', nofBytes));
+      if (!end && nofBytes == bufferSize) {
+        AD_THROW(ad_semsearch::Exception::INVALID_PARAMETER_VALUE,
+            "Buffer too small when reading from file: " + _name + ".");
+      }
+      line->assign(buf, end ? end - buf : nofBytes);
+      return true;
     }
 
     //! Returns the number of bytes from the beginning
@@ -7,6 +7,13 @@
 #include <algorithm>
 #include <assert.h>
 
+// The AVX2 decoder is compiled for x86 regardless of the target flags and
+// selected at runtime if the CPU supports it.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AD_SIMPLE8B_AVX2
+#include <immintrin.h>
+#endif
+
 namespace ad_utility {
 
   //! Selector mask,
@@ -131,21 +138,201 @@ namespace ad_utility {
     // ! The overhead is included so that no check for noundaries
     // ! is necessary inside the decoding of a single codeword.
     template<typename Numeric>
-    static void decode(uint64_t* encoded, size_t nofElements,
+    static void decode(const uint64_t* encoded, size_t nofElements,
                        Numeric* decoded) {
-      uint64_t word;
-      // Loop over full 64bit codewords and
-      for (size_t nofElementsDone(0), nofCodeWordsDone(0),
-           selector(encoded[nofCodeWordsDone] & SIMPLE8B_SELECTOR_MASK);
-           nofElementsDone < nofElements; ++nofCodeWordsDone,
-           selector = encoded[nofCodeWordsDone] & SIMPLE8B_SELECTOR_MASK) {
-        word = encoded[nofCodeWordsDone] >> 4;
-        for (size_t i(0); i < SIMPLE8B_SELECTORS[selector]._groupSize;
-             ++i) {
-          decoded[nofElementsDone++] = word & SIMPLE8B_SELECTORS[selector]._mask;
-          word >>= SIMPLE8B_SELECTORS[selector]._itemWidth;
+      PlainTransform<Numeric> transform;
+      decodeDispatch(encoded, nofElements, decoded, transform);
+    }
+
+    // ! Decodes a gap-encoded list and turns the gaps into the actual
+    // ! values while decoding, i.e. decoded[i] = base + sum of the first
+    // ! i + 1 gaps. Same requirements on decoded as decode.
+    template<typename Numeric>
+    static void decodeGaps(const uint64_t* encoded, size_t nofElements,
+                           Numeric* decoded, Numeric base = 0) {
+      GapTransform<Numeric> transform(base);
+      decodeDispatch(encoded, nofElements, decoded, transform);
+    }
+
+    // ! Decodes a list of codes and replaces each by its codebook entry
+    // ! while decoding, i.e. decoded[i] = codebook[code i].
+    // ! Same requirements on decoded as decode. The codebook must not be
+    // ! empty, the overhead behind the last element is filled with
+    // ! codebook[0].
+    template<typename Numeric>
+    static void decodeWithCodebook(const uint64_t* encoded,
+                                   size_t nofElements,
+                                   const Numeric* codebook,
+                                   Numeric* decoded) {
+      CodebookTransform<Numeric> transform(codebook);
+      decodeDispatch(encoded, nofElements, decoded, transform);
+    }
+
+    // ! Whether decoding uses the AVX2 code path. True by default if the
+    // ! CPU supports it. Can be set to false, e.g. to compare both paths.
+    static bool& simdEnabled() {
+      static bool enabled = cpuSupportsSimd();
+      return enabled;
+    }
+
+    // ! Whether the CPU we run on supports the AVX2 code path.
+    static bool cpuSupportsSimd() {
+#ifdef AD_SIMPLE8B_AVX2
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+   private:
+
+    template<typename Numeric, typename T>
+    static void decodeDispatch(const uint64_t* encoded, size_t nofElements,
+                               Numeric* decoded, T& transform) {
+#ifdef AD_SIMPLE8B_AVX2
+      if (simdEnabled()) {
+        decodeAvx2(encoded, nofElements, decoded, transform);
+        return;
+      }
+#endif
+      decodeScalar(encoded, nofElements, decoded, transform);
+    }
+
+    // Loop over full 64bit codewords. Only read the selector of a word
+    // that is needed, the list may end right after the last one.
+    template<typename Numeric, typename T>
+    static void decodeScalar(const uint64_t* encoded, size_t nofElements,
+                             Numeric* decoded, T& transform) {
+      for (size_t nofElementsDone(0), nofCodeWordsDone(0);
+           nofElementsDone < nofElements; ++nofCodeWordsDone) {
+        size_t selector = encoded[nofCodeWordsDone] & SIMPLE8B_SELECTOR_MASK;
+        uint64_t word = encoded[nofCodeWordsDone] >> 4;
+        const auto& sel = SIMPLE8B_SELECTORS[selector];
+        for (size_t i(0); i < sel._groupSize; ++i) {
+          decoded[nofElementsDone++] = transform(word & sel._mask);
+          word >>= sel._itemWidth;
         }
       }
     }
+
+#ifdef AD_SIMPLE8B_AVX2
+    // Extracts four items of a codeword at once with variable shifts.
+    // Items past the end of the group come out as 0, either because the
+    // shift exceeds the word or because the encoder leaves those bits 0.
+    // Hence transforms may process all four lanes unconditionally.
+    template<typename Numeric, typename T>
+    __attribute__((target("avx2")))
+    static void decodeAvx2(const uint64_t* encoded, size_t nofElements,
+                           Numeric* decoded, T& transform) {
+      for (size_t nofElementsDone(0), nofCodeWordsDone(0);
+           nofElementsDone < nofElements; ++nofCodeWordsDone) {
+        uint64_t codeword = encoded[nofCodeWordsDone];
+        const auto& sel = SIMPLE8B_SELECTORS[codeword & SIMPLE8B_SELECTOR_MASK];
+        if (sel._itemWidth == 0) {
+          transform.zeros(decoded + nofElementsDone, sel._groupSize);
+          nofElementsDone += sel._groupSize;
+          continue;
+        }
+        const long long w = sel._itemWidth;
+        __m256i word = _mm256_set1_epi64x(static_cast<long long>(codeword));
+        __m256i mask = _mm256_set1_epi64x(static_cast<long long>(sel._mask));
+        __m256i shifts = _mm256_set_epi64x(4 + 3 * w, 4 + 2 * w, 4 + w, 4);
+        __m256i step = _mm256_set1_epi64x(4 * w);
+        for (size_t i(0); i < sel._groupSize; i += 4) {
+          __m256i items = _mm256_and_si256(
+              _mm256_srlv_epi64(word, shifts), mask);
+          transform.four(items, decoded + nofElementsDone + i);
+          shifts = _mm256_add_epi64(shifts, step);
+        }
+        nofElementsDone += sel._groupSize;
+      }
+    }
+
+    template<typename Numeric>
+    __attribute__((target("avx2")))
+    static void store4(__m256i items, Numeric* out) {
+      if (sizeof(Numeric) == sizeof(uint64_t)) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), items);
+      } else {
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), items);
+        for (size_t i = 0; i < 4; ++i) {
+          out[i] = static_cast<Numeric>(lanes[i]);
+        }
+      }
+    }
+#endif
+
+    // Transforms applied to each decoded item. The AVX2 path calls zeros
+    // for runs of selectors 0 and 1 and four for four items at once.
+    template<typename Numeric>
+    struct PlainTransform {
+      Numeric operator()(uint64_t item) {
+        return static_cast<Numeric>(item);
+      }
+      void zeros(Numeric* out, size_t n) {
+        std::fill(out, out + n, Numeric(0));
+      }
+#ifdef AD_SIMPLE8B_AVX2
+      __attribute__((target("avx2")))
+      void four(__m256i items, Numeric* out) {
+        store4(items, out);
+      }
+#endif
+    };
+
+    template<typename Numeric>
+    struct GapTransform {
+      explicit GapTransform(Numeric base) : _current(base) {}
+      Numeric operator()(uint64_t item) {
+        _current += static_cast<Numeric>(item);
+        return _current;
+      }
+      void zeros(Numeric* out, size_t n) {
+        std::fill(out, out + n, _current);
+      }
+#ifdef AD_SIMPLE8B_AVX2
+      // Prefix sum over the four lanes in two shift-and-add steps.
+      // Sums wrap around at 64 bits before they are narrowed to Numeric,
+      // the same result as summing in Numeric directly.
+      __attribute__((target("avx2")))
+      void four(__m256i items, Numeric* out) {
+        __m256i zero = _mm256_setzero_si256();
+        items = _mm256_add_epi64(items, _mm256_blend_epi32(
+            zero, _mm256_permute4x64_epi64(items, 0x90), 0xFC));
+        items = _mm256_add_epi64(items, _mm256_blend_epi32(
+            zero, _mm256_permute4x64_epi64(items, 0x40), 0xF0));
+        items = _mm256_add_epi64(items, _mm256_set1_epi64x(
+            static_cast<long long>(_current)));
+        store4(items, out);
+        _current = out[3];
+      }
+#endif
+      Numeric _current;
+    };
+
+    template<typename Numeric>
+    struct CodebookTransform {
+      explicit CodebookTransform(const Numeric* codebook)
+          : _codebook(codebook) {}
+      Numeric operator()(uint64_t item) {
+        return _codebook[item];
+      }
+      void zeros(Numeric* out, size_t n) {
+        std::fill(out, out + n, _codebook[0]);
+      }
+#ifdef AD_SIMPLE8B_AVX2
+      __attribute__((target("avx2")))
+      void four(__m256i items, Numeric* out) {
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), items);
+        out[0] = _codebook[lanes[0]];
+        out[1] = _codebook[lanes[1]];
+        out[2] = _codebook[lanes[2]];
+        out[3] = _codebook[lanes[3]];
+      }
+#endif
+      const Numeric* _codebook;
+    };
   };
 }
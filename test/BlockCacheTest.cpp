@@ -0,0 +1,84 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+#include "../src/util/BlockCache.h"
+
+using std::string;
+
+namespace ad_utility {
+// _____________________________________________________________________________
+TEST(BlockCacheTest, testGetAndInsert) {
+  // A single shard makes the LRU order predictable.
+  BlockCache cache(100, 1);
+  BlockCache::Key a = {1, 0, 10};
+  BlockCache::Key b = {1, 10, 10};
+  BlockCache::Key c = {2, 0, 10};
+  ASSERT_FALSE(cache.get<string>(a));
+  cache.insert<string>(a, std::make_shared<string>("a"), 40);
+  cache.insert<vector<int>>(b, std::make_shared<vector<int>>(3, 7), 40);
+  ASSERT_EQ("a", *cache.get<string>(a));
+  ASSERT_EQ(vector<int>(3, 7), *cache.get<vector<int>>(b));
+  ASSERT_FALSE(cache.get<string>(c));
+  ASSERT_EQ(2u, cache.getNofHits());
+  ASSERT_EQ(2u, cache.getNofMisses());
+  ASSERT_EQ(80u, cache.getSizeInBytes());
+
+  // Evicts a, the least recently used one.
+  shared_ptr<const string> stillUsed = cache.get<string>(a);
+  cache.get<vector<int>>(b);
+  cache.insert<string>(c, std::make_shared<string>("c"), 40);
+  ASSERT_FALSE(cache.get<string>(a));
+  ASSERT_TRUE(cache.get<vector<int>>(b));
+  ASSERT_EQ("c", *cache.get<string>(c));
+  ASSERT_EQ("a", *stillUsed);
+  ASSERT_EQ(80u, cache.getSizeInBytes());
+
+  // Too large.
+  cache.insert<string>(a, std::make_shared<string>("a"), 101);
+  ASSERT_FALSE(cache.get<string>(a));
+
+  cache.setCapacity(50);
+  ASSERT_EQ(40u, cache.getSizeInBytes());
+  ASSERT_EQ("c", *cache.get<string>(c));
+  cache.clear();
+  ASSERT_EQ(0u, cache.getSizeInBytes());
+  ASSERT_FALSE(cache.get<string>(c));
+}
+
+// _____________________________________________________________________________
+TEST(BlockCacheTest, testConcurrentAccess) {
+  BlockCache cache(1000 * sizeof(size_t));
+  vector<std::thread> threads;
+  vector<size_t> nofWrong(4, 0);
+  for (size_t t = 0; t < nofWrong.size(); ++t) {
+    threads.push_back(std::thread([&cache, &nofWrong, t] {
+      for (size_t i = 0; i < 10000; ++i) {
+        off_t offset = static_cast<off_t>((i * 7 + t) % 300);
+        BlockCache::Key key = {1, offset, 1};
+        shared_ptr<const size_t> block = cache.get<size_t>(key);
+        if (!block) {
+          cache.insert<size_t>(key, std::make_shared<size_t>(offset),
+                               sizeof(size_t));
+        } else if (*block != static_cast<size_t>(offset)) {
+          ++nofWrong[t];
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+    ASSERT_EQ(0u, nofWrong[t]);
+  }
+  ASSERT_EQ(40000u, cache.getNofHits() + cache.getNofMisses());
+  ASSERT_LE(cache.getSizeInBytes(), 1000 * sizeof(size_t));
+}
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
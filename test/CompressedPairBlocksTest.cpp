@@ -0,0 +1,63 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "../src/index/CompressedPairBlocks.h"
+
+// _____________________________________________________________________________
+TEST(CompressedPairBlocksTest, encodeDecodeTest) {
+  vector<array<Id, 2>> pairs;
+  for (Id i = 0; i < 1000; ++i) {
+    pairs.push_back(array<Id, 2>{{1000 + i / 3, 5000 + (i * 7) % 100}});
+  }
+  vector<uint64_t> encoded;
+  size_t nofBytes = CompressedPairBlocks::encode(pairs.data(), pairs.size(),
+                                                 &encoded);
+  ASSERT_EQ(encoded.size() * sizeof(uint64_t), nofBytes);
+  ASSERT_EQ(CompressedPairBlocks::SIMPLE8B, encoded[1]);
+  ASSERT_LT(nofBytes, pairs.size() * sizeof(array<Id, 2>) / 4);
+
+  vector<array<Id, 2>> decoded;
+  ASSERT_EQ(encoded.size(),
+            CompressedPairBlocks::decode(encoded.data(), &decoded));
+  ASSERT_EQ(pairs, decoded);
+}
+
+// _____________________________________________________________________________
+TEST(CompressedPairBlocksTest, rawFallbackTest) {
+  vector<array<Id, 2>> pairs;
+  pairs.push_back(array<Id, 2>{{0, 5}});
+  pairs.push_back(array<Id, 2>{{1, Id(1) << 62}});
+  vector<uint64_t> encoded;
+  CompressedPairBlocks::encode(pairs.data(), pairs.size(), &encoded);
+  ASSERT_EQ(CompressedPairBlocks::RAW, encoded[1]);
+  ASSERT_EQ(2u + 2 * pairs.size(), encoded.size());
+  vector<array<Id, 2>> decoded;
+  CompressedPairBlocks::decode(encoded.data(), &decoded);
+  ASSERT_EQ(pairs, decoded);
+}
+
+// _____________________________________________________________________________
+TEST(CompressedPairBlocksTest, decodeAllTest) {
+  vector<array<Id, 2>> pairs;
+  for (Id i = 0; i < 700; ++i) {
+    pairs.push_back(array<Id, 2>{{i, i % 2 == 0 ? i : 3}});
+  }
+  pairs.push_back(array<Id, 2>{{700, Id(1) << 61}});
+  vector<uint64_t> encoded;
+  size_t nofBytes = 0;
+  for (size_t i = 0; i < pairs.size(); i += 300) {
+    nofBytes += CompressedPairBlocks::encode(
+        pairs.data() + i, std::min<size_t>(300, pairs.size() - i), &encoded);
+  }
+  vector<array<Id, 2>> decoded;
+  CompressedPairBlocks::decodeAll(encoded.data(), nofBytes, &decoded);
+  ASSERT_EQ(pairs, decoded);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
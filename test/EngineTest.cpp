@@ -48,6 +48,59 @@ TEST(EngineTest, joinTest) {
   ASSERT_EQ(2, res[4][2]);
 };
 
+// Hands out the pairs of a vector in blocks of a fixed size.
+class VectorScan {
+public:
+  VectorScan(const vector<array<Id, 2>>& pairs, size_t pairsPerBlock) :
+      _pairs(pairs), _pairsPerBlock(pairsPerBlock), _pos(0) { }
+
+  bool next(vector<array<Id, 2>>* block) {
+    size_t end = std::min(_pos + _pairsPerBlock, _pairs.size());
+    block->assign(_pairs.begin() + _pos, _pairs.begin() + end);
+    _pos = end;
+    return !block->empty();
+  }
+
+private:
+  vector<array<Id, 2>> _pairs;
+  size_t _pairsPerBlock;
+  size_t _pos;
+};
+
+TEST(EngineTest, joinBlocksTest) {
+  Engine e;
+  vector<array<Id, 2>> a;
+  a.push_back(array<Id, 2>{{1, 1}});
+  a.push_back(array<Id, 2>{{1, 3}});
+  a.push_back(array<Id, 2>{{2, 1}});
+  a.push_back(array<Id, 2>{{2, 2}});
+  a.push_back(array<Id, 2>{{4, 1}});
+  a.push_back(array<Id, 2>{{5, 1}});
+  a.push_back(array<Id, 2>{{6, 1}});
+  vector<array<Id, 2>> b;
+  b.push_back(array<Id, 2>{{1, 3}});
+  b.push_back(array<Id, 2>{{1, 8}});
+  b.push_back(array<Id, 2>{{3, 1}});
+  b.push_back(array<Id, 2>{{4, 2}});
+  b.push_back(array<Id, 2>{{6, 2}});
+  b.push_back(array<Id, 2>{{6, 3}});
+  vector<array<Id, 3>> expected;
+  e.join(a, 0, b, 0, &expected);
+  ASSERT_EQ(7u, expected.size());
+  for (size_t blockSize = 1; blockSize < 8; ++blockSize) {
+    VectorScan scanA(a, blockSize);
+    VectorScan scanB(b, blockSize + 1);
+    vector<array<Id, 3>> res;
+    Engine::joinBlocks(&scanA, &scanB, &res);
+    ASSERT_EQ(expected, res);
+  }
+  VectorScan empty(vector<array<Id, 2>>(), 1);
+  VectorScan scanA(a, 2);
+  vector<array<Id, 3>> res;
+  Engine::joinBlocks(&scanA, &empty, &res);
+  ASSERT_TRUE(res.empty());
+};
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -2,6 +2,7 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <algorithm>
 #include <gtest/gtest.h>
 #include "../src/index/FTSAlgorithms.h"
 
@@ -234,6 +235,104 @@ TEST(FTSAlgorithmsTest, intersectKWayTest) {
   ASSERT_EQ(9, resScores[1]);
 };
 
+TEST(FTSAlgorithmsTest, intersectionModesTest) {
+  // Sorted contexts below universe, each taken with probability 1 / step,
+  // some twice.
+  auto makeList = [](size_t universe, size_t step, size_t seed,
+                     vector<Id>* cids, vector<Score>* scores) {
+    cids->clear();
+    scores->clear();
+    for (size_t c = 0; c < universe; ++c) {
+      size_t h = (c * 2654435761u + seed * 40503u) % 1000003u;
+      if (h % step == 0) {
+        size_t n = h % 7 == 0 ? 2 : 1;
+        for (size_t i = 0; i < n; ++i) {
+          cids->push_back(c);
+          scores->push_back(static_cast<Score>(h % 13 + i));
+        }
+      }
+    }
+  };
+
+  for (size_t step : {size_t(1), size_t(3), size_t(40), size_t(900)}) {
+    vector<Id> cids1;
+    vector<Score> scores1;
+    vector<Id> cids2;
+    vector<Score> scores2;
+    vector<Id> cids3;
+    vector<Score> scores3;
+    makeList(5000, step, 1, &cids1, &scores1);
+    makeList(5000, 2, 2, &cids2, &scores2);
+    makeList(5000, 5, 3, &cids3, &scores3);
+    vector<Id> eids3(cids3.size());
+    for (size_t i = 0; i < eids3.size(); ++i) {
+      eids3[i] = i % 3;
+    }
+
+    // Expected: pairs of postings of a context in order, all entity
+    // postings of a matching context and the first postings in k-way.
+    vector<Id> expCids;
+    vector<Score> expScores;
+    vector<Id> expECids;
+    vector<Id> expEids;
+    vector<Score> expEScores;
+    vector<Id> expKCids;
+    vector<Score> expKScores;
+    for (Id c = 0; c < 5000; ++c) {
+      auto r1 = std::equal_range(cids1.begin(), cids1.end(), c);
+      auto r2 = std::equal_range(cids2.begin(), cids2.end(), c);
+      auto r3 = std::equal_range(cids3.begin(), cids3.end(), c);
+      size_t i1 = r1.first - cids1.begin();
+      size_t i2 = r2.first - cids2.begin();
+      size_t i3 = r3.first - cids3.begin();
+      size_t n = std::min(r1.second - r1.first, r2.second - r2.first);
+      for (size_t i = 0; i < n; ++i) {
+        expCids.push_back(c);
+        expScores.push_back(scores1[i1 + i] + scores2[i2 + i]);
+      }
+      if (r1.first != r1.second) {
+        for (size_t j = i3; j < size_t(r3.second - cids3.begin()); ++j) {
+          expECids.push_back(c);
+          expEids.push_back(eids3[j]);
+          expEScores.push_back(scores3[j]);
+        }
+      }
+      if (n > 0 && r3.first != r3.second) {
+        expKCids.push_back(c);
+        expKScores.push_back(scores1[i1] + scores2[i2] + scores3[i3]);
+      }
+    }
+
+    for (auto mode : {FTSAlgorithms::MERGE, FTSAlgorithms::GALLOP,
+                      FTSAlgorithms::SIMD_MERGE, FTSAlgorithms::ADAPTIVE}) {
+      FTSAlgorithms::intersectionMode() = mode;
+      vector<Id> resCids;
+      vector<Id> resEids;
+      vector<Score> resScores;
+      FTSAlgorithms::intersectTwoPostingLists(cids1, scores1, cids2, scores2,
+                                              resCids, resScores);
+      ASSERT_EQ(expCids, resCids) << mode << " " << step;
+      ASSERT_EQ(expScores, resScores) << mode << " " << step;
+      FTSAlgorithms::intersectTwoPostingLists(cids2, scores2, cids1, scores1,
+                                              resCids, resScores);
+      ASSERT_EQ(expCids, resCids) << mode << " " << step;
+
+      FTSAlgorithms::intersect(cids1, scores1, cids3, eids3, scores3,
+                               resCids, resEids, resScores);
+      ASSERT_EQ(expECids, resCids) << mode << " " << step;
+      ASSERT_EQ(expEids, resEids) << mode << " " << step;
+      ASSERT_EQ(expEScores, resScores) << mode << " " << step;
+
+      FTSAlgorithms::intersectKWay({cids1, cids2, cids3},
+                                   {scores1, scores2, scores3}, nullptr,
+                                   resCids, resEids, resScores);
+      ASSERT_EQ(expKCids, resCids) << mode << " " << step;
+      ASSERT_EQ(expKScores, resScores) << mode << " " << step;
+    }
+  }
+  FTSAlgorithms::intersectionMode() = FTSAlgorithms::ADAPTIVE;
+};
+
 TEST(FTSAlgorithmsTest, aggScoresAndTakeTopKContextsTest) {
   try {
     FTSAlgorithms::WidthThreeList result;
@@ -444,6 +543,113 @@ TEST(FTSAlgorithmsTest, appendCrossProductWithTwoW1Test) {
   ASSERT_EQ(0, res[0][4]);
 }
 
+TEST(FTSAlgorithmsTest, getTopKByBlockMaxScoresTest) {
+  // List i holds the multiples of i + 2, some of them twice. Contexts
+  // that are multiples of 499 score high in all lists.
+  size_t nofLists = 3;
+  vector<vector<Id>> cids(nofLists);
+  vector<vector<Score>> scores(nofLists);
+  for (size_t i = 0; i < nofLists; ++i) {
+    for (Id c = 0; c < 5000; c += i + 2) {
+      Score score = static_cast<Score>((c * 7 + i * 13) % 50);
+      if (c % 499 == 0) {
+        score = static_cast<Score>(1000 + c % 7);
+      }
+      cids[i].push_back(c);
+      scores[i].push_back(score);
+      if (c % 5 == 0) {
+        cids[i].push_back(c);
+        scores[i].push_back(static_cast<Score>(score / 2 + 30));
+      }
+    }
+  }
+  // Sub-blocks of at least 16 postings, a context is never split.
+  vector<vector<size_t>> starts(nofLists);
+  vector<vector<Id>> lastCids(nofLists);
+  vector<vector<Score>> maxScores(nofLists);
+  for (size_t i = 0; i < nofLists; ++i) {
+    for (size_t j = 0; j < cids[i].size(); ++j) {
+      if (j == 0 ||
+          (j >= starts[i].back() + 16 && cids[i][j] != cids[i][j - 1])) {
+        starts[i].push_back(j);
+        maxScores[i].push_back(0);
+      } else {
+        lastCids[i].pop_back();
+      }
+      lastCids[i].push_back(cids[i][j]);
+      maxScores[i].back() = std::max(maxScores[i].back(), scores[i][j]);
+    }
+  }
+  size_t nofReads = 0;
+  auto read = [&](size_t i, size_t b, vector<Id>& blockCids,
+                  vector<Score>& blockScores) {
+    ++nofReads;
+    size_t end = b + 1 < starts[i].size() ? starts[i][b + 1] : cids[i].size();
+    blockCids.assign(cids[i].begin() + starts[i][b], cids[i].begin() + end);
+    blockScores.assign(scores[i].begin() + starts[i][b],
+                       scores[i].begin() + end);
+  };
+
+  // Expected: the highest score per list, summed, for all lists.
+  vector<std::pair<size_t, Id>> expected;
+  for (Id c = 0; c < 5000; c += 12) {
+    size_t score = 0;
+    for (size_t i = 0; i < nofLists; ++i) {
+      Score best = 0;
+      for (size_t j = 0; j < cids[i].size(); ++j) {
+        if (cids[i][j] == c) {
+          best = std::max(best, scores[i][j]);
+        }
+      }
+      score += best;
+    }
+    expected.push_back(std::make_pair(score, c));
+  }
+  std::sort(expected.begin(), expected.end(),
+            [](const std::pair<size_t, Id>& a, const std::pair<size_t, Id>& b) {
+              return a.first > b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+
+  size_t nofBlocks = starts[0].size() + starts[1].size() + starts[2].size();
+  size_t ks[] = {1, 3, 10, 50, 1000};
+  for (size_t k : ks) {
+    nofReads = 0;
+    FTSAlgorithms::WidthTwoList result;
+    FTSAlgorithms::getTopKByBlockMaxScores(lastCids, maxScores, read, k,
+                                           &result);
+    ASSERT_EQ(std::min(k, expected.size()), result.size());
+    for (size_t j = 0; j < result.size(); ++j) {
+      ASSERT_EQ(expected[j].second, result[j][0]);
+      ASSERT_EQ(expected[j].first, result[j][1]);
+    }
+    ASSERT_LE(nofReads, nofBlocks);
+    if (k == 1) {
+      // Context 0 scores high in all lists, nothing else comes close.
+      ASSERT_LT(nofReads, nofBlocks / 4);
+    }
+  }
+
+  // A single list.
+  FTSAlgorithms::WidthTwoList result;
+  vector<vector<Id>> lastCids1(1, lastCids[0]);
+  vector<vector<Score>> maxScores1(1, maxScores[0]);
+  FTSAlgorithms::getTopKByBlockMaxScores(lastCids1, maxScores1, read, 2,
+                                         &result);
+  ASSERT_EQ(2u, result.size());
+  ASSERT_EQ(4990u, result[0][0]);
+  ASSERT_EQ(1006u, result[0][1]);
+  ASSERT_EQ(2994u, result[1][0]);
+  ASSERT_EQ(1005u, result[1][1]);
+
+  // An empty list.
+  lastCids1.push_back(vector<Id>());
+  maxScores1.push_back(vector<Score>());
+  FTSAlgorithms::getTopKByBlockMaxScores(lastCids1, maxScores1, read, 2,
+                                         &result);
+  ASSERT_EQ(0u, result.size());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
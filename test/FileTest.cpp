@@ -158,6 +158,51 @@ namespace ad_utility {
     ASSERT_EQ(off_t(3), off);
   }
 
+  TEST_F(FileTest, testPositionalRead) {
+    const File objUnderTest("_tmp_testFileBinary", "r");
+    size_t c = 0;
+    ASSERT_EQ(sizeof(size_t), objUnderTest.read(&c, sizeof(size_t),
+                                                2 * sizeof(size_t)));
+    ASSERT_EQ(size_t(5000), c);
+    size_t a = 0;
+    ASSERT_EQ(sizeof(size_t), objUnderTest.read(&a, sizeof(size_t), 0));
+    ASSERT_EQ(size_t(1), a);
+    // Only what is there.
+    ASSERT_EQ(sizeof(off_t), objUnderTest.read(&a, 2 * sizeof(size_t),
+                                               3 * sizeof(size_t)));
+
+    size_t b = 7;
+    off_t off = 0;
+    c = 0;
+    vector<File::ReadRequest> requests(3);
+    requests[0]._buffer = &c;
+    requests[0]._nofBytes = sizeof(size_t);
+    requests[0]._offset = 2 * sizeof(size_t);
+    requests[1]._buffer = &off;
+    requests[1]._nofBytes = sizeof(off_t);
+    requests[1]._offset = 3 * sizeof(size_t);
+    requests[2]._buffer = &b;
+    requests[2]._nofBytes = sizeof(size_t);
+    requests[2]._offset = sizeof(size_t);
+    ASSERT_TRUE(objUnderTest.readBatch(requests));
+    ASSERT_EQ(size_t(5000), c);
+    ASSERT_EQ(off_t(3), off);
+    ASSERT_EQ(size_t(0), b);
+    requests[2]._offset = 4 * sizeof(size_t);
+    ASSERT_FALSE(objUnderTest.readBatch(requests));
+
+    const File text("_tmp_testFile2", "r");
+    char buf[1024];
+    string line;
+    ASSERT_TRUE(text.readLine(&line, buf, 1024, 6));
+    ASSERT_EQ("line2", line);
+    ASSERT_TRUE(text.readLine(&line, buf, 1024, 2));
+    ASSERT_EQ("ne1", line);
+    ASSERT_FALSE(text.readLine(&line, buf, 1024, 11));
+    ASSERT_THROW(text.readLine(&line, buf, 3, 0),
+                 ad_semsearch::Exception);
+  }
+
 }  // namespace
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
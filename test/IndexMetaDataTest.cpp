@@ -24,8 +24,9 @@ TEST(RelationMetaDataTest, getBlockStartAndNofBytesForLhsTest) {
   off_t afterFI =  6 * 2 * sizeof(Id);
   off_t afterLhs = afterFI + 4 * (sizeof(Id) + sizeof(off_t));
   off_t afterRhs = afterLhs + 6 * sizeof(Id);
-  bs.push_back(BlockMetaData(10, afterFI));
-  bs.push_back(BlockMetaData(16, afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
+  bs.push_back(BlockMetaData(10, 15, afterFI));
+  bs.push_back(BlockMetaData(16, 17,
+                             afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
   RelationMetaData rmd(1, 0, afterLhs, afterRhs, 6, 2, bs);
 
   auto rv = rmd.getBlockStartAndNofBytesForLhs(10);
@@ -42,41 +43,138 @@ TEST(RelationMetaDataTest, getBlockStartAndNofBytesForLhsTest) {
   ASSERT_EQ(2 * (sizeof(Id) + sizeof(off_t)), rv.second);
 }
 
-TEST(RelationMetaDataTest, writeReadTest) {
+TEST(RelationMetaDataTest, getBlocksForLhsRangeTest) {
   vector<BlockMetaData> bs;
   off_t afterFI =  6 * 2 * sizeof(Id);
   off_t afterLhs = afterFI + 4 * (sizeof(Id) + sizeof(off_t));
   off_t afterRhs = afterLhs + 6 * sizeof(Id);
-  bs.push_back(BlockMetaData(10, afterFI));
-  bs.push_back(BlockMetaData(16, afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
+  bs.push_back(BlockMetaData(10, 15, afterFI));
+  bs.push_back(BlockMetaData(16, 17,
+                             afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
   RelationMetaData rmd(1, 0, afterLhs, afterRhs, 6, 2, bs);
 
-  ad_utility::File f("_testtmp.rmd", "w");
-  f << rmd;
+  typedef pair<size_t, size_t> Blocks;
+  ASSERT_EQ(Blocks(0, 2), rmd.getBlocksForLhsRange(0, 100));
+  ASSERT_EQ(Blocks(0, 1), rmd.getBlocksForLhsRange(11, 14));
+  ASSERT_EQ(Blocks(0, 1), rmd.getBlocksForLhsRange(0, 15));
+  ASSERT_EQ(Blocks(1, 2), rmd.getBlocksForLhsRange(16, 16));
+  ASSERT_EQ(Blocks(0, 2), rmd.getBlocksForLhsRange(15, 16));
+  ASSERT_EQ(rmd.getBlocksForLhsRange(18, 100).first,
+            rmd.getBlocksForLhsRange(18, 100).second);
+  ASSERT_EQ(rmd.getBlocksForLhsRange(0, 9).first,
+            rmd.getBlocksForLhsRange(0, 9).second);
+  ASSERT_EQ(Blocks(0, 0), rmd.getBlocksForLhsRange(17, 16));
+  ASSERT_EQ(afterFI + 2 * (sizeof(Id) + sizeof(off_t)), rmd.getBlockEnd(0));
+  ASSERT_EQ(afterLhs, rmd.getBlockEnd(1));
+}
+
+namespace {
+// Writes imd to a file after nofBytesBefore bytes of relation data, the
+// way permutations end, and maps it into imd2.
+void writeAndRead(const IndexMetaData& imd, size_t nofBytesBefore,
+                  IndexMetaData* imd2) {
+  ad_utility::File f("_testtmp.imd", "w");
+  vector<char> before(nofBytesBefore, 0);
+  f.write(before.data(), before.size());
+  f << imd;
+  off_t startOfMeta = nofBytesBefore;
+  f.write(&startOfMeta, sizeof(startOfMeta));
   f.close();
+  imd2->readFromFile("_testtmp.imd");
+  remove("_testtmp.imd");
+}
+}
+
+TEST(RelationMetaDataTest, lhsFilterTest) {
+  vector<Id> keys;
+  for (Id i = 0; i < 1000; ++i) {
+    keys.push_back(i * 7 + 100);
+  }
+  vector<BlockMetaData> bs;
+  bs.push_back(BlockMetaData(100, 100 + 999 * 7, 0));
+  RelationMetaData rmd(1, 0, 1000 * 2 * sizeof(Id), 1000 * 2 * sizeof(Id),
+                       1000, 1, bs);
+  vector<uint64_t> words;
+  size_t nofHashes = BloomFilter::build(keys, 10, &words);
+  ASSERT_EQ(10000u / 64 + 1, words.size());
+  ASSERT_EQ(7u, nofHashes);
+  rmd._lhsFilter = BloomFilter(words.data(), words.size(), nofHashes);
+  IndexMetaData imd;
+  imd.add(rmd);
+  imd.setLhsFilters(true);
+  IndexMetaData imd2;
+  writeAndRead(imd, 0, &imd2);
+  ASSERT_TRUE(imd2.hasLhsFilters());
+  RelationMetaData rmd2 = imd2.getRmd(1);
+  ASSERT_EQ(words.size(), rmd2._lhsFilter.getNofWords());
+  ASSERT_EQ(nofHashes, rmd2._lhsFilter.getNofHashes());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_TRUE(rmd2.mayContainLhs(keys[i]));
+  }
+  // Below the first LHS.
+  ASSERT_FALSE(rmd2.mayContainLhs(99));
+  size_t falsePositives = 0;
+  for (Id i = 0; i < 10000; ++i) {
+    if (rmd2.mayContainLhs(i * 7 + 101)) {
+      ++falsePositives;
+    }
+  }
+  ASSERT_LT(falsePositives, 300u);
+
+  // Without a filter everything from the first LHS on may be contained.
+  RelationMetaData rmd3(1, 0, 1000 * 2 * sizeof(Id), 1000 * 2 * sizeof(Id),
+                        1000, 1, bs);
+  ASSERT_TRUE(rmd3.mayContainLhs(101));
+  ASSERT_FALSE(rmd3.mayContainLhs(99));
+}
+
+TEST(RelationMetaDataTest, statisticsTest) {
+  vector<array<Id, 2>> pairs;
+  pairs.push_back(array<Id, 2>{{10, 20}});
+  pairs.push_back(array<Id, 2>{{10, 21}});
+  pairs.push_back(array<Id, 2>{{10, 22}});
+  pairs.push_back(array<Id, 2>{{15, 20}});
+  pairs.push_back(array<Id, 2>{{16, 20}});
+  pairs.push_back(array<Id, 2>{{17, 20}});
+  RelationStatistics stats(pairs);
+  ASSERT_EQ(4u, stats._nofDistinctLhs);
+  ASSERT_EQ(3u, stats._nofDistinctRhs);
+  ASSERT_EQ(3u, stats._maxLhsMultiplicity);
+  ASSERT_EQ(4u, stats._maxRhsMultiplicity);
+  ASSERT_EQ(3u, stats._lhsHistogram[0]);
+  ASSERT_EQ(1u, stats._lhsHistogram[1]);
+  ASSERT_EQ(0u, stats._lhsHistogram[2]);
+  vector<BlockMetaData> noBlocks;
+  RelationMetaData rmd(1, 0, 0, 0, pairs.size(), 0, noBlocks);
+  rmd._stats = stats;
+  ASSERT_DOUBLE_EQ(1.5, rmd.getAverageLhsMultiplicity());
+  // Half of the pairs belong to the LHS with three pairs.
+  ASSERT_DOUBLE_EQ(2, rmd.getPairWeightedLhsMultiplicity());
 
-  ad_utility::File in("_testtmp.rmd", "r");
-  ASSERT_EQ(3 * sizeof(Id) + 5 * sizeof(off_t) + 2 * sizeof(size_t),
-      rmd.bytesRequired());
-  unsigned char* buf = new unsigned char[rmd.bytesRequired()];
-  in.read(buf, rmd.bytesRequired());
-  RelationMetaData rmd2;
-  rmd2.createFromByteBuffer(buf);
-
-  delete[] buf;
-  remove("_testtmp.rmd");
-
-  ASSERT_EQ(rmd._relId, rmd2._relId);
-  ASSERT_EQ(rmd._startFullIndex, rmd2._startFullIndex);
-  ASSERT_EQ(rmd._startRhs, rmd2._startRhs);
-  ASSERT_EQ(rmd._offsetAfter, rmd2._offsetAfter);
-  ASSERT_EQ(rmd._nofElements, rmd2._nofElements);
-  ASSERT_EQ(rmd._nofBlocks, rmd2._nofBlocks);
-  ASSERT_EQ(rmd._blocks.size(), rmd2._blocks.size());
-  ASSERT_EQ(rmd._blocks[0]._firstLhs, rmd2._blocks[0]._firstLhs);
-  ASSERT_EQ(rmd._blocks[0]._startOffset, rmd2._blocks[0]._startOffset);
-  ASSERT_EQ(rmd._blocks[1]._firstLhs, rmd2._blocks[1]._firstLhs);
-  ASSERT_EQ(rmd._blocks[1]._startOffset, rmd2._blocks[1]._startOffset);
+  pairs.clear();
+  for (Id i = 0; i < 1000; ++i) {
+    pairs.push_back(array<Id, 2>{{1, i}});
+  }
+  stats = RelationStatistics(pairs);
+  ASSERT_EQ(1u, stats._nofDistinctLhs);
+  ASSERT_EQ(1000u, stats._nofDistinctRhs);
+  ASSERT_EQ(1000u, stats._maxLhsMultiplicity);
+  ASSERT_EQ(1u, stats._maxRhsMultiplicity);
+  ASSERT_EQ(1u, stats._lhsHistogram[RelationStatistics::HISTOGRAM_SIZE - 1]);
+  rmd = RelationMetaData(1, 0, 0, 0, pairs.size(), 0, noBlocks);
+  rmd._stats = stats;
+  ASSERT_DOUBLE_EQ(1000, rmd.getPairWeightedLhsMultiplicity());
+
+  // One LHS with 1000 pairs and 1000 with one pair each.
+  for (Id i = 0; i < 1000; ++i) {
+    pairs.push_back(array<Id, 2>{{2 + i, i}});
+  }
+  stats = RelationStatistics(pairs);
+  rmd = RelationMetaData(1, 0, 0, 0, pairs.size(), 0, noBlocks);
+  rmd._stats = stats;
+  ASSERT_NEAR(2000.0 / 1001, rmd.getAverageLhsMultiplicity(), 1e-9);
+  ASSERT_DOUBLE_EQ(1001000.0 / 2000, rmd.getPairWeightedLhsMultiplicity());
 }
 
 TEST(IndexMetaDataTest, writeReadTest) {
@@ -84,51 +182,78 @@ TEST(IndexMetaDataTest, writeReadTest) {
   off_t afterFI =  6 * 2 * sizeof(Id);
   off_t afterLhs = afterFI + 4 * (sizeof(Id) + sizeof(off_t));
   off_t afterRhs = afterLhs + 6 * sizeof(Id);
-  bs.push_back(BlockMetaData(10, afterFI));
-  bs.push_back(BlockMetaData(16, afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
+  bs.push_back(BlockMetaData(10, 15, afterFI));
+  bs.push_back(BlockMetaData(16, 17,
+                             afterFI + 2 * (sizeof(Id) + sizeof(off_t))));
   RelationMetaData rmd(1, 0, afterLhs, afterRhs, 6, 2, bs);
-  RelationMetaData rmd2(rmd);
-  rmd2._relId = 2;
+  rmd._stats._nofDistinctLhs = 4;
+  rmd._stats._nofDistinctRhs = 3;
+  rmd._stats._lhsHistogram[1] = 1;
+  // Does not fit into 32 bits.
+  rmd._stats._lhsHistogram[2] = 5000000000u;
+  vector<BlockMetaData> bs2;
+  bs2.push_back(BlockMetaData(20, 20, afterRhs + afterFI));
+  RelationMetaData rmd2(3, afterRhs, afterRhs + afterFI, afterRhs + afterFI,
+                        6, 1, bs2);
   IndexMetaData imd;
   imd.add(rmd);
   imd.add(rmd2);
+  imd.setFullIndexCompressed(true);
+  ASSERT_EQ(2u, imd.getNofRelations());
+  ASSERT_EQ(afterRhs + afterFI, imd.getOffsetAfter());
 
-  ad_utility::File f("_testtmp.imd", "w");
-  f << imd;
-  f.close();
-
-  ad_utility::File in("_testtmp.imd", "r");
-  size_t imdBytes = sizeof(size_t) + rmd.bytesRequired() * 2;
-  unsigned char* buf = new unsigned char[imdBytes];
-  in.read(buf, imdBytes);
+  // The meta data does not start at a page boundary.
   IndexMetaData imd2;
-  imd2.createFromByteBuffer(buf);
-  delete[] buf;
-  remove("_testtmp.rmd");
-
-  ASSERT_EQ(rmd._relId, imd2.getRmd(1)._relId);
-  ASSERT_EQ(rmd._startFullIndex, imd2.getRmd(1)._startFullIndex);
-  ASSERT_EQ(rmd._startRhs, imd2.getRmd(1)._startRhs);
-  ASSERT_EQ(rmd._offsetAfter, imd2.getRmd(1)._offsetAfter);
-  ASSERT_EQ(rmd._nofElements, imd2.getRmd(1)._nofElements);
-  ASSERT_EQ(rmd._nofBlocks, imd2.getRmd(1)._nofBlocks);
-  ASSERT_EQ(rmd._blocks.size(), imd2.getRmd(1)._blocks.size());
-  ASSERT_EQ(rmd._blocks[0]._firstLhs, imd2.getRmd(1)._blocks[0]._firstLhs);
-  ASSERT_EQ(rmd._blocks[0]._startOffset, imd2.getRmd(1)._blocks[0]._startOffset);
-  ASSERT_EQ(rmd._blocks[1]._firstLhs, imd2.getRmd(1)._blocks[1]._firstLhs);
-  ASSERT_EQ(rmd._blocks[1]._startOffset, imd2.getRmd(1)._blocks[1]._startOffset);
-
-  ASSERT_EQ(rmd2._relId, imd2.getRmd(2)._relId);
-  ASSERT_EQ(rmd2._startFullIndex, imd2.getRmd(2)._startFullIndex);
-  ASSERT_EQ(rmd2._startRhs, imd2.getRmd(2)._startRhs);
-  ASSERT_EQ(rmd2._offsetAfter, imd2.getRmd(2)._offsetAfter);
-  ASSERT_EQ(rmd2._nofElements, imd2.getRmd(2)._nofElements);
-  ASSERT_EQ(rmd2._nofBlocks, imd2.getRmd(2)._nofBlocks);
-  ASSERT_EQ(rmd2._blocks.size(), imd2.getRmd(2)._blocks.size());
-  ASSERT_EQ(rmd2._blocks[0]._firstLhs, imd2.getRmd(2)._blocks[0]._firstLhs);
-  ASSERT_EQ(rmd2._blocks[0]._startOffset, imd2.getRmd(2)._blocks[0]._startOffset);
-  ASSERT_EQ(rmd2._blocks[1]._firstLhs, imd2.getRmd(2)._blocks[1]._firstLhs);
-  ASSERT_EQ(rmd2._blocks[1]._startOffset, imd2.getRmd(2)._blocks[1]._startOffset);
+  writeAndRead(imd, 4096 + 3 * sizeof(Id), &imd2);
+
+  ASSERT_TRUE(imd2.isFullIndexCompressed());
+  ASSERT_FALSE(imd2.hasLhsFilters());
+  ASSERT_EQ(2u, imd2.getNofRelations());
+  ASSERT_EQ(imd.getOffsetAfter(), imd2.getOffsetAfter());
+  ASSERT_TRUE(imd2.relationExists(1));
+  ASSERT_FALSE(imd2.relationExists(2));
+  ASSERT_TRUE(imd2.relationExists(3));
+  ASSERT_FALSE(imd2.relationExists(4));
+  ASSERT_EQ(vector<Id>({1, 3}), imd2.getRelationIds());
+
+  RelationMetaData r = imd2.getRmd(1);
+  ASSERT_EQ(rmd._relId, r._relId);
+  ASSERT_EQ(rmd._startFullIndex, r._startFullIndex);
+  ASSERT_EQ(rmd._startRhs, r._startRhs);
+  ASSERT_EQ(rmd._offsetAfter, r._offsetAfter);
+  ASSERT_EQ(rmd._nofElements, r._nofElements);
+  ASSERT_EQ(rmd._nofBlocks, r._nofBlocks);
+  ASSERT_EQ(rmd._blocks[0]._firstLhs, r._blocks[0]._firstLhs);
+  ASSERT_EQ(rmd._blocks[0]._startOffset, r._blocks[0]._startOffset);
+  ASSERT_EQ(rmd._blocks[1]._firstLhs, r._blocks[1]._firstLhs);
+  ASSERT_EQ(rmd._blocks[1]._lastLhs, r._blocks[1]._lastLhs);
+  ASSERT_EQ(rmd._blocks[1]._startOffset, r._blocks[1]._startOffset);
+  ASSERT_TRUE(r._lhsFilter.empty());
+  ASSERT_EQ(4u, r._stats._nofDistinctLhs);
+  ASSERT_EQ(3u, r._stats._nofDistinctRhs);
+  ASSERT_EQ(1u, r._stats._lhsHistogram[1]);
+  ASSERT_EQ(5000000000u, r._stats._lhsHistogram[2]);
+  ASSERT_DOUBLE_EQ(1.5, r.getAverageLhsMultiplicity());
+  ASSERT_DOUBLE_EQ(2, r.getAverageRhsMultiplicity());
+  auto rv = r.getBlockStartAndNofBytesForLhs(15);
+  ASSERT_EQ(afterFI, rv.first);
+  ASSERT_EQ(2 * (sizeof(Id) + sizeof(off_t)), rv.second);
+
+  r = imd2.getRmd(3);
+  ASSERT_EQ(rmd2._relId, r._relId);
+  ASSERT_EQ(rmd2._startFullIndex, r._startFullIndex);
+  ASSERT_EQ(rmd2._startRhs, r._startRhs);
+  ASSERT_EQ(rmd2._offsetAfter, r._offsetAfter);
+  ASSERT_EQ(rmd2._nofElements, r._nofElements);
+  ASSERT_EQ(1u, r._nofBlocks);
+  ASSERT_EQ(20u, r._blocks[0]._firstLhs);
+  ASSERT_EQ(afterRhs + afterFI, r._blocks[0]._startOffset);
+  ASSERT_TRUE(r.isFunctional());
+
+  // Moving keeps the mapping.
+  IndexMetaData imd3(std::move(imd2));
+  ASSERT_EQ(0u, imd2.getNofRelations());
+  ASSERT_EQ(afterLhs, imd3.getRmd(1)._startRhs);
 }
 
 
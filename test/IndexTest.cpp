@@ -2,10 +2,16 @@
 // Chair of Algorithms and Data Structures.
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <fstream>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
 #include "../src/index/Index.h"
+#include "../src/engine/Engine.h"
 
 
 string getStxxlDiskFileName(const string& location, const string& tail) {
@@ -53,24 +59,25 @@ TEST(IndexTest, createFromTsvTest) {
     Index index;
     index.createFromTsvFile("_testtmp2.tsv", "_testindex");
 
-    ASSERT_TRUE(index._psoMeta.relationExists(2));
-    ASSERT_TRUE(index._psoMeta.relationExists(3));
-    ASSERT_FALSE(index._psoMeta.relationExists(1));
-    ASSERT_FALSE(index._psoMeta.relationExists(4));
-    ASSERT_FALSE(index._psoMeta.getRmd(2).isFunctional());
-    ASSERT_TRUE(index._psoMeta.getRmd(3).isFunctional());
-    ASSERT_EQ(1, index._psoMeta.getRmd(2)._nofBlocks);
-    ASSERT_EQ(1, index._psoMeta.getRmd(3)._nofBlocks);
-
-    ASSERT_TRUE(index._posMeta.relationExists(2));
-    ASSERT_TRUE(index._posMeta.relationExists(3));
-    ASSERT_FALSE(index._posMeta.relationExists(1));
-    ASSERT_FALSE(index._posMeta.relationExists(4));
-    ASSERT_TRUE(index._posMeta.getRmd(2).isFunctional());
-    ASSERT_TRUE(index._posMeta.getRmd(3).isFunctional());
+    ASSERT_TRUE(index.getMeta(Index::PSO).relationExists(2));
+    ASSERT_TRUE(index.getMeta(Index::PSO).relationExists(3));
+    ASSERT_FALSE(index.getMeta(Index::PSO).relationExists(1));
+    ASSERT_FALSE(index.getMeta(Index::PSO).relationExists(4));
+    ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(2).isFunctional());
+    ASSERT_TRUE(index.getMeta(Index::PSO).getRmd(3).isFunctional());
+    ASSERT_EQ(1, index.getMeta(Index::PSO).getRmd(2)._nofBlocks);
+    ASSERT_EQ(1, index.getMeta(Index::PSO).getRmd(3)._nofBlocks);
+
+    ASSERT_TRUE(index.getMeta(Index::POS).relationExists(2));
+    ASSERT_TRUE(index.getMeta(Index::POS).relationExists(3));
+    ASSERT_FALSE(index.getMeta(Index::POS).relationExists(1));
+    ASSERT_FALSE(index.getMeta(Index::POS).relationExists(4));
+    ASSERT_TRUE(index.getMeta(Index::POS).getRmd(2).isFunctional());
+    ASSERT_TRUE(index.getMeta(Index::POS).getRmd(3).isFunctional());
 
     ad_utility::File psoFile("_testindex.index.pso", "r");
-    size_t nofbytes = static_cast<size_t>(index._psoMeta.getOffsetAfter());
+    size_t nofbytes =
+        static_cast<size_t>(index.getMeta(Index::PSO).getOffsetAfter());
     unsigned char* buf = new unsigned char[nofbytes];
     psoFile.read(buf, nofbytes);
 
@@ -107,7 +114,7 @@ TEST(IndexTest, createFromTsvTest) {
     ASSERT_EQ(5, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
     // No LHS & RHS
-    ASSERT_EQ(index._psoMeta.getOffsetAfter(), bytesDone);
+    ASSERT_EQ(index.getMeta(Index::PSO).getOffsetAfter(), bytesDone);
 
     delete[] buf;
     psoFile.close();
@@ -115,6 +122,8 @@ TEST(IndexTest, createFromTsvTest) {
 
     remove("_testtmp2.tsv");
     std::remove(stxxlFileName.c_str());
+    remove("_testindex.vocabulary");
+    remove("_testindex.vocabulary.mphf");
     remove("_testindex.index.pso");
     remove("_testindex.index.pos");
   }
@@ -149,17 +158,18 @@ TEST(IndexTest, createFromTsvTest) {
     Index index;
     index.createFromTsvFile("_testtmp2.tsv", "_testindex");
 
-    ASSERT_TRUE(index._psoMeta.relationExists(7));
-    ASSERT_FALSE(index._psoMeta.relationExists(1));
+    ASSERT_TRUE(index.getMeta(Index::PSO).relationExists(7));
+    ASSERT_FALSE(index.getMeta(Index::PSO).relationExists(1));
 
-    ASSERT_FALSE(index._psoMeta.getRmd(7).isFunctional());
-    ASSERT_EQ(1, index._psoMeta.getRmd(7)._nofBlocks);
+    ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(7).isFunctional());
+    ASSERT_EQ(1, index.getMeta(Index::PSO).getRmd(7)._nofBlocks);
 
-    ASSERT_TRUE(index._posMeta.relationExists(7));
-    ASSERT_FALSE(index._posMeta.getRmd(7).isFunctional());
+    ASSERT_TRUE(index.getMeta(Index::POS).relationExists(7));
+    ASSERT_FALSE(index.getMeta(Index::POS).getRmd(7).isFunctional());
 
     ad_utility::File psoFile("_testindex.index.pso", "r");
-    size_t nofbytes = static_cast<size_t>(index._psoMeta.getOffsetAfter());
+    size_t nofbytes =
+        static_cast<size_t>(index.getMeta(Index::PSO).getOffsetAfter());
     unsigned char* buf = new unsigned char[nofbytes];
     psoFile.read(buf, nofbytes);
 
@@ -199,22 +209,22 @@ TEST(IndexTest, createFromTsvTest) {
 
     ASSERT_EQ(4, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._psoMeta.getRmd(7)._startRhs,
+    ASSERT_EQ(index.getMeta(Index::PSO).getRmd(7)._startRhs,
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
     ASSERT_EQ(5, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._psoMeta.getRmd(7)._startRhs + 3 * sizeof(Id),
+    ASSERT_EQ(index.getMeta(Index::PSO).getRmd(7)._startRhs + 3 * sizeof(Id),
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
     ASSERT_EQ(6, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._psoMeta.getRmd(7)._startRhs + 5 * sizeof(Id),
+    ASSERT_EQ(index.getMeta(Index::PSO).getRmd(7)._startRhs + 5 * sizeof(Id),
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
 
     // Rhs list
-    ASSERT_EQ(bytesDone, index._psoMeta.getRmd(7)._startRhs);
+    ASSERT_EQ(bytesDone, index.getMeta(Index::PSO).getRmd(7)._startRhs);
     ASSERT_EQ(0, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
     ASSERT_EQ(1, *reinterpret_cast<Id*>(buf + bytesDone));
@@ -234,7 +244,7 @@ TEST(IndexTest, createFromTsvTest) {
 
 
     ad_utility::File posFile("_testindex.index.pos", "r");
-    nofbytes = static_cast<size_t>(index._posMeta.getOffsetAfter());
+    nofbytes = static_cast<size_t>(index.getMeta(Index::POS).getOffsetAfter());
     buf = new unsigned char[nofbytes];
     posFile.read(buf, nofbytes);
 
@@ -274,27 +284,27 @@ TEST(IndexTest, createFromTsvTest) {
     // Lhs info
     ASSERT_EQ(0, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._posMeta.getRmd(7)._startRhs,
+    ASSERT_EQ(index.getMeta(Index::POS).getRmd(7)._startRhs,
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
     ASSERT_EQ(1, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._posMeta.getRmd(7)._startRhs + 2 * sizeof(Id),
+    ASSERT_EQ(index.getMeta(Index::POS).getRmd(7)._startRhs + 2 * sizeof(Id),
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
     ASSERT_EQ(2, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._posMeta.getRmd(7)._startRhs + 4 * sizeof(Id),
+    ASSERT_EQ(index.getMeta(Index::POS).getRmd(7)._startRhs + 4 * sizeof(Id),
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
     ASSERT_EQ(3, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
-    ASSERT_EQ(index._posMeta.getRmd(7)._startRhs + 6 * sizeof(Id),
+    ASSERT_EQ(index.getMeta(Index::POS).getRmd(7)._startRhs + 6 * sizeof(Id),
         *reinterpret_cast<off_t*>(buf + bytesDone));
     bytesDone += sizeof(off_t);
 
     // Rhs list
-    ASSERT_EQ(bytesDone, index._posMeta.getRmd(7)._startRhs);
+    ASSERT_EQ(bytesDone, index.getMeta(Index::POS).getRmd(7)._startRhs);
     ASSERT_EQ(4, *reinterpret_cast<Id*>(buf + bytesDone));
     bytesDone += sizeof(Id);
     ASSERT_EQ(5, *reinterpret_cast<Id*>(buf + bytesDone));
@@ -315,6 +325,8 @@ TEST(IndexTest, createFromTsvTest) {
 
     remove("_testtmp2.tsv");
     std::remove(stxxlFileName.c_str());
+    remove("_testindex.vocabulary");
+    remove("_testindex.vocabulary.mphf");
     remove("_testindex.index.pso");
     remove("_testindex.index.pos");
   }
@@ -350,28 +362,1073 @@ TEST(IndexTest, createFromOnDiskIndexTest) {
   Index index;
   index.createFromOnDiskIndex("_testindex2");
 
-  ASSERT_TRUE(index._psoMeta.relationExists(2));
-  ASSERT_TRUE(index._psoMeta.relationExists(3));
-  ASSERT_FALSE(index._psoMeta.relationExists(1));
-  ASSERT_FALSE(index._psoMeta.relationExists(4));
-  ASSERT_FALSE(index._psoMeta.getRmd(2).isFunctional());
-  ASSERT_TRUE(index._psoMeta.getRmd(3).isFunctional());
-  ASSERT_EQ(1, index._psoMeta.getRmd(2)._nofBlocks);
-  ASSERT_EQ(1, index._psoMeta.getRmd(3)._nofBlocks);
-
-  ASSERT_TRUE(index._posMeta.relationExists(2));
-  ASSERT_TRUE(index._posMeta.relationExists(3));
-  ASSERT_FALSE(index._posMeta.relationExists(1));
-  ASSERT_FALSE(index._posMeta.relationExists(4));
-  ASSERT_TRUE(index._posMeta.getRmd(2).isFunctional());
-  ASSERT_TRUE(index._posMeta.getRmd(3).isFunctional());
+  ASSERT_TRUE(index.getMeta(Index::PSO).relationExists(2));
+  ASSERT_TRUE(index.getMeta(Index::PSO).relationExists(3));
+  ASSERT_FALSE(index.getMeta(Index::PSO).relationExists(1));
+  ASSERT_FALSE(index.getMeta(Index::PSO).relationExists(4));
+  ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(2).isFunctional());
+  ASSERT_TRUE(index.getMeta(Index::PSO).getRmd(3).isFunctional());
+  ASSERT_EQ(1, index.getMeta(Index::PSO).getRmd(2)._nofBlocks);
+  ASSERT_EQ(1, index.getMeta(Index::PSO).getRmd(3)._nofBlocks);
+
+  ASSERT_TRUE(index.getMeta(Index::POS).relationExists(2));
+  ASSERT_TRUE(index.getMeta(Index::POS).relationExists(3));
+  ASSERT_FALSE(index.getMeta(Index::POS).relationExists(1));
+  ASSERT_FALSE(index.getMeta(Index::POS).relationExists(4));
+  ASSERT_TRUE(index.getMeta(Index::POS).getRmd(2).isFunctional());
+  ASSERT_TRUE(index.getMeta(Index::POS).getRmd(3).isFunctional());
 
   remove("_testtmp3.tsv");
+  remove("_testindex2.vocabulary");
+  remove("_testindex2.vocabulary.mphf");
   remove("_testindex2.index.pso");
   remove("_testindex2.index.pos");
   std::remove(stxxlFileName.c_str());
 };
 
+TEST(IndexTest, createWithPartialVocabulariesTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp4.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a\tb\tc2\t.\n"
+      "a\tb2\tc\t.\n"
+      "a2\tb2\tc2\t.";
+  f.close();
+
+  {
+    Index index;
+    // Small enough to force a spill after every line.
+    index.setVocabularyMemoryBudget(1);
+    index.createFromTsvFile("_testtmp4.tsv", "_testindex4");
+    ASSERT_EQ(size_t(6), index._vocab.size());
+    ASSERT_EQ("a", index.idToString(0));
+    ASSERT_EQ("a2", index.idToString(1));
+    ASSERT_EQ("b", index.idToString(2));
+    ASSERT_EQ("b2", index.idToString(3));
+    ASSERT_EQ("c", index.idToString(4));
+    ASSERT_EQ("c2", index.idToString(5));
+
+    Index::WidthTwoList wtl;
+    index.scanPSO("b2", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(0u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[0][1]);
+    ASSERT_EQ(1u, wtl[1][0]);
+    ASSERT_EQ(5u, wtl[1][1]);
+    std::ifstream partial("_testindex4.partial-vocabulary.0");
+    ASSERT_FALSE(partial.good());
+    std::ifstream order("_testindex4.partial-vocabulary.0.order");
+    ASSERT_FALSE(order.good());
+  }
+
+  remove("_testtmp4.tsv");
+  remove("_testindex4.vocabulary");
+  remove("_testindex4.vocabulary.mphf");
+  remove("_testindex4.index.pso");
+  remove("_testindex4.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, allPermutationsTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp5.tsv", std::ios_base::out);
+
+  // Vocab:
+  // 0: a
+  // 1: a2
+  // 2: b
+  // 3: b2
+  // 4: c
+  // 5: c2
+  f << "a\tb\tc\t.\n"
+      "a\tb\tc2\t.\n"
+      "a\tb2\tc\t.\n"
+      "a2\tb2\tc2\t.";
+  f.close();
+  {
+    Index index;
+    index.setBuildAllPermutations(true);
+    index.createFromTsvFile("_testtmp5.tsv", "_testindex5");
+    ASSERT_TRUE(index.hasAllPermutations());
+
+    const BuildReport& report = index.getBuildReport();
+    ASSERT_EQ(9u, report.getPhases().size());
+    ASSERT_EQ("parse", report.getPhases()[0]._name);
+    ASSERT_EQ("vocabulary", report.getPhases()[1]._name);
+    ASSERT_EQ("sort PSO", report.getPhases()[2]._name);
+    ASSERT_EQ("permutation PSO", report.getPhases()[3]._name);
+    ASSERT_EQ("permutation OPS", report.getPhases()[8]._name);
+    ASSERT_EQ(6u, report.getPermutations().size());
+    const BuildReport::PermutationSizes& pso = report.getPermutations()[0];
+    ASSERT_EQ("PSO", pso._name);
+    ASSERT_EQ(2u, pso._nofRelations);
+    ASSERT_EQ(1u, pso._nofFunctionalRelations);
+    ASSERT_EQ(4u, pso._nofElements);
+    ASSERT_EQ(pso._fileBytes, pso._pairIndexBytes + pso._lhsBytes +
+                              pso._rhsBytes + pso._metaBytes);
+    string json = report.asJson();
+    ASSERT_NE(string::npos, json.find("\"name\": \"OPS\""));
+    ASSERT_NE(string::npos, json.find("\"wallMs\": "));
+    ASSERT_EQ(string::npos, json.find("\"text\""));
+
+    // A running phase has no figures yet.
+    BuildReport running;
+    running.startPhase("parse");
+    ASSERT_NE(string::npos, running.asJson().find(
+        "{\"name\": \"parse\", \"wallMs\": 0, \"cpuMs\": 0, "
+        "\"bytesRead\": 0, \"bytesWritten\": 0, \"peakRssKb\": 0, "
+        "\"stxxlPeakBytes\": 0, \"stxxlCurrentBytes\": 0}"));
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex5");
+    ASSERT_TRUE(index.hasAllPermutations());
+    ASSERT_EQ(3u, index.subjectCardinality("a"));
+    ASSERT_EQ(2u, index.objectCardinality("c2"));
+    ASSERT_DOUBLE_EQ(2, index.averageMultiplicity(Index::PSO, "b", true));
+    ASSERT_DOUBLE_EQ(1, index.averageMultiplicity(Index::PSO, "b", false));
+    ASSERT_DOUBLE_EQ(1, index.averageMultiplicity(Index::POS, "b2", true));
+    ASSERT_DOUBLE_EQ(1.5, index.averageMultiplicity(Index::SOP, "a", true));
+    ASSERT_DOUBLE_EQ(1, index.averageMultiplicity(Index::PSO, "x", true));
+    ASSERT_DOUBLE_EQ(2, index.pairWeightedLhsMultiplicity(Index::PSO, "b"));
+    ASSERT_DOUBLE_EQ(1, index.pairWeightedLhsMultiplicity(Index::PSO, "x"));
+
+    Index::WidthOneList wol;
+    Index::WidthTwoList wtl;
+
+    index.scanSPO("a", &wtl);
+    ASSERT_EQ(3u, wtl.size());
+    ASSERT_EQ(2u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[0][1]);
+    ASSERT_EQ(2u, wtl[1][0]);
+    ASSERT_EQ(5u, wtl[1][1]);
+    ASSERT_EQ(3u, wtl[2][0]);
+    ASSERT_EQ(4u, wtl[2][1]);
+    wtl.clear();
+
+    index.scanSOP("a", &wtl);
+    ASSERT_EQ(3u, wtl.size());
+    ASSERT_EQ(4u, wtl[0][0]);
+    ASSERT_EQ(2u, wtl[0][1]);
+    ASSERT_EQ(4u, wtl[1][0]);
+    ASSERT_EQ(3u, wtl[1][1]);
+    ASSERT_EQ(5u, wtl[2][0]);
+    ASSERT_EQ(2u, wtl[2][1]);
+    wtl.clear();
+
+    index.scanSOP("a", "c", &wol);
+    ASSERT_EQ(2u, wol.size());
+    ASSERT_EQ(2u, wol[0][0]);
+    ASSERT_EQ(3u, wol[1][0]);
+    wol.clear();
+
+    index.scanOSP("c2", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(0u, wtl[0][0]);
+    ASSERT_EQ(2u, wtl[0][1]);
+    ASSERT_EQ(1u, wtl[1][0]);
+    ASSERT_EQ(3u, wtl[1][1]);
+    wtl.clear();
+
+    index.scanOPS("c2", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(2u, wtl[0][0]);
+    ASSERT_EQ(0u, wtl[0][1]);
+    ASSERT_EQ(3u, wtl[1][0]);
+    ASSERT_EQ(1u, wtl[1][1]);
+    wtl.clear();
+
+    index.scanSPO("x", &wtl);
+    ASSERT_EQ(0u, wtl.size());
+  }
+
+  remove("_testtmp5.tsv");
+  remove("_testindex5.vocabulary");
+  remove("_testindex5.vocabulary.mphf");
+  remove("_testindex5.index.pso");
+  remove("_testindex5.index.pos");
+  remove("_testindex5.index.spo");
+  remove("_testindex5.index.sop");
+  remove("_testindex5.index.osp");
+  remove("_testindex5.index.ops");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, compressedFullIndexTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp6.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a\tb\tc2\t.\n"
+      "a\tb2\tc\t.\n"
+      "a2\tb2\tc2\t.";
+  f.close();
+  {
+    Index index;
+    index.setCompressFullIndex(true);
+    index.setBuildLhsFilters(true);
+    index.createFromTsvFile("_testtmp6.tsv", "_testindex6");
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex6");
+    ASSERT_TRUE(index.getMeta(Index::PSO).isFullIndexCompressed());
+    ASSERT_TRUE(index.getMeta(Index::POS).isFullIndexCompressed());
+    ASSERT_TRUE(index.getMeta(Index::PSO).hasLhsFilters());
+    ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(2)._lhsFilter.empty());
+    ASSERT_TRUE(index.hasTriple("a", "b"));
+    ASSERT_TRUE(index.hasTriple("a", "b", "c2"));
+    ASSERT_TRUE(index.hasTriple("a2", "b2", "c2"));
+    ASSERT_FALSE(index.hasTriple("a2", "b2", "c"));
+    ASSERT_FALSE(index.hasTriple("a2", "b"));
+    ASSERT_FALSE(index.hasTriple("x", "b"));
+    ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(2).isFunctional());
+    ASSERT_TRUE(index.getMeta(Index::PSO).getRmd(3).isFunctional());
+
+    Index::WidthOneList wol;
+    Index::WidthTwoList wtl;
+
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(0u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[0][1]);
+    ASSERT_EQ(0u, wtl[1][0]);
+    ASSERT_EQ(5u, wtl[1][1]);
+    wtl.clear();
+
+    index.scanPOS("b2", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(4u, wtl[0][0]);
+    ASSERT_EQ(0u, wtl[0][1]);
+    ASSERT_EQ(5u, wtl[1][0]);
+    ASSERT_EQ(1u, wtl[1][1]);
+    wtl.clear();
+
+    index.scanPSO("b", "a", &wol);
+    ASSERT_EQ(2u, wol.size());
+    ASSERT_EQ(4u, wol[0][0]);
+    ASSERT_EQ(5u, wol[1][0]);
+    wol.clear();
+
+    index.scanPSO("b2", "a2", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(5u, wol[0][0]);
+    wol.clear();
+
+    index.scanPOS("b2", "c2", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(1u, wol[0][0]);
+    wol.clear();
+
+    index.scanPOS("b", "c3", &wol);
+    ASSERT_EQ(0u, wol.size());
+
+    // The second scan of a block is answered from the block cache.
+    index.clearBlockCache();
+    size_t nofHits = index._blockCache.getNofHits();
+    index.scanPSO("b2", "a2", &wol);
+    ASSERT_EQ(nofHits, index._blockCache.getNofHits());
+    wol.clear();
+    index.scanPSO("b2", "a2", &wol);
+    ASSERT_EQ(nofHits + 1, index._blockCache.getNofHits());
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(5u, wol[0][0]);
+    wol.clear();
+
+    // Reads do not share a file position and take no lock, threads can
+    // scan concurrently, also while compactions replace the files.
+    // "a2 b c" comes and goes, the other triples stay.
+    std::atomic<bool> done(false);
+    vector<size_t> nofMismatches(4, 0);
+    vector<size_t> nofScans(4, 0);
+    vector<std::thread> threads;
+    for (size_t t = 0; t < nofMismatches.size(); ++t) {
+      threads.push_back(std::thread([&index, &done, &nofMismatches,
+                                     &nofScans, t] {
+        while (!done || nofScans[t] < 200) {
+          Index::WidthTwoList pairs;
+          Index::WidthOneList rhs;
+          index.scanPSO(t % 2 == 0 ? "b" : "b2", &pairs);
+          index.scanPOS("b2", "c2", &rhs);
+          size_t nofPairs = t % 2 == 0 && pairs.size() == 3 ? 3 : 2;
+          if (pairs.size() != nofPairs || pairs[0][0] != 0 ||
+              rhs.size() != 1 || rhs[0][0] != 1) {
+            ++nofMismatches[t];
+          }
+          ++nofScans[t];
+        }
+      }));
+    }
+    for (size_t i = 0; i < 4; ++i) {
+      ASSERT_TRUE(index.insertTriple("a2", "b", "c"));
+      index.startCompaction();
+      // Several threads may wait for the same compaction.
+      std::thread waiter([&index] { index.waitForCompaction(); });
+      index.waitForCompaction();
+      waiter.join();
+      ASSERT_TRUE(index.deleteTriple("a2", "b", "c"));
+      index.startCompaction();
+      index.waitForCompaction();
+    }
+    done = true;
+    for (size_t t = 0; t < threads.size(); ++t) {
+      threads[t].join();
+      ASSERT_EQ(0u, nofMismatches[t]);
+    }
+    ASSERT_TRUE(index.getMeta(Index::PSO).isFullIndexCompressed());
+    ASSERT_EQ(2u, index.getMeta(Index::PSO).getRmd(2)._nofElements);
+  }
+
+  remove("_testtmp6.tsv");
+  remove("_testindex6.vocabulary");
+  remove("_testindex6.vocabulary.mphf");
+  remove("_testindex6.index.pso");
+  remove("_testindex6.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, updateTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp7.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a\tb\tc2\t.\n"
+      "a\tb2\tc\t.\n"
+      "a2\tb2\tc2\t.";
+  f.close();
+  {
+    Index index;
+    index.createFromTsvFile("_testtmp7.tsv", "_testindex7");
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex7");
+    ASSERT_TRUE(index.insertTriple("a2", "b", "c"));
+    ASSERT_TRUE(index.deleteTriple("a", "b", "c2"));
+    ASSERT_FALSE(index.insertTriple("a", "b", "x"));
+
+    Index::WidthOneList wol;
+    Index::WidthTwoList wtl;
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(0u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[0][1]);
+    ASSERT_EQ(1u, wtl[1][0]);
+    ASSERT_EQ(4u, wtl[1][1]);
+    wtl.clear();
+    index.scanPOS("b", "c", &wol);
+    ASSERT_EQ(2u, wol.size());
+    ASSERT_EQ(0u, wol[0][0]);
+    ASSERT_EQ(1u, wol[1][0]);
+    wol.clear();
+    index.scanPSO("b", "a", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(4u, wol[0][0]);
+    wol.clear();
+
+    // Deleting an inserted triple cancels the insert.
+    ASSERT_TRUE(index.insertTriple("a2", "b", "c2"));
+    ASSERT_TRUE(index.deleteTriple("a2", "b", "c2"));
+    index.scanPSO("b", "a2", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(4u, wol[0][0]);
+    wol.clear();
+
+    index.startCompaction();
+    index.waitForCompaction();
+    ASSERT_TRUE(index._deltas[Index::PSO].empty());
+    ASSERT_TRUE(index._snapshot->_compactingDeltas[Index::PSO].empty());
+    ASSERT_EQ(2u, index.getMeta(Index::PSO).getRmd(2)._nofElements);
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(1u, wtl[1][0]);
+    ASSERT_EQ(4u, wtl[1][1]);
+    wtl.clear();
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex7");
+    Index::WidthOneList wol;
+    index.scanPOS("b", "c", &wol);
+    ASSERT_EQ(2u, wol.size());
+    ASSERT_EQ(0u, wol[0][0]);
+    ASSERT_EQ(1u, wol[1][0]);
+  }
+  {
+    // The POS file cannot be moved aside, the PSO file that was already
+    // replaced is restored and the changes are kept in memory.
+    mkdir("_testindex7.replaced.index.pos", 0700);
+    Index index;
+    index.createFromOnDiskIndex("_testindex7");
+    ASSERT_TRUE(index.insertTriple("a", "b", "c2"));
+    index.startCompaction();
+    ASSERT_THROW(index.waitForCompaction(), ad_semsearch::Exception);
+    rmdir("_testindex7.replaced.index.pos");
+    ASSERT_FALSE(ad_utility::File::exists("_testindex7.replaced.index.pso"));
+    Index::WidthTwoList wtl;
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(3u, wtl.size());
+    wtl.clear();
+    {
+      Index onDisk;
+      onDisk.createFromOnDiskIndex("_testindex7");
+      onDisk.scanPSO("b", &wtl);
+      ASSERT_EQ(2u, wtl.size());
+      wtl.clear();
+    }
+    // The next compaction retries.
+    index.startCompaction();
+    index.waitForCompaction();
+    ASSERT_EQ(3u, index.getMeta(Index::PSO).getRmd(2)._nofElements);
+  }
+  {
+    // Deleting all triples leaves empty permutations behind.
+    Index index;
+    index.createFromOnDiskIndex("_testindex7");
+    ASSERT_TRUE(index.deleteTriple("a", "b", "c"));
+    ASSERT_TRUE(index.deleteTriple("a", "b", "c2"));
+    ASSERT_TRUE(index.deleteTriple("a", "b2", "c"));
+    ASSERT_TRUE(index.deleteTriple("a2", "b", "c"));
+    ASSERT_TRUE(index.deleteTriple("a2", "b2", "c2"));
+    index.startCompaction();
+    index.waitForCompaction();
+    ASSERT_EQ(0u, index.getMeta(Index::PSO).getNofRelations());
+    ASSERT_EQ(0u, index.getMeta(Index::POS).getNofRelations());
+    Index::WidthTwoList wtl;
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(0u, wtl.size());
+    // The terms are still known and can be added again.
+    ASSERT_TRUE(index.insertTriple("a", "b", "c"));
+    index.startCompaction();
+    index.waitForCompaction();
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(1u, wtl.size());
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex7");
+    Index::WidthTwoList wtl;
+    index.scanPSO("b", &wtl);
+    ASSERT_EQ(1u, wtl.size());
+  }
+
+  remove("_testtmp7.tsv");
+  remove("_testindex7.vocabulary");
+  remove("_testindex7.vocabulary.mphf");
+  remove("_testindex7.index.pso");
+  remove("_testindex7.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, blockScanTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp8.tsv", std::ios_base::out);
+  for (size_t i = 0; i < 300; ++i) {
+    f << "s" << i << "\tp\to" << i % 50 << "\t.\n";
+    if (i % 3 == 0) {
+      f << "s" << i << "\tp\to" << (i * 7 + 1) % 50 << "\t.\n";
+    }
+    if (i % 2 == 0) {
+      f << "s" << i << "\tq\to" << i % 13 << "\t.\n";
+    }
+  }
+  f.close();
+  for (int compress = 0; compress < 2; ++compress) {
+    {
+      Index index;
+      index.setCompressFullIndex(compress == 1);
+      index.createFromTsvFile("_testtmp8.tsv", "_testindex8");
+    }
+    Index index;
+    index.createFromOnDiskIndex("_testindex8");
+    ASSERT_TRUE(index.insertTriple("s1", "p", "o49"));
+    ASSERT_TRUE(index.deleteTriple("s0", "p", "o0"));
+    ASSERT_TRUE(index.insertTriple("s299", "q", "o0"));
+    ASSERT_TRUE(index.insertTriple("s0", "q", "o1"));
+
+    Index::WidthTwoList p;
+    Index::WidthTwoList q;
+    index.scanPSO("p", &p);
+    index.scanPSO("q", &q);
+    ASSERT_EQ(400u, p.size());
+    ASSERT_EQ(152u, q.size());
+
+    size_t sizes[] = {1, 7, 64, 1000};
+    for (size_t k = 0; k < 4; ++k) {
+      RelationScan scan = index.scanBlocks(Index::PSO, "p", sizes[k]);
+      Index::WidthTwoList block;
+      Index::WidthTwoList all;
+      while (scan.next(&block)) {
+        ASSERT_FALSE(block.empty());
+        all.insert(all.end(), block.begin(), block.end());
+      }
+      ASSERT_EQ(p, all);
+      ASSERT_FALSE(scan.next(&block));
+      ASSERT_TRUE(block.empty());
+
+      RelationScan scanP = index.scanBlocks(Index::PSO, "p", sizes[k]);
+      RelationScan scanQ = index.scanBlocks(Index::PSO, "q", sizes[k]);
+      Index::WidthThreeList joined;
+      Index::WidthThreeList expected;
+      Engine::joinBlocks(&scanP, &scanQ, &joined);
+      for (size_t i = 0; i < p.size(); ++i) {
+        for (size_t j = 0; j < q.size(); ++j) {
+          if (p[i][0] == q[j][0]) {
+            expected.push_back(array<Id, 3>{{p[i][0], p[i][1], q[j][1]}});
+          }
+        }
+      }
+      ASSERT_EQ(expected, joined);
+    }
+
+    // A scan keeps the state at its start.
+    RelationScan scan = index.scanBlocks(Index::PSO, "q", 10);
+    ASSERT_TRUE(index.insertTriple("s1", "q", "o1"));
+    Index::WidthTwoList block;
+    Index::WidthTwoList all;
+    while (scan.next(&block)) {
+      all.insert(all.end(), block.begin(), block.end());
+    }
+    ASSERT_EQ(q, all);
+    ASSERT_FALSE(index.scanBlocks(Index::PSO, "x").next(&block));
+  }
+
+  remove("_testtmp8.tsv");
+  remove("_testindex8.vocabulary");
+  remove("_testindex8.vocabulary.mphf");
+  remove("_testindex8.index.pso");
+  remove("_testindex8.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+namespace {
+// The pairs of all with the LHS in range.
+Index::WidthTwoList inRange(const Index::WidthTwoList& all,
+                            const IdRange& range) {
+  Index::WidthTwoList res;
+  for (const auto& e: all) {
+    if (range._first <= e[0] && e[0] <= range._last) {
+      res.push_back(e);
+    }
+  }
+  return res;
+}
+
+// The pairs of all with one of the LHS.
+Index::WidthTwoList withLhs(const Index::WidthTwoList& all,
+                            const vector<Id>& lhs) {
+  Index::WidthTwoList res;
+  for (const auto& e: all) {
+    if (std::binary_search(lhs.begin(), lhs.end(), e[0])) {
+      res.push_back(e);
+    }
+  }
+  return res;
+}
+}
+
+TEST(IndexTest, rangeScanTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  // More than DISTINCT_LHS_PER_BLOCK subjects, so relations have
+  // several blocks, f is functional, n is not.
+  std::fstream f("_testtmp9.tsv", std::ios_base::out);
+  for (size_t i = 0; i < 25000; ++i) {
+    f << "s" << i << "\tf\to" << i % 100 << "\t.\n";
+    f << "s" << i << "\tn\to" << i % 7 << "\t.\n";
+    if (i % 3 == 0) {
+      f << "s" << i << "\tn\to" << 7 + i % 11 << "\t.\n";
+    }
+  }
+  f.close();
+  for (int compress = 0; compress < 2; ++compress) {
+    {
+      Index index;
+      index.setCompressFullIndex(compress == 1);
+      index.createFromTsvFile("_testtmp9.tsv", "_testindex9");
+    }
+    Index index;
+    index.createFromOnDiskIndex("_testindex9");
+    bool exact = false;
+    Id relF = index.getLowerBoundId("f", &exact);
+    Id relN = index.getLowerBoundId("n", &exact);
+    ASSERT_TRUE(index.getMeta(Index::PSO).getRmd(relF).isFunctional());
+    ASSERT_EQ(3u, index.getMeta(Index::PSO).getRmd(relF)._nofBlocks);
+    ASSERT_FALSE(index.getMeta(Index::PSO).getRmd(relN).isFunctional());
+    ASSERT_EQ(3u, index.getMeta(Index::PSO).getRmd(relN)._nofBlocks);
+    ASSERT_TRUE(index.insertTriple("s17", "f", "o5"));
+    ASSERT_TRUE(index.deleteTriple("s18", "f", "o18"));
+    ASSERT_TRUE(index.insertTriple("s20000", "n", "o9"));
+    ASSERT_TRUE(index.deleteTriple("s3", "n", "o3"));
+
+    const string relations[] = {"f", "n"};
+    for (const string& rel: relations) {
+      Index::WidthTwoList pso;
+      Index::WidthTwoList pos;
+      index.scanPSO(rel, &pso);
+      index.scanPOS(rel, &pos);
+      vector<IdRange> ranges;
+      ranges.push_back(IdRange(0, std::numeric_limits<Id>::max()));
+      ranges.push_back(IdRange(pso[0][0], pso[0][0]));
+      ranges.push_back(IdRange(pso[100][0], pso[20000][0]));
+      ranges.push_back(IdRange(pso[12345][0], pso.back()[0] - 1));
+      ranges.push_back(IdRange(pso[9999][0] + 1, pso[10001][0]));
+      ranges.push_back(IdRange(pos[5][0], pos[5][0]));
+      ranges.push_back(IdRange(pos[0][0] + 1, pos.back()[0]));
+      ranges.push_back(IdRange(5, 4));
+      for (const IdRange& range: ranges) {
+        Index::WidthTwoList res;
+        index.scanPSO(rel, range, &res);
+        ASSERT_EQ(inRange(pso, range), res) << rel << ' ' << range;
+        res.clear();
+        index.scanPOS(rel, range, &res);
+        ASSERT_EQ(inRange(pos, range), res) << rel << ' ' << range;
+      }
+
+      // Batches of keys, the second time from the block cache.
+      vector<vector<Id>> batches(4);
+      for (size_t i = 0; i < pso.size(); i += 97) {
+        batches[0].push_back(pso[i][0]);
+      }
+      for (size_t i = 9990; i < 10010; ++i) {
+        batches[1].push_back(pso[i][0]);
+        batches[1].push_back(pso[i][0]);
+      }
+      batches[2].push_back(relF);
+      batches[2].push_back(pso.back()[0]);
+      batches[2].push_back(std::numeric_limits<Id>::max());
+      for (size_t i = 0; i < pos.size(); i += 501) {
+        batches[3].push_back(pos[i][0]);
+      }
+      // The last LHS of the first block without the next block.
+      vector<Id> lhs;
+      for (const auto& e: pso) {
+        if (lhs.empty() || lhs.back() != e[0]) {
+          lhs.push_back(e[0]);
+        }
+      }
+      batches.push_back(vector<Id>(1, lhs[DISTINCT_LHS_PER_BLOCK - 1]));
+      batches.back().push_back(lhs[2 * DISTINCT_LHS_PER_BLOCK - 1]);
+      for (int pass = 0; pass < 2; ++pass) {
+        for (auto& batch: batches) {
+          std::sort(batch.begin(), batch.end());
+          Index::WidthTwoList res;
+          index.scanPSOBatch(rel, batch, &res);
+          ASSERT_EQ(withLhs(pso, batch), res) << rel;
+          res.clear();
+          index.scanPOSBatch(rel, batch, &res);
+          ASSERT_EQ(withLhs(pos, batch), res) << rel;
+        }
+      }
+    }
+    Index::WidthTwoList res;
+    index.scanPSO("x", IdRange(0, 10), &res);
+    ASSERT_EQ(0u, res.size());
+
+    Id s17 = index.getLowerBoundId("s17", &exact);
+    ASSERT_TRUE(exact);
+    ASSERT_EQ(s17 + 1, index.getLowerBoundId("s17!", &exact));
+    ASSERT_FALSE(exact);
+  }
+
+  remove("_testtmp9.tsv");
+  remove("_testindex9.vocabulary");
+  remove("_testindex9.vocabulary.mphf");
+  remove("_testindex9.index.pso");
+  remove("_testindex9.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, valueIdTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp8.tsv", std::ios_base::out);
+  f << "a\tb\t\"10\"^^xsd:integer\t.\n"
+      "a2\tb\t\"9\"^^<http://www.w3.org/2001/XMLSchema#integer>\t.\n"
+      "a3\tb\t\"2.50\"^^xsd:decimal\t.\n"
+      "a\tc\t\"2015-01-01\"^^xsd:date\t.";
+  f.close();
+  {
+    Index index;
+    index.createFromTsvFile("_testtmp8.tsv", "_testindex8");
+  }
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindex8");
+    Index::WidthOneList wol;
+    Index::WidthTwoList wtl;
+    index.scanPOS("b", &wtl);
+    ASSERT_EQ(3u, wtl.size());
+    ASSERT_TRUE(ValueId::isValue(wtl[0][0]));
+    ASSERT_EQ("\"9\"^^<http://www.w3.org/2001/XMLSchema#integer>",
+              index.idToString(wtl[0][0]));
+    ASSERT_EQ("a2", index.idToString(wtl[0][1]));
+    ASSERT_EQ("\"10\"^^<http://www.w3.org/2001/XMLSchema#integer>",
+              index.idToString(wtl[1][0]));
+    ASSERT_EQ("\"2.5\"^^<http://www.w3.org/2001/XMLSchema#decimal>",
+              index.idToString(wtl[2][0]));
+    ASSERT_EQ("a3", index.idToString(wtl[2][1]));
+    ASSERT_LT(ValueId::compare(wtl[2][0], wtl[0][0]), 0);
+
+    index.scanPOS("b", "\"10\"^^xsd:integer", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ("a", index.idToString(wol[0][0]));
+    wol.clear();
+
+    index.scanPSO("c", "a", &wol);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ("\"2015-01-01\"^^<http://www.w3.org/2001/XMLSchema#date>",
+              index.idToString(wol[0][0]));
+  }
+
+  remove("_testtmp8.tsv");
+  remove("_testindex8.vocabulary");
+  remove("_testindex8.vocabulary.mphf");
+  remove("_testindex8.index.pso");
+  remove("_testindex8.index.pos");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, topKContextsTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp10.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a2\tb\tc\t.\n"
+      "a3\tb\td\t.\n"
+      "a\te\tc\t.";
+  f.close();
+  // Enough contexts for several sub-blocks per list, gammaa and gammab
+  // share a block. Some contexts score high for all words.
+  vector<std::map<string, Score>> contexts(10000);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    Score high = static_cast<Score>(c % 997 == 0 ? 100 + c % 13 : 0);
+    if (c % 2 == 0) {
+      contexts[c]["alpha"] = static_cast<Score>(high + (c * 7) % 50 + 1);
+    }
+    if (c % 3 == 0) {
+      contexts[c]["beta"] = static_cast<Score>(high + (c * 11) % 40 + 1);
+    }
+    if (c % 5 == 0) {
+      contexts[c]["gammaa"] = static_cast<Score>(high + (c * 3) % 30 + 1);
+    }
+    if (c % 7 == 0) {
+      contexts[c]["gammab"] = static_cast<Score>(high + (c * 5) % 30 + 1);
+    }
+  }
+  std::fstream w("_testtmp10.words", std::ios_base::out);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    for (const auto& word : contexts[c]) {
+      w << word.first << "\t0\t" << c << "\t" << word.second << "\n";
+    }
+  }
+  w.close();
+  {
+    Index index;
+    index.createFromTsvFile("_testtmp10.tsv", "_testindex10");
+    index.addTextFromContextFile("_testtmp10.words");
+  }
+  Index index;
+  index.createFromOnDiskIndex("_testindex10");
+  index.addTextFromOnDiskIndex();
+
+  // The highest score of the words of each term, summed over the terms.
+  auto expected = [&contexts](const vector<string>& terms, size_t k) {
+    vector<array<Id, 2>> rows;
+    for (size_t c = 0; c < contexts.size(); ++c) {
+      size_t score = 0;
+      bool all = true;
+      for (const string& term : terms) {
+        Score best = 0;
+        bool found = false;
+        for (const auto& word : contexts[c]) {
+          if (word.first == term || (term.back() == '*' &&
+              word.first.compare(0, term.size() - 1, term, 0,
+                                 term.size() - 1) == 0)) {
+            best = std::max(best, word.second);
+            found = true;
+          }
+        }
+        all = all && found;
+        score += best;
+      }
+      if (all) {
+        rows.push_back({{static_cast<Id>(c), static_cast<Id>(score)}});
+      }
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const array<Id, 2>& a, const array<Id, 2>& b) {
+                return a[1] > b[1] || (a[1] == b[1] && a[0] < b[0]);
+              });
+    rows.resize(std::min(k, rows.size()));
+    return rows;
+  };
+
+  const TextBlockMetaData& alpha = index._textMeta.getBlockById(0);
+  ASSERT_GT(alpha._cl.getNofSubBlocks(), 10u);
+  ASSERT_EQ(0u, alpha._entityCl.getNofSubBlocks());
+
+  vector<vector<string>> queries = {
+      {"alpha"}, {"alpha", "beta"}, {"gammaa"}, {"gamm*"},
+      {"beta", "gammab", "alpha"}, {"gamm*", "beta"}};
+  size_t ks[] = {1, 4, 20, 100000};
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& terms : queries) {
+      string words = terms[0];
+      for (size_t i = 1; i < terms.size(); ++i) {
+        words += " " + terms[i];
+      }
+      for (size_t k : ks) {
+        Index::WidthTwoList res;
+        index.getTopKContextsForWords(words, k, &res);
+        ASSERT_EQ(expected(terms, k), res) << words << " " << k;
+      }
+    }
+  }
+
+  Index::WidthTwoList res;
+  index.getTopKContextsForWords("alpha delta", 10, &res);
+  ASSERT_EQ(0u, res.size());
+
+  // Whole lists still read as before.
+  index.getContextListForWords("alpha", &res);
+  ASSERT_EQ(5000u, res.size());
+  for (size_t i = 0; i < res.size(); ++i) {
+    ASSERT_EQ(2 * i, res[i][0]);
+    ASSERT_EQ(contexts[2 * i]["alpha"], res[i][1]);
+  }
+  vector<Id> cids;
+  vector<Score> scores;
+  index.getWordPostingsForTerm("gammab", cids, scores);
+  ASSERT_EQ(1429u, cids.size());
+  ASSERT_EQ(7u, cids[1]);
+  ASSERT_EQ(contexts[7]["gammab"], scores[1]);
+
+  remove("_testtmp10.tsv");
+  remove("_testtmp10.words");
+  remove("_testindex10.vocabulary");
+  remove("_testindex10.vocabulary.mphf");
+  remove("_testindex10.index.pso");
+  remove("_testindex10.index.pos");
+  remove("_testindex10.text.vocabulary");
+  remove("_testindex10.text.index");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, textCodecsTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp11.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a\te\tc\t.";
+  f.close();
+  // gammaa and gammab share a block, so reading gammab filters by word.
+  vector<std::map<string, Score>> contexts(3000);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    if (c % 2 == 0) {
+      contexts[c]["alpha"] = static_cast<Score>((c * 7) % 50 + 1);
+    }
+    if (c % 3 == 0) {
+      contexts[c]["beta"] = static_cast<Score>((c * 11) % 40 + 1);
+    }
+    if (c % 5 == 0) {
+      contexts[c]["gammaa"] = static_cast<Score>((c * 3) % 30 + 1);
+    }
+    if (c % 7 == 0) {
+      contexts[c]["gammab"] = static_cast<Score>((c * 5) % 30 + 1);
+    }
+  }
+  std::fstream w("_testtmp11.words", std::ios_base::out);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    for (const auto& word : contexts[c]) {
+      w << word.first << "\t0\t" << c << "\t" << word.second << "\n";
+    }
+  }
+  w.close();
+
+  for (size_t c = 1; c < PostingListCodec::NOF_CODECS; ++c) {
+    auto codec = PostingListCodec::Codec(c);
+    {
+      Index index;
+      index.setTextCodecSelection(PostingListCodec::SMALLEST,
+                                  PostingListCodec::only(codec));
+      index.createFromTsvFile("_testtmp11.tsv", "_testindex11");
+      index.addTextFromContextFile("_testtmp11.words");
+    }
+    Index index;
+    index.createFromOnDiskIndex("_testindex11");
+    index.addTextFromOnDiskIndex();
+
+    const TextBlockMetaData& alpha = index._textMeta.getBlockById(0);
+    ASSERT_EQ(codec, alpha._cl._contextCodec);
+    ASSERT_EQ(codec, alpha._cl._scoreCodec);
+    ASSERT_GT(alpha._cl.getNofSubBlocks(), 1u);
+
+    Index::WidthTwoList res;
+    index.getContextListForWords("alpha", &res);
+    ASSERT_EQ(1500u, res.size());
+    for (size_t i = 0; i < res.size(); ++i) {
+      ASSERT_EQ(2 * i, res[i][0]);
+      ASSERT_EQ(contexts[2 * i]["alpha"], res[i][1]);
+    }
+    vector<Id> cids;
+    vector<Score> scores;
+    index.getWordPostingsForTerm("gammab", cids, scores);
+    ASSERT_EQ(429u, cids.size());
+    for (size_t i = 0; i < cids.size(); ++i) {
+      ASSERT_EQ(7 * i, cids[i]);
+      ASSERT_EQ(contexts[7 * i]["gammab"], scores[i]);
+    }
+
+    // Top-k reads single sub-blocks.
+    vector<array<Id, 2>> expected;
+    for (size_t i = 0; i < contexts.size(); i += 6) {
+      expected.push_back({{static_cast<Id>(i), static_cast<Id>(
+          contexts[i]["alpha"] + contexts[i]["beta"])}});
+    }
+    std::sort(expected.begin(), expected.end(),
+              [](const array<Id, 2>& a, const array<Id, 2>& b) {
+                return a[1] > b[1] || (a[1] == b[1] && a[0] < b[0]);
+              });
+    expected.resize(10);
+    index.getTopKContextsForWords("alpha beta", 10, &res);
+    ASSERT_EQ(expected, res) << PostingListCodec::name(codec);
+  }
+
+  remove("_testtmp11.tsv");
+  remove("_testtmp11.words");
+  remove("_testindex11.vocabulary");
+  remove("_testindex11.vocabulary.mphf");
+  remove("_testindex11.index.pso");
+  remove("_testindex11.index.pos");
+  remove("_testindex11.text.vocabulary");
+  remove("_testindex11.text.index");
+  std::remove(stxxlFileName.c_str());
+};
+
+TEST(IndexTest, postingListCacheTest) {
+  string location = "./";
+  string tail = "";
+  writeStxxlConfigFile(location, tail);
+  string stxxlFileName = getStxxlDiskFileName(location, tail);
+
+  std::fstream f("_testtmp12.tsv", std::ios_base::out);
+  f << "a\tb\tc\t.\n"
+      "a\te\tc\t.";
+  f.close();
+  // gammaa and gammab share a block, entity c co-occurs with gammab.
+  std::fstream w("_testtmp12.words", std::ios_base::out);
+  for (size_t c = 0; c < 1000; ++c) {
+    if (c % 5 == 0) {
+      w << "gammaa\t0\t" << c << "\t1\n";
+    }
+    if (c % 7 == 0) {
+      w << "gammab\t0\t" << c << "\t2\n";
+      w << "c\t1\t" << c << "\t1\n";
+    }
+  }
+  w.close();
+
+  {
+    Index index;
+    index.createFromTsvFile("_testtmp12.tsv", "_testindex12");
+    index.addTextFromContextFile("_testtmp12.words");
+  }
+  Index index;
+  index.createFromOnDiskIndex("_testindex12");
+  index.addTextFromOnDiskIndex();
+
+  vector<Id> cids;
+  vector<Score> scores;
+  index.getWordPostingsForTerm("gammab", cids, scores);
+  ASSERT_EQ(143u, cids.size());
+  ASSERT_EQ(0u, index._postingListCache.getNofHits());
+  ASSERT_EQ(1u, index._postingListCache.getNofMisses());
+  ASSERT_GT(index._postingListCache.getSizeInBytes(), 0u);
+
+  vector<Id> cachedCids;
+  vector<Score> cachedScores;
+  index.getWordPostingsForTerm("gammab", cachedCids, cachedScores);
+  ASSERT_EQ(1u, index._postingListCache.getNofHits());
+  ASSERT_EQ(cids, cachedCids);
+  ASSERT_EQ(scores, cachedScores);
+
+  // A prefix of the same block is a different range. The 29 contexts
+  // with both words have a posting for each.
+  cids.clear();
+  scores.clear();
+  index.getWordPostingsForTerm("gamm*", cids, scores);
+  ASSERT_EQ(1u, index._postingListCache.getNofHits());
+  ASSERT_EQ(200u + 143u, cids.size());
+
+  // Entity postings are cached apart from the word postings.
+  vector<Id> eids;
+  cids.clear();
+  scores.clear();
+  index.getEntityPostingsForTerm("gammab", cids, eids, scores);
+  size_t hits = index._postingListCache.getNofHits();
+  ASSERT_EQ(143u, cids.size());
+  ASSERT_EQ(143u, eids.size());
+  vector<Id> cachedEids;
+  cachedCids.clear();
+  cachedScores.clear();
+  index.getEntityPostingsForTerm("gammab", cachedCids, cachedEids,
+                                 cachedScores);
+  ASSERT_EQ(hits + 1, index._postingListCache.getNofHits());
+  ASSERT_EQ(cids, cachedCids);
+  ASSERT_EQ(eids, cachedEids);
+  ASSERT_EQ(scores, cachedScores);
+
+  // Without capacity nothing is cached.
+  index.setPostingListCacheCapacity(0);
+  ASSERT_EQ(0u, index._postingListCache.getSizeInBytes());
+  cids.clear();
+  scores.clear();
+  index.getWordPostingsForTerm("gammab", cids, scores);
+  ASSERT_EQ(143u, cids.size());
+  ASSERT_EQ(0u, index._postingListCache.getSizeInBytes());
+
+  remove("_testtmp12.tsv");
+  remove("_testtmp12.words");
+  remove("_testindex12.vocabulary");
+  remove("_testindex12.vocabulary.mphf");
+  remove("_testindex12.index.pso");
+  remove("_testindex12.index.pos");
+  remove("_testindex12.text.vocabulary");
+  remove("_testindex12.text.index");
+  std::remove(stxxlFileName.c_str());
+};
+
 TEST(IndexTest, scanTest) {
   string location = "./";
   string tail = "";
@@ -443,6 +1500,8 @@ TEST(IndexTest, scanTest) {
 
   remove("_testtmp2.tsv");
   std::remove(stxxlFileName.c_str());
+  remove("_testindex.vocabulary");
+  remove("_testindex.vocabulary.mphf");
   remove("_testindex.index.pso");
   remove("_testindex.index.pos");
 
@@ -557,6 +1616,8 @@ TEST(IndexTest, scanTest) {
   }
   remove("_testtmp2.tsv");
   std::remove(stxxlFileName.c_str());
+  remove("_testindex.vocabulary");
+  remove("_testindex.vocabulary.mphf");
   remove("_testindex.index.pso");
   remove("_testindex.index.pos");
 };
@@ -61,6 +61,44 @@ TEST(NTriplesParserTest, getLineTest) {
   }
 };
 
+TEST(NTriplesParserTest, parallelGetLineTest) {
+  {
+    std::fstream f("_testtmp.nt", std::ios_base::out);
+    f << "<foo>\t<bar>\t<c>\t.\n"
+        "\n"
+        "<foo>    <Äö>\t\"this is some text. It goes\ton!\"\t.\n"
+        "<a> <b> \"123\"^^<http://foo.bar/a> .\n";
+    f.close();
+    ParallelNTriplesParser p("_testtmp.nt", 2, 16);
+    array<string, 3> a;
+    ASSERT_TRUE(p.getLine(a));
+    ASSERT_EQ("<foo>", a[0]);
+    ASSERT_EQ("<bar>", a[1]);
+    ASSERT_EQ("<c>", a[2]);
+    ASSERT_TRUE(p.getLine(a));
+    ASSERT_EQ("<foo>", a[0]);
+    ASSERT_EQ("<Äö>", a[1]);
+    ASSERT_EQ("\"this is some text. It goes\ton!\"", a[2]);
+    ASSERT_TRUE(p.getLine(a));
+    ASSERT_EQ("<a>", a[0]);
+    ASSERT_EQ("<b>", a[1]);
+    ASSERT_EQ("\"123\"^^<http://foo.bar/a>", a[2]);
+    ASSERT_FALSE(p.getLine(a));
+    remove("_testtmp.nt");
+  }
+  // Errors in worker threads reach the consumer.
+  {
+    std::fstream f("_testtmp.nt", std::ios_base::out);
+    f << "<a>\t<b>\t<c>\t.\n"
+        "a2\t<b2>\t<c2>\t.\n";
+    f.close();
+    ParallelNTriplesParser p("_testtmp.nt", 2, 1 << 20);
+    array<string, 3> a;
+    ASSERT_THROW(p.getLine(a), ad_semsearch::Exception);
+    remove("_testtmp.nt");
+  }
+};
+
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,157 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <gtest/gtest.h>
+#include "../src/index/PostingListCodec.h"
+
+namespace {
+// Small values with runs of 0's and a few large outliers.
+vector<uint64_t> makeValues(size_t n, uint64_t largest) {
+  vector<uint64_t> values;
+  for (size_t i = 0; i < n; ++i) {
+    if (i % 300 < 40) {
+      values.push_back(0);
+    } else if (i % 97 == 0) {
+      values.push_back(largest - i % 90);
+    } else {
+      values.push_back((i * 7919) % 50);
+    }
+  }
+  return values;
+}
+}
+
+// _____________________________________________________________________________
+TEST(PostingListCodecTest, encodeDecodeAllCodecsTest) {
+  for (uint64_t largest : {uint64_t(1000), uint64_t(1) << 40,
+                           uint64_t(0x0FFFFFFFFFFFFFFF)}) {
+    for (size_t n : {size_t(1), size_t(128), size_t(129), size_t(5000)}) {
+      vector<uint64_t> values = makeValues(n, largest);
+      for (size_t c = 0; c < PostingListCodec::NOF_CODECS; ++c) {
+        auto codec = PostingListCodec::Codec(c);
+        vector<uint64_t> encoded;
+        vector<size_t> entryElements;
+        vector<size_t> entryWords;
+        PostingListCodec::encode(codec, values.data(), n, &encoded,
+                                 &entryElements, &entryWords);
+        ASSERT_EQ(entryElements.size(), entryWords.size());
+        ASSERT_EQ(0u, entryElements[0]);
+
+        vector<uint64_t> decoded(n + PostingListCodec::DECODE_OVERHEAD);
+        PostingListCodec::decode(codec, encoded.data(), n, decoded.data());
+        decoded.resize(n);
+        ASSERT_EQ(values, decoded) << PostingListCodec::name(codec);
+
+        // Decode from the last entry point onwards.
+        size_t first = entryElements.back();
+        decoded.assign(n + PostingListCodec::DECODE_OVERHEAD, 0);
+        PostingListCodec::decode(codec, encoded.data() + entryWords.back(),
+                                 n - first, decoded.data());
+        for (size_t i = first; i < n; ++i) {
+          ASSERT_EQ(values[i], decoded[i - first]);
+        }
+        ASSERT_LE(encoded.size() - entryWords.back(),
+                  PostingListCodec::maxWordsPerEntry(codec));
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+TEST(PostingListCodecTest, gapsAndCodebookTest) {
+  vector<uint64_t> gaps = makeValues(1000, 1 << 20);
+  vector<uint64_t> codes;
+  for (size_t i = 0; i < 1000; ++i) {
+    codes.push_back(i % 11 == 0 ? 3 : i % 5);
+  }
+  vector<uint16_t> codebook = {10, 20, 30, 40, 50};
+  for (size_t c = 0; c < PostingListCodec::NOF_CODECS; ++c) {
+    auto codec = PostingListCodec::Codec(c);
+    vector<uint64_t> encoded;
+    vector<size_t> entryElements;
+    vector<size_t> entryWords;
+    PostingListCodec::encode(codec, gaps.data(), gaps.size(), &encoded,
+                             &entryElements, &entryWords);
+    vector<uint64_t> ids(gaps.size() + PostingListCodec::DECODE_OVERHEAD);
+    PostingListCodec::decodeGaps(codec, encoded.data(), gaps.size(),
+                                 ids.data(), uint64_t(5));
+    uint64_t id = 5;
+    for (size_t i = 0; i < gaps.size(); ++i) {
+      id += gaps[i];
+      ASSERT_EQ(id, ids[i]);
+    }
+
+    encoded.clear();
+    PostingListCodec::encode(codec, codes.data(), codes.size(), &encoded,
+                             &entryElements, &entryWords);
+    vector<uint16_t> scores(codes.size() + PostingListCodec::DECODE_OVERHEAD);
+    PostingListCodec::decodeWithCodebook(codec, encoded.data(), codes.size(),
+                                         codebook.data(), scores.data());
+    for (size_t i = 0; i < codes.size(); ++i) {
+      ASSERT_EQ(codebook[codes[i]], scores[i]);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+TEST(PostingListCodecTest, selectionTest) {
+  vector<uint64_t> values = makeValues(3000, 1 << 30);
+  vector<uint64_t> encoded;
+  vector<size_t> entryElements;
+  vector<size_t> entryWords;
+  size_t smallest = std::numeric_limits<size_t>::max();
+  for (size_t c = 0; c < PostingListCodec::NOF_CODECS; ++c) {
+    encoded.clear();
+    PostingListCodec::encode(PostingListCodec::Codec(c), values.data(),
+                             values.size(), &encoded, &entryElements,
+                             &entryWords);
+    smallest = std::min(smallest, encoded.size());
+  }
+  encoded.clear();
+  auto codec = PostingListCodec::encodeWithBestCodec(
+      PostingListCodec::SMALLEST, PostingListCodec::ALL_CODECS,
+      values.data(), values.size(), &encoded,
+      &entryElements, &entryWords);
+  ASSERT_EQ(smallest, encoded.size());
+  vector<uint64_t> decoded(values.size() + PostingListCodec::DECODE_OVERHEAD);
+  PostingListCodec::decode(codec, encoded.data(), values.size(),
+                           decoded.data());
+  decoded.resize(values.size());
+  ASSERT_EQ(values, decoded);
+
+  encoded.clear();
+  PostingListCodec::encodeWithBestCodec(
+      PostingListCodec::FASTEST, PostingListCodec::ALL_CODECS,
+      values.data(), values.size(), &encoded,
+      &entryElements, &entryWords);
+  ASSERT_LE(encoded.size(),
+            PostingListCodec::FASTEST_MAX_SIZE_FACTOR * smallest);
+
+  // Values above 60 bits cannot be Simple8b encoded.
+  values.push_back(uint64_t(1) << 62);
+  encoded.clear();
+  codec = PostingListCodec::encodeWithBestCodec(
+      PostingListCodec::SMALLEST, PostingListCodec::ALL_CODECS,
+      values.data(), values.size(), &encoded,
+      &entryElements, &entryWords);
+  ASSERT_NE(PostingListCodec::SIMPLE8B, codec);
+  decoded.assign(values.size() + PostingListCodec::DECODE_OVERHEAD, 0);
+  PostingListCodec::decode(codec, encoded.data(), values.size(),
+                           decoded.data());
+  decoded.resize(values.size());
+  ASSERT_EQ(values, decoded);
+
+  // Only Simple8b allowed, but it cannot encode the values.
+  encoded.clear();
+  codec = PostingListCodec::encodeWithBestCodec(
+      PostingListCodec::SMALLEST,
+      PostingListCodec::only(PostingListCodec::SIMPLE8B), values.data(),
+      values.size(), &encoded, &entryElements, &entryWords);
+  ASSERT_EQ(PostingListCodec::BIT_PACKING, codec);
+
+  PostingListCodec::Codec named;
+  ASSERT_TRUE(PostingListCodec::fromName("PFor", &named));
+  ASSERT_EQ(PostingListCodec::PFOR, named);
+  ASSERT_FALSE(PostingListCodec::fromName("Gzip", &named));
+}
@@ -237,8 +237,19 @@ TEST(QueryExecutionTreeTest, testTextQuerySE) {
     const QueryExecutionTree& qet = qg.getExecutionTree();
     ASSERT_EQ("{TEXT OPERATION FOR CONTEXTS: "
                   "co-occurrence with words: "
-                  "\"search engine\" with textLimit = 1 | width: 2}",
+                  "\"search engine\" | width: 2}",
               qet.asString());
+
+    pq = SparqlParser::parse(
+        "SELECT TEXT(?c) \n "
+            "WHERE \t {?c <in-context> search engine} TEXTLIMIT 3");
+    pq.expandPrefixes();
+    QueryGraph qg2;
+    qg2.createFromParsedQuery(pq);
+    ASSERT_EQ("{TEXT OPERATION FOR CONTEXTS: "
+                  "co-occurrence with words: "
+                  "\"search engine\" with textLimit = 3 | width: 2}",
+              qg2.getExecutionTree().asString());
   } catch (const ad_semsearch::Exception& e) {
     std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
     FAIL() << e.getFullErrorMessage();
@@ -3,10 +3,51 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
+#include "../src/engine/Filter.h"
 #include "../src/engine/QueryPlanner.h"
 #include "../src/parser/SparqlParser.h"
 
+namespace {
+// Builds an index from a TSV file for queries that are executed.
+void buildIndex(const string& tsv, const string& onDiskBase) {
+  ad_utility::File stxxlConfig(".stxxl", "w");
+  std::ostringstream config;
+  config << "disk=./-stxxl.disk," << STXXL_DISK_SIZE_INDEX_TEST << ",syscall";
+  stxxlConfig.writeLine(config.str());
+  stxxlConfig.close();
+  std::fstream f("_testtmpqp.tsv", std::ios_base::out);
+  f << tsv;
+  f.close();
+  Index index;
+  index.createFromTsvFile("_testtmpqp.tsv", onDiskBase);
+  remove("_testtmpqp.tsv");
+}
+
+void removeIndex(const string& onDiskBase) {
+  remove((onDiskBase + ".vocabulary").c_str());
+  remove((onDiskBase + ".vocabulary.mphf").c_str());
+  remove((onDiskBase + ".index.pso").c_str());
+  remove((onDiskBase + ".index.pos").c_str());
+  remove("./-stxxl.disk");
+}
+
+// The rows of the query result, one line per row.
+string runQuery(QueryExecutionContext* qec, const string& query,
+                const vector<string>& selectVars) {
+  ParsedQuery pq = SparqlParser::parse(query);
+  pq.expandPrefixes();
+  QueryPlanner qp(qec);
+  QueryExecutionTree qet = qp.createExecutionTree(pq);
+  std::ostringstream os;
+  qet.writeResultToStream(os, selectVars);
+  return os.str();
+}
+}
+
 
 TEST(QueryPlannerTest, createTripleGraph) {
   try {
@@ -115,6 +156,47 @@ TEST(QueryPlannerTest, test_free_PX) {
                       "2}" == qet.asString());
 }
 
+TEST(QueryPlannerTest, testS_free_P_free_O) {
+  ParsedQuery pq = SparqlParser::parse(
+      "PREFIX : <http://rdf.myprefix.com/>\n"
+          "SELECT ?p \n "
+          "WHERE \t {:s ?p ?o}");
+  pq.expandPrefixes();
+  QueryPlanner qp(nullptr);
+  QueryExecutionTree qet = qp.createExecutionTree(pq);
+  EXPECT_TRUE("{SCAN SPO with S = \"<http://rdf.myprefix.com/s>\" | width: "
+                "2}" == qet.asString() ||
+                  "{SCAN SOP with S = \"<http://rdf.myprefix.com/s>\" | width: "
+                      "2}" == qet.asString());
+}
+
+TEST(QueryPlannerTest, test_free_S_free_PO) {
+  ParsedQuery pq = SparqlParser::parse(
+      "PREFIX : <http://rdf.myprefix.com/>\n"
+          "SELECT ?s \n "
+          "WHERE \t {?s ?p :o}");
+  pq.expandPrefixes();
+  QueryPlanner qp(nullptr);
+  QueryExecutionTree qet = qp.createExecutionTree(pq);
+  EXPECT_TRUE("{SCAN OSP with O = \"<http://rdf.myprefix.com/o>\" | width: "
+                "2}" == qet.asString() ||
+                  "{SCAN OPS with O = \"<http://rdf.myprefix.com/o>\" | width: "
+                      "2}" == qet.asString());
+}
+
+TEST(QueryPlannerTest, testS_free_PO) {
+  ParsedQuery pq = SparqlParser::parse(
+      "PREFIX : <http://rdf.myprefix.com/>\n"
+          "SELECT ?p \n "
+          "WHERE \t {:s ?p :o}");
+  pq.expandPrefixes();
+  QueryPlanner qp(nullptr);
+  QueryExecutionTree qet = qp.createExecutionTree(pq);
+  ASSERT_EQ("{SCAN SOP with S = \"<http://rdf.myprefix.com/s>\", "
+                "O = \"<http://rdf.myprefix.com/o>\" | width: 1}",
+            qet.asString());
+}
+
 TEST(QueryPlannerTest, testSPX_SPX) {
   try {
     ParsedQuery pq = SparqlParser::parse(
@@ -324,6 +406,193 @@ TEST(QueryPlannerTest, testFilterAfterJoin) {
   }
 }
 
+TEST(QueryPlannerTest, testFilterWithConstant) {
+  try {
+    // Part of the scan of the POS permutation, where ?y is the first column.
+    ParsedQuery pq = SparqlParser::parse("SELECT ?x ?y WHERE {"
+                                             "?x <r> ?y . "
+                                             "FILTER(?y < <m>) }");
+    QueryPlanner qp(nullptr);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ("{SCAN POS with P = \"<r>\" and col 0 < <m> | width: 2}",
+              qet.asString());
+
+    // Numeric filters keep the filter. Without estimates filtering the
+    // second column is as cheap, testValueFiltersAndOrder pushes one down.
+    pq = SparqlParser::parse("SELECT ?x ?y WHERE {"
+                                 "?x <r> ?y . "
+                                 "FILTER(?y < \"10\"^^xsd:integer) }");
+    qet = qp.createExecutionTree(pq);
+    ASSERT_EQ("{FILTER {SCAN PSO with P = \"<r>\" | width: 2} with "
+                  "col 1 < \"10\"^^xsd:integer | width: 2}", qet.asString());
+
+    IdRange range;
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::LE, 5, true, &range));
+    ASSERT_EQ(0u, range._first);
+    ASSERT_EQ(5u, range._last);
+    // 5 is the lower bound of a value that is not in the vocabulary.
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::LE, 5, false, &range));
+    ASSERT_EQ(4u, range._last);
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::GT, 5, false, &range));
+    ASSERT_EQ(5u, range._first);
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::EQ, 5, false, &range));
+    ASSERT_GT(range._first, range._last);
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::LT, 0, true, &range));
+    ASSERT_GT(range._first, range._last);
+    ASSERT_FALSE(Filter::getIdRange(SparqlFilter::NE, 5, true, &range));
+    // Values are type errors for words and not part of their ranges.
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::GE, 5, true, &range));
+    ASSERT_EQ(5u, range._first);
+    ASSERT_EQ(ValueId::getClassEnd(5), range._last);
+    Id date;
+    ASSERT_TRUE(ValueId::fromString("\"2000-01-01\"^^xsd:date", &date));
+    ASSERT_TRUE(Filter::getIdRange(SparqlFilter::LT, date, true, &range));
+    ASSERT_EQ(ValueId::getClassBegin(date), range._first);
+    ASSERT_EQ(date - 1, range._last);
+
+    // Numbers get one range per numeric type.
+    vector<IdRange> ranges;
+    Id ten;
+    Id decimal;
+    Id dbl;
+    ASSERT_TRUE(ValueId::fromString("\"10\"^^xsd:integer", &ten));
+    ASSERT_FALSE(Filter::getIdRanges(SparqlFilter::NE, ten, true, &ranges));
+    ASSERT_TRUE(Filter::getIdRanges(SparqlFilter::LT, ten, true, &ranges));
+    ASSERT_EQ(3u, ranges.size());
+    ASSERT_EQ(ValueId::make(ValueId::INTEGER, 0), ranges[0]._first);
+    ASSERT_EQ(ten - 1, ranges[0]._last);
+    ASSERT_TRUE(ValueId::fromDouble(10, ValueId::DECIMAL, &decimal));
+    ASSERT_EQ(ValueId::make(ValueId::DECIMAL, 0), ranges[1]._first);
+    ASSERT_EQ(decimal, ranges[1]._last);
+    ASSERT_TRUE(ValueId::fromDouble(10, ValueId::DOUBLE, &dbl));
+    ASSERT_EQ(ValueId::make(ValueId::DOUBLE, 0), ranges[2]._first);
+    ASSERT_EQ(dbl, ranges[2]._last);
+    // No integer equals 2.5, numbers above 2.5 include the integer 3.
+    ASSERT_TRUE(ValueId::fromString("\"2.5\"^^xsd:double", &dbl));
+    ASSERT_TRUE(Filter::getIdRanges(SparqlFilter::EQ, dbl, true, &ranges));
+    ASSERT_EQ(2u, ranges.size());
+    ASSERT_TRUE(ValueId::fromDouble(2.5, ValueId::DECIMAL, &decimal));
+    ASSERT_EQ(decimal, ranges[0]._first);
+    ASSERT_EQ(decimal, ranges[0]._last);
+    ASSERT_EQ(dbl, ranges[1]._first);
+    ASSERT_EQ(dbl, ranges[1]._last);
+    ASSERT_TRUE(Filter::getIdRanges(SparqlFilter::GT, dbl, true, &ranges));
+    ASSERT_EQ(3u, ranges.size());
+    Id three;
+    ASSERT_TRUE(ValueId::fromInteger(3, &three));
+    ASSERT_EQ(three, ranges[0]._first);
+    ASSERT_EQ(dbl + 1, ranges[2]._first);
+    ASSERT_EQ(ValueId::getClassEnd(dbl), ranges[2]._last);
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testValueFiltersAndOrder) {
+  // The long decimal cannot be encoded and stays in the vocabulary.
+  buildIndex("<a>\t<v>\t\"10\"^^xsd:integer\t.\n"
+             "<b>\t<v>\t\"1.5\"^^xsd:decimal\t.\n"
+             "<c>\t<v>\t\"2.5\"^^xsd:double\t.\n"
+             "<d>\t<v>\t<iri>\t.\n"
+             "<e>\t<v>\t\"text\"\t.\n"
+             "<f>\t<v>\t\"2015-01-01\"^^xsd:date\t.\n"
+             "<g>\t<v>\t\"0.12345678901234567890123\"^^xsd:decimal\t.\n",
+             "_testindexqp");
+  {
+    Index index;
+    index.createFromOnDiskIndex("_testindexqp");
+    Engine engine;
+    QueryExecutionContext qec(index, engine);
+    // Words, dates and numbers that are words are type errors for a
+    // comparison with a number.
+    ASSERT_EQ("<b>\n<c>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y < \"5\"^^xsd:integer) } ORDER BY ?x",
+                       {"?x"}));
+    ASSERT_EQ("<a>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y > \"5\"^^xsd:integer) }", {"?x"}));
+    ASSERT_EQ("<a>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y = \"10.0\"^^xsd:double) }", {"?x"}));
+    // Numbers without datatype are values as well.
+    ASSERT_EQ("<b>\n<c>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y < 5) } ORDER BY ?x", {"?x"}));
+    ASSERT_EQ("<a>\n<c>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y >= 2.5) } ORDER BY ?x", {"?x"}));
+    ASSERT_EQ("<a>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y = 1e1) }", {"?x"}));
+    ASSERT_EQ("<a>\n<c>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y >= \"2.5\"^^xsd:decimal) } "
+                             "ORDER BY ?x", {"?x"}));
+    // The scan only reads the numbers around the value, the filter on top
+    // of it compares them.
+    ParsedQuery pq = SparqlParser::parse("SELECT ?x WHERE { ?x <v> ?y . "
+                                         "FILTER(?y > \"5\"^^xsd:integer) }");
+    QueryPlanner qp(&qec);
+    ASSERT_EQ("{FILTER {SCAN POS with P = \"<v>\" and col 0 > "
+                  "\"5\"^^xsd:integer | width: 2} with col 0 > "
+                  "\"5\"^^xsd:integer | width: 2}",
+              qp.createExecutionTree(pq).asString());
+    ASSERT_EQ("<f>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y > \"2000-01-01\"^^xsd:date) }",
+                       {"?x"}));
+    // A word only compares with words, literals come before IRIs. The
+    // long decimal is a word.
+    ASSERT_EQ("<g>\n<e>\n<d>\n",
+              runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y <= <iri>) }", {"?x"}));
+
+    // Numbers of all types by their values, after the words and
+    // before the dates, ascending and descending.
+    string numbers = runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                                    "FILTER(?y > \"0\"^^xsd:integer) } "
+                                    "ORDER BY ?y", {"?x"});
+    ASSERT_EQ("<b>\n<c>\n<a>\n", numbers);
+    numbers = runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y . "
+                             "FILTER(?y > \"0\"^^xsd:integer) } "
+                             "ORDER BY DESC(?y)", {"?x"});
+    ASSERT_EQ("<a>\n<c>\n<b>\n", numbers);
+    string all = runQuery(&qec, "SELECT ?x WHERE { ?x <v> ?y } ORDER BY ?y",
+                          {"?x"});
+    ASSERT_EQ("<b>\n<c>\n<a>\n<f>\n", all.substr(all.size() - 16));
+  }
+  removeIndex("_testindexqp");
+}
+
+TEST(QueryPlannerTest, testOrderByValues) {
+  try {
+    // A subject is never a number, its order by Id is that of the values.
+    ParsedQuery pq = SparqlParser::parse("SELECT ?x ?y WHERE {"
+                                             "?x <r> ?y } ORDER BY ?x");
+    QueryPlanner qp(nullptr);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ("{SCAN PSO with P = \"<r>\" | width: 2}", qet.asString());
+
+    // An object may hold numbers of different types.
+    pq = SparqlParser::parse("SELECT ?x ?y WHERE {"
+                                 "?x <r> ?y } ORDER BY ?y");
+    qet = qp.createExecutionTree(pq);
+    ASSERT_EQ("{OrderBy {SCAN PSO with P = \"<r>\" | width: 2} on asc(1)  "
+                  "| width: 2}", qet.asString());
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
 TEST(QueryExecutionTreeTest, testBooksbyNewman) {
   try {
     ParsedQuery pq = SparqlParser::parse(
@@ -3,9 +3,11 @@
 // Author: Björn Buchhold <buchholb>
 
 #include <gtest/gtest.h>
+#include <vector>
 #include "../src/util/Simple8bCode.h"
 
 using std::string;
+using std::vector;
 
 namespace ad_utility {
 // _____________________________________________________________________________
@@ -207,6 +209,49 @@ namespace ad_utility {
       delete[] encoded;
       delete[] decoded;
     }
+// _____________________________________________________________________________
+    TEST(Simple8bTest, testDecodeGapsAndCodebook) {
+      vector<uint64_t> gaps;
+      for (size_t i = 0; i < 5000; ++i) {
+        // Mix runs of 0's with small and large gaps to hit all selectors.
+        gaps.push_back(i % 700 < 300 ? 0 : (i * 7919) % (uint64_t(1) << (i % 40)));
+      }
+      vector<uint64_t> encoded(gaps.size());
+      Simple8bCode::encode(gaps.data(), gaps.size(), encoded.data());
+
+      vector<uint16_t> codebook = {7, 3, 9, 1, 4};
+      vector<uint16_t> codes;
+      for (size_t i = 0; i < 1000; ++i) {
+        codes.push_back(i % 300 < 130 ? 0 : (i * 31) % codebook.size());
+      }
+      vector<uint64_t> encodedCodes(codes.size());
+      Simple8bCode::encode(codes.data(), codes.size(), encodedCodes.data());
+
+      bool simd = Simple8bCode::simdEnabled();
+      for (bool useSimd : {false, Simple8bCode::cpuSupportsSimd()}) {
+        Simple8bCode::simdEnabled() = useSimd;
+        vector<uint64_t> decoded(gaps.size() + 239);
+        Simple8bCode::decodeGaps(encoded.data(), gaps.size(), decoded.data(),
+                                 uint64_t(42));
+        uint64_t id = 42;
+        for (size_t i = 0; i < gaps.size(); ++i) {
+          id += gaps[i];
+          ASSERT_EQ(id, decoded[i]);
+        }
+        Simple8bCode::decode(encoded.data(), gaps.size(), decoded.data());
+        for (size_t i = 0; i < gaps.size(); ++i) {
+          ASSERT_EQ(gaps[i], decoded[i]);
+        }
+
+        vector<uint16_t> values(codes.size() + 239);
+        Simple8bCode::decodeWithCodebook(encodedCodes.data(), codes.size(),
+                                         codebook.data(), values.data());
+        for (size_t i = 0; i < codes.size(); ++i) {
+          ASSERT_EQ(codebook[codes[i]], values[i]);
+        }
+      }
+      Simple8bCode::simdEnabled() = simd;
+    }
 }
 
 // _____________________________________________________________________________
@@ -137,6 +137,20 @@ TEST(ParserTest, testParse) {
     ASSERT_EQ("<in-context>", pq._whereClauseTriples[3]._p);
     ASSERT_EQ("coca* abuse", pq._whereClauseTriples[3]._o);
 
+    pq = SparqlParser::parse(
+        "PREFIX xxx: <http://rdf.myprefix.com/xxx/>\n"
+            "SELECT ?x ?y WHERE {?x xxx:rel ?y . FILTER(?y >= xxx:a) ."
+            "FILTER(?x > 10)}");
+    pq.expandPrefixes();
+    ASSERT_EQ(2, pq._filters.size());
+    ASSERT_EQ("?y", pq._filters[0]._lhs);
+    ASSERT_EQ("<http://rdf.myprefix.com/xxx/a>", pq._filters[0]._rhs);
+    ASSERT_EQ(SparqlFilter::FilterType::GE, pq._filters[0]._type);
+    ASSERT_EQ("?x", pq._filters[1]._lhs);
+    ASSERT_EQ("\"10\"^^<http://www.w3.org/2001/XMLSchema#integer>",
+              pq._filters[1]._rhs);
+    ASSERT_EQ(SparqlFilter::FilterType::GT, pq._filters[1]._type);
+
     pq = SparqlParser::parse(
         "PREFIX : <>\n"
             "SELECT ?x ?y ?z TEXT(?c) SCORE(?c) ?c WHERE {\n"
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include <cstdio>
 #include <fstream>
+#include <sstream>
 #include "../src/parser/TsvParser.h"
 
 
@@ -49,6 +50,82 @@ TEST(TsvParserTest, getLineTest) {
   }
 };
 
+TEST(TsvParserTest, parallelGetLineTest) {
+  {
+    std::fstream f("_testtmp.tsv", std::ios_base::out);
+    for (size_t i = 0; i < 1000; ++i) {
+      f << "s" << i << "\tp\to" << i << "\t.\n";
+    }
+    f.close();
+    // Chunks smaller than a single line and chunks with many lines.
+    size_t chunkSizes[] = {5, 64, 1 << 20};
+    for (size_t chunkSize : chunkSizes) {
+      ParallelTsvParser p("_testtmp.tsv", 3, chunkSize);
+      array<string, 3> a;
+      for (size_t i = 0; i < 1000; ++i) {
+        std::ostringstream s;
+        s << "s" << i;
+        std::ostringstream o;
+        o << "o" << i;
+        ASSERT_TRUE(p.getLine(a));
+        ASSERT_EQ(s.str(), a[0]);
+        ASSERT_EQ("p", a[1]);
+        ASSERT_EQ(o.str(), a[2]);
+      }
+      ASSERT_FALSE(p.getLine(a));
+    }
+    remove("_testtmp.tsv");
+  }
+  // Without trailing newline
+  {
+    std::fstream f("_testtmp.tsv", std::ios_base::out);
+    f << "a\tb\tc\t.\n"
+        "a2\tb2\tc2\t.";
+    f.close();
+    ParallelTsvParser p("_testtmp.tsv", 2, 8);
+    array<string, 3> a;
+    ASSERT_TRUE(p.getLine(a));
+    ASSERT_EQ("a", a[0]);
+    ASSERT_TRUE(p.getLine(a));
+    ASSERT_EQ("a2", a[0]);
+    ASSERT_EQ("b2", a[1]);
+    ASSERT_EQ("c2", a[2]);
+    ASSERT_FALSE(p.getLine(a));
+    remove("_testtmp.tsv");
+  }
+};
+
+TEST(TsvParserTest, getIdChunkTest) {
+  std::fstream f("_testtmp.tsv", std::ios_base::out);
+  for (size_t i = 0; i < 1000; ++i) {
+    f << "s" << i % 10 << "\tp\t\"" << i << "\"^^xsd:integer\t.\n";
+  }
+  f.close();
+  size_t chunkSizes[] = {5, 64, 1 << 20};
+  for (size_t chunkSize : chunkSizes) {
+    ParallelTsvParser p("_testtmp.tsv", 3, chunkSize, true);
+    IdChunk chunk;
+    size_t i = 0;
+    while (p.getIdChunk(chunk)) {
+      for (size_t t = 0; t < chunk._triples.size(); ++t, ++i) {
+        const array<Id, 3>& ids = chunk._triples[t];
+        std::ostringstream s;
+        s << "s" << i % 10;
+        ASSERT_LT(ids[0], chunk._words.size());
+        ASSERT_EQ(s.str(), chunk._words[ids[0]]);
+        ASSERT_LT(ids[1], chunk._words.size());
+        ASSERT_EQ("p", chunk._words[ids[1]]);
+        ASSERT_TRUE(ValueId::isValue(ids[2]));
+        ASSERT_EQ(static_cast<int64_t>(i), ValueId::toInteger(ids[2]));
+      }
+      // Each distinct word of a chunk once.
+      ASSERT_LE(chunk._words.size(), 11u);
+    }
+    ASSERT_EQ(1000u, i);
+  }
+  remove("_testtmp.tsv");
+};
+
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,162 @@
+// Copyright 2015, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "../src/global/ValueId.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+string xsd(const string& lexical, const string& type) {
+  return "\"" + lexical + "\"^^<http://www.w3.org/2001/XMLSchema#" + type +
+         ">";
+}
+
+Id id(const string& literal) {
+  Id result = 0;
+  EXPECT_TRUE(ValueId::fromString(literal, &result)) << literal;
+  return result;
+}
+}
+
+// _____________________________________________________________________________
+TEST(ValueIdTest, parseAndPrintTest) {
+  Id i;
+  ASSERT_FALSE(ValueId::fromString("<http://x.org/a>", &i));
+  ASSERT_FALSE(ValueId::fromString("\"42\"", &i));
+  ASSERT_FALSE(ValueId::fromString("\"42\"@en", &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("42", "string"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("4x2", "integer"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("1e5", "decimal"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("NaN", "double"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("2015-13-01", "date"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("2015-01-01+02:00", "date"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("1.000000000000001", "decimal"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("1234567890123.4567", "decimal"), &i));
+  ASSERT_FALSE(ValueId::fromString(xsd("1.0000000000000002", "double"), &i));
+  ASSERT_FALSE(ValueId::isValue(5));
+
+  ASSERT_EQ(ValueId::INTEGER, ValueId::getType(id(xsd("42", "integer"))));
+  ASSERT_EQ(xsd("42", "integer"), ValueId::toString(id(xsd("42", "integer"))));
+  ASSERT_EQ(xsd("7", "integer"), ValueId::toString(id("\"+007\"^^xsd:integer")));
+  ASSERT_EQ(xsd("-12", "integer"), ValueId::toString(id(xsd("-12", "integer"))));
+  ASSERT_EQ(xsd("3.25", "decimal"), ValueId::toString(id(xsd("3.25", "decimal"))));
+  ASSERT_EQ(xsd("-0.1", "decimal"), ValueId::toString(id(xsd("-.1", "decimal"))));
+  ASSERT_EQ(xsd("2", "decimal"), ValueId::toString(id(xsd("2.0", "decimal"))));
+  ASSERT_EQ(xsd("1e+10", "double"), ValueId::toString(id(xsd("1E10", "double"))));
+  ASSERT_EQ(xsd("0.5", "double"), ValueId::toString(id(xsd("0.5", "double"))));
+  ASSERT_EQ(xsd("3.14", "double"), ValueId::toString(id(xsd("3.14", "double"))));
+  ASSERT_EQ(xsd("-0.1", "decimal"),
+            ValueId::toString(id(xsd("-000.100", "decimal"))));
+  ASSERT_EQ(xsd("1234567890.25", "decimal"),
+            ValueId::toString(id(xsd("1234567890.25", "decimal"))));
+  ASSERT_EQ(xsd("2015-02-28", "date"),
+            ValueId::toString(id(xsd("2015-02-28", "date"))));
+  ASSERT_EQ(xsd("-0044-03-15Z", "date"),
+            ValueId::toString(id(xsd("-0044-03-15Z", "date"))));
+  ASSERT_EQ(xsd("2015-02-28T13:05:09.250Z", "dateTime"),
+            ValueId::toString(id(xsd("2015-02-28T13:05:09.25Z", "dateTime"))));
+  ASSERT_EQ(xsd("2015-02-28T13:05:09", "dateTime"),
+            ValueId::toString(id(xsd("2015-02-28T13:05:09", "dateTime"))));
+}
+
+// _____________________________________________________________________________
+TEST(ValueIdTest, orderTest) {
+  vector<string> integers = {"-1000000000000", "-5", "0", "3", "17",
+                             "1000000000000"};
+  vector<string> doubles = {"-1e300", "-2.5", "-0.001", "0", "1e-300",
+                            "0.001", "2.5", "1e300"};
+  vector<string> dates = {"-0500-01-01", "0800-12-24", "1999-12-31",
+                          "2000-01-01", "2000-01-02"};
+  for (size_t j = 1; j < integers.size(); ++j) {
+    ASSERT_LT(id(xsd(integers[j - 1], "integer")),
+              id(xsd(integers[j], "integer")));
+  }
+  for (size_t j = 1; j < doubles.size(); ++j) {
+    ASSERT_LT(id(xsd(doubles[j - 1], "double")),
+              id(xsd(doubles[j], "double")));
+  }
+  for (size_t j = 1; j < dates.size(); ++j) {
+    ASSERT_LT(id(xsd(dates[j - 1], "date")), id(xsd(dates[j], "date")));
+  }
+  ASSERT_LT(id(xsd("2000-01-01T23:59:59.999", "dateTime")),
+            id(xsd("2000-01-02T00:00:00", "dateTime")));
+  ASSERT_EQ(id(xsd("-0", "double")), id(xsd("0", "double")));
+}
+
+// _____________________________________________________________________________
+TEST(ValueIdTest, compareTest) {
+  Id three = id(xsd("3", "integer"));
+  Id threeAndAHalf = id(xsd("3.5", "decimal"));
+  Id threeDouble = id(xsd("3", "double"));
+  Id minusTen = id(xsd("-10", "decimal"));
+  ASSERT_LT(ValueId::compare(three, threeAndAHalf), 0);
+  ASSERT_GT(ValueId::compare(threeAndAHalf, three), 0);
+  ASSERT_EQ(0, ValueId::compare(three, threeDouble));
+  ASSERT_GT(ValueId::compare(three, minusTen), 0);
+  ASSERT_EQ(0, ValueId::compare(three, three));
+  // Above 2^53 integers and doubles still compare by their exact values,
+  // 10^16 + 1 is no double and would be rounded to 10^16.
+  Id big = id(xsd("10000000000000001", "integer"));
+  Id bigDouble = id(xsd("1e16", "double"));
+  Id nextDouble = id(xsd("1.00000000000001e16", "double"));
+  ASSERT_GT(ValueId::compare(big, bigDouble), 0);
+  ASSERT_LT(ValueId::compare(big, nextDouble), 0);
+  ASSERT_LT(ValueId::compare(bigDouble, big), 0);
+  ASSERT_EQ(0, ValueId::compare(id(xsd("10000000000000000", "integer")),
+                                bigDouble));
+  ASSERT_LT(ValueId::compare(id(xsd("-2.5", "double")),
+                             id(xsd("-2", "integer"))), 0);
+  ASSERT_GT(ValueId::compare(id(xsd("-1.5", "decimal")),
+                             id(xsd("-2", "integer"))), 0);
+  ASSERT_LT(ValueId::compare(id(xsd("100000000000000000", "integer")),
+                             id(xsd("1e300", "double"))), 0);
+  // Vocabulary ids come before all values.
+  ASSERT_LT(ValueId::compare(12345, minusTen), 0);
+  ASSERT_LT(ValueId::compare(12345, id(xsd("1000-01-01", "date"))), 0);
+  ASSERT_LT(ValueId::compare(1, 2), 0);
+}
+
+// _____________________________________________________________________________
+TEST(ValueIdTest, comparableTest) {
+  Id three = id(xsd("3", "integer"));
+  Id threeDouble = id(xsd("3", "double"));
+  Id date = id(xsd("1000-01-01", "date"));
+  ASSERT_TRUE(ValueId::comparable(three, threeDouble));
+  ASSERT_TRUE(ValueId::comparable(date, id(xsd("2000-01-01", "date"))));
+  ASSERT_TRUE(ValueId::comparable(1, 12345));
+  // Numbers, dates and vocabulary words are type errors with each other.
+  ASSERT_FALSE(ValueId::comparable(three, 12345));
+  ASSERT_FALSE(ValueId::comparable(12345, threeDouble));
+  ASSERT_FALSE(ValueId::comparable(three, date));
+  ASSERT_FALSE(ValueId::comparable(date, 12345));
+  ASSERT_EQ(ValueId::getClassBegin(threeDouble), ValueId::getClassBegin(three));
+  ASSERT_LT(ValueId::getClassEnd(three), ValueId::getClassBegin(date));
+  ASSERT_EQ(0u, ValueId::getClassBegin(12345));
+  ASSERT_LT(ValueId::getClassEnd(12345), ValueId::getClassBegin(three));
+}
+
+TEST(ValueIdTest, typedLiteralForNumberTest) {
+  string literal;
+  ASSERT_TRUE(ValueId::typedLiteralForNumber("10", &literal));
+  ASSERT_EQ(xsd("10", "integer"), literal);
+  ASSERT_TRUE(ValueId::typedLiteralForNumber("-1.5", &literal));
+  ASSERT_EQ(xsd("-1.5", "decimal"), literal);
+  ASSERT_TRUE(ValueId::typedLiteralForNumber("2.5e3", &literal));
+  ASSERT_EQ(xsd("2.5e3", "double"), literal);
+  ASSERT_EQ(ValueId::compare(id(xsd("2500", "integer")), id(literal)), 0);
+  ASSERT_FALSE(ValueId::typedLiteralForNumber("<a>", &literal));
+  ASSERT_FALSE(ValueId::typedLiteralForNumber("1e", &literal));
+  ASSERT_FALSE(ValueId::typedLiteralForNumber("10a", &literal));
+  ASSERT_FALSE(ValueId::typedLiteralForNumber(".", &literal));
+}
+
+// _____________________________________________________________________________
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
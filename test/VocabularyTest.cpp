@@ -4,7 +4,10 @@
 
 #include <gtest/gtest.h>
 #include <cstdio>
+#include <iomanip>
+#include <sstream>
 #include "../src/index/Vocabulary.h"
+#include "../src/index/VocabularyMerger.h"
 
 
 TEST(VocabularyTest, getIdForWordTest) {
@@ -68,6 +71,156 @@ TEST(VocabularyTest, readWriteTest) {
   ASSERT_EQ(size_t(6), v.size());
   v.readFromFile("_testtmp_vocfile");
   ASSERT_EQ(size_t(5), v.size());
+  ASSERT_EQ("wordA0", v[0]);
+  ASSERT_EQ("wordB4", v[4]);
+  remove("_testtmp_vocfile");
+  remove("_testtmp_vocfile.mphf");
+}
+
+TEST(VocabularyTest, frontCodedBlocksTest) {
+  // Several blocks, words share prefixes across block boundaries.
+  vector<string> words;
+  for (size_t i = 0; i < 5 * VOCABULARY_BLOCK_SIZE + 3; ++i) {
+    std::ostringstream os;
+    os << "<http://x.org/" << (i < 20 ? "a" : "b") << std::setw(4)
+       << std::setfill('0') << i << ">";
+    words.push_back(os.str());
+  }
+  {
+    Vocabulary::Writer writer("_testtmp_vocfile");
+    for (size_t i = 0; i < words.size(); ++i) {
+      writer.push_back(words[i]);
+    }
+  }
+  Vocabulary v;
+  v.readFromFile("_testtmp_vocfile");
+  ASSERT_EQ(words.size(), v.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    ASSERT_EQ(words[i], v[i]);
+    Id id;
+    ASSERT_TRUE(v.getId(words[i], &id));
+    ASSERT_EQ(Id(i), id);
+  }
+  Id id;
+  ASSERT_FALSE(v.getId("<http://x.org/a0003", &id));
+  ASSERT_FALSE(v.getId("<http://x.org/c>", &id));
+  ASSERT_FALSE(v.getId("", &id));
+
+  IdRange range;
+  ASSERT_TRUE(v.getIdRangeForFullTextPrefix("<http://x.org/a*", &range));
+  ASSERT_EQ(Id(0), range._first);
+  ASSERT_EQ(Id(19), range._last);
+  ASSERT_TRUE(v.getIdRangeForFullTextPrefix("<http://x.org/b*", &range));
+  ASSERT_EQ(Id(20), range._first);
+  ASSERT_EQ(Id(words.size() - 1), range._last);
+  ASSERT_FALSE(v.getIdRangeForFullTextPrefix("<http://y*", &range));
+
+  // Appending to a mapped vocabulary continues in memory.
+  v.push_back("<http://y.org/>");
+  ASSERT_EQ(words.size() + 1, v.size());
+  ASSERT_EQ(words[17], v[17]);
+  ASSERT_TRUE(v.getId("<http://y.org/>", &id));
+  ASSERT_EQ(Id(words.size()), id);
+  remove("_testtmp_vocfile");
+  remove("_testtmp_vocfile.mphf");
+}
+
+TEST(VocabularyTest, externalizedLiteralsTest) {
+  string longPrefix = "\"" + string(MAX_INLINE_LITERAL_SIZE, 'a');
+  vector<string> words;
+  words.push_back("\"short\"");
+  words.push_back(longPrefix + "b\"");
+  words.push_back(longPrefix + "c\"");
+  words.push_back(longPrefix + "c\"@en");
+  words.push_back("\"x" + string(MAX_INLINE_LITERAL_SIZE, 'y') + "\"");
+  words.push_back("<a>");
+  std::sort(words.begin(), words.end());
+  ASSERT_FALSE(Vocabulary::shouldBeExternalized("\"short\""));
+  ASSERT_FALSE(Vocabulary::shouldBeExternalized("<" + longPrefix + ">"));
+  ASSERT_TRUE(Vocabulary::shouldBeExternalized(longPrefix + "b\""));
+  {
+    Vocabulary::Writer writer("_testtmp_vocfile");
+    for (size_t i = 0; i < words.size(); ++i) {
+      writer.push_back(words[i]);
+    }
+  }
+  ASSERT_TRUE(ad_utility::File::exists("_testtmp_vocfile.external"));
+  Vocabulary v;
+  v.readFromFile("_testtmp_vocfile");
+  ASSERT_EQ(words.size(), v.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    ASSERT_EQ(words[i], v[i]);
+    Id id;
+    ASSERT_TRUE(v.getId(words[i], &id));
+    ASSERT_EQ(Id(i), id);
+  }
+  // Same inline prefix as the externalized words, decided by the full word.
+  // Sorted: a..b", a..c", a..c"@en, "short", "xy..", <a>
+  Id id;
+  ASSERT_FALSE(v.getId(longPrefix + "bb\"", &id));
+  ASSERT_FALSE(v.getId(longPrefix, &id));
+  IdRange range;
+  ASSERT_TRUE(v.getIdRangeForFullTextPrefix(longPrefix + "c*", &range));
+  ASSERT_EQ(Id(1), range._first);
+  ASSERT_EQ(Id(2), range._last);
+  ASSERT_TRUE(v.getIdRangeForFullTextPrefix(longPrefix + "*", &range));
+  ASSERT_EQ(Id(0), range._first);
+  ASSERT_EQ(Id(2), range._last);
+  ASSERT_FALSE(v.getIdRangeForFullTextPrefix(longPrefix + "bb*", &range));
+  std::unordered_map<string, Id> map = v.asMap();
+  ASSERT_EQ(Id(2), map[longPrefix + "c\"@en"]);
+  remove("_testtmp_vocfile");
+  remove("_testtmp_vocfile.external");
+  remove("_testtmp_vocfile.mphf");
+}
+
+TEST(VocabularyTest, perfectHashTest) {
+  vector<string> words;
+  for (size_t i = 0; i < 10000; ++i) {
+    std::ostringstream os;
+    os << "<http://x.org/" << std::setw(5) << std::setfill('0') << i * 2
+       << ">";
+    words.push_back(os.str());
+  }
+  {
+    Vocabulary::Writer writer("_testtmp_vocfile");
+    for (size_t i = 0; i < words.size(); ++i) {
+      writer.push_back(words[i]);
+    }
+  }
+  ASSERT_TRUE(ad_utility::File::exists("_testtmp_vocfile.mphf"));
+  PerfectHash hash;
+  ASSERT_TRUE(hash.readFromFile("_testtmp_vocfile.mphf"));
+  vector<bool> seen(words.size(), false);
+  for (size_t i = 0; i < words.size(); ++i) {
+    Id id;
+    ASSERT_TRUE(hash.lookup(words[i], &id));
+    ASSERT_EQ(Id(i), id);
+    ASSERT_FALSE(seen[id]);
+    seen[id] = true;
+  }
+  hash.clear();
+
+  Vocabulary v;
+  v.readFromFile("_testtmp_vocfile");
+  for (size_t i = 0; i < words.size(); ++i) {
+    Id id;
+    ASSERT_TRUE(v.getId(words[i], &id));
+    ASSERT_EQ(Id(i), id);
+    // Odd numbers are not in the vocabulary.
+    std::ostringstream os;
+    os << "<http://x.org/" << std::setw(5) << std::setfill('0') << i * 2 + 1
+       << ">";
+    ASSERT_FALSE(v.getId(os.str(), &id));
+  }
+
+  // Without the hash function, lookups fall back to binary search.
+  remove("_testtmp_vocfile.mphf");
+  v.readFromFile("_testtmp_vocfile");
+  Id id;
+  ASSERT_TRUE(v.getId(words[4711], &id));
+  ASSERT_EQ(Id(4711), id);
+  ASSERT_FALSE(v.getId("<http://x.org/00001>", &id));
   remove("_testtmp_vocfile");
 }
 
@@ -87,6 +240,62 @@ TEST(VocabularyTest, createFromSetTest) {
   ASSERT_FALSE(v.getId("foo", &id));
 };
 
+TEST(VocabularyTest, mergePartialVocabulariesTest) {
+  std::unordered_map<string, Id> c1;
+  c1["b"] = 0;
+  c1["a"] = 1;
+  c1["d"] = 2;
+  std::unordered_map<string, Id> c2;
+  c2["c"] = 0;
+  c2["b"] = 1;
+  c2["e"] = 2;
+  vector<Id> ranks1 =
+      VocabularyMerger::writePartialVocabulary(c1, "_testtmp_partial0");
+  vector<Id> ranks2 =
+      VocabularyMerger::writePartialVocabulary(c2, "_testtmp_partial1");
+  ASSERT_EQ(Id(1), ranks1[0]);
+  ASSERT_EQ(Id(0), ranks1[1]);
+  ASSERT_EQ(Id(2), ranks1[2]);
+  ASSERT_EQ(Id(1), ranks2[0]);
+  ASSERT_EQ(Id(0), ranks2[1]);
+  ASSERT_EQ(Id(2), ranks2[2]);
+  vector<string> files;
+  files.push_back("_testtmp_partial0");
+  files.push_back("_testtmp_partial1");
+  vector<string> idMaps;
+  idMaps.push_back("_testtmp_partial0.ids");
+  idMaps.push_back("_testtmp_partial1.ids");
+  ASSERT_EQ(size_t(5),
+            VocabularyMerger::mergePartialVocabularies(files,
+                                                       "_testtmp_vocfile",
+                                                       idMaps));
+  Vocabulary v;
+  v.readFromFile("_testtmp_vocfile");
+  ASSERT_EQ(size_t(5), v.size());
+  ASSERT_EQ("a", v[0]);
+  ASSERT_EQ("b", v[1]);
+  ASSERT_EQ("c", v[2]);
+  ASSERT_EQ("d", v[3]);
+  ASSERT_EQ("e", v[4]);
+
+  // Partial 0 is a, b, d. Partial 1 is b, c, e.
+  vector<Id> ids1 = VocabularyMerger::readIdMap("_testtmp_partial0.ids");
+  vector<Id> ids2 = VocabularyMerger::readIdMap("_testtmp_partial1.ids");
+  ASSERT_EQ(size_t(3), ids1.size());
+  ASSERT_EQ(Id(0), ids1[0]);
+  ASSERT_EQ(Id(1), ids1[1]);
+  ASSERT_EQ(Id(3), ids1[2]);
+  ASSERT_EQ(size_t(3), ids2.size());
+  ASSERT_EQ(Id(1), ids2[0]);
+  ASSERT_EQ(Id(2), ids2[1]);
+  ASSERT_EQ(Id(4), ids2[2]);
+  remove("_testtmp_partial0");
+  remove("_testtmp_partial1");
+  remove("_testtmp_partial0.ids");
+  remove("_testtmp_partial1.ids");
+  remove("_testtmp_vocfile");
+  remove("_testtmp_vocfile.mphf");
+};
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);